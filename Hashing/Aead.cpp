@@ -0,0 +1,360 @@
+#include "Aead.h"
+#include "Encoding.h"
+#include "FileIO.h"
+#include "TaskScheduler.h"
+#include "Wipe.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// Uncomment to enable debug prints
+// #define AEAD_DEBUG
+
+#ifdef AEAD_DEBUG
+#define AEAD_LOG(msg) std::cerr << "[Aead] " << msg << "\n"
+#else
+#define AEAD_LOG(msg) /* no-op */
+#endif
+
+static const uint8_t SEAL_MAGIC[8] = { 'Q', 'F', 'S', 'E', 'A', 'L', '0', '1' };
+static const size_t RATE_WORDS = QF_RATE_BYTES / 8;
+static const size_t MAX_CHUNK = size_t(1) << 30;
+static const size_t WINDOW_BYTES = size_t(64) << 20;   // per-window buffer cap
+
+// Domain bytes XORed into the last capacity word of each padded block
+static const uint64_t DOMAIN_KEY = 1;
+static const uint64_t DOMAIN_AD = 2;
+static const uint64_t DOMAIN_CHUNK = 3;
+static const uint64_t DOMAIN_PAYLOAD = 4;
+
+static inline uint8_t* rateBytes(QFState& qs) { return reinterpret_cast<uint8_t*>(qs.state); }
+
+// Full blocks as qfAbsorb does, then the (possibly empty) tail padded
+// 10*1 with the domain in the capacity and permuted, so every phase ends
+// on a permutation and phases cannot be confused with each other
+static void absorbPadded(QFState& qs, const uint8_t* data, size_t len, uint64_t domain) {
+    for (; len >= QF_RATE_BYTES; data += QF_RATE_BYTES, len -= QF_RATE_BYTES) {
+        uint8_t* rate = rateBytes(qs);
+        for (size_t i = 0; i < QF_RATE_BYTES; i++) rate[i] ^= data[i];
+        qfPermutation(qs);
+    }
+    uint8_t* rate = rateBytes(qs);
+    for (size_t i = 0; i < len; i++) rate[i] ^= data[i];
+    rate[len] ^= 0x01;
+    rate[QF_RATE_BYTES - 1] ^= 0x80;
+    qs.state[QFState::STATE_WORDS - 1] ^= domain;
+    qfPermutation(qs);
+}
+
+// One full rate block each way: the ciphertext replaces the rate
+static inline void duplexEncrypt(QFState& qs, const uint8_t* in, uint8_t* out) {
+    for (size_t w = 0; w < RATE_WORDS; w++) {
+        uint64_t p;
+        std::memcpy(&p, in + 8 * w, 8);
+        uint64_t c = p ^ qs.state[w];
+        qs.state[w] = c;
+        std::memcpy(out + 8 * w, &c, 8);
+    }
+    qfPermutation(qs);
+}
+
+static inline void duplexDecrypt(QFState& qs, const uint8_t* in, uint8_t* out) {
+    for (size_t w = 0; w < RATE_WORDS; w++) {
+        uint64_t c;
+        std::memcpy(&c, in + 8 * w, 8);
+        uint64_t p = c ^ qs.state[w];
+        qs.state[w] = c;
+        std::memcpy(out + 8 * w, &p, 8);
+    }
+    qfPermutation(qs);
+}
+
+static void finishTag(QFState& qs, size_t tailLen, uint8_t* tag) {
+    uint8_t* rate = rateBytes(qs);
+    rate[tailLen] ^= 0x01;
+    rate[QF_RATE_BYTES - 1] ^= 0x80;
+    qs.state[QFState::STATE_WORDS - 1] ^= DOMAIN_PAYLOAD;
+    qfPermutation(qs);
+    std::memcpy(tag, rateBytes(qs), QF_AEAD_TAG_BYTES);
+}
+
+// --------------------------------------------------------------------
+// QFAead
+// --------------------------------------------------------------------
+QFAead::QFAead(const uint8_t key[QF_AEAD_KEY_BYTES], const uint8_t* ad, size_t adLen) {
+    qfInit(base);
+    absorbPadded(base, key, QF_AEAD_KEY_BYTES, DOMAIN_KEY);
+    absorbPadded(base, ad, adLen, DOMAIN_AD);
+}
+
+QFAead::~QFAead() {
+    qfWipe(&base, sizeof(base));
+}
+
+void QFAead::chunkState(QFState& qs, const uint8_t nonce[QF_AEAD_NONCE_BYTES], uint64_t index, bool final) const {
+    uint8_t block[QF_AEAD_NONCE_BYTES + 9];
+    std::memcpy(block, nonce, QF_AEAD_NONCE_BYTES);
+    for (int i = 0; i < 8; i++) block[QF_AEAD_NONCE_BYTES + i] = static_cast<uint8_t>(index >> (8 * i));
+    block[QF_AEAD_NONCE_BYTES + 8] = final ? 1 : 0;
+    qs = base;
+    absorbPadded(qs, block, sizeof(block), DOMAIN_CHUNK);
+}
+
+void QFAead::sealChunk(const uint8_t nonce[QF_AEAD_NONCE_BYTES], uint64_t index, bool final,
+    const uint8_t* in, size_t len, uint8_t* out, uint8_t tag[QF_AEAD_TAG_BYTES]) const {
+    QFState qs;
+    chunkState(qs, nonce, index, final);
+    for (; len >= QF_RATE_BYTES; in += QF_RATE_BYTES, out += QF_RATE_BYTES, len -= QF_RATE_BYTES) {
+        duplexEncrypt(qs, in, out);
+    }
+    uint8_t* rate = rateBytes(qs);
+    for (size_t i = 0; i < len; i++) {
+        rate[i] ^= in[i];
+        out[i] = rate[i];
+    }
+    finishTag(qs, len, tag);
+    qfWipe(&qs, sizeof(qs));
+}
+
+bool QFAead::openChunk(const uint8_t nonce[QF_AEAD_NONCE_BYTES], uint64_t index, bool final,
+    const uint8_t* in, size_t len, uint8_t* out, const uint8_t tag[QF_AEAD_TAG_BYTES]) const {
+    QFState qs;
+    chunkState(qs, nonce, index, final);
+    uint8_t* start = out;
+    size_t total = len;
+    for (; len >= QF_RATE_BYTES; in += QF_RATE_BYTES, out += QF_RATE_BYTES, len -= QF_RATE_BYTES) {
+        duplexDecrypt(qs, in, out);
+    }
+    uint8_t* rate = rateBytes(qs);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = in[i];
+        out[i] = c ^ rate[i];
+        rate[i] = c;
+    }
+    uint8_t expected[QF_AEAD_TAG_BYTES];
+    finishTag(qs, len, expected);
+    qfWipe(&qs, sizeof(qs));
+
+    uint8_t diff = 0;
+    for (size_t i = 0; i < QF_AEAD_TAG_BYTES; i++) diff |= static_cast<uint8_t>(expected[i] ^ tag[i]);
+    if (diff != 0) {
+        qfWipe(start, total);
+        return false;
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Sealed files
+// --------------------------------------------------------------------
+static uint32_t loadLE32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Chunks per window: a few per worker to balance, bounded in memory
+static size_t windowChunks(size_t stride) {
+    size_t perWorkers = size_t(qfScheduler().workerCount()) * 4;
+    return std::max<size_t>(1, std::min(perWorkers, WINDOW_BYTES / stride));
+}
+
+bool qfSealFile(const std::string& inPath, const std::string& outPath, const uint8_t key[QF_AEAD_KEY_BYTES],
+    const QFSealOptions& options, QFSealReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    report = QFSealReport();
+
+    size_t chunk = std::max(options.chunkSize, QF_RATE_BYTES);
+    chunk = (chunk + QF_RATE_BYTES - 1) / QF_RATE_BYTES * QF_RATE_BYTES;
+    if (chunk > MAX_CHUNK) {
+        std::cerr << "[Aead] Chunk size over 1 GiB: " << chunk << "\n";
+        return false;
+    }
+
+    // The output is truncated while the input is still mapped
+    if (qfSameFile(inPath, outPath)) {
+        std::cerr << "[Aead] Input and output are the same file: " << outPath << "\n";
+        return false;
+    }
+    QFMappedFile in;
+    if (!in.open(inPath, true)) {
+        std::cerr << "[Aead] Cannot read " << inPath << "\n";
+        return false;
+    }
+
+    uint8_t header[QF_SEAL_HEADER_BYTES] = { 0 };
+    std::memcpy(header, SEAL_MAGIC, sizeof(SEAL_MAGIC));
+    for (int i = 0; i < 4; i++) header[8 + i] = static_cast<uint8_t>(chunk >> (8 * i));
+    uint8_t* nonce = header + 16;
+    std::random_device rd;
+    for (size_t i = 0; i < QF_AEAD_NONCE_BYTES; i += 4) {
+        uint32_t r = rd();
+        std::memcpy(nonce + i, &r, 4);
+    }
+    QFAead aead(key, header, sizeof(header));
+
+    int fd = qfOpenWrite(outPath);
+    if (fd < 0) {
+        std::cerr << "[Aead] Cannot create " << outPath << "\n";
+        return false;
+    }
+    bool ok = qfWriteAll(fd, header, sizeof(header)) == static_cast<long>(sizeof(header));
+
+    const uint8_t* data = in.data();
+    size_t size = in.size();
+    size_t count = size == 0 ? 1 : (size + chunk - 1) / chunk;
+    size_t stride = chunk + QF_AEAD_TAG_BYTES;
+    size_t window = windowChunks(stride);
+    std::vector<uint8_t> buffer(std::min(window, count) * stride);
+
+    for (size_t first = 0; ok && first < count; first += window) {
+        size_t n = std::min(window, count - first);
+        qfScheduler().parallelFor(n, [&](size_t j) {
+            size_t i = first + j;
+            size_t offset = i * chunk;
+            size_t len = std::min(chunk, size - offset);
+            uint8_t* out = buffer.data() + j * stride;
+            aead.sealChunk(nonce, i, i + 1 == count, data + offset, len, out, out + len);
+        });
+        // Only the last chunk can be short, so the window is contiguous
+        size_t last = first + n - 1;
+        size_t bytes = (n - 1) * stride + std::min(chunk, size - last * chunk) + QF_AEAD_TAG_BYTES;
+        ok = qfWriteAll(fd, buffer.data(), bytes) == static_cast<long>(bytes);
+        AEAD_LOG("sealed chunks " << first << ".." << last);
+    }
+    ok = qfClose(fd) && ok;
+    if (!ok) {
+        std::cerr << "[Aead] Write failed: " << outPath << "\n";
+        std::remove(outPath.c_str());
+        return false;
+    }
+
+    report.bytes = size;
+    report.chunks = count;
+    report.seconds = secondsSince(start);
+    return true;
+}
+
+bool qfOpenSealedFile(const std::string& inPath, const std::string& outPath, const uint8_t key[QF_AEAD_KEY_BYTES],
+    QFSealReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    report = QFSealReport();
+
+    // The output is truncated while the input is still mapped
+    if (qfSameFile(inPath, outPath)) {
+        std::cerr << "[Aead] Input and output are the same file: " << outPath << "\n";
+        return false;
+    }
+    QFMappedFile in;
+    if (!in.open(inPath, true)) {
+        std::cerr << "[Aead] Cannot read " << inPath << "\n";
+        return false;
+    }
+    const uint8_t* data = in.data();
+    size_t size = in.size();
+    if (size < QF_SEAL_HEADER_BYTES || std::memcmp(data, SEAL_MAGIC, sizeof(SEAL_MAGIC)) != 0) {
+        std::cerr << "[Aead] Not a sealed file: " << inPath << "\n";
+        return false;
+    }
+    size_t chunk = loadLE32(data + 8);
+    if (chunk == 0 || chunk % QF_RATE_BYTES != 0 || chunk > MAX_CHUNK) {
+        std::cerr << "[Aead] Bad chunk size " << chunk << " in " << inPath << "\n";
+        return false;
+    }
+
+    // The last chunk holds 0 .. chunk bytes plus its tag
+    size_t stride = chunk + QF_AEAD_TAG_BYTES;
+    size_t body = size - QF_SEAL_HEADER_BYTES;
+    size_t count = (body + stride - 1) / stride;
+    size_t tail = count == 0 ? 0 : body - (count - 1) * stride;
+    if (count == 0 || tail < QF_AEAD_TAG_BYTES) {
+        std::cerr << "[Aead] Truncated sealed file: " << inPath << "\n";
+        return false;
+    }
+    size_t plainSize = (count - 1) * chunk + (tail - QF_AEAD_TAG_BYTES);
+
+    QFAead aead(key, data, QF_SEAL_HEADER_BYTES);
+    const uint8_t* nonce = data + 16;
+    const uint8_t* chunks = data + QF_SEAL_HEADER_BYTES;
+
+    int fd = qfOpenWrite(outPath);
+    if (fd < 0) {
+        std::cerr << "[Aead] Cannot create " << outPath << "\n";
+        return false;
+    }
+    size_t window = windowChunks(stride);
+    std::vector<uint8_t> buffer(std::min(window, count) * chunk);
+    std::vector<uint8_t> verified(std::min(window, count));
+    bool ok = true;
+    bool authentic = true;
+
+    for (size_t first = 0; ok && first < count; first += window) {
+        size_t n = std::min(window, count - first);
+        qfScheduler().parallelFor(n, [&](size_t j) {
+            size_t i = first + j;
+            size_t len = std::min(chunk, plainSize - i * chunk);
+            const uint8_t* in = chunks + i * stride;
+            verified[j] = aead.openChunk(nonce, i, i + 1 == count, in, len, buffer.data() + j * chunk, in + len) ? 1 : 0;
+        });
+        for (size_t j = 0; j < n && authentic; j++) {
+            if (!verified[j]) {
+                authentic = false;
+                report.badChunk = first + j;
+            }
+        }
+        if (!authentic) {
+            ok = false;
+            break;
+        }
+        size_t bytes = std::min(n * chunk, plainSize - first * chunk);
+        ok = qfWriteAll(fd, buffer.data(), bytes) == static_cast<long>(bytes);
+        AEAD_LOG("opened chunks " << first << ".." << first + n - 1);
+    }
+    std::fill(buffer.begin(), buffer.end(), 0);
+    if (!qfClose(fd)) ok = false;
+    if (!ok) {
+        if (!authentic) std::cerr << "[Aead] Chunk " << report.badChunk << " failed authentication: " << inPath << "\n";
+        else std::cerr << "[Aead] Write failed: " << outPath << "\n";
+        std::remove(outPath.c_str());
+        return false;
+    }
+
+    report.bytes = plainSize;
+    report.chunks = count;
+    report.seconds = secondsSince(start);
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Key files
+// --------------------------------------------------------------------
+bool qfLoadKeyFile(const std::string& path, uint8_t key[QF_AEAD_KEY_BYTES]) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "[Aead] Cannot read key file " << path << "\n";
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (text.size() == QF_AEAD_KEY_BYTES) {
+        std::memcpy(key, text.data(), QF_AEAD_KEY_BYTES);
+        qfWipe(&text[0], text.size());
+        return true;
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.pop_back();
+    bool ok = text.size() == 2 * QF_AEAD_KEY_BYTES && qfHexDecode(text.data(), text.size(), key);
+    if (!text.empty()) qfWipe(&text[0], text.size());
+    if (!ok) {
+        std::cerr << "[Aead] Key file must hold 64 hex digits or 32 raw bytes: " << path << "\n";
+        qfWipe(key, QF_AEAD_KEY_BYTES);
+    }
+    return ok;
+}
@@ -0,0 +1,88 @@
+#ifndef AEAD_H
+#define AEAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "QuantumProtection.h"
+
+// --------------------------------------------------------------------
+// Duplex authenticated encryption (SpongeWrap on QFState)
+//   - The key and the associated data are absorbed once into a base
+//     state.  Each chunk copies it and absorbs one framing block (nonce,
+//     chunk index, final flag), so chunks are independent: any of them
+//     can be sealed or opened on its own, in any order or in parallel.
+//   - Payload is duplexed one rate block at a time: ciphertext =
+//     plaintext ^ rate, the ciphertext replaces the rate, one
+//     permutation.  Encryption and authentication share that single
+//     permutation per 128 bytes, the same cost as hashing the payload.
+//   - The last (possibly empty) block is padded 10*1 with a domain byte
+//     in the capacity; the tag is the first 32 rate bytes after one more
+//     permutation.  The final flag in the framing block makes dropping
+//     trailing chunks detectable.
+// --------------------------------------------------------------------
+
+static const size_t QF_AEAD_KEY_BYTES = 32;
+static const size_t QF_AEAD_NONCE_BYTES = 24;
+static const size_t QF_AEAD_TAG_BYTES = 32;
+
+class QFAead {
+public:
+    QFAead(const uint8_t key[QF_AEAD_KEY_BYTES], const uint8_t* ad = nullptr, size_t adLen = 0);
+    ~QFAead();
+
+    QFAead(const QFAead&) = delete;
+    QFAead& operator=(const QFAead&) = delete;
+
+    // in and out may be the same buffer
+    void sealChunk(const uint8_t nonce[QF_AEAD_NONCE_BYTES], uint64_t index, bool final,
+        const uint8_t* in, size_t len, uint8_t* out, uint8_t tag[QF_AEAD_TAG_BYTES]) const;
+
+    // Returns false on a tag mismatch (compared in constant time); out
+    // is then zeroed so unauthenticated plaintext never escapes
+    bool openChunk(const uint8_t nonce[QF_AEAD_NONCE_BYTES], uint64_t index, bool final,
+        const uint8_t* in, size_t len, uint8_t* out, const uint8_t tag[QF_AEAD_TAG_BYTES]) const;
+
+private:
+    void chunkState(QFState& qs, const uint8_t nonce[QF_AEAD_NONCE_BYTES], uint64_t index, bool final) const;
+
+    QFState base;
+};
+
+// --------------------------------------------------------------------
+// Sealed file format
+//   header: "QFSEAL01" | chunk size (u32 LE) | reserved (u32) | nonce (24)
+//   then per chunk: ciphertext (chunk size, the last one shorter and
+//   possibly empty) followed by its 32-byte tag.  The header is the
+//   associated data, so chunk size and nonce cannot be swapped.
+//   Chunk i sits at a fixed offset, so readers can seek to it.
+// --------------------------------------------------------------------
+
+static const size_t QF_SEAL_HEADER_BYTES = 40;
+
+struct QFSealOptions {
+    size_t chunkSize = 1 << 20;   // rounded up to a multiple of the sponge rate
+};
+
+struct QFSealReport {
+    uint64_t bytes = 0;      // plaintext bytes
+    uint64_t chunks = 0;
+    uint64_t badChunk = 0;   // first chunk that failed to open (valid when opening fails on a tag)
+    double seconds = 0.0;
+};
+
+// Chunks are processed on the scheduler in windows of a few per worker
+// and written in order.  Opening writes a window only after all of its
+// chunks verified; on any failure the output file is removed.  The
+// output must not be the input file (refused, as it would be truncated
+// while still being read).
+bool qfSealFile(const std::string& inPath, const std::string& outPath, const uint8_t key[QF_AEAD_KEY_BYTES],
+    const QFSealOptions& options, QFSealReport& report);
+bool qfOpenSealedFile(const std::string& inPath, const std::string& outPath, const uint8_t key[QF_AEAD_KEY_BYTES],
+    QFSealReport& report);
+
+// Key file: 64 hex digits (as the kdf mode prints, trailing whitespace
+// ignored) or exactly 32 raw bytes
+bool qfLoadKeyFile(const std::string& path, uint8_t key[QF_AEAD_KEY_BYTES]);
+
+#endif // AEAD_H
@@ -0,0 +1,495 @@
+#include "Archive.h"
+#include "BufferArena.h"
+#include "FileIO.h"
+#include "Inflate.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// Uncomment to enable debug prints
+// #define ARCHIVE_DEBUG
+
+#ifdef ARCHIVE_DEBUG
+#define ARCHIVE_LOG(msg) std::cerr << "[Archive] " << msg << "\n"
+#else
+#define ARCHIVE_LOG(msg) /* no-op */
+#endif
+
+static const size_t TAR_BLOCK = 512;
+
+static uint64_t loadLE(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// --------------------------------------------------------------------
+// CRC-32 (IEEE, zip), slicing-by-8
+// --------------------------------------------------------------------
+static const uint32_t* crc32Tables() {
+    static uint32_t table[8][256];
+    static const bool ready = []() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int t = 1; t < 8; t++) table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+        }
+        return true;
+    }();
+    (void)ready;
+    return &table[0][0];
+}
+
+uint32_t qfCrc32(uint32_t crc, const uint8_t* p, size_t len) {
+    const uint32_t* t = crc32Tables();
+    crc = ~crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint32_t lo = crc ^ (uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24));
+        crc = t[7 * 256 + (lo & 0xFF)] ^ t[6 * 256 + ((lo >> 8) & 0xFF)]
+            ^ t[5 * 256 + ((lo >> 16) & 0xFF)] ^ t[4 * 256 + (lo >> 24)]
+            ^ t[3 * 256 + p[4]] ^ t[2 * 256 + p[5]] ^ t[1 * 256 + p[6]] ^ t[p[7]];
+    }
+    while (len-- > 0) crc = t[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// --------------------------------------------------------------------
+// tar
+//   The archive is read in arena-sized chunks, each absorbed into the
+//   archive digest as read (digestFile's chunking).  Payloads start on
+//   512-byte boundaries, so every piece handed to a member's sponge is
+//   a multiple of the rate and per-piece absorption matches absorbing
+//   the extracted file in 4 MiB reads.
+// --------------------------------------------------------------------
+namespace {
+
+class TarStream {
+public:
+    TarStream(int fd, QFBufferArena& arena) : in(fd), lease(arena), capacity(arena.bufferSize()) {
+        qfInit(archive);
+    }
+
+    // Hand the next n bytes to fn(ptr, len) in place; false on EOF/error
+    template <typename Fn>
+    bool consume(uint64_t n, Fn fn) {
+        while (n > 0) {
+            if (pos == have && !refill()) return false;
+            size_t take = static_cast<size_t>(std::min<uint64_t>(n, have - pos));
+            fn(lease.data() + pos, take);
+            pos += take;
+            n -= take;
+        }
+        return true;
+    }
+    bool read(uint8_t* dst, size_t n) {
+        return consume(n, [&](const uint8_t* p, size_t len) {
+            std::memcpy(dst, p, len);
+            dst += len;
+        });
+    }
+    // Rest of the stream (end-of-archive padding) still counts toward the
+    // archive digest
+    bool drain() {
+        pos = have;
+        while (refill()) pos = have;
+        return error == 0;
+    }
+
+    QFState archive;
+    long error = 0;
+
+private:
+    bool refill() {
+        if (eof) return false;
+        long n = qfReadFull(in, lease.data(), capacity);
+        if (n < 0) {
+            error = n;
+            eof = true;
+            return false;
+        }
+        processRaw(archive, lease.data(), static_cast<size_t>(n));
+        have = static_cast<size_t>(n);
+        pos = 0;
+        if (have < capacity) eof = true;
+        return have > 0;
+    }
+
+    int in;
+    QFArenaLease lease;
+    size_t capacity;
+    size_t have = 0;
+    size_t pos = 0;
+    bool eof = false;
+};
+
+} // namespace
+
+static uint64_t parseOctal(const uint8_t* p, size_t len) {
+    // GNU base-256 for values that do not fit the octal field
+    if (p[0] & 0x80) {
+        uint64_t v = p[0] & 0x7F;
+        for (size_t i = 1; i < len; i++) v = (v << 8) | p[i];
+        return v;
+    }
+    uint64_t v = 0;
+    size_t i = 0;
+    while (i < len && (p[i] == ' ' || p[i] == 0)) i++;
+    for (; i < len && p[i] >= '0' && p[i] <= '7'; i++) v = (v << 3) | uint64_t(p[i] - '0');
+    return v;
+}
+
+static std::string fieldString(const uint8_t* p, size_t len) {
+    size_t n = 0;
+    while (n < len && p[n] != 0) n++;
+    return std::string(reinterpret_cast<const char*>(p), n);
+}
+
+static bool headerChecksumOk(const uint8_t* h) {
+    uint64_t expected = parseOctal(h + 148, 8);
+    uint64_t sum = 0;
+    int64_t signedSum = 0;
+    for (size_t i = 0; i < TAR_BLOCK; i++) {
+        uint8_t b = (i >= 148 && i < 156) ? uint8_t(' ') : h[i];
+        sum += b;
+        signedSum += static_cast<int8_t>(b);
+    }
+    return sum == expected || static_cast<uint64_t>(signedSum) == expected;
+}
+
+// pax extended header: "<len> key=value\n" records
+static void parsePax(const std::string& data, std::string& path, uint64_t& size, bool& hasSize) {
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t space = data.find(' ', pos);
+        if (space == std::string::npos) break;
+        size_t len = std::strtoull(data.c_str() + pos, nullptr, 10);
+        if (len == 0 || pos + len > data.size()) break;
+        std::string record = data.substr(space + 1, pos + len - space - 2);   // drop '\n'
+        size_t eq = record.find('=');
+        if (eq != std::string::npos) {
+            std::string key = record.substr(0, eq);
+            if (key == "path") path = record.substr(eq + 1);
+            else if (key == "size") {
+                size = std::strtoull(record.c_str() + eq + 1, nullptr, 10);
+                hasSize = true;
+            }
+        }
+        pos += len;
+    }
+}
+
+bool hashTarArchive(const std::string& path, std::vector<QFArchiveMember>& members, QFArchiveReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    members.clear();
+    report = QFArchiveReport();
+    report.format = "tar";
+
+    int fd = (path == "-") ? 0 : qfOpenRead(path);
+    if (fd < 0) {
+        std::cerr << "[Archive] Failed to open " << path << "\n";
+        return false;
+    }
+    TarStream stream(fd, qfIoArena());
+    bool ok = true;
+    std::string longName, paxPath;
+    uint64_t paxSize = 0;
+    bool paxHasSize = false;
+    uint8_t header[TAR_BLOCK];
+
+    while (true) {
+        if (!stream.read(header, TAR_BLOCK)) {
+            // EOF without end-of-archive blocks is tolerated; a read error is not
+            ok = (stream.error == 0);
+            break;
+        }
+        if (std::all_of(header, header + TAR_BLOCK, [](uint8_t b) { return b == 0; })) break;
+        if (!headerChecksumOk(header)) {
+            std::cerr << "[Archive] Bad tar header checksum in " << path << " after "
+                << members.size() << " members\n";
+            ok = false;
+            break;
+        }
+
+        char type = static_cast<char>(header[156]);
+        uint64_t size = parseOctal(header + 124, 12);
+        std::string name = fieldString(header, 100);
+        if (std::memcmp(header + 257, "ustar", 5) == 0 && header[345] != 0) {
+            name = fieldString(header + 345, 155) + "/" + name;
+        }
+        if (!longName.empty()) name = longName;
+        if (!paxPath.empty()) name = paxPath;
+        if (paxHasSize) size = paxSize;
+        uint64_t padded = (size + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+
+        if (type == 'L' || type == 'x') {
+            // Metadata for the next header
+            std::string data;
+            bool got = stream.consume(padded, [&](const uint8_t* p, size_t len) {
+                if (data.size() < size) data.append(reinterpret_cast<const char*>(p),
+                    std::min<size_t>(len, static_cast<size_t>(size - data.size())));
+            });
+            if (!got) {
+                ok = false;
+                break;
+            }
+            if (type == 'L') longName = fieldString(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+            else parsePax(data, paxPath, paxSize, paxHasSize);
+            continue;
+        }
+        longName.clear();
+        paxPath.clear();
+        paxHasSize = false;
+
+        bool regular = (type == '0' || type == '\0' || type == '7');
+        if (!regular) {
+            // Directories, links, devices, global pax headers: skip the payload
+            if (!stream.consume(padded, [](const uint8_t*, size_t) {})) {
+                ok = false;
+                break;
+            }
+            continue;
+        }
+
+        QFArchiveMember member;
+        member.name = name;
+        member.size = size;
+        QFState qs;
+        qfInit(qs);
+        uint64_t left = size;
+        bool got = stream.consume(padded, [&](const uint8_t* p, size_t len) {
+            size_t take = static_cast<size_t>(std::min<uint64_t>(left, len));
+            if (take > 0) processRaw(qs, p, take);
+            left -= take;
+        });
+        if (!got) {
+            std::cerr << "[Archive] Truncated member " << name << " in " << path << "\n";
+            ok = false;
+            break;
+        }
+        qfSqueeze(qs, member.digest.data(), member.digest.size());
+        member.ok = true;
+        report.payloadBytes += size;
+        members.push_back(std::move(member));
+    }
+
+    ok = stream.drain() && ok;
+    if (stream.error != 0) {
+        std::cerr << "[Archive] Read error on " << path << ": "
+            << std::strerror(static_cast<int>(-stream.error)) << "\n";
+    }
+    if (fd != 0) qfClose(fd);
+    qfSqueeze(stream.archive, report.archiveDigest.data(), report.archiveDigest.size());
+    report.members = members.size();
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ARCHIVE_LOG(path << ": " << report.members << " members, " << report.payloadBytes << " bytes");
+    return ok;
+}
+
+// --------------------------------------------------------------------
+// zip
+// --------------------------------------------------------------------
+namespace {
+
+struct ZipEntry {
+    std::string name;
+    uint16_t flags;
+    uint16_t method;
+    uint32_t crc;
+    uint64_t compressedSize;
+    uint64_t size;
+    uint64_t localOffset;
+};
+
+// Reads the (zip64-aware) central directory; false if malformed
+bool readCentralDirectory(const uint8_t* base, size_t size, std::vector<ZipEntry>& entries) {
+    if (size < 22) return false;
+    // End of central directory: last signature within 64 KiB + 22 of the end
+    size_t eocd = SIZE_MAX;
+    size_t lowest = (size > 65557) ? size - 65557 : 0;
+    for (size_t i = size - 22 + 1; i-- > lowest;) {
+        if (loadLE(base + i, 4) == 0x06054b50) {
+            eocd = i;
+            break;
+        }
+    }
+    if (eocd == SIZE_MAX) return false;
+    uint64_t count = loadLE(base + eocd + 10, 2);
+    uint64_t cdSize = loadLE(base + eocd + 12, 4);
+    uint64_t cdOffset = loadLE(base + eocd + 16, 4);
+
+    if (eocd >= 20 && loadLE(base + eocd - 20, 4) == 0x07064b50) {
+        // The zip64 record sits before its locator; compare without
+        // adding to the untrusted offset, which would wrap
+        uint64_t record = loadLE(base + eocd - 20 + 8, 8);
+        uint64_t locator = eocd - 20;
+        if (record > locator || locator - record < 56 || loadLE(base + record, 4) != 0x06064b50) return false;
+        count = loadLE(base + record + 32, 8);
+        cdSize = loadLE(base + record + 40, 8);
+        cdOffset = loadLE(base + record + 48, 8);
+    }
+    if (cdOffset > size || cdSize > size - cdOffset) return false;
+
+    const uint8_t* p = base + cdOffset;
+    const uint8_t* end = p + cdSize;
+    entries.clear();
+    for (uint64_t i = 0; i < count; i++) {
+        if (end - p < 46 || loadLE(p, 4) != 0x02014b50) return false;
+        ZipEntry e;
+        e.flags = static_cast<uint16_t>(loadLE(p + 8, 2));
+        e.method = static_cast<uint16_t>(loadLE(p + 10, 2));
+        e.crc = static_cast<uint32_t>(loadLE(p + 16, 4));
+        e.compressedSize = loadLE(p + 20, 4);
+        e.size = loadLE(p + 24, 4);
+        size_t nameLen = loadLE(p + 28, 2), extraLen = loadLE(p + 30, 2), commentLen = loadLE(p + 32, 2);
+        e.localOffset = loadLE(p + 42, 4);
+        if (static_cast<size_t>(end - p) < 46 + nameLen + extraLen + commentLen) return false;
+        e.name.assign(reinterpret_cast<const char*>(p + 46), nameLen);
+
+        // zip64 extra field: only the values saturated above are present
+        const uint8_t* x = p + 46 + nameLen;
+        const uint8_t* xend = x + extraLen;
+        while (xend - x >= 4) {
+            uint16_t id = static_cast<uint16_t>(loadLE(x, 2));
+            uint16_t len = static_cast<uint16_t>(loadLE(x + 2, 2));
+            if (xend - x - 4 < len) break;
+            if (id == 0x0001) {
+                const uint8_t* v = x + 4;
+                const uint8_t* vend = v + len;
+                if (e.size == 0xFFFFFFFFu && vend - v >= 8) { e.size = loadLE(v, 8); v += 8; }
+                if (e.compressedSize == 0xFFFFFFFFu && vend - v >= 8) { e.compressedSize = loadLE(v, 8); v += 8; }
+                if (e.localOffset == 0xFFFFFFFFu && vend - v >= 8) { e.localOffset = loadLE(v, 8); }
+            }
+            x += 4 + len;
+        }
+        p += 46 + nameLen + extraLen + commentLen;
+        // Local headers precede the central directory
+        if (e.localOffset >= cdOffset || cdOffset - e.localOffset < 30) return false;
+        if (!e.name.empty() && e.name.back() == '/') continue;   // directory
+        entries.push_back(std::move(e));
+    }
+    return true;
+}
+
+} // namespace
+
+bool hashZipArchive(const std::string& path, std::vector<QFArchiveMember>& members, QFArchiveReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    members.clear();
+    report = QFArchiveReport();
+    report.format = "zip";
+
+    QFMappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "[Archive] Failed to open " << path << "\n";
+        return false;
+    }
+    const uint8_t* base = file.data();
+    const size_t size = file.size();
+    std::vector<ZipEntry> entries;
+    if (!readCentralDirectory(base, size, entries)) {
+        std::cerr << "[Archive] No valid zip central directory in " << path << "\n";
+        return false;
+    }
+
+    const size_t chunk = qfIoArena().bufferSize();
+    members.resize(entries.size());
+    std::vector<uint8_t> okFlags(entries.size(), 0);
+
+    // One task per member, plus one for the archive digest
+    qfScheduler().parallelFor(entries.size() + 1, [&](size_t i) {
+        if (i == entries.size()) {
+            QFState qs;
+            qfInit(qs);
+            for (size_t off = 0; off < size; off += chunk) processRaw(qs, base + off, std::min(chunk, size - off));
+            qfSqueeze(qs, report.archiveDigest.data(), report.archiveDigest.size());
+            return;
+        }
+        const ZipEntry& e = entries[i];
+        QFArchiveMember& m = members[i];
+        m.name = e.name;
+        m.size = e.size;
+
+        uint64_t local = e.localOffset;
+        if (local > size || size - local < 30 || loadLE(base + local, 4) != 0x04034b50) {
+            std::cerr << "[Archive] Bad local header for " << e.name << "\n";
+            return;
+        }
+        uint64_t header = 30 + loadLE(base + local + 26, 2) + loadLE(base + local + 28, 2);
+        if (size - local < header || e.compressedSize > size - local - header) {
+            std::cerr << "[Archive] Member " << e.name << " runs past the end of " << path << "\n";
+            return;
+        }
+        if (e.flags & 1) {
+            std::cerr << "[Archive] Member " << e.name << " is encrypted\n";
+            return;
+        }
+
+        QFState qs;
+        qfInit(qs);
+        uint32_t crc = 0;
+        uint64_t produced = 0;
+        const uint8_t* data = base + local + header;
+        bool good;
+        if (e.method == 0) {
+            for (uint64_t off = 0; off < e.compressedSize; off += chunk) {
+                size_t n = static_cast<size_t>(std::min<uint64_t>(chunk, e.compressedSize - off));
+                processRaw(qs, data + off, n);
+                crc = qfCrc32(crc, data + off, n);
+            }
+            produced = e.compressedSize;
+            good = true;
+        }
+        else if (e.method == 8) {
+            good = qfInflate(data, static_cast<size_t>(e.compressedSize), chunk,
+                [&](const uint8_t* p, size_t n) {
+                    processRaw(qs, p, n);
+                    crc = qfCrc32(crc, p, n);
+                }, &produced);
+            if (!good) std::cerr << "[Archive] Corrupt deflate data in " << e.name << "\n";
+        }
+        else {
+            std::cerr << "[Archive] Member " << e.name << " uses unsupported method " << e.method << "\n";
+            return;
+        }
+        if (good && (produced != e.size || crc != e.crc)) {
+            std::cerr << "[Archive] CRC/size mismatch in " << e.name << "\n";
+            good = false;
+        }
+        if (!good) return;
+        qfSqueeze(qs, m.digest.data(), m.digest.size());
+        okFlags[i] = 1;
+    });
+
+    for (size_t i = 0; i < members.size(); i++) {
+        members[i].ok = okFlags[i] != 0;
+        if (members[i].ok) report.payloadBytes += members[i].size;
+        else report.failures++;
+    }
+    report.members = members.size();
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ARCHIVE_LOG(path << ": " << report.members << " members, " << report.failures << " failures");
+    return true;
+}
+
+bool hashArchive(const std::string& path, std::vector<QFArchiveMember>& members, QFArchiveReport& report) {
+    if (path != "-") {
+        int fd = qfOpenRead(path);
+        if (fd < 0) {
+            std::cerr << "[Archive] Failed to open " << path << "\n";
+            return false;
+        }
+        uint8_t magic[4] = { 0 };
+        long n = qfReadFull(fd, magic, sizeof(magic));
+        qfClose(fd);
+        if (n == 4 && magic[0] == 'P' && magic[1] == 'K'
+            && ((magic[2] == 3 && magic[3] == 4) || (magic[2] == 5 && magic[3] == 6))) {
+            return hashZipArchive(path, members, report);
+        }
+    }
+    return hashTarArchive(path, members, report);
+}
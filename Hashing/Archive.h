@@ -0,0 +1,51 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Per-member digests of tar and zip archives, without extracting
+//   - tar: one sequential pass over a file or a pipe ("-" = stdin);
+//     ustar, GNU long names and pax path/size records are understood.
+//     Each regular member's payload is absorbed into its own digest as
+//     it streams past (compressed tars: pipe through zcat).
+//   - zip: the central directory gives every member's offset, so
+//     members are hashed in parallel on the scheduler straight from a
+//     mapping; stored and deflated members are supported, and each is
+//     checked against its CRC-32.
+//   - Member digests equal digestFile() of the extracted file; the
+//     archive digest equals digestFile() of the archive itself.
+// --------------------------------------------------------------------
+
+struct QFArchiveMember {
+    std::string name;
+    uint64_t size = 0;      // uncompressed payload bytes
+    QFDigest digest{};
+    bool ok = false;        // false: unsupported method, CRC mismatch, corrupt data
+};
+
+struct QFArchiveReport {
+    std::string format;     // "tar" or "zip"
+    uint64_t members = 0;
+    uint64_t payloadBytes = 0;
+    uint64_t failures = 0;
+    QFDigest archiveDigest{};
+    double seconds = 0.0;
+};
+
+// Regular-file members in archive order.  Returns false (after logging)
+// if the archive itself cannot be read or parsed; per-member problems
+// only clear that member's ok flag.
+bool hashTarArchive(const std::string& path, std::vector<QFArchiveMember>& members, QFArchiveReport& report);
+bool hashZipArchive(const std::string& path, std::vector<QFArchiveMember>& members, QFArchiveReport& report);
+
+// IEEE CRC-32 as used by zip and gzip; chain calls starting from 0
+uint32_t qfCrc32(uint32_t crc, const uint8_t* data, size_t len);
+
+// Picks tar or zip from the leading bytes ("-" is always tar)
+bool hashArchive(const std::string& path, std::vector<QFArchiveMember>& members, QFArchiveReport& report);
+
+#endif // ARCHIVE_H
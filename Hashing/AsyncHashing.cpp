@@ -0,0 +1,507 @@
+#include "AsyncHashing.h"
+#include "FileIO.h"
+#include "IoUring.h"
+#include "UniversalData.h"
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+// Uncomment to enable debug prints
+// #define ASYNC_DEBUG
+
+#ifdef ASYNC_DEBUG
+#define ASYNC_LOG(msg) std::cerr << "[AsyncHashing] " << msg << "\n"
+#else
+#define ASYNC_LOG(msg) /* no-op */
+#endif
+
+// --------------------------------------------------------------------
+// Backend interface (one per QFIoContext)
+// --------------------------------------------------------------------
+struct QFIoContext::Backend {
+    virtual ~Backend() = default;
+    virtual void submit(int fd, void* buf, size_t len, int64_t offset, Completion done) = 0;
+    // timeoutMs: 0 = don't block, -1 = forever
+    virtual size_t reap(int timeoutMs) = 0;
+    virtual size_t pending() const = 0;
+    virtual int notifyFd() const = 0;
+    virtual const char* name() const = 0;
+};
+
+namespace {
+
+struct PendingRead {
+    int fd;
+    void* buf;
+    size_t len;
+    int64_t offset;
+    QFIoContext::Completion done;
+};
+
+// --------------------------------------------------------------------
+// 1) Synchronous queue: reads execute inside reap().
+//    Used on non-Linux platforms.
+// --------------------------------------------------------------------
+class SyncBackend : public QFIoContext::Backend {
+public:
+    void submit(int fd, void* buf, size_t len, int64_t offset, QFIoContext::Completion done) override {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            queue.push_back(PendingRead{ fd, buf, len, offset, std::move(done) });
+        }
+        wake.notify_one();
+    }
+
+    size_t reap(int timeoutMs) override {
+        std::deque<PendingRead> batch;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            if (queue.empty() && timeoutMs != 0) {
+                auto ready = [this]() { return !queue.empty(); };
+                if (timeoutMs < 0) wake.wait(guard, ready);
+                else wake.wait_for(guard, std::chrono::milliseconds(timeoutMs), ready);
+            }
+            batch.swap(queue);
+            inFlight += batch.size();
+        }
+        for (PendingRead& r : batch) {
+            long n = qfReadAt(r.fd, r.buf, r.len, r.offset);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                inFlight--;
+            }
+            r.done(n);
+        }
+        return batch.size();
+    }
+
+    size_t pending() const override {
+        std::lock_guard<std::mutex> guard(lock);
+        return queue.size() + inFlight;
+    }
+    int notifyFd() const override { return -1; }
+    const char* name() const override { return "sync"; }
+
+private:
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    std::deque<PendingRead> queue;
+    size_t inFlight = 0;
+};
+
+#if defined(__linux__)
+// --------------------------------------------------------------------
+// 2) epoll reactor: regular files are always "ready" and are read when
+//    the eventfd fires, with a blocking pread on the reaping thread (the
+//    synchronous path: epoll cannot wait for disk I/O).  Pipes and
+//    sockets wait for EPOLLIN first; a stream fd stays in the epoll set
+//    only while reads are queued for it, so closing it afterwards (or
+//    reusing its number) cannot leave a stale registration behind.
+// --------------------------------------------------------------------
+class ReactorBackend : public QFIoContext::Backend {
+public:
+    bool init() {
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || eventFd < 0) return false;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = eventFd;
+        return ::epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &ev) == 0;
+    }
+
+    ~ReactorBackend() override {
+        if (eventFd >= 0) ::close(eventFd);
+        if (epollFd >= 0) ::close(epollFd);
+    }
+
+    void submit(int fd, void* buf, size_t len, int64_t offset, QFIoContext::Completion done) override {
+        struct stat st;
+        bool streamFd = (::fstat(fd, &st) == 0) && !S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode);
+
+        std::lock_guard<std::mutex> guard(lock);
+        count++;
+        if (streamFd) {
+            std::deque<PendingRead>& waiting = streams[fd];
+            waiting.push_back(PendingRead{ fd, buf, len, offset, std::move(done) });
+            if (waiting.size() == 1 && armStream(fd, EPOLL_CTL_ADD)) return;
+            if (waiting.size() > 1) return;
+            // epoll refused the descriptor: treat it like a regular file
+            ready.push_back(std::move(waiting.front()));
+            streams.erase(fd);
+        }
+        else {
+            ready.push_back(PendingRead{ fd, buf, len, offset, std::move(done) });
+        }
+        uint64_t one = 1;
+        ssize_t ignored = ::write(eventFd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    size_t reap(int timeoutMs) override {
+        size_t handled = runReady();
+        if (handled > 0) return handled;
+
+        epoll_event events[16];
+        int n = ::epoll_wait(epollFd, events, 16, timeoutMs);
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == eventFd) {
+                uint64_t counter;
+                ssize_t ignored = ::read(eventFd, &counter, sizeof(counter));
+                (void)ignored;
+                continue;
+            }
+            PendingRead r;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                auto it = streams.find(fd);
+                if (it == streams.end() || it->second.empty()) continue;
+                r = std::move(it->second.front());
+                it->second.pop_front();
+                if (it->second.empty()) {
+                    streams.erase(it);
+                    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                }
+                else armStream(fd, EPOLL_CTL_MOD);
+                count--;
+            }
+            r.done(qfReadAt(r.fd, r.buf, r.len, -1));
+            handled++;
+        }
+        return handled + runReady();
+    }
+
+    size_t pending() const override {
+        std::lock_guard<std::mutex> guard(lock);
+        return count;
+    }
+    int notifyFd() const override { return epollFd; }
+    const char* name() const override { return "epoll"; }
+
+private:
+    // Caller holds the lock.  ADD for the first queued read, MOD to
+    // re-arm the one-shot registration for the next
+    bool armStream(int fd, int op) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.fd = fd;
+        return ::epoll_ctl(epollFd, op, fd, &ev) == 0;
+    }
+
+    size_t runReady() {
+        std::deque<PendingRead> batch;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            batch.swap(ready);
+        }
+        for (PendingRead& r : batch) {
+            long n = qfReadAt(r.fd, r.buf, r.len, r.offset);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                count--;
+            }
+            r.done(n);
+        }
+        return batch.size();
+    }
+
+    int epollFd = -1;
+    int eventFd = -1;
+    mutable std::mutex lock;
+    std::deque<PendingRead> ready;
+    std::unordered_map<int, std::deque<PendingRead>> streams;
+    size_t count = 0;
+};
+#endif // __linux__
+
+#if defined(QF_HAVE_IO_URING)
+// --------------------------------------------------------------------
+// 3) io_uring (see IoUring.h).
+//    Completions signal a registered eventfd, which is also what an
+//    external event loop should watch.
+// --------------------------------------------------------------------
+class UringBackend : public QFIoContext::Backend {
+public:
+    bool init(unsigned depth) {
+        if (!ring.init(depth, true)) return false;
+        // Plain IORING_OP_READ with offset -1 needs 5.6+ (RW_CUR_POS)
+        return (ring.features() & IORING_FEAT_RW_CUR_POS) != 0;
+    }
+
+    void submit(int fd, void* buf, size_t len, int64_t offset, QFIoContext::Completion done) override {
+        std::lock_guard<std::mutex> guard(lock);
+        uint64_t id = nextId++;
+        ops.emplace(id, std::move(done));
+        // Never exceed the CQ size with reads in flight; park the rest
+        if (inFlight >= ring.cqEntries() || !ring.prepRead(fd, buf, len, offset, id)) {
+            overflow.push_back(PendingRead{ fd, buf, len, offset, nullptr });
+            overflowIds.push_back(id);
+            return;
+        }
+        inFlight++;
+        ring.submit();
+    }
+
+    size_t reap(int timeoutMs) override {
+        size_t handled = drain();
+        if (handled > 0 || timeoutMs == 0) return handled;
+        // Completions bump the registered eventfd
+        pollfd pfd{ ring.eventFd(), POLLIN, 0 };
+        ::poll(&pfd, 1, timeoutMs);
+        return drain();
+    }
+
+    size_t pending() const override {
+        std::lock_guard<std::mutex> guard(lock);
+        return ops.size();
+    }
+    int notifyFd() const override { return ring.eventFd(); }
+    const char* name() const override { return "io_uring"; }
+
+private:
+    size_t drain() {
+        std::vector<std::pair<QFIoContext::Completion, long>> finished;
+        // Reset the eventfd before scanning so a completion posted while we
+        // scan still leaves it readable for the next reap()
+        uint64_t counter;
+        ssize_t ignored = ::read(ring.eventFd(), &counter, sizeof(counter));
+        (void)ignored;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ring.drain([&](uint64_t id, int res) {
+                auto it = ops.find(id);
+                if (it != ops.end()) {
+                    finished.emplace_back(std::move(it->second), static_cast<long>(res));
+                    ops.erase(it);
+                }
+                inFlight--;
+            });
+
+            // Move parked reads into the ring now that slots are free
+            unsigned pushed = 0;
+            while (!overflow.empty() && inFlight < ring.cqEntries()) {
+                const PendingRead& r = overflow.front();
+                if (!ring.prepRead(r.fd, r.buf, r.len, r.offset, overflowIds.front())) break;
+                overflow.pop_front();
+                overflowIds.pop_front();
+                inFlight++;
+                pushed++;
+            }
+            if (pushed > 0) ring.submit();
+        }
+        for (auto& f : finished) f.first(f.second);
+        return finished.size();
+    }
+
+    QFUring ring;
+    mutable std::mutex lock;
+    std::unordered_map<uint64_t, QFIoContext::Completion> ops;
+    std::deque<PendingRead> overflow;
+    std::deque<uint64_t> overflowIds;
+    uint64_t nextId = 1;
+    unsigned inFlight = 0;
+};
+#endif // QF_HAVE_IO_URING
+
+} // namespace
+
+// --------------------------------------------------------------------
+// QFIoContext: pick the best backend the platform allows
+// --------------------------------------------------------------------
+QFIoContext::QFIoContext(unsigned queueDepth, QFIoBackend backend) {
+    if (backend == QFIoBackend::Sync) {
+        impl.reset(new SyncBackend());
+    }
+#if defined(QF_HAVE_IO_URING)
+    if (!impl && (backend == QFIoBackend::Auto || backend == QFIoBackend::Uring)) {
+        std::unique_ptr<UringBackend> uring(new UringBackend());
+        if (uring->init(queueDepth)) {
+            impl = std::move(uring);
+        }
+    }
+#endif
+#if defined(__linux__)
+    if (!impl) {
+        std::unique_ptr<ReactorBackend> reactor(new ReactorBackend());
+        if (reactor->init()) {
+            impl = std::move(reactor);
+        }
+    }
+#endif
+    if (!impl) {
+        impl.reset(new SyncBackend());
+    }
+    (void)queueDepth;
+    ASYNC_LOG("QFIoContext backend: " << impl->name());
+}
+
+QFIoContext::~QFIoContext() = default;
+
+void QFIoContext::submitRead(int fd, void* buf, size_t len, int64_t offset, Completion done) {
+    impl->submit(fd, buf, len, offset, std::move(done));
+}
+
+size_t QFIoContext::poll() { return impl->reap(0); }
+size_t QFIoContext::runOne(int timeoutMs) { return impl->reap(timeoutMs); }
+size_t QFIoContext::pending() const { return impl->pending(); }
+int QFIoContext::notifyFd() const { return impl->notifyFd(); }
+const char* QFIoContext::backendName() const { return impl->name(); }
+
+// --------------------------------------------------------------------
+// QFReadOp
+// --------------------------------------------------------------------
+static char readDoneTag;
+static void* const READ_DONE = &readDoneTag;
+
+void QFReadOp::start(QFIoContext& ioCtx, int readFd, uint8_t* readBuf, size_t readLen, int64_t readOffset) {
+    io = &ioCtx;
+    fd = readFd;
+    buf = readBuf;
+    len = readLen;
+    got = 0;
+    offset = readOffset;
+    result = 0;
+    waiter.store(nullptr, std::memory_order_relaxed);
+    io->submitRead(fd, buf, len, offset, [this](long n) { onChunk(n); });
+}
+
+void QFReadOp::onChunk(long n) {
+    if (n == -EAGAIN || n == -EINTR) {
+        n = -EAGAIN; // spurious wakeup: re-issue the same range
+    }
+    else if (n > 0) {
+        got += static_cast<size_t>(n);
+    }
+
+    if (n == -EAGAIN || (n > 0 && got < len)) {
+        int64_t next = (offset >= 0) ? offset + static_cast<int64_t>(got) : -1;
+        io->submitRead(fd, buf + got, len - got, next, [this](long m) { onChunk(m); });
+        return;
+    }
+    // n < 0 => error, otherwise the buffer is full or we hit EOF
+    result = (n < 0) ? n : static_cast<long>(got);
+
+    void* prev = waiter.exchange(READ_DONE, std::memory_order_acq_rel);
+    if (prev != nullptr) {
+        std::coroutine_handle<>::from_address(prev).resume();
+    }
+}
+
+bool QFReadOp::await_ready() const noexcept {
+    return waiter.load(std::memory_order_acquire) == READ_DONE;
+}
+
+bool QFReadOp::await_suspend(std::coroutine_handle<> h) noexcept {
+    void* expected = nullptr;
+    // false => the read finished in the meantime, resume immediately
+    return waiter.compare_exchange_strong(expected, h.address(), std::memory_order_acq_rel);
+}
+
+// --------------------------------------------------------------------
+// processFdAsync
+//   - Two buffers: chunk k+1 is read while chunk k is absorbed.
+//   - Every absorbed chunk is full (a multiple of the rate) except the
+//     last one, so the digest equals the synchronous processFile().
+// --------------------------------------------------------------------
+QFTask<bool> processFdAsync(QFIoContext& io, QFState& qs, int fd, QFExecutor* executor, size_t chunkSize) {
+    const size_t rateBytes = 128;
+    chunkSize = (chunkSize < rateBytes) ? rateBytes : (chunkSize / rateBytes) * rateBytes;
+
+    int64_t offset = qfTell(fd); // -1 for pipes/sockets => sequential reads
+    std::vector<uint8_t> buffers[2] = { std::vector<uint8_t>(chunkSize), std::vector<uint8_t>(chunkSize) };
+    QFReadOp ops[2];
+    int cur = 0;
+
+    ops[cur].start(io, fd, buffers[cur].data(), chunkSize, offset);
+    while (true) {
+        QFReadOp& op = ops[cur];
+        long n = co_await op;
+        if (n < 0) {
+            std::cerr << "[processFdAsync] Read error: " << std::strerror(static_cast<int>(-n)) << "\n";
+            co_return false;
+        }
+        if (n == 0) break;
+
+        bool eof = static_cast<size_t>(n) < chunkSize;
+        if (offset >= 0) offset += n;
+        if (!eof) {
+            // Keep the device busy while we permute
+            ops[cur ^ 1].start(io, fd, buffers[cur ^ 1].data(), chunkSize, offset);
+        }
+
+        co_await qfScheduleOn(executor);
+        processRaw(qs, buffers[cur].data(), static_cast<size_t>(n));
+
+        if (eof) break;
+        cur ^= 1;
+    }
+
+    // Leave the descriptor positioned after what we consumed
+    if (offset >= 0) qfSeek(fd, offset);
+    co_return true;
+}
+
+QFTask<bool> processFileAsync(QFIoContext& io, QFState& qs, const std::string& filename,
+    QFExecutor* executor, size_t chunkSize) {
+    int fd = qfOpenRead(filename);
+    if (fd < 0) {
+        std::cerr << "[processFileAsync] Failed to open file: " << filename << "\n";
+        co_return false;
+    }
+    struct FdCloser {
+        int fd;
+        ~FdCloser() { qfClose(fd); }
+    } closer{ fd };
+
+    bool ok = co_await processFdAsync(io, qs, fd, executor, chunkSize);
+    co_return ok;
+}
+
+QFTask<bool> qfHashFileAsync(QFIoContext& io, const std::string& filename,
+    uint8_t* out, size_t outLen, QFExecutor* executor) {
+    QFState qs;
+    qfInit(qs);
+    bool ok = co_await processFileAsync(io, qs, filename, executor);
+    if (ok) {
+        qfSqueeze(qs, out, outLen);
+    }
+    co_return ok;
+}
+
+// --------------------------------------------------------------------
+// QFAsyncHasher
+// --------------------------------------------------------------------
+QFAsyncHasher::QFAsyncHasher(QFIoContext& ioCtx, QFExecutor* exec)
+    : io(ioCtx), executor(exec) {
+    qfInit(qs);
+}
+
+QFTask<bool> QFAsyncHasher::updateAsync(int fd, size_t chunkSize) {
+    return processFdAsync(io, qs, fd, executor, chunkSize);
+}
+
+void QFAsyncHasher::update(const uint8_t* data, size_t len) {
+    processRaw(qs, data, len);
+}
+
+void QFAsyncHasher::finalize(uint8_t* out, size_t outLen) const {
+    qfSqueeze(qs, out, outLen);
+}
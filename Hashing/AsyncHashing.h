@@ -0,0 +1,289 @@
+#ifndef ASYNC_HASHING_H
+#define ASYNC_HASHING_H
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include "QuantumProtection.h"
+
+// --------------------------------------------------------------------
+// Awaitable (C++20 coroutine) hashing API.
+//
+// The synchronous processFile() blocks its caller for the whole read.
+// The functions here suspend on I/O completion instead, so a service
+// running an event loop can interleave hashing with request handling:
+//
+//     QFIoContext io;                       // owned by the event loop
+//     bool ok = co_await processFileAsync(io, qs, "big.img");
+//
+// Reads are submitted to QFIoContext, which uses io_uring on Linux when
+// the kernel allows it, an epoll/eventfd reactor otherwise, and a plain
+// synchronous queue on other platforms.  Completions are delivered from
+// QFIoContext::poll()/runOne(), i.e. on the thread driving the loop.
+// epoll cannot wait for disk reads, so on the epoll backend regular
+// files and block devices take the synchronous path: each read is a
+// blocking pread on the loop thread inside poll().  Only pipes and
+// sockets actually wait for readiness there.
+// The permutation work runs on an optional QFExecutor; with no executor
+// it runs inline on the loop thread.
+// --------------------------------------------------------------------
+
+// Default read size for the async file path (a multiple of the 128-byte
+// rate, so digests match processFile()).
+static const size_t QF_ASYNC_CHUNK_SIZE = 256 * 1024;
+
+// --------------------------------------------------------------------
+// QFExecutor
+//   - Where CPU-bound absorb work is resumed.  Implement post() with
+//     your own loop or thread pool.
+// --------------------------------------------------------------------
+class QFExecutor {
+public:
+    virtual ~QFExecutor() = default;
+    virtual void post(std::function<void()> fn) = 0;
+};
+
+// Backend selection for QFIoContext; a forced backend the platform
+// cannot provide falls back to the Auto order (check backendName())
+enum class QFIoBackend { Auto, Uring, Epoll, Sync };
+
+// --------------------------------------------------------------------
+// QFIoContext
+//   - Asynchronous read submission and completion reaping.
+//   - submitRead() is thread-safe; poll()/runOne() must be called from
+//     one thread (the event loop).
+//   - notifyFd() becomes readable when poll() has work to do, so it can
+//     be added to an existing epoll/select loop (-1 if unsupported).
+// --------------------------------------------------------------------
+class QFIoContext {
+public:
+    // Completion callback: bytes read (0 at EOF) or a negative errno.
+    using Completion = std::function<void(long)>;
+
+    explicit QFIoContext(unsigned queueDepth = 64, QFIoBackend backend = QFIoBackend::Auto);
+    ~QFIoContext();
+
+    QFIoContext(const QFIoContext&) = delete;
+    QFIoContext& operator=(const QFIoContext&) = delete;
+
+    // offset < 0 reads from the current file position (pipes, sockets)
+    void submitRead(int fd, void* buf, size_t len, int64_t offset, Completion done);
+
+    // Reap completions without blocking; returns the number handled.
+    size_t poll();
+
+    // Block up to timeoutMs (-1 = forever) for at least one completion.
+    size_t runOne(int timeoutMs = -1);
+
+    // Number of submitted reads that have not completed yet
+    size_t pending() const;
+
+    int notifyFd() const;
+    const char* backendName() const;
+
+    struct Backend;
+private:
+    std::unique_ptr<Backend> impl;
+};
+
+// --------------------------------------------------------------------
+// QFTask<T>
+//   - Lazily started coroutine result.  co_await it from another
+//     coroutine, or drive it from plain code with qfRunSync().
+// --------------------------------------------------------------------
+template <typename T>
+class QFTask {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+        std::atomic<bool> finished{ false };
+
+        QFTask get_return_object() {
+            return QFTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                std::coroutine_handle<> next = h.promise().continuation;
+                h.promise().finished.store(true, std::memory_order_release);
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_value(T v) { value = std::move(v); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    QFTask() = default;
+    QFTask(QFTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    QFTask& operator=(QFTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    QFTask(const QFTask&) = delete;
+    QFTask& operator=(const QFTask&) = delete;
+    ~QFTask() { if (handle) handle.destroy(); }
+
+    // Awaiting from another coroutine (symmetric transfer)
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() { return result(); }
+
+    // Driving from non-coroutine code
+    void start() { if (handle && !handle.done()) handle.resume(); }
+    bool done() const {
+        return !handle || handle.promise().finished.load(std::memory_order_acquire);
+    }
+    T result() {
+        if (handle.promise().error) std::rethrow_exception(handle.promise().error);
+        return std::move(*handle.promise().value);
+    }
+
+private:
+    explicit QFTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+// --------------------------------------------------------------------
+// QFDetached
+//   - Fire-and-forget coroutine, used by qfSpawn().
+// --------------------------------------------------------------------
+struct QFDetached {
+    struct promise_type {
+        QFDetached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Start a task from the event loop and hand its result to onDone.
+template <typename T, typename F>
+QFDetached qfSpawn(QFTask<T> task, F onDone) {
+    onDone(co_await task);
+}
+
+// Run a task to completion, driving the I/O context on this thread.
+template <typename T>
+T qfRunSync(QFIoContext& io, QFTask<T>& task) {
+    task.start();
+    while (!task.done()) {
+        // Short timeout: the task may be parked on an executor, not on I/O
+        io.runOne(1);
+    }
+    return task.result();
+}
+
+// --------------------------------------------------------------------
+// Awaitables
+// --------------------------------------------------------------------
+
+// co_await qfScheduleOn(exec) resumes the coroutine on exec
+// (no-op for a null executor).
+struct QFScheduleAwaiter {
+    QFExecutor* executor;
+    bool await_ready() const noexcept { return executor == nullptr; }
+    void await_suspend(std::coroutine_handle<> h) {
+        executor->post([h]() { h.resume(); });
+    }
+    void await_resume() const noexcept {}
+};
+inline QFScheduleAwaiter qfScheduleOn(QFExecutor* executor) { return QFScheduleAwaiter{ executor }; }
+
+// --------------------------------------------------------------------
+// QFReadOp
+//   - A read that can be started now and awaited later, so the next
+//     chunk is in flight while the current one is absorbed.
+//   - Keeps reading until len bytes or EOF (short reads are retried),
+//     which keeps every absorbed chunk a multiple of the rate.
+// --------------------------------------------------------------------
+class QFReadOp {
+public:
+    QFReadOp() = default;
+    QFReadOp(const QFReadOp&) = delete;
+    QFReadOp& operator=(const QFReadOp&) = delete;
+
+    void start(QFIoContext& io, int fd, uint8_t* buf, size_t len, int64_t offset);
+
+    bool await_ready() const noexcept;
+    bool await_suspend(std::coroutine_handle<> h) noexcept;
+    // Total bytes read (short only at EOF) or a negative errno
+    long await_resume() const noexcept { return result; }
+
+private:
+    void onChunk(long n);
+
+    QFIoContext* io = nullptr;
+    int fd = -1;
+    uint8_t* buf = nullptr;
+    size_t len = 0;
+    size_t got = 0;
+    int64_t offset = 0;
+    long result = 0;
+    // nullptr = running, DONE = finished, otherwise the waiting coroutine
+    std::atomic<void*> waiter{ nullptr };
+};
+
+// --------------------------------------------------------------------
+// Async counterparts of processFile()
+// --------------------------------------------------------------------
+
+// Absorb an open descriptor until EOF; returns false on read error.
+// Offsets are used when the descriptor is seekable, otherwise reads are
+// sequential (pipes, sockets).
+QFTask<bool> processFdAsync(QFIoContext& io, QFState& qs, int fd,
+    QFExecutor* executor = nullptr, size_t chunkSize = QF_ASYNC_CHUNK_SIZE);
+
+// Same digest as processFile(qs, filename) for the same file.
+QFTask<bool> processFileAsync(QFIoContext& io, QFState& qs, const std::string& filename,
+    QFExecutor* executor = nullptr, size_t chunkSize = QF_ASYNC_CHUNK_SIZE);
+
+// One-shot: qfInit + processFileAsync + qfSqueeze into out[0..outLen).
+QFTask<bool> qfHashFileAsync(QFIoContext& io, const std::string& filename,
+    uint8_t* out, size_t outLen, QFExecutor* executor = nullptr);
+
+// --------------------------------------------------------------------
+// QFAsyncHasher
+//   - Incremental hasher over several sources:
+//       QFAsyncHasher h(io);
+//       co_await h.updateAsync(sockFd);
+//       h.update(trailer, n);
+//       h.finalize(digest, 64);
+// --------------------------------------------------------------------
+class QFAsyncHasher {
+public:
+    explicit QFAsyncHasher(QFIoContext& io, QFExecutor* executor = nullptr);
+
+    QFTask<bool> updateAsync(int fd, size_t chunkSize = QF_ASYNC_CHUNK_SIZE);
+    void update(const uint8_t* data, size_t len);
+    void finalize(uint8_t* out, size_t outLen) const;
+
+    const QFState& state() const { return qs; }
+
+private:
+    QFIoContext& io;
+    QFExecutor* executor;
+    QFState qs;
+};
+
+#endif // ASYNC_HASHING_H
@@ -0,0 +1,2152 @@
+#include "Benchmark.h"
+#include "Aead.h"
+#include "Archive.h"
+#include "AsyncHashing.h"
+#include "BloomFilter.h"
+#include "Delta.h"
+#include "BufferArena.h"
+#include "Dupes.h"
+#include "Encoding.h"
+#include "FileIO.h"
+#include "Kdf.h"
+#include "Keystream.h"
+#include "ManifestDiff.h"
+#include "MerkleLog.h"
+#include "MultiHash.h"
+#include "MultisetHash.h"
+#include "QuantumProtection.h"
+#include "Routing.h"
+#include "Scrubber.h"
+#include "Sketches.h"
+#include "SmallFiles.h"
+#include "TaskScheduler.h"
+#include "TreeDigest.h"
+#include "Watch.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#if defined(_WIN32)
+#include <fcntl.h>   // for _O_BINARY
+#include <io.h>      // for _pipe
+#else
+#include <unistd.h>  // for pipe
+#endif
+
+// --------------------------------------------------------------------
+// Small helpers shared by the benchmarks
+// --------------------------------------------------------------------
+static double nowSeconds() {
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+static unsigned long long argOr(const std::vector<std::string>& args, size_t index,
+    unsigned long long fallback) {
+    if (index >= args.size()) return fallback;
+    return std::strtoull(args[index].c_str(), nullptr, 10);
+}
+
+static void hashBuffer(const uint8_t* data, size_t len, uint8_t* digest) {
+    QFState qs;
+    qfInit(qs);
+    qfAbsorb(qs, data, len);
+    qfSqueeze(qs, digest, 64);
+}
+
+// --------------------------------------------------------------------
+// 1) scheduler [maxThreads=64] [totalMiB=32]
+//    - Hashes a synthetic corpus of mixed file sizes (70% 4-64 KiB,
+//      25% 64 KiB-1 MiB, 5% 1-8 MiB) as bulk tasks, one task per file,
+//      for 1, 2, 4, ... maxThreads workers.
+//    - While each scan runs, a probe thread submits small interactive
+//      jobs and records their queueing latency.
+//    - Checks that a throwing task reaches the caller of parallelFor /
+//      wait() and leaves the pool usable.
+// --------------------------------------------------------------------
+static int benchScheduler(const std::vector<std::string>& args) {
+    unsigned maxThreads = static_cast<unsigned>(argOr(args, 0, 64));
+    size_t totalBytes = static_cast<size_t>(argOr(args, 1, 32)) << 20;
+
+    std::mt19937_64 rng(42);
+    std::vector<size_t> sizes;
+    size_t sum = 0;
+    while (sum < totalBytes) {
+        unsigned bucket = static_cast<unsigned>(rng() % 100);
+        size_t size;
+        if (bucket < 70)      size = 4096 + rng() % (60 * 1024);
+        else if (bucket < 95) size = (64 << 10) + rng() % (960 << 10);
+        else                  size = (1 << 20) + rng() % (7 << 20);
+        sizes.push_back(size);
+        sum += size;
+    }
+    size_t largest = *std::max_element(sizes.begin(), sizes.end());
+    std::vector<uint8_t> corpus(largest);
+    for (size_t i = 0; i < corpus.size(); i++) corpus[i] = static_cast<uint8_t>(rng());
+
+    std::cout << "[Bench] scheduler: " << sizes.size() << " files, "
+        << (sum >> 20) << " MiB, hardware threads = "
+        << std::thread::hardware_concurrency() << "\n";
+    std::printf("%8s %10s %10s %8s %8s %10s %12s\n",
+        "threads", "seconds", "MiB/s", "speedup", "effic.", "steals", "p99 inter.");
+
+    double baseline = 0.0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        QFScheduler scheduler(threads);
+
+        std::atomic<bool> scanning{ true };
+        std::vector<double> latencies;
+        std::mutex latencyLock;
+        std::thread probe([&]() {
+            uint8_t small[1024] = { 0 };
+            while (scanning.load()) {
+                double submitted = nowSeconds();
+                std::atomic<bool> done{ false };
+                scheduler.submit([&]() {
+                    uint8_t digest[64];
+                    hashBuffer(small, sizeof(small), digest);
+                    std::lock_guard<std::mutex> guard(latencyLock);
+                    latencies.push_back(nowSeconds() - submitted);
+                    done.store(true);
+                }, QFTaskPriority::Interactive);
+                while (!done.load()) std::this_thread::yield();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        double start = nowSeconds();
+        {
+            QFTaskGroup group(scheduler);
+            for (size_t size : sizes) {
+                group.run([&corpus, size]() {
+                    uint8_t digest[64];
+                    hashBuffer(corpus.data(), size, digest);
+                });
+            }
+            group.wait();
+        }
+        double elapsed = nowSeconds() - start;
+        scanning.store(false);
+        probe.join();
+
+        if (threads == 1) baseline = elapsed;
+        double p99 = 0.0;
+        if (!latencies.empty()) {
+            std::sort(latencies.begin(), latencies.end());
+            p99 = latencies[std::min(latencies.size() - 1, (latencies.size() * 99) / 100)];
+        }
+        QFSchedulerStats st = scheduler.stats();
+        double speedup = baseline / elapsed;
+        std::printf("%8u %10.3f %10.1f %8.2f %7.0f%% %10llu %10.3fms\n",
+            threads, elapsed, (sum / 1048576.0) / elapsed, speedup,
+            100.0 * speedup / threads, static_cast<unsigned long long>(st.stolen), p99 * 1e3);
+    }
+
+    QFScheduler scheduler(2);
+    std::atomic<size_t> ran{ 0 };
+    bool caught = false;
+    try {
+        scheduler.parallelFor(64, [&ran](size_t i) {
+            ran++;
+            if (i == 17) throw std::runtime_error("task 17");
+        });
+    }
+    catch (const std::runtime_error&) {
+        caught = true;
+    }
+    std::atomic<size_t> after{ 0 };
+    scheduler.parallelFor(64, [&after](size_t) { after++; });
+    bool recovered = caught && ran == 64 && after == 64;
+    std::cout << "[Bench] throwing task " << (recovered ? "rethrown from wait(), pool still usable" : "NOT handled") << "\n";
+    return recovered ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 2) arena [bufferMiB=4] [rounds=64]
+//    - Cost of filling a multi-MiB read buffer: a fresh heap buffer per
+//      file (page faults + TLB misses every time) versus a recycled,
+//      prefaulted arena buffer.
+// --------------------------------------------------------------------
+static int benchArena(const std::vector<std::string>& args) {
+    size_t bufferBytes = static_cast<size_t>(argOr(args, 0, 4)) << 20;
+    unsigned rounds = static_cast<unsigned>(argOr(args, 1, 64));
+
+    double start = nowSeconds();
+    QFBufferArena arena(bufferBytes, 2);
+    double setup = nowSeconds() - start;
+
+    // Simulated read: fill the buffer, then one pass over it
+    uint64_t sink = 0;
+    auto fillAndScan = [&sink](uint8_t* buf, size_t len, unsigned round) {
+        std::memset(buf, static_cast<int>(round), len);
+        for (size_t off = 0; off < len; off += 64) sink += buf[off];
+    };
+
+    start = nowSeconds();
+    for (unsigned r = 0; r < rounds; r++) {
+        std::vector<uint8_t> fresh(bufferBytes);
+        fillAndScan(fresh.data(), fresh.size(), r);
+    }
+    double heap = nowSeconds() - start;
+
+    start = nowSeconds();
+    for (unsigned r = 0; r < rounds; r++) {
+        QFArenaLease lease(arena);
+        fillAndScan(lease.data(), bufferBytes, r);
+    }
+    double pooled = nowSeconds() - start;
+
+    std::cout << "[Bench] arena: " << rounds << " x " << (bufferBytes >> 20)
+        << " MiB buffers (checksum " << (sink & 0xFF) << ")\n";
+    std::printf("%-22s %12s %12s\n", "path", "us/buffer", "GiB/s");
+    std::printf("%-22s %12.1f %12.2f\n", "fresh heap buffer",
+        1e6 * heap / rounds, (double(bufferBytes) * rounds / (1 << 30)) / heap);
+    std::printf("%-22s %12.1f %12.2f\n", "arena (recycled)",
+        1e6 * pooled / rounds, (double(bufferBytes) * rounds / (1 << 30)) / pooled);
+    std::printf("%-22s %12.1f ms (one-time map; buffers prefault on first lease)\n", "arena setup", setup * 1e3);
+    printArenaStats(arena.stats(), std::cout);
+    return EXIT_SUCCESS;
+}
+
+// --------------------------------------------------------------------
+// 3) smallfiles [files=1000000] [dir=<tmp>/qf_smallfiles]
+//    - Builds (once; reused while the file count matches) a synthetic
+//      tree of 1-16 KiB files, 1000 per directory.
+//    - Digests it with the io_uring batch path, the thread-pool batch
+//      path (each with a per-call and a reused slab arena) and one
+//      digestFile() per file, and reports files/s.  Runs use a warm page
+//      cache, so they measure syscall and per-file cost.  Any digest that
+//      differs from digestFile() fails the bench.
+// --------------------------------------------------------------------
+static int benchSmallFiles(const std::vector<std::string>& args) {
+    size_t count = static_cast<size_t>(argOr(args, 0, 1000000));
+    std::filesystem::path root = (args.size() > 1) ? std::filesystem::path(args[1])
+        : std::filesystem::temp_directory_path() / "qf_smallfiles";
+
+    std::vector<std::string> files(count);
+    for (size_t i = 0; i < count; i++) {
+        files[i] = (root / std::to_string(i / 1000) / (std::to_string(i) + ".bin")).string();
+    }
+
+    std::filesystem::path marker = root / ".qf_bench_files";
+    size_t existing = 0;
+    {
+        std::ifstream in(marker);
+        in >> existing;
+    }
+    if (existing != count) {
+        std::cout << "[Bench] smallfiles: creating " << count << " files under " << root.string() << "\n";
+        std::error_code ec;
+        std::filesystem::remove_all(root, ec);
+        std::mt19937_64 rng(7);
+        std::vector<uint8_t> data(16 << 10);
+        for (size_t i = 0; i < count; i++) {
+            if (i % 1000 == 0) {
+                std::filesystem::create_directories(root / std::to_string(i / 1000), ec);
+                if (ec) {
+                    std::cerr << "[Bench] Cannot create " << root.string() << ": " << ec.message() << "\n";
+                    return EXIT_FAILURE;
+                }
+            }
+            size_t size = 1024 + rng() % (15 << 10);
+            for (size_t b = 0; b < size; b += 8) {
+                uint64_t v = rng();
+                std::memcpy(&data[b], &v, std::min<size_t>(8, size - b));
+            }
+            std::ofstream out(files[i], std::ios::binary);
+            out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(size));
+        }
+        std::ofstream(marker) << count << "\n";
+    }
+
+    std::cout << "[Bench] smallfiles: " << count << " files, workers = "
+        << qfScheduler().workerCount() << "\n";
+    std::printf("%-22s %10s %12s %10s\n", "path", "seconds", "files/s", "mismatch");
+
+    // Reference: one digestFile() per file on the scheduler
+    std::vector<QFDigest> reference(count);
+    std::vector<uint8_t> referenceOk(count, 0);
+    double start = nowSeconds();
+    qfScheduler().parallelFor(count, [&](size_t i) {
+        referenceOk[i] = digestFile(files[i], reference[i]) ? 1 : 0;
+    }, QFTaskPriority::Bulk, 64);
+    double perFile = nowSeconds() - start;
+    std::printf("%-22s %10.3f %12.0f %10s\n", "digestFile per file", perFile, count / perFile, "-");
+
+    const QFSmallFilesBackend backends[] = { QFSmallFilesBackend::Uring, QFSmallFilesBackend::ThreadPool };
+    std::unique_ptr<QFBufferArena> shared = newSmallFilesArena();
+    size_t totalMismatches = 0;
+    for (QFSmallFilesBackend backend : backends) {
+        for (int reuse = 0; reuse < 2; reuse++) {
+            QFSmallFilesOptions options;
+            options.backend = backend;
+            options.arena = reuse ? shared.get() : nullptr;
+            std::vector<QFDigest> digests;
+            std::vector<bool> ok;
+            QFSmallFilesReport report;
+            hashSmallFiles(files, digests, ok, report, options);
+
+            size_t mismatches = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (ok[i] != (referenceOk[i] != 0) || (ok[i] && digests[i] != reference[i])) mismatches++;
+            }
+            totalMismatches += mismatches;
+            std::string label = std::string(reuse ? "reused (" : "batched (") + report.backend + ")";
+            std::printf("%-22s %10.3f %12.0f %10zu\n", label.c_str(), report.seconds,
+                report.filesPerSecond(), mismatches);
+        }
+    }
+    return totalMismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 4) sparse [logicalMiB=256] [dataMiB=16] [file=<tmp>/qf_sparse.img]
+//    - Creates a sparse image with dataMiB of random data spread over
+//      logicalMiB, then digests it with the extent-aware processFile and
+//      with a dense read of every byte.  Digests must match; the sparse
+//      path should only read the allocated extents.
+// --------------------------------------------------------------------
+static int benchSparse(const std::vector<std::string>& args) {
+    uint64_t logical = argOr(args, 0, 256) << 20;
+    uint64_t dataBytes = argOr(args, 1, 16) << 20;
+    std::string path = (args.size() > 2) ? args[2]
+        : (std::filesystem::temp_directory_path() / "qf_sparse.img").string();
+
+    // 1 MiB data extents at evenly spaced offsets
+    const uint64_t EXTENT = 1 << 20;
+    uint64_t extents = std::max<uint64_t>(dataBytes / EXTENT, 1);
+    if (extents * EXTENT > logical) extents = logical / EXTENT;
+    {
+        int fd = qfOpenWrite(path);
+        if (fd < 0) {
+            std::cerr << "[Bench] Cannot create " << path << "\n";
+            return EXIT_FAILURE;
+        }
+        std::mt19937_64 rng(9);
+        std::vector<uint8_t> block(EXTENT);
+        uint64_t stride = logical / std::max<uint64_t>(extents, 1);
+        for (uint64_t e = 0; e < extents; e++) {
+            for (size_t b = 0; b < block.size(); b += 8) {
+                uint64_t v = rng();
+                std::memcpy(&block[b], &v, 8);
+            }
+            qfSeek(fd, static_cast<int64_t>(e * stride));
+            qfWriteAll(fd, block.data(), block.size());
+        }
+        qfClose(fd);
+        std::filesystem::resize_file(path, logical);
+    }
+
+    QFArenaLease buffer(qfIoArena());
+    std::printf("%-10s %10s %12s %14s\n", "path", "seconds", "MiB read", "logical MiB/s");
+
+    QFState sparse;
+    qfInit(sparse);
+    QFReadStats stats;
+    double start = nowSeconds();
+    processFile(sparse, path, buffer.data(), buffer.size(), &stats);
+    double sparseTime = nowSeconds() - start;
+    std::printf("%-10s %10.3f %12.1f %14.1f\n", "sparse", sparseTime,
+        stats.bytesRead / 1048576.0, (logical / 1048576.0) / sparseTime);
+
+    // Dense reference: same chunking, every byte read from the file
+    QFState dense;
+    qfInit(dense);
+    uint64_t denseRead = 0;
+    start = nowSeconds();
+    int fd = qfOpenRead(path);
+    long n;
+    while ((n = qfReadFull(fd, buffer.data(), buffer.size())) > 0) {
+        processRaw(dense, buffer.data(), static_cast<size_t>(n));
+        denseRead += static_cast<uint64_t>(n);
+        if (static_cast<size_t>(n) < buffer.size()) break;
+    }
+    qfClose(fd);
+    double denseTime = nowSeconds() - start;
+    std::printf("%-10s %10.3f %12.1f %14.1f\n", "dense", denseTime,
+        denseRead / 1048576.0, (logical / 1048576.0) / denseTime);
+
+    uint8_t a[64], b[64];
+    qfSqueeze(sparse, a, sizeof(a));
+    qfSqueeze(dense, b, sizeof(b));
+    bool same = std::memcmp(a, b, sizeof(a)) == 0;
+    std::cout << "[Bench] digests " << (same ? "match" : "DIFFER") << ", holes synthesized = "
+        << (stats.holeBytes >> 20) << " MiB\n";
+    std::filesystem::remove(path);
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 5) multi [MiB=64] [file=<tmp>/qf_multi.bin]
+//    - QF-512 + SHA-256 + CRC32C of one file: three separate passes
+//      versus hashFileMulti's single read with QF on its own thread.
+// --------------------------------------------------------------------
+static int benchMulti(const std::vector<std::string>& args) {
+    size_t bytes = static_cast<size_t>(argOr(args, 0, 64)) << 20;
+    std::string path = (args.size() > 1) ? args[1]
+        : (std::filesystem::temp_directory_path() / "qf_multi.bin").string();
+    {
+        std::mt19937_64 rng(5);
+        std::vector<uint8_t> data(bytes);
+        for (size_t b = 0; b + 8 <= data.size(); b += 8) {
+            uint64_t v = rng();
+            std::memcpy(&data[b], &v, 8);
+        }
+        int fd = qfOpenWrite(path);
+        if (fd < 0 || qfWriteAll(fd, data.data(), data.size()) < 0) {
+            std::cerr << "[Bench] Cannot write " << path << "\n";
+            qfClose(fd);
+            return EXIT_FAILURE;
+        }
+        qfClose(fd);
+    }
+
+    std::cout << "[Bench] multi: " << (bytes >> 20) << " MiB, sha256 = " << QFSha256::implementation()
+        << ", crc32c = " << qfCrc32cImplementation() << "\n";
+    std::printf("%-24s %10s %10s\n", "pass", "seconds", "MiB/s");
+
+    const struct { const char* name; unsigned algorithms; } passes[] = {
+        { "qf512 only", QF_ALG_QF512 },
+        { "sha256 only", QF_ALG_SHA256 },
+        { "crc32c only", QF_ALG_CRC32C },
+    };
+    QFMultiDigest separate[3];
+    double separateTotal = 0.0;
+    for (int i = 0; i < 3; i++) {
+        double start = nowSeconds();
+        hashFileMulti(path, passes[i].algorithms, separate[i]);
+        double elapsed = nowSeconds() - start;
+        separateTotal += elapsed;
+        std::printf("%-24s %10.3f %10.1f\n", passes[i].name, elapsed, (bytes / 1048576.0) / elapsed);
+    }
+    std::printf("%-24s %10.3f %10.1f\n", "three passes (sum)", separateTotal,
+        (bytes / 1048576.0) / separateTotal);
+
+    QFMultiDigest all;
+    double start = nowSeconds();
+    hashFileMulti(path, QF_ALG_ALL, all);
+    double elapsed = nowSeconds() - start;
+    std::printf("%-24s %10.3f %10.1f\n", "single pass (all)", elapsed, (bytes / 1048576.0) / elapsed);
+
+    bool same = all.qf == separate[0].qf && all.sha256 == separate[1].sha256
+        && all.crc32c == separate[2].crc32c;
+    std::cout << "[Bench] digests " << (same ? "match" : "DIFFER") << "\n";
+    std::filesystem::remove(path);
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 6) dupes [files=2000] [dir=<tmp>/qf_dupes]
+//    - Synthetic tree: sizes from a small set (so most files share a
+//      size with another), 20% exact copies, the rest differing in the
+//      first, last or a middle byte.
+//    - Reports how many files each stage kept and the bytes the staging
+//      avoided reading compared with full-hashing every file.
+// --------------------------------------------------------------------
+static int benchDupes(const std::vector<std::string>& args) {
+    size_t count = static_cast<size_t>(argOr(args, 0, 2000));
+    std::filesystem::path root = (args.size() > 1) ? std::filesystem::path(args[1])
+        : std::filesystem::temp_directory_path() / "qf_dupes";
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    std::filesystem::create_directories(root, ec);
+    if (ec) {
+        std::cerr << "[Bench] Cannot create " << root.string() << ": " << ec.message() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    const size_t SIZES[] = { 4096, 100000, 300000, 1 << 20, 3 << 20 };
+    std::mt19937_64 rng(11);
+    std::vector<uint8_t> base(3 << 20);
+    for (size_t b = 0; b < base.size(); b += 8) {
+        uint64_t v = rng();
+        std::memcpy(&base[b], &v, 8);
+    }
+    std::vector<std::string> files;
+    for (size_t i = 0; i < count; i++) {
+        size_t size = SIZES[rng() % (sizeof(SIZES) / sizeof(SIZES[0]))];
+        std::vector<uint8_t> data(base.begin(), base.begin() + size);
+        unsigned kind = static_cast<unsigned>(rng() % 10);
+        if (kind >= 2) {
+            // Unique content: perturb the head, the tail or the middle
+            size_t where = (kind < 5) ? 0 : (kind < 8) ? size - 1 - (i % 64) : size / 2;
+            std::memcpy(&data[where], &i, std::min(sizeof(i), size - where));
+        }
+        std::string path = (root / (std::to_string(i) + ".bin")).string();
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()),
+            static_cast<std::streamsize>(size));
+        files.push_back(path);
+    }
+
+    std::vector<QFDupeGroup> groups;
+    QFDupesReport report;
+    findDuplicates(files, groups, report);
+
+    std::cout << "[Bench] dupes: " << count << " files, " << (report.totalBytes >> 20) << " MiB\n";
+    std::printf("%-28s %10s %10s\n", "stage", "files", "seconds");
+    std::printf("%-28s %10llu %10.3f\n", "1) same size", static_cast<unsigned long long>(report.sizeCandidates),
+        report.seconds[0]);
+    std::printf("%-28s %10llu %10.3f\n", "2) same head+tail", static_cast<unsigned long long>(report.partialCandidates),
+        report.seconds[1]);
+    std::printf("%-28s %10llu %10.3f\n", "3) duplicates (full digest)", static_cast<unsigned long long>(report.duplicateFiles),
+        report.seconds[2]);
+    std::printf("bytes read %.1f MiB of %.1f MiB, avoided %.1f MiB (%.1f%%), %zu groups\n",
+        report.bytesRead / 1048576.0, report.totalBytes / 1048576.0, report.bytesAvoided() / 1048576.0,
+        report.totalBytes ? 100.0 * report.bytesAvoided() / report.totalBytes : 0.0, groups.size());
+    std::filesystem::remove_all(root, ec);
+    return EXIT_SUCCESS;
+}
+
+// --------------------------------------------------------------------
+// 7) manifest [entries=1000000] [memoryMiB=16]
+//    - Two shuffled synthetic manifests: the new one drops 1% of the
+//      entries, changes 1% and adds 1% new paths.
+//    - Diffs them under a deliberately small memory budget (many runs,
+//      merge levels) and checks the counts.
+// --------------------------------------------------------------------
+static int benchManifest(const std::vector<std::string>& args) {
+    size_t entries = static_cast<size_t>(argOr(args, 0, 1000000));
+    QFManifestDiffOptions options;
+    options.memoryBudget = static_cast<size_t>(argOr(args, 1, 16)) << 20;
+    options.maxFanIn = 16;
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string oldPath = (dir / "qf_bench_old.manifest").string();
+    std::string newPath = (dir / "qf_bench_new.manifest").string();
+
+    std::mt19937_64 rng(13);
+    std::vector<size_t> order(entries + entries / 100);
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    auto writeManifest = [&](const std::string& path, bool isNew) {
+        std::shuffle(order.begin(), order.end(), rng);
+        std::ofstream out(path, std::ios::binary);
+        char line[256];
+        for (size_t id : order) {
+            bool added = id >= entries;
+            bool removed = !added && id % 100 == 1;
+            bool changed = !added && id % 100 == 2;
+            if ((added && !isNew) || (removed && isNew)) continue;
+            uint64_t d = id * 0x9E3779B97F4A7C15ULL + ((changed && isNew) ? 1 : 0);
+            int n = std::snprintf(line, sizeof(line), "%016llx%016llx  data/%03zu/file_%zu.bin\n",
+                static_cast<unsigned long long>(d), static_cast<unsigned long long>(~d), id % 997, id);
+            out.write(line, n);
+        }
+    };
+    writeManifest(oldPath, false);
+    writeManifest(newPath, true);
+
+    QFManifestDiffReport report;
+    bool ok = diffManifests(oldPath, newPath,
+        [](QFDiffKind, std::string_view, std::string_view, std::string_view) {}, report, options);
+    std::filesystem::remove(oldPath);
+    std::filesystem::remove(newPath);
+    if (!ok) return EXIT_FAILURE;
+
+    size_t expected = entries / 100;
+    std::cout << "[Bench] manifest: " << report.oldEntries << " -> " << report.newEntries
+        << " entries, budget " << (options.memoryBudget >> 20) << " MiB, runs "
+        << report.oldRuns << " + " << report.newRuns << " (fan-in " << options.maxFanIn << ")\n";
+    std::printf("%10s %10s %10s %10s %12s %14s\n", "added", "removed", "changed", "seconds",
+        "entries/s", "peak sort MiB");
+    std::printf("%10llu %10llu %10llu %10.3f %12.0f %14.1f\n",
+        static_cast<unsigned long long>(report.added), static_cast<unsigned long long>(report.removed),
+        static_cast<unsigned long long>(report.changed), report.seconds,
+        (report.oldEntries + report.newEntries) / report.seconds, report.peakSortBytes / 1048576.0);
+    bool counts = report.added == expected && report.removed == expected && report.changed == expected;
+    std::cout << "[Bench] counts " << (counts ? "as expected" : "UNEXPECTED") << "\n";
+    return counts ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 8) short [iterations=200000]
+//    - Latency of one 64-byte digest of a 0-127 byte message:
+//      qfInit + qfAbsorb + qfSqueeze versus qfHashShort.
+// --------------------------------------------------------------------
+static int benchShort(const std::vector<std::string>& args) {
+    unsigned iterations = static_cast<unsigned>(argOr(args, 0, 200000));
+    const size_t LENGTHS[] = { 0, 8, 16, 32, 64, 127 };
+    uint8_t message[127];
+    for (size_t i = 0; i < sizeof(message); i++) message[i] = static_cast<uint8_t>(i * 7 + 1);
+
+    std::printf("%8s %14s %14s %8s\n", "bytes", "generic ns", "short ns", "speedup");
+    bool same = true;
+    uint8_t sink = 0;
+    for (size_t len : LENGTHS) {
+        uint8_t a[64], b[64];
+        double start = nowSeconds();
+        for (unsigned i = 0; i < iterations; i++) {
+            message[0] = static_cast<uint8_t>(i);
+            QFState qs;
+            qfInit(qs);
+            qfAbsorb(qs, message, len);
+            qfSqueeze(qs, a, sizeof(a));
+            sink ^= a[0];
+        }
+        double generic = (nowSeconds() - start) / iterations;
+
+        start = nowSeconds();
+        for (unsigned i = 0; i < iterations; i++) {
+            message[0] = static_cast<uint8_t>(i);
+            qfHashShort(message, len, b, sizeof(b));
+            sink ^= b[0];
+        }
+        double fast = (nowSeconds() - start) / iterations;
+        same = same && std::memcmp(a, b, sizeof(a)) == 0;
+        std::printf("%8zu %14.1f %14.1f %7.2fx\n", len, generic * 1e9, fast * 1e9, generic / fast);
+    }
+    std::cout << "[Bench] digests " << (same ? "match" : "DIFFER") << " (checksum " << int(sink) << ")\n";
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 9) multiset [elements=1000000]
+//    - Object-key style strings hashed as a collection three ways:
+//      sort + hash the sorted list (the old approach), QFMultisetHash
+//      add() one at a time, and addMany() on the scheduler.
+//    - Checks that a shuffled order gives the same digest and times an
+//      incremental update (remove one key, add another).
+//    - Checks that {"a"} and {"a\0"} hash apart through add() and
+//      addMany().
+// --------------------------------------------------------------------
+static int benchMultiset(const std::vector<std::string>& args) {
+    size_t count = static_cast<size_t>(argOr(args, 0, 1000000));
+    std::mt19937_64 rng(7);
+    std::vector<std::string> keys(count);
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = "bucket/objects/" + std::to_string(rng() % 100000) + "/" + std::to_string(i) + ".bin";
+    }
+
+    double start = nowSeconds();
+    std::vector<std::string> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    QFState qs;
+    qfInit(qs);
+    for (const std::string& k : sorted) {
+        qfAbsorb(qs, reinterpret_cast<const uint8_t*>(k.data()), k.size() + 1); // include the NUL separator
+    }
+    uint8_t sortedDigest[64];
+    qfSqueeze(qs, sortedDigest, sizeof(sortedDigest));
+    double sortSeconds = nowSeconds() - start;
+
+    start = nowSeconds();
+    QFMultisetHash serial;
+    for (const std::string& k : keys) serial.add(k);
+    double serialSeconds = nowSeconds() - start;
+
+    std::vector<std::string> shuffled = keys;
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    start = nowSeconds();
+    QFMultisetHash parallel;
+    parallel.addMany(shuffled);
+    double parallelSeconds = nowSeconds() - start;
+
+    start = nowSeconds();
+    const unsigned UPDATES = 1000;
+    QFMultisetHash updated = parallel;
+    for (unsigned i = 0; i < UPDATES; i++) {
+        updated.remove(keys[i]);
+        updated.add(keys[i]);
+    }
+    double updateSeconds = (nowSeconds() - start) / (2 * UPDATES);
+
+    QFDigest a, b, c;
+    serial.digest(a);
+    parallel.digest(b);
+    updated.digest(c);
+    bool same = (a == b) && (b == c);
+
+    QFMultisetHash plain, padded, paddedMany;
+    plain.add(std::string("a"));
+    padded.add(std::string("a\0", 2));
+    paddedMany.addMany(std::vector<std::string>{ std::string("a\0", 2) });
+    bool distinct = plain != padded && padded == paddedMany;
+
+    std::printf("%-22s %10s %14s\n", "method", "seconds", "elements/s");
+    std::printf("%-22s %10.3f %14.0f\n", "sort + hash", sortSeconds, count / sortSeconds);
+    std::printf("%-22s %10.3f %14.0f\n", "multiset add()", serialSeconds, count / serialSeconds);
+    std::printf("%-22s %10.3f %14.0f\n", "multiset addMany()", parallelSeconds, count / parallelSeconds);
+    std::cout << "[Bench] incremental update: " << updateSeconds * 1e9 << " ns per add/remove (vs "
+        << sortSeconds << " s to re-sort and re-hash), " << qfScheduler().workerCount() << " workers\n";
+    std::cout << "[Bench] order-independent digests " << (same ? "match" : "DIFFER") << "\n";
+    std::cout << "[Bench] {\"a\"} vs {\"a\\0\"}: " << (distinct ? "distinct" : "COLLIDE") << "\n";
+    return (same && distinct) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 10) sketches [events=2000000] [distinct=500000]
+//    - Skewed event stream (key i drawn with probability ~ 1/i): one
+//      HyperLogLog + Count-Min per task, filled with add() on each
+//      (two QF evaluations per event) or qfSketchAddMany() (one batched
+//      evaluation), then merged into a single pair.
+//    - Reports throughput, cardinality error, heavy-hitter error and
+//      the serialized sizes (checked by a round trip).
+// --------------------------------------------------------------------
+static int benchSketches(const std::vector<std::string>& args) {
+    size_t events = static_cast<size_t>(argOr(args, 0, 2000000));
+    size_t distinct = std::max<size_t>(1, static_cast<size_t>(argOr(args, 1, 500000)));
+
+    std::mt19937_64 rng(11);
+    std::vector<std::string> keys(distinct);
+    for (size_t i = 0; i < distinct; i++) keys[i] = "user:" + std::to_string(i * 2654435761ULL % 1000000007ULL);
+    std::vector<uint32_t> stream(events);
+    std::vector<uint64_t> truth(distinct, 0);
+    std::unordered_set<uint32_t> seen;
+    for (size_t i = 0; i < events; i++) {
+        // Log-uniform rank => heavy head, long tail
+        double u = std::uniform_real_distribution<double>(0.0, std::log(double(distinct)))(rng);
+        uint32_t k = static_cast<uint32_t>(std::min<double>(distinct - 1, std::exp(u) - 1));
+        stream[i] = k;
+        truth[k]++;
+        seen.insert(k);
+    }
+
+    const size_t TASKS = 16;
+    const size_t perTask = (events + TASKS - 1) / TASKS;
+    QFHyperLogLog hll;
+    QFCountMin cm = QFCountMin::forError(0.0005, 0.001);
+    double seconds[2] = { 0.0, 0.0 };
+    double mergeSeconds = 0.0;
+    for (int batched = 0; batched < 2; batched++) {
+        std::vector<QFHyperLogLog> hlls(TASKS, QFHyperLogLog());
+        std::vector<QFCountMin> cms(TASKS, QFCountMin(cm.width(), cm.depth()));
+        double start = nowSeconds();
+        qfScheduler().parallelFor(TASKS, [&](size_t t) {
+            size_t first = t * perTask;
+            size_t last = std::min(events, first + perTask);
+            if (batched) {
+                std::vector<const uint8_t*> ptrs;
+                std::vector<size_t> lens;
+                for (size_t i = first; i < last; i++) {
+                    ptrs.push_back(reinterpret_cast<const uint8_t*>(keys[stream[i]].data()));
+                    lens.push_back(keys[stream[i]].size());
+                }
+                qfSketchAddMany(hlls[t], cms[t], ptrs.data(), lens.data(), ptrs.size());
+            }
+            else {
+                for (size_t i = first; i < last; i++) {
+                    hlls[t].add(keys[stream[i]]);
+                    cms[t].add(keys[stream[i]]);
+                }
+            }
+        });
+        seconds[batched] = nowSeconds() - start;
+
+        start = nowSeconds();
+        hll.clear();
+        cm.clear();
+        for (size_t t = 0; t < TASKS; t++) {
+            hll.merge(hlls[t]);
+            cm.merge(cms[t]);
+        }
+        mergeSeconds = nowSeconds() - start;
+    }
+
+    // Heavy hitters: the 20 most frequent keys
+    std::vector<uint32_t> order(distinct);
+    for (size_t i = 0; i < distinct; i++) order[i] = static_cast<uint32_t>(i);
+    std::partial_sort(order.begin(), order.begin() + std::min<size_t>(20, distinct), order.end(),
+        [&](uint32_t a, uint32_t b) { return truth[a] > truth[b]; });
+    double worst = 0.0;
+    for (size_t i = 0; i < std::min<size_t>(20, distinct); i++) {
+        uint64_t est = cm.estimate(keys[order[i]]);
+        worst = std::max(worst, double(est - truth[order[i]]) / double(events));
+    }
+
+    std::vector<uint8_t> hllBytes, cmBytes;
+    hll.serialize(hllBytes);
+    cm.serialize(cmBytes);
+    QFHyperLogLog hll2(4);
+    QFCountMin cm2(1, 1);
+    bool roundTrip = hll2.deserialize(hllBytes.data(), hllBytes.size())
+        && cm2.deserialize(cmBytes.data(), cmBytes.size())
+        && hll2.estimate() == hll.estimate() && cm2.estimate(keys[0]) == cm.estimate(keys[0]);
+
+    double est = hll.estimate();
+    std::printf("%-12s %10s %14s\n", "method", "seconds", "events/s");
+    std::printf("%-12s %10.3f %14.0f\n", "add()", seconds[0], events / seconds[0]);
+    std::printf("%-12s %10.3f %14.0f\n", "batched", seconds[1], events / seconds[1]);
+    std::cout << "[Bench] merge of " << TASKS << " sketch pairs: " << mergeSeconds * 1e3 << " ms ("
+        << qfScheduler().workerCount() << " workers)\n"
+        << "[Bench] HLL p=" << hll.precision() << ": " << est << " vs " << seen.size() << " distinct ("
+        << 100.0 * (est - double(seen.size())) / double(seen.size()) << "%), " << hllBytes.size() << " bytes\n"
+        << "[Bench] Count-Min " << cm.width() << "x" << cm.depth() << ": worst top-20 overestimate "
+        << worst * 100.0 << "% of events, " << cmBytes.size() << " bytes serialized ("
+        << cm.width() * cm.depth() * 8 << " in memory)\n"
+        << "[Bench] serialization round trip " << (roundTrip ? "ok" : "FAILED") << "\n";
+    return (roundTrip && cm.total() == events) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 11) bloom [keys=2000000] [fpr=0.001] [file=<tmp>/qf_bloom.bin]
+//    - Sizes a blocked filter for the key count and target rate, then
+//      times insert()/contains() per key against the batched, prefetching
+//      insertMany()/containsMany().
+//    - Measures the false-positive rate on absent keys against the
+//      prediction, and queries the saved file through a mapped view.
+// --------------------------------------------------------------------
+static int benchBloom(const std::vector<std::string>& args) {
+    size_t count = static_cast<size_t>(argOr(args, 0, 2000000));
+    double target = (args.size() > 1) ? std::strtod(args[1].c_str(), nullptr) : 0.001;
+    std::string path = (args.size() > 2) ? args[2]
+        : (std::filesystem::temp_directory_path() / "qf_bloom.bin").string();
+
+    QFBloomSizing sizing = qfBloomSize(count, target);
+    std::cout << "[Bench] " << count << " keys, target " << target << ": " << sizing.blocks << " blocks ("
+        << sizing.bytes() / double(1 << 20) << " MiB), k=" << sizing.hashes
+        << ", predicted " << sizing.falsePositiveRate << "\n";
+
+    std::vector<std::string> present(count), absent(count);
+    for (size_t i = 0; i < count; i++) {
+        present[i] = "chunk:" + std::to_string(i * 0x9E3779B97F4A7C15ULL);
+        absent[i] = "miss:" + std::to_string(i);
+    }
+    auto pointers = [](const std::vector<std::string>& keys, std::vector<const uint8_t*>& ptrs,
+        std::vector<size_t>& lens) {
+        ptrs.resize(keys.size());
+        lens.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            ptrs[i] = reinterpret_cast<const uint8_t*>(keys[i].data());
+            lens[i] = keys[i].size();
+        }
+    };
+    std::vector<const uint8_t*> presentPtrs, absentPtrs;
+    std::vector<size_t> presentLens, absentLens;
+    pointers(present, presentPtrs, presentLens);
+    pointers(absent, absentPtrs, absentLens);
+
+    QFBloomFilter single(sizing), batched(sizing);
+    double start = nowSeconds();
+    for (const std::string& key : present) single.insert(key);
+    double insertOne = nowSeconds() - start;
+    start = nowSeconds();
+    batched.insertMany(presentPtrs.data(), presentLens.data(), count);
+    double insertMany = nowSeconds() - start;
+
+    size_t falsePositives = 0;
+    start = nowSeconds();
+    for (const std::string& key : absent) falsePositives += single.contains(key) ? 1 : 0;
+    double queryOne = nowSeconds() - start;
+
+    std::vector<uint8_t> results(count), hits(count);
+    start = nowSeconds();
+    batched.containsMany(absentPtrs.data(), absentLens.data(), count, results.data());
+    double queryMany = nowSeconds() - start;
+    size_t batchedFalsePositives = 0;
+    for (uint8_t r : results) batchedFalsePositives += r;
+    batched.containsMany(presentPtrs.data(), presentLens.data(), count, hits.data());
+    bool noFalseNegatives = std::all_of(hits.begin(), hits.end(), [](uint8_t r) { return r == 1; });
+
+    bool viewOk = batched.save(path);
+    QFBloomFilterView view;
+    double viewSeconds = 0.0;
+    if (viewOk && view.open(path)) {
+        std::vector<uint8_t> viewResults(count);
+        start = nowSeconds();
+        view.containsMany(absentPtrs.data(), absentLens.data(), count, viewResults.data());
+        viewSeconds = nowSeconds() - start;
+        viewOk = (viewResults == results) && view.insertedItems() == count;
+        view.close();
+    }
+    else {
+        viewOk = false;
+    }
+    std::remove(path.c_str());
+
+    std::printf("%-22s %12s %12s\n", "operation", "ns/key", "keys/s");
+    std::printf("%-22s %12.1f %12.0f\n", "insert()", insertOne * 1e9 / count, count / insertOne);
+    std::printf("%-22s %12.1f %12.0f\n", "insertMany()", insertMany * 1e9 / count, count / insertMany);
+    std::printf("%-22s %12.1f %12.0f\n", "contains()", queryOne * 1e9 / count, count / queryOne);
+    std::printf("%-22s %12.1f %12.0f\n", "containsMany()", queryMany * 1e9 / count, count / queryMany);
+    std::printf("%-22s %12.1f %12.0f\n", "mapped containsMany()", viewSeconds * 1e9 / count, count / viewSeconds);
+    std::cout << "[Bench] false positives " << double(falsePositives) / count << " (predicted "
+        << batched.estimatedFalsePositiveRate() << "), batched "
+        << (batchedFalsePositives == falsePositives ? "agrees" : "DISAGREES")
+        << ", false negatives " << (noFalseNegatives ? "none" : "FOUND")
+        << ", mapped view " << (viewOk ? "ok" : "FAILED") << "\n";
+    return (noFalseNegatives && viewOk && batchedFalsePositives == falsePositives) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 12) routing [keys=1000000] [nodes=64]
+//    - Routing decisions per second for jump hash, weighted rendezvous
+//      and the 1% sampler, per key and batched.
+//    - Checks balance (max / mean load), how many keys move when one
+//      node is added, the sampled fraction, and that secrets differing
+//      only in a trailing zero byte or past 128 bytes hash apart.
+// --------------------------------------------------------------------
+static int benchRouting(const std::vector<std::string>& args) {
+    size_t count = static_cast<size_t>(argOr(args, 0, 1000000));
+    int32_t nodes = static_cast<int32_t>(std::max<unsigned long long>(2, argOr(args, 1, 64)));
+    const std::string secret = "bench-routing-key";
+
+    std::vector<std::string> keys(count);
+    std::vector<const uint8_t*> ptrs(count);
+    std::vector<size_t> lens(count);
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = "request-" + std::to_string(i * 7919 + 13);
+        ptrs[i] = reinterpret_cast<const uint8_t*>(keys[i].data());
+        lens[i] = keys[i].size();
+    }
+    std::vector<QFRouteNode> nodeList(nodes);
+    for (int32_t i = 0; i < nodes; i++) nodeList[i] = { "node-" + std::to_string(i), (i % 4 == 0) ? 2.0 : 1.0 };
+
+    QFJumpRouter jump(nodes, secret), jumpGrown(nodes + 1, secret);
+    QFRendezvousRouter hrw(nodeList, secret);
+    nodeList.push_back({ "node-" + std::to_string(nodes), 1.0 });
+    QFRendezvousRouter hrwGrown(nodeList, secret);
+    QFSampler sampler(0.01, secret);
+
+    std::vector<int32_t> jumpOne(count), jumpMany(count), jumpMoved(count);
+    std::vector<size_t> hrwOne(count), hrwMany(count), hrwMoved(count);
+    std::vector<uint8_t> keep(count);
+    double t[6];
+    double start = nowSeconds();
+    for (size_t i = 0; i < count; i++) jumpOne[i] = jump.route(keys[i]);
+    t[0] = nowSeconds() - start;
+    start = nowSeconds();
+    jump.routeMany(ptrs.data(), lens.data(), count, jumpMany.data());
+    t[1] = nowSeconds() - start;
+    start = nowSeconds();
+    for (size_t i = 0; i < count; i++) hrwOne[i] = hrw.route(keys[i]);
+    t[2] = nowSeconds() - start;
+    start = nowSeconds();
+    hrw.routeMany(ptrs.data(), lens.data(), count, hrwMany.data());
+    t[3] = nowSeconds() - start;
+    size_t sampledOne = 0;
+    start = nowSeconds();
+    for (size_t i = 0; i < count; i++) sampledOne += sampler.sample(keys[i]) ? 1 : 0;
+    t[4] = nowSeconds() - start;
+    start = nowSeconds();
+    sampler.sampleMany(ptrs.data(), lens.data(), count, keep.data());
+    t[5] = nowSeconds() - start;
+    size_t sampledMany = 0;
+    for (uint8_t k : keep) sampledMany += k;
+
+    jumpGrown.routeMany(ptrs.data(), lens.data(), count, jumpMoved.data());
+    hrwGrown.routeMany(ptrs.data(), lens.data(), count, hrwMoved.data());
+    std::vector<size_t> jumpLoad(nodes, 0);
+    std::vector<double> hrwShare(nodes, 0.0);
+    size_t jumpChanged = 0, hrwChanged = 0;
+    for (size_t i = 0; i < count; i++) {
+        jumpLoad[jumpMany[i]]++;
+        hrwShare[hrwMany[i]] += 1.0 / nodeList[hrwMany[i]].weight;
+        jumpChanged += (jumpMoved[i] != jumpMany[i]) ? 1 : 0;
+        hrwChanged += (hrwMoved[i] != hrwMany[i]) ? 1 : 0;
+    }
+    double mean = double(count) / nodes;
+    double jumpImbalance = *std::max_element(jumpLoad.begin(), jumpLoad.end()) / mean;
+    double weightSum = 0.0;
+    for (int32_t i = 0; i < nodes; i++) weightSum += nodeList[i].weight;
+    double hrwImbalance = *std::max_element(hrwShare.begin(), hrwShare.end()) / (double(count) / weightSum);
+
+    bool same = (jumpOne == jumpMany) && (hrwOne == hrwMany) && (sampledOne == sampledMany);
+
+    const uint8_t probe[] = { 'p', 'r', 'o', 'b', 'e' };
+    std::string longSecret(200, 'k'), longSecret2 = longSecret;
+    longSecret2.back() = 'l';
+    bool keysApart = QFKeyedHash("a").hash64(probe, sizeof(probe))
+            != QFKeyedHash(std::string("a\0", 2)).hash64(probe, sizeof(probe))
+        && QFKeyedHash(longSecret).hash64(probe, sizeof(probe))
+            != QFKeyedHash(longSecret2).hash64(probe, sizeof(probe));
+
+    const char* NAMES[] = { "jump route()", "jump routeMany()", "rendezvous route()",
+        "rendezvous routeMany()", "sampler sample()", "sampler sampleMany()" };
+    std::printf("%-24s %14s\n", "operation", "decisions/s");
+    for (int i = 0; i < 6; i++) std::printf("%-24s %14.0f\n", NAMES[i], count / t[i]);
+    std::cout << "[Bench] " << nodes << " nodes: jump max/mean load " << jumpImbalance
+        << ", rendezvous (weight-normalised) " << hrwImbalance << "\n"
+        << "[Bench] adding one node moved " << 100.0 * jumpChanged / count << "% (jump), "
+        << 100.0 * hrwChanged / count << "% (rendezvous); ideal ~" << 100.0 / (nodes + 1) << "%\n"
+        << "[Bench] sampled " << 100.0 * sampledMany / count << "% at rate 1%, batched results "
+        << (same ? "match" : "DIFFER") << "\n"
+        << "[Bench] secrets \"a\" vs \"a\\0\" and 200-byte secrets differing in the last byte: "
+        << (keysApart ? "distinct" : "COLLIDE") << "\n";
+    return (same && keysApart) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 13) delta [MiB=64] [edits=64] [dir=<tmp>]
+//    - Random "old" file; "new" = old with `edits` scattered inserts,
+//      deletes and overwrites (so most blocks shift position).
+//    - Times signature, delta and patch, and reports how much of the new
+//      file travelled as copies versus literals.
+//    - Repeats with a zero-filled old file and a 5-byte edit (every
+//      offset is a weak hit) and checks that patching onto the old file
+//      itself is refused with the old file left intact.
+// --------------------------------------------------------------------
+static bool writeBytes(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return static_cast<bool>(out);
+}
+
+static int benchDelta(const std::vector<std::string>& args) {
+    size_t bytes = static_cast<size_t>(argOr(args, 0, 64)) << 20;
+    unsigned edits = static_cast<unsigned>(argOr(args, 1, 64));
+    std::filesystem::path dir = (args.size() > 2) ? std::filesystem::path(args[2])
+        : std::filesystem::temp_directory_path();
+    const std::string oldPath = (dir / "qf_delta_old.bin").string();
+    const std::string newPath = (dir / "qf_delta_new.bin").string();
+    const std::string sigPath = (dir / "qf_delta.sig").string();
+    const std::string deltaPath = (dir / "qf_delta.dlt").string();
+    const std::string outPath = (dir / "qf_delta_out.bin").string();
+
+    std::mt19937_64 rng(3);
+    std::vector<uint8_t> oldData(bytes);
+    for (size_t i = 0; i + 8 <= bytes; i += 8) {
+        uint64_t v = rng();
+        std::memcpy(oldData.data() + i, &v, 8);
+    }
+    std::vector<size_t> at(edits);
+    for (unsigned e = 0; e < edits; e++) at[e] = bytes ? rng() % bytes : 0;
+    std::sort(at.begin(), at.end());
+    std::vector<uint8_t> newData;
+    newData.reserve(bytes + edits * 128);
+    size_t from = 0;
+    for (unsigned e = 0; e < edits; e++) {
+        if (at[e] < from) continue;
+        newData.insert(newData.end(), oldData.begin() + from, oldData.begin() + at[e]);
+        from = at[e];
+        switch (e % 3) {
+        case 0: for (int i = 0; i < 100; i++) newData.push_back(static_cast<uint8_t>(rng())); break; // insert
+        case 1: from = std::min(bytes, from + 50); break;                                            // delete
+        default:                                                                                     // overwrite
+            for (int i = 0; i < 16 && from < bytes; i++, from++) newData.push_back(static_cast<uint8_t>(rng()));
+        }
+    }
+    newData.insert(newData.end(), oldData.begin() + from, oldData.end());
+    bool ok = writeBytes(oldPath, oldData) && writeBytes(newPath, newData);
+    double start = nowSeconds();
+    ok = ok && writeSignature(oldPath, sigPath);
+    double sigSeconds = nowSeconds() - start;
+    QFDeltaReport report;
+    ok = ok && writeDelta(sigPath, newPath, deltaPath, report);
+    start = nowSeconds();
+    ok = ok && applyDelta(oldPath, deltaPath, outPath);
+    double patchSeconds = nowSeconds() - start;
+
+    std::error_code ec;
+    uint64_t sigBytes = std::filesystem::file_size(sigPath, ec);
+    QFDigest a{}, b{};
+    ok = ok && digestFile(newPath, a) && digestFile(outPath, b) && a == b;
+    for (const std::string& p : { oldPath, newPath, sigPath, deltaPath, outPath }) std::filesystem::remove(p, ec);
+
+    double mib = double(1 << 20);
+    std::printf("%-10s %10s %12s\n", "phase", "seconds", "MiB/s");
+    std::printf("%-10s %10.3f %12.1f\n", "signature", sigSeconds, bytes / mib / sigSeconds);
+    std::printf("%-10s %10.3f %12.1f\n", "delta", report.seconds, newData.size() / mib / report.seconds);
+    std::printf("%-10s %10.3f %12.1f\n", "patch", patchSeconds, newData.size() / mib / patchSeconds);
+
+    // Repetitive input: zeros, old and new differing in five bytes
+    std::vector<uint8_t> zeros(std::min<size_t>(bytes, 16 << 20), 0);
+    std::vector<uint8_t> edited = zeros;
+    for (size_t i = 0; i < 5 && i < edited.size(); i++) edited[edited.size() / 2 + i] = 0xA5;
+    QFDeltaReport zeroReport;
+    bool zeroOk = writeBytes(oldPath, zeros) && writeBytes(newPath, edited) && writeSignature(oldPath, sigPath)
+        && writeDelta(sigPath, newPath, deltaPath, zeroReport) && applyDelta(oldPath, deltaPath, outPath)
+        && digestFile(newPath, a) && digestFile(outPath, b) && a == b;
+    bool refused = !applyDelta(oldPath, deltaPath, oldPath)
+        && std::filesystem::file_size(oldPath, ec) == zeros.size();
+    for (const std::string& p : { oldPath, newPath, sigPath, deltaPath, outPath }) std::filesystem::remove(p, ec);
+    std::printf("%-10s %10.3f %12.1f\n", "delta 0s", zeroReport.seconds, edited.size() / mib / zeroReport.seconds);
+    std::cout << "[Bench] signature " << sigBytes << " bytes; delta " << report.deltaBytes << " bytes for "
+        << newData.size() << " (" << 100.0 * report.deltaBytes / std::max<size_t>(1, newData.size()) << "%): "
+        << report.copyOps << " copy runs, " << report.literalOps << " literals, "
+        << report.candidates << " candidates (" << report.falseCandidates << " false)\n"
+        << "[Bench] patched file " << (ok ? "verified" : "FAILED") << " (" << qfScheduler().workerCount() << " workers)\n"
+        << "[Bench] zero-filled: delta " << zeroReport.deltaBytes << " bytes, " << zeroReport.candidates
+        << " candidates, patch " << (zeroOk ? "verified" : "FAILED") << "; patch onto the old file "
+        << (refused ? "refused" : "NOT refused") << "\n";
+    return (ok && zeroOk && refused) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 14) mlog [appends=200000] [threads=64] [dir=<tmp>]
+//    - `threads` writers append ~100-byte audit records to a fresh log
+//      with fdatasync on; reports appends/s and the average group size.
+//    - Then checks inclusion proofs of random entries, consistency
+//      proofs between random sizes, and that a reopened log has the
+//      same root.
+//    - Rewrites a record "pay 10" as "pay 10\0" (length fixed up, stored
+//      leaf hash kept) in front of another record; open() must refuse it.
+// --------------------------------------------------------------------
+static int benchMerkleLog(const std::vector<std::string>& args) {
+    uint64_t appends = argOr(args, 0, 200000);
+    unsigned threads = static_cast<unsigned>(std::max<unsigned long long>(1, argOr(args, 1, 64)));
+    std::filesystem::path dir = (args.size() > 2) ? std::filesystem::path(args[2])
+        : std::filesystem::temp_directory_path();
+    const std::string path = (dir / "qf_audit.log").string();
+    std::filesystem::remove(path);
+
+    QFMerkleLog log;
+    if (!log.open(path)) return EXIT_FAILURE;
+    std::atomic<uint64_t> next{ 0 };
+    std::atomic<bool> ok{ true };
+    double start = nowSeconds();
+    std::vector<std::thread> writers;
+    for (unsigned t = 0; t < threads; t++) {
+        writers.emplace_back([&, t]() {
+            for (uint64_t i = next++; i < appends; i = next++) {
+                std::string entry = "{\"ts\":" + std::to_string(1700000000 + i) + ",\"actor\":\"svc-"
+                    + std::to_string(t) + "\",\"action\":\"object.put\",\"id\":" + std::to_string(i) + "}";
+                if (!log.append(entry)) ok = false;
+            }
+        });
+    }
+    for (std::thread& w : writers) w.join();
+    double seconds = nowSeconds() - start;
+
+    std::mt19937_64 rng(5);
+    const uint64_t n = log.size();
+    QFDigest root = log.root();
+    unsigned checked = 0, failures = 0;
+    start = nowSeconds();
+    for (int i = 0; i < 1000 && n > 0; i++, checked++) {
+        uint64_t size = 1 + rng() % n, index = rng() % size;
+        QFInclusionProof inclusion;
+        std::vector<uint8_t> entry;
+        bool good = log.inclusionProof(index, size, inclusion) && log.readEntry(index, entry)
+            && qfVerifyInclusion(qfLogLeafHash(entry.data(), entry.size()), inclusion, log.root(size));
+        uint64_t older = rng() % (size + 1);
+        QFConsistencyProof consistency;
+        good = good && log.consistencyProof(older, size, consistency)
+            && qfVerifyConsistency(consistency, log.root(older), log.root(size));
+        // A proof must not verify against the wrong root
+        if (size > 1) good = good && !qfVerifyInclusion(log.leafHash(index), inclusion, log.root(size - 1));
+        if (!good) failures++;
+    }
+    double proofSeconds = nowSeconds() - start;
+    uint64_t commits = log.commits();
+    log.close();
+
+    QFMerkleLog reopened;
+    bool sameRoot = reopened.open(path) && reopened.size() == n && reopened.root() == root;
+    reopened.close();
+    std::filesystem::remove(path);
+
+    const std::string tamperPath = (dir / "qf_audit_tamper.log").string();
+    std::filesystem::remove(tamperPath);
+    bool tamperRefused = false;
+    {
+        QFMerkleLog small;
+        bool built = small.open(tamperPath, QFLogOptions{ false }) && small.append("pay 10") && small.append("pay 20");
+        small.close();
+        std::string bytes;
+        if (built) {
+            std::ifstream in(tamperPath, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        const size_t first = 8, entryAt = first + 4 + QF_DIGEST_BYTES;
+        if (bytes.size() > entryAt + 6 && bytes.compare(entryAt, 6, "pay 10") == 0) {
+            bytes[first] = 7;
+            bytes.insert(entryAt + 6, 1, '\0');
+            std::ofstream(tamperPath, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+            QFMerkleLog tampered;
+            tamperRefused = !tampered.open(tamperPath);
+        }
+    }
+    std::filesystem::remove(tamperPath);
+
+    std::cout << "[Bench] " << n << " appends from " << threads << " threads in " << seconds << " s: "
+        << n / seconds << " appends/s, " << commits << " group commits (avg "
+        << double(n) / std::max<uint64_t>(1, commits) << " entries per fdatasync)\n"
+        << "[Bench] " << checked << " inclusion + consistency proof pairs in " << proofSeconds * 1e3
+        << " ms, " << failures << " failures; reopen " << (sameRoot ? "matches" : "DIFFERS") << "\n"
+        << "[Bench] zero-extended record " << (tamperRefused ? "refused" : "ACCEPTED") << " on open\n";
+    return (ok && failures == 0 && sameRoot && tamperRefused && n == appends) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 15) archive [members=2000] [dir=<tmp>]
+//    - Writes `members` random files (64 B .. 1 MiB, log-spread) as loose
+//      files, as a ustar tar, and as a zip whose members alternate
+//      between stored and deflate (stored deflate blocks, so no
+//      compressor is needed).
+//    - Times per-member digests of the tar (one streaming pass) and the
+//      zip (parallel from the central directory) against digestFile on
+//      the loose files, and checks that all three agree.
+// --------------------------------------------------------------------
+static void putLE(std::string& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+static int benchArchive(const std::vector<std::string>& args) {
+    size_t count = static_cast<size_t>(std::max<unsigned long long>(1, argOr(args, 0, 2000)));
+    std::filesystem::path dir = (args.size() > 1) ? std::filesystem::path(args[1])
+        : std::filesystem::temp_directory_path();
+    std::filesystem::path loose = dir / "qf_archive_src";
+    const std::string tarPath = (dir / "qf_archive.tar").string();
+    const std::string zipPath = (dir / "qf_archive.zip").string();
+    std::filesystem::create_directories(loose);
+
+    std::mt19937_64 rng(15);
+    std::vector<std::string> names(count), paths(count);
+    std::string tar, zip, central;
+    for (size_t i = 0; i < count; i++) {
+        size_t size = static_cast<size_t>(64.0 * std::pow(16384.0, double(rng() % 1000) / 1000.0));
+        std::string data(size, '\0');
+        for (size_t k = 0; k < size; k++) data[k] = static_cast<char>(rng() % 64);   // compressible-ish
+        names[i] = "dir" + std::to_string(i % 16) + "/file" + std::to_string(i) + ".bin";
+        paths[i] = (loose / ("file" + std::to_string(i) + ".bin")).string();
+        std::ofstream(paths[i], std::ios::binary).write(data.data(), data.size());
+
+        // ustar header
+        char h[512] = { 0 };
+        std::snprintf(h, 100, "%s", names[i].c_str());
+        std::snprintf(h + 100, 8, "%07o", 0644);
+        std::snprintf(h + 108, 8, "%07o", 0);
+        std::snprintf(h + 116, 8, "%07o", 0);
+        std::snprintf(h + 124, 12, "%011llo", static_cast<unsigned long long>(size));
+        std::snprintf(h + 136, 12, "%011o", 0);
+        std::memset(h + 148, ' ', 8);
+        h[156] = '0';
+        std::memcpy(h + 257, "ustar\0" "00", 8);
+        unsigned sum = 0;
+        for (int k = 0; k < 512; k++) sum += static_cast<uint8_t>(h[k]);
+        std::snprintf(h + 148, 8, "%06o", sum);
+        tar.append(h, 512);
+        tar.append(data);
+        tar.append((512 - size % 512) % 512, '\0');
+
+        // zip local header + data (odd members: deflate stored blocks)
+        uint16_t method = (i % 2) ? 8 : 0;
+        std::string body;
+        if (method == 0) body = data;
+        else {
+            size_t off = 0;
+            do {
+                size_t n = std::min<size_t>(65535, size - off);
+                body.push_back(off + n == size ? 1 : 0);   // BFINAL, BTYPE=00
+                putLE(body, n, 2);
+                putLE(body, ~n & 0xFFFF, 2);
+                body.append(data, off, n);
+                off += n;
+            } while (off < size);
+        }
+        uint32_t crc = qfCrc32(0, reinterpret_cast<const uint8_t*>(data.data()), size);
+        uint64_t local = zip.size();
+        putLE(zip, 0x04034b50, 4); putLE(zip, 20, 2); putLE(zip, 0, 2); putLE(zip, method, 2);
+        putLE(zip, 0, 4); putLE(zip, crc, 4); putLE(zip, body.size(), 4); putLE(zip, size, 4);
+        putLE(zip, names[i].size(), 2); putLE(zip, 0, 2);
+        zip.append(names[i]);
+        zip.append(body);
+        putLE(central, 0x02014b50, 4); putLE(central, 20, 2); putLE(central, 20, 2); putLE(central, 0, 2);
+        putLE(central, method, 2); putLE(central, 0, 4); putLE(central, crc, 4); putLE(central, body.size(), 4);
+        putLE(central, size, 4); putLE(central, names[i].size(), 2); putLE(central, 0, 2); putLE(central, 0, 2);
+        putLE(central, 0, 2); putLE(central, 0, 2); putLE(central, 0, 4); putLE(central, local, 4);
+        central.append(names[i]);
+    }
+    tar.append(1024, '\0');
+    uint64_t cdOffset = zip.size();
+    zip.append(central);
+    putLE(zip, 0x06054b50, 4); putLE(zip, 0, 2); putLE(zip, 0, 2); putLE(zip, count, 2); putLE(zip, count, 2);
+    putLE(zip, central.size(), 4); putLE(zip, cdOffset, 4); putLE(zip, 0, 2);
+    std::ofstream(tarPath, std::ios::binary).write(tar.data(), tar.size());
+    std::ofstream(zipPath, std::ios::binary).write(zip.data(), zip.size());
+
+    double start = nowSeconds();
+    std::vector<QFDigest> expected(count);
+    bool ok = true;
+    for (size_t i = 0; i < count; i++) ok = digestFile(paths[i], expected[i]) && ok;
+    double looseSeconds = nowSeconds() - start;
+
+    std::vector<QFArchiveMember> tarMembers, zipMembers;
+    QFArchiveReport tarReport, zipReport;
+    ok = hashArchive(tarPath, tarMembers, tarReport) && ok;
+    ok = hashArchive(zipPath, zipMembers, zipReport) && ok;
+    unsigned mismatches = 0;
+    for (size_t i = 0; i < count; i++) {
+        bool good = i < tarMembers.size() && tarMembers[i].ok && tarMembers[i].name == names[i]
+            && tarMembers[i].digest == expected[i]
+            && i < zipMembers.size() && zipMembers[i].ok && zipMembers[i].name == names[i]
+            && zipMembers[i].digest == expected[i];
+        if (!good) mismatches++;
+    }
+    QFDigest tarWhole{}, zipWhole{};
+    ok = ok && digestFile(tarPath, tarWhole) && digestFile(zipPath, zipWhole)
+        && tarWhole == tarReport.archiveDigest && zipWhole == zipReport.archiveDigest;
+
+    std::error_code ec;
+    std::filesystem::remove_all(loose, ec);
+    std::filesystem::remove(tarPath, ec);
+    std::filesystem::remove(zipPath, ec);
+
+    double mib = double(1 << 20);
+    std::printf("%-12s %10s %12s\n", "source", "seconds", "MiB/s");
+    std::printf("%-12s %10.3f %12.1f\n", "loose files", looseSeconds, tarReport.payloadBytes / mib / looseSeconds);
+    std::printf("%-12s %10.3f %12.1f\n", "tar stream", tarReport.seconds, tarReport.payloadBytes / mib / tarReport.seconds);
+    std::printf("%-12s %10.3f %12.1f\n", "zip mapped", zipReport.seconds, zipReport.payloadBytes / mib / zipReport.seconds);
+    std::cout << "[Bench] " << count << " members, " << tarReport.payloadBytes << " payload bytes; "
+        << mismatches << " member mismatches, archive digests " << (ok ? "match" : "DIFFER")
+        << " (" << qfScheduler().workerCount() << " workers)\n";
+    return (ok && mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 16) watch [files=20000] [changes=200] [dir=<tmp>]
+//    - Fills a directory tree with 4 KiB files and starts a watcher
+//      (100 ms debounce), then rewrites `changes` files, deletes and
+//      creates a few more in one burst.
+//    - Reports the initial full scan against the time from the end of
+//      the burst to the last callback, how many files were re-digested,
+//      and whether the watcher's manifest matches a fresh scan.
+// --------------------------------------------------------------------
+static int benchWatch(const std::vector<std::string>& args) {
+    size_t files = static_cast<size_t>(std::max<unsigned long long>(16, argOr(args, 0, 20000)));
+    size_t changes = static_cast<size_t>(std::min<unsigned long long>(files / 2, argOr(args, 1, 200)));
+    std::filesystem::path dir = ((args.size() > 2) ? std::filesystem::path(args[2])
+        : std::filesystem::temp_directory_path()) / "qf_watch";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+
+    std::mt19937_64 rng(16);
+    auto writeFile = [&](const std::filesystem::path& path) {
+        std::vector<uint8_t> data(4096);
+        for (size_t k = 0; k + 8 <= data.size(); k += 8) {
+            uint64_t v = rng();
+            std::memcpy(data.data() + k, &v, 8);
+        }
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+    };
+    std::vector<std::filesystem::path> paths(files);
+    for (size_t i = 0; i < files; i++) {
+        std::filesystem::path sub = dir / ("d" + std::to_string(i % 64));
+        if (i < 64) std::filesystem::create_directories(sub);
+        paths[i] = sub / ("f" + std::to_string(i));
+        writeFile(paths[i]);
+    }
+
+    QFWatchOptions options;
+    options.debounceMs = 100;
+    QFDirectoryWatcher watcher(dir.string(), options);
+    std::atomic<uint64_t> seen{ 0 };
+    std::atomic<double> lastCallback{ 0.0 };
+    if (!watcher.start([&](QFWatchChange, const std::string&, const QFDigest*, const QFDigest*) {
+        seen++;
+        lastCallback = nowSeconds();
+    })) return EXIT_FAILURE;
+    QFWatchStats initial = watcher.stats();
+
+    // Burst: rewrite, delete, create (distinct files)
+    const size_t churn = std::max<size_t>(1, changes / 10);
+    for (size_t i = 0; i < changes; i++) writeFile(paths[i]);
+    for (size_t i = 0; i < churn; i++) std::filesystem::remove(paths[files - 1 - i], ec);
+    for (size_t i = 0; i < churn; i++) writeFile(dir / "d0" / ("new" + std::to_string(i)));
+    double burstEnd = nowSeconds();
+    const uint64_t expected = changes + 2 * churn;
+    double waitLimit = burstEnd + 10.0 + options.pollSeconds;
+    while (seen < expected && nowSeconds() < waitLimit) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));   // nothing extra may arrive
+    watcher.stop();
+    QFWatchStats stats = watcher.stats();
+
+    // The maintained manifest must equal a fresh digest of the tree
+    std::vector<std::pair<std::string, QFDigest>> live = watcher.snapshot();
+    bool match = true;
+    size_t onDisk = 0;
+    for (auto it = std::filesystem::recursive_directory_iterator(dir, ec);
+        !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_regular_file(ec)) onDisk++;
+    }
+    for (const auto& entry : live) {
+        QFDigest d{};
+        match = match && digestFile(entry.first, d) && d == entry.second;
+    }
+    match = match && live.size() == onDisk;
+    std::filesystem::remove_all(dir, ec);
+
+    std::cout << "[Bench] " << files << " files, backend " << stats.backend << ": initial scan "
+        << initial.initialSeconds * 1e3 << " ms\n"
+        << "[Bench] burst of " << expected << " changes: " << seen << " callbacks, last "
+        << (lastCallback.load() - burstEnd) * 1e3 << " ms after the burst (debounce " << options.debounceMs
+        << " ms); " << stats.rehashed << " files rehashed in " << stats.flushes << " flushes from "
+        << stats.events << " events\n"
+        << "[Bench] live manifest " << (match ? "matches" : "DIFFERS from") << " a fresh scan\n";
+    return (match && seen == expected) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 17) tree [files=100000] [changes=10] [dir=<tmp>]
+//    - Builds a three-level tree of small files, digests it bottom-up,
+//      saves and reloads the .tree file.
+//    - Rewrites `changes` files, adds one directory and changes the mode
+//      of another, rebuilds, and diffs the saved snapshot against the
+//      new tree: checks the counts and reports how many nodes the
+//      descent visited out of the whole tree.
+// --------------------------------------------------------------------
+static int benchTree(const std::vector<std::string>& args) {
+    size_t files = static_cast<size_t>(std::max<unsigned long long>(1, argOr(args, 0, 100000)));
+    size_t changes = static_cast<size_t>(std::min<unsigned long long>(files, argOr(args, 1, 10)));
+    std::filesystem::path base = (args.size() > 2) ? std::filesystem::path(args[2])
+        : std::filesystem::temp_directory_path();
+    std::filesystem::path dir = base / "qf_tree";
+    const std::string snapshot = (base / "qf_tree.tree").string();
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+
+    std::mt19937_64 rng(17);
+    auto writeFile = [&](const std::filesystem::path& path) {
+        std::vector<uint8_t> data(1024 + rng() % 3072);
+        for (uint8_t& b : data) b = static_cast<uint8_t>(rng());
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+    };
+    std::vector<std::filesystem::path> paths(files);
+    for (size_t i = 0; i < files; i++) {
+        std::filesystem::path sub = dir / ("a" + std::to_string(i % 32)) / ("b" + std::to_string((i / 32) % 32));
+        if (i < 1024) std::filesystem::create_directories(sub);
+        paths[i] = sub / ("f" + std::to_string(i));
+        writeFile(paths[i]);
+    }
+
+    QFTree before;
+    QFTreeReport buildReport;
+    bool ok = before.build(dir.string(), buildReport) && before.save(snapshot);
+    double start = nowSeconds();
+    QFTree loaded;
+    ok = ok && loaded.load(snapshot) && loaded.rootDigest() == before.rootDigest();
+    double loadSeconds = nowSeconds() - start;
+
+    std::unordered_set<size_t> rewritten;
+    for (size_t i = 0; i < changes; i++) {
+        size_t k = rng() % files;
+        writeFile(paths[k]);
+        rewritten.insert(k);
+    }
+    std::filesystem::create_directories(dir / "added");
+    writeFile(dir / "added" / "x");
+    const std::filesystem::path chmodded = dir / "a0" / "b0";
+    const std::filesystem::perms ownerOnly = std::filesystem::perms::owner_all;
+    std::filesystem::permissions(chmodded, (std::filesystem::status(chmodded).permissions() == ownerOnly)
+        ? ownerOnly | std::filesystem::perms::group_read | std::filesystem::perms::group_exec : ownerOnly);
+    QFTree after;
+    QFTreeReport rebuild;
+    ok = ok && after.build(dir.string(), rebuild);
+
+    QFTreeDiffReport diff;
+    diffTrees(loaded, after, nullptr, diff);
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::remove(snapshot, ec);
+
+    std::cout << "[Bench] " << buildReport.files << " files, " << buildReport.directories << " directories: scan "
+        << buildReport.scanSeconds * 1e3 << " ms, files " << buildReport.hashSeconds * 1e3 << " ms, directories "
+        << buildReport.treeSeconds * 1e3 << " ms; .tree reload + verify " << loadSeconds * 1e3 << " ms\n"
+        << "[Bench] after " << changes << " rewrites + 1 new directory + 1 chmod: " << diff.changed << " changed, "
+        << diff.added << " added, " << diff.removed << " removed; visited " << diff.visited << " of "
+        << diff.newNodes << " nodes in " << diff.seconds * 1e6 << " us\n";
+    bool counts = diff.added == 1 && diff.removed == 0 && diff.changed == rewritten.size() + 1;
+    return (ok && counts) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 18) scrub [files=64] [MiB=4] [ioMiBps=64] [cpu=0.5] [dir=<tmp>]
+//    - Writes `files` random files and their manifest, then scrubs them
+//      twice: unthrottled, and under the I/O and CPU budgets.  Reports
+//      achieved MiB/s and CPU cores against the budgets.
+//    - Flips one byte in one file and deletes another before the
+//      throttled pass; both must be reported, and a reopened state must
+//      have nothing due.
+// --------------------------------------------------------------------
+static int benchScrub(const std::vector<std::string>& args) {
+    size_t files = static_cast<size_t>(std::max<unsigned long long>(2, argOr(args, 0, 64)));
+    size_t bytes = static_cast<size_t>(argOr(args, 1, 4)) << 20;
+    double ioMiB = static_cast<double>(argOr(args, 2, 64));
+    double cores = (args.size() > 3) ? std::strtod(args[3].c_str(), nullptr) : 0.5;
+    std::filesystem::path dir = ((args.size() > 4) ? std::filesystem::path(args[4])
+        : std::filesystem::temp_directory_path()) / "qf_scrub";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directories(dir);
+    const std::string manifest = (dir / "manifest.txt").string();
+    const std::string state = (dir / "scrub.state").string();
+
+    std::mt19937_64 rng(18);
+    std::vector<std::string> paths(files);
+    {
+        std::ofstream list(manifest);
+        std::vector<uint8_t> data(bytes);
+        for (size_t i = 0; i < files; i++) {
+            for (size_t k = 0; k + 8 <= bytes; k += 8) {
+                uint64_t v = rng();
+                std::memcpy(data.data() + k, &v, 8);
+            }
+            paths[i] = (dir / ("f" + std::to_string(i) + ".bin")).string();
+            std::ofstream(paths[i], std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+            QFDigest d{};
+            digestFile(paths[i], d);
+            list << toHex(d.data(), d.size()) << "  " << paths[i] << "\n";
+        }
+    }
+
+    QFScrubOptions fast;
+    fast.ioBytesPerSecond = 0.0;
+    fast.cpuCores = 0.0;
+    fast.lowPriority = false;
+    QFScrubReport unthrottled, throttled;
+    QFScrubber first;
+    bool ok = first.open(state) && first.importManifest(manifest) == static_cast<long>(files)
+        && first.run(fast, unthrottled) && unthrottled.verified == files && unthrottled.corrupt == 0;
+
+    // Rot one file, lose another; everything is due again
+    {
+        std::fstream f(paths[0], std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(bytes / 2);
+        f.put('\x5a');
+    }
+    std::filesystem::remove(paths[1], ec);
+    QFScrubOptions budget;
+    budget.ioBytesPerSecond = ioMiB * (1 << 20);
+    budget.cpuCores = cores;
+    budget.intervalSeconds = 0;
+    std::vector<std::string> flagged;
+    ok = ok && first.run(budget, throttled, [&](const std::string& path, QFScrubStatus status, const QFDigest&, const QFDigest&) {
+        if (status != QFScrubStatus::Ok) flagged.push_back(std::string(qfScrubStatusName(status)) + " " + path);
+    });
+    bool detected = throttled.corrupt == 1 && throttled.missing == 1 && flagged.size() == 2;
+
+    QFScrubber reopened;
+    bool resumed = reopened.open(state) && reopened.size() == files
+        && reopened.secondsUntilDue(QFScrubOptions().intervalSeconds) > 0;
+    std::filesystem::remove_all(dir, ec);
+
+    double mib = double(1 << 20);
+    std::printf("%-12s %10s %10s %10s %10s\n", "pass", "seconds", "MiB/s", "CPU cores", "threads");
+    std::printf("%-12s %10.3f %10.1f %10.2f %10u\n", "unthrottled", unthrottled.seconds,
+        unthrottled.bytes / mib / unthrottled.seconds, unthrottled.cpuSeconds / unthrottled.seconds, unthrottled.threads);
+    std::printf("%-12s %10.3f %10.1f %10.2f %10u\n", "budget", throttled.seconds,
+        throttled.bytes / mib / throttled.seconds, throttled.cpuSeconds / throttled.seconds, throttled.threads);
+    std::cout << "[Bench] budget " << ioMiB << " MiB/s, " << cores << " cores (" << qfAvailableCpus()
+        << " CPUs available); rot + loss " << (detected ? "detected" : "MISSED") << "; reopened state "
+        << (resumed ? "resumes" : "DIFFERS") << "\n";
+    return (ok && detected && resumed) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 19) kdf [maxMiB=256] [passes=3] [lanes=4]
+//    - Derives one key per memory size (1 MiB doubling up to maxMiB) and
+//      reports seconds and fill rate, then the same 16 MiB derivation
+//      with 1 lane versus `lanes` lanes.
+//    - Checks that the key is deterministic, that salt/passphrase/cost
+//      changes alter it, and that an encoded verifier round-trips.
+// --------------------------------------------------------------------
+static int benchKdf(const std::vector<std::string>& args) {
+    uint32_t maxMiB = static_cast<uint32_t>(std::max<unsigned long long>(1, argOr(args, 0, 256)));
+    uint32_t passes = static_cast<uint32_t>(std::max<unsigned long long>(1, argOr(args, 1, 3)));
+    uint32_t lanes = static_cast<uint32_t>(std::max<unsigned long long>(1, argOr(args, 2, 4)));
+    const std::string password = "correct horse battery staple";
+    const std::string salt = "qf-bench-salt-0001";
+    auto derive = [&](const std::string& pw, const std::string& s, const QFKdfParams& p, std::array<uint8_t, 32>& key) {
+        return qfKdf(reinterpret_cast<const uint8_t*>(pw.data()), pw.size(),
+            reinterpret_cast<const uint8_t*>(s.data()), s.size(), p, key.data(), key.size());
+    };
+
+    bool ok = true;
+    std::printf("%-10s %8s %8s %10s %12s\n", "memory", "passes", "lanes", "seconds", "MiB/s fill");
+    for (uint32_t mib = 1; mib <= maxMiB; mib *= 2) {
+        QFKdfParams p;
+        p.memoryKiB = mib << 10;
+        p.passes = passes;
+        p.lanes = lanes;
+        std::array<uint8_t, 32> key{};
+        double start = nowSeconds();
+        ok = derive(password, salt, p, key) && ok;
+        double seconds = nowSeconds() - start;
+        std::printf("%7u MiB %8u %8u %10.3f %12.1f\n", mib, passes, lanes, seconds, double(mib) * passes / seconds);
+    }
+    for (uint32_t l : { 1u, lanes }) {
+        QFKdfParams p;
+        p.memoryKiB = 16 << 10;
+        p.passes = passes;
+        p.lanes = l;
+        std::array<uint8_t, 32> key{};
+        double start = nowSeconds();
+        ok = derive(password, salt, p, key) && ok;
+        std::printf("%-10s %8u %8u %10.3f\n", "16 MiB", passes, l, nowSeconds() - start);
+    }
+
+    QFKdfParams small;
+    small.memoryKiB = 256;
+    small.passes = 2;
+    std::array<uint8_t, 32> a{}, b{}, c{}, d{}, e{};
+    ok = derive(password, salt, small, a) && derive(password, salt, small, b) && ok;
+    ok = derive(password + "!", salt, small, c) && derive(password, salt + "!", small, d) && ok;
+    QFKdfParams costlier = small;
+    costlier.passes = 3;
+    ok = derive(password, salt, costlier, e) && ok;
+    bool distinct = a == b && a != c && a != d && a != e && c != d;
+    std::string encoded;
+    bool verifier = qfKdfEncode(password, reinterpret_cast<const uint8_t*>(salt.data()), salt.size(), small, 32, encoded)
+        && qfKdfVerify(password, encoded) && !qfKdfVerify(password + "x", encoded);
+
+    std::cout << "[Bench] deterministic + input-sensitive: " << (distinct ? "yes" : "NO") << "; verifier "
+        << (verifier ? "round-trips" : "FAILED") << " (" << qfScheduler().workerCount() << " workers)\n";
+    return (ok && distinct && verifier) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 20) aead [MiB=256] [chunkKiB=1024] [dir]
+//    - One core: plain hash (qfAbsorb) of the buffer versus sealing and
+//      opening it as a single duplex chunk, then the same buffer as
+//      chunks sealed / opened / hashed in parallel on the scheduler.
+//    - Round-trips a file through qfSealFile / qfOpenSealedFile, and
+//      checks that a flipped ciphertext byte fails exactly its own chunk
+//      and that a sealed file cut at a chunk boundary is rejected.
+// --------------------------------------------------------------------
+static int benchAead(const std::vector<std::string>& args) {
+    size_t bytes = static_cast<size_t>(std::max<unsigned long long>(1, argOr(args, 0, 256))) << 20;
+    size_t chunk = static_cast<size_t>(std::max<unsigned long long>(1, argOr(args, 1, 1024))) << 10;
+    std::filesystem::path dir = args.size() > 2 ? std::filesystem::path(args[2])
+        : std::filesystem::temp_directory_path();
+
+    std::vector<uint8_t> plain(bytes);
+    std::mt19937_64 rng(23);
+    for (size_t i = 0; i + 8 <= bytes; i += 8) {
+        uint64_t v = rng();
+        std::memcpy(&plain[i], &v, 8);
+    }
+    uint8_t key[QF_AEAD_KEY_BYTES], nonce[QF_AEAD_NONCE_BYTES] = { 0 };
+    for (size_t i = 0; i < sizeof(key); i++) key[i] = static_cast<uint8_t>(rng());
+    QFAead aead(key);
+    std::vector<uint8_t> sealed(bytes), opened(bytes);
+    uint8_t tag[QF_AEAD_TAG_BYTES];
+    double mib = double(1 << 20);
+
+    std::printf("%-22s %10s %10s\n", "path", "seconds", "MiB/s");
+    auto row = [&](const char* name, double seconds) {
+        std::printf("%-22s %10.3f %10.1f\n", name, seconds, bytes / mib / seconds);
+    };
+
+    double start = nowSeconds();
+    QFState qs;
+    qfInit(qs);
+    qfAbsorb(qs, plain.data(), plain.size());
+    uint8_t digest[64];
+    qfSqueeze(qs, digest, sizeof(digest));
+    row("hash, 1 core", nowSeconds() - start);
+
+    start = nowSeconds();
+    aead.sealChunk(nonce, 0, true, plain.data(), bytes, sealed.data(), tag);
+    row("seal, 1 core", nowSeconds() - start);
+    start = nowSeconds();
+    bool ok = aead.openChunk(nonce, 0, true, sealed.data(), bytes, opened.data(), tag) && opened == plain;
+    row("open, 1 core", nowSeconds() - start);
+
+    size_t chunks = (bytes + chunk - 1) / chunk;
+    std::vector<uint8_t> tags(chunks * QF_AEAD_TAG_BYTES), verified(chunks);
+    auto lenOf = [&](size_t i) { return std::min(chunk, bytes - i * chunk); };
+
+    start = nowSeconds();
+    qfScheduler().parallelFor(chunks, [&](size_t i) {
+        QFState s;
+        qfInit(s);
+        qfAbsorb(s, plain.data() + i * chunk, lenOf(i));
+        qfSqueeze(s, tags.data() + i * QF_AEAD_TAG_BYTES, QF_AEAD_TAG_BYTES);
+    });
+    row("hash, chunks parallel", nowSeconds() - start);
+
+    start = nowSeconds();
+    qfScheduler().parallelFor(chunks, [&](size_t i) {
+        aead.sealChunk(nonce, i, i + 1 == chunks, plain.data() + i * chunk, lenOf(i),
+            sealed.data() + i * chunk, tags.data() + i * QF_AEAD_TAG_BYTES);
+    });
+    row("seal, chunks parallel", nowSeconds() - start);
+
+    std::fill(opened.begin(), opened.end(), 0);
+    start = nowSeconds();
+    qfScheduler().parallelFor(chunks, [&](size_t i) {
+        verified[i] = aead.openChunk(nonce, i, i + 1 == chunks, sealed.data() + i * chunk, lenOf(i),
+            opened.data() + i * chunk, tags.data() + i * QF_AEAD_TAG_BYTES) ? 1 : 0;
+    });
+    row("open, chunks parallel", nowSeconds() - start);
+    ok = ok && opened == plain && std::count(verified.begin(), verified.end(), 1) == static_cast<long>(chunks);
+
+    // Tampering: only the chunk holding the flipped byte fails
+    size_t victim = chunks / 2;
+    sealed[victim * chunk + lenOf(victim) / 2] ^= 0x20;
+    size_t failures = 0;
+    bool victimFailed = false;
+    for (size_t i = 0; i < chunks; i++) {
+        bool good = aead.openChunk(nonce, i, i + 1 == chunks, sealed.data() + i * chunk, lenOf(i),
+            opened.data() + i * chunk, tags.data() + i * QF_AEAD_TAG_BYTES);
+        if (!good) {
+            failures++;
+            victimFailed = i == victim;
+        }
+    }
+    bool tamperCaught = failures == 1 && victimFailed;
+
+    // Files: round trip, then a copy missing its last chunk
+    std::string plainPath = (dir / "qf_bench_aead.bin").string();
+    std::string sealedPath = plainPath + ".sealed";
+    std::string openedPath = plainPath + ".opened";
+    std::string cutPath = plainPath + ".cut";
+    {
+        std::ofstream out(plainPath, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(plain.data()), static_cast<std::streamsize>(std::min<size_t>(bytes, 64 << 20)) - 77);
+    }
+    QFSealOptions options;
+    options.chunkSize = chunk;
+    QFSealReport sealReport, openReport, cutReport;
+    bool files = qfSealFile(plainPath, sealedPath, key, options, sealReport)
+        && qfOpenSealedFile(sealedPath, openedPath, key, openReport)
+        && std::filesystem::file_size(openedPath) == std::filesystem::file_size(plainPath);
+    if (files) {
+        std::ifstream a(plainPath, std::ios::binary), b(openedPath, std::ios::binary);
+        files = std::equal(std::istreambuf_iterator<char>(a), std::istreambuf_iterator<char>(),
+            std::istreambuf_iterator<char>(b), std::istreambuf_iterator<char>());
+    }
+    bool cutRejected = false;
+    if (files && sealReport.chunks > 1) {
+        std::error_code ec;
+        std::filesystem::copy_file(sealedPath, cutPath, std::filesystem::copy_options::overwrite_existing, ec);
+        std::filesystem::resize_file(cutPath, QF_SEAL_HEADER_BYTES + (sealReport.chunks - 1) * (options.chunkSize + QF_AEAD_TAG_BYTES), ec);
+        std::cerr << "[Bench] expecting an authentication failure:\n";
+        cutRejected = !ec && !qfOpenSealedFile(cutPath, openedPath, key, cutReport)
+            && !std::filesystem::exists(openedPath);
+    }
+    std::error_code ec;
+    for (const std::string& p : { plainPath, sealedPath, openedPath, cutPath }) std::filesystem::remove(p, ec);
+
+    std::printf("%-22s %10.3f %10.1f\n", "seal file", sealReport.seconds, sealReport.bytes / mib / sealReport.seconds);
+    std::printf("%-22s %10.3f %10.1f\n", "open file", openReport.seconds, openReport.bytes / mib / openReport.seconds);
+    std::cout << "[Bench] " << chunks << " chunks of " << (chunk >> 10) << " KiB on " << qfScheduler().workerCount()
+        << " workers; round trip " << (ok && files ? "ok" : "FAILED") << "; tamper "
+        << (tamperCaught ? "caught in its chunk" : "MISSED") << "; truncation "
+        << (cutRejected ? "rejected" : "MISSED") << "\n";
+    return (ok && files && tamperCaught && cutRejected) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 21) ctr [MiB=256] [reads=2000] [dir]
+//    - Keystream rate with the scalar permutation, four blocks per
+//      qfPermutationX4, and split over the scheduler, next to the plain
+//      hash of the same bytes.
+//    - Round-trips a file through qfCtrEncryptFile / qfCtrDecryptFile,
+//      then checks random ranges read through QFCtrReader against the
+//      plaintext and reports reads per second.
+// --------------------------------------------------------------------
+static int benchCtr(const std::vector<std::string>& args) {
+    size_t bytes = static_cast<size_t>(std::max<unsigned long long>(1, argOr(args, 0, 256))) << 20;
+    size_t reads = static_cast<size_t>(argOr(args, 1, 2000));
+    std::filesystem::path dir = args.size() > 2 ? std::filesystem::path(args[2])
+        : std::filesystem::temp_directory_path();
+
+    std::vector<uint8_t> plain(bytes), cipher(bytes), back(bytes);
+    std::mt19937_64 rng(29);
+    for (size_t i = 0; i + 8 <= bytes; i += 8) {
+        uint64_t v = rng();
+        std::memcpy(&plain[i], &v, 8);
+    }
+    uint8_t key[QF_AEAD_KEY_BYTES], nonce[QF_AEAD_NONCE_BYTES];
+    for (uint8_t& b : key) b = static_cast<uint8_t>(rng());
+    for (uint8_t& b : nonce) b = static_cast<uint8_t>(rng());
+    QFKeystream stream(key, nonce);
+    double mib = double(1 << 20);
+
+    std::printf("%-22s %10s %10s\n", "path", "seconds", "MiB/s");
+    auto row = [&](const char* name, double seconds) {
+        std::printf("%-22s %10.3f %10.1f\n", name, seconds, bytes / mib / seconds);
+    };
+
+    double start = nowSeconds();
+    QFState qs;
+    qfInit(qs);
+    qfAbsorb(qs, plain.data(), plain.size());
+    uint8_t digest[64];
+    qfSqueeze(qs, digest, sizeof(digest));
+    row("hash, 1 core", nowSeconds() - start);
+
+    size_t blocks = bytes / QF_KEYSTREAM_BLOCK_BYTES;
+    start = nowSeconds();
+    for (size_t i = 0; i < blocks; i++) stream.block(i, &cipher[i * QF_KEYSTREAM_BLOCK_BYTES]);
+    row("keystream, scalar", nowSeconds() - start);
+    start = nowSeconds();
+    stream.blocks(0, blocks, back.data());
+    row("keystream, x4", nowSeconds() - start);
+    bool same = std::memcmp(cipher.data(), back.data(), blocks * QF_KEYSTREAM_BLOCK_BYTES) == 0;
+
+    start = nowSeconds();
+    stream.applyParallel(0, plain.data(), cipher.data(), bytes);
+    row("encrypt, parallel", nowSeconds() - start);
+    stream.apply(0, cipher.data(), back.data(), bytes);
+    bool ok = same && back == plain && cipher != plain;
+
+    // Seeking: every byte offset decrypts on its own
+    for (size_t r = 0; ok && r < 1000; r++) {
+        size_t at = static_cast<size_t>(rng() % bytes);
+        size_t len = std::min<size_t>(bytes - at, 1 + rng() % 700);
+        uint8_t piece[700];
+        stream.apply(at, cipher.data() + at, piece, len);
+        ok = std::memcmp(piece, plain.data() + at, len) == 0;
+    }
+
+    std::string plainPath = (dir / "qf_bench_ctr.bin").string();
+    std::string encPath = plainPath + ".ctr";
+    std::string decPath = plainPath + ".out";
+    size_t fileBytes = std::min<size_t>(bytes, 64 << 20) - 13;
+    {
+        std::ofstream out(plainPath, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(plain.data()), static_cast<std::streamsize>(fileBytes));
+    }
+    QFCtrReport encReport, decReport;
+    bool files = qfCtrEncryptFile(plainPath, encPath, key, encReport)
+        && qfCtrDecryptFile(encPath, decPath, key, decReport)
+        && std::filesystem::file_size(decPath) == fileBytes;
+    if (files) {
+        std::ifstream in(decPath, std::ios::binary);
+        std::vector<char> got(fileBytes);
+        in.read(got.data(), static_cast<std::streamsize>(fileBytes));
+        files = std::memcmp(got.data(), plain.data(), fileBytes) == 0;
+    }
+
+    QFCtrReader reader;
+    bool seeks = files && reader.open(encPath, key) && reader.size() == fileBytes;
+    std::vector<uint8_t> piece(64 << 10);
+    start = nowSeconds();
+    for (size_t r = 0; seeks && r < reads; r++) {
+        uint64_t at = rng() % fileBytes;
+        size_t len = 1 + static_cast<size_t>(rng() % piece.size());
+        long got = reader.readAt(piece.data(), len, at);
+        size_t expect = static_cast<size_t>(std::min<uint64_t>(len, fileBytes - at));
+        seeks = got == static_cast<long>(expect) && std::memcmp(piece.data(), plain.data() + at, expect) == 0;
+    }
+    double seekSeconds = nowSeconds() - start;
+    reader.close();
+    std::error_code ec;
+    for (const std::string& p : { plainPath, encPath, decPath }) std::filesystem::remove(p, ec);
+
+    std::printf("%-22s %10.3f %10.1f\n", "encrypt file", encReport.seconds, encReport.bytes / mib / encReport.seconds);
+    std::printf("%-22s %10.3f %10.1f\n", "decrypt file", decReport.seconds, decReport.bytes / mib / decReport.seconds);
+    std::cout << "[Bench] " << reads << " random reads (up to 64 KiB) in " << seekSeconds << " s ("
+        << reads / seekSeconds << "/s) on " << qfScheduler().workerCount() << " workers; x4 matches scalar: "
+        << (same ? "yes" : "NO") << "; round trip " << (ok && files ? "ok" : "FAILED") << "; seeks "
+        << (seeks ? "ok" : "FAILED") << "\n";
+    return (ok && files && seeks) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 22) encode [lines=1000000] [dir]
+//    - 64-byte digests through snprintf("%02x") per byte (the old demo
+//      path), qfHexEncode / qfHexDecode and qfBase64Encode / Decode, in
+//      digests per second.
+//    - Writes the same manifest with an iostream line per entry and with
+//      QFManifestWriter, reports lines per second and compares the files.
+//    - Checks codecs against simple references for every length up to
+//      200 bytes and that bad characters are rejected in any position.
+// --------------------------------------------------------------------
+static std::string referenceBase64(const uint8_t* data, size_t len) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = uint32_t(data[i]) << 16;
+        if (i + 1 < len) v |= uint32_t(data[i + 1]) << 8;
+        if (i + 2 < len) v |= data[i + 2];
+        out += ALPHABET[(v >> 18) & 63];
+        out += ALPHABET[(v >> 12) & 63];
+        out += i + 1 < len ? ALPHABET[(v >> 6) & 63] : '=';
+        out += i + 2 < len ? ALPHABET[v & 63] : '=';
+    }
+    return out;
+}
+
+static int benchEncode(const std::vector<std::string>& args) {
+    size_t lines = static_cast<size_t>(std::max<unsigned long long>(1, argOr(args, 0, 1000000)));
+    std::filesystem::path dir = args.size() > 1 ? std::filesystem::path(args[1])
+        : std::filesystem::temp_directory_path();
+
+    std::mt19937_64 rng(31);
+    std::vector<uint8_t> digests(lines * 64);
+    for (size_t i = 0; i + 8 <= digests.size(); i += 8) {
+        uint64_t v = rng();
+        std::memcpy(&digests[i], &v, 8);
+    }
+
+    // Correctness first: every length, and a bad character in every position
+    bool ok = true;
+    std::vector<uint8_t> back(256);
+    for (size_t len = 0; ok && len <= 200; len++) {
+        const uint8_t* d = digests.data() + len;
+        std::string ref;
+        char pair[3];
+        for (size_t i = 0; i < len; i++) {
+            std::snprintf(pair, sizeof(pair), "%02x", d[i]);
+            ref += pair;
+        }
+        std::string hex(qfHexLength(len), '?');
+        qfHexEncode(d, len, &hex[0]);
+        std::string upper = hex;
+        for (char& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        ok = hex == ref && qfHexDecode(hex.data(), hex.size(), back.data()) && std::memcmp(back.data(), d, len) == 0
+            && qfHexDecode(upper.data(), upper.size(), back.data()) && std::memcmp(back.data(), d, len) == 0;
+
+        std::string b64 = toBase64(d, len);
+        size_t outLen = 0;
+        ok = ok && b64 == referenceBase64(d, len) && qfBase64Decode(b64.data(), b64.size(), back.data(), outLen)
+            && outLen == len && std::memcmp(back.data(), d, len) == 0;
+        for (size_t pos = 0; ok && pos < hex.size(); pos++) {
+            std::string bad = hex;
+            bad[pos] = pos % 2 ? 'g' : ':';
+            ok = !qfHexDecode(bad.data(), bad.size(), back.data());
+        }
+        for (size_t pos = 0; ok && pos < b64.size(); pos++) {
+            if (b64[pos] == '=') continue;
+            std::string bad = b64;
+            bad[pos] = pos % 2 ? '*' : '\xC3';
+            ok = !qfBase64Decode(bad.data(), bad.size(), back.data(), outLen);
+        }
+    }
+
+    std::printf("%-24s %10s %14s\n", "codec (64-byte digests)", "seconds", "digests/s");
+    auto row = [&](const char* name, double seconds) {
+        std::printf("%-24s %10.3f %14.0f\n", name, seconds, lines / seconds);
+    };
+    std::vector<char> text(lines * 128);
+    uint64_t sink = 0;
+
+    double start = nowSeconds();
+    char pair[3];
+    for (size_t i = 0; i < lines; i++) {
+        for (size_t k = 0; k < 64; k++) {
+            std::snprintf(pair, sizeof(pair), "%02x", digests[i * 64 + k]);
+            text[i * 128 + 2 * k] = pair[0];
+            text[i * 128 + 2 * k + 1] = pair[1];
+        }
+    }
+    row("snprintf %02x", nowSeconds() - start);
+    std::vector<char> reference(text);
+
+    start = nowSeconds();
+    for (size_t i = 0; i < lines; i++) qfHexEncode(&digests[i * 64], 64, &text[i * 128]);
+    row("hex encode", nowSeconds() - start);
+    ok = ok && text == reference;
+
+    std::vector<uint8_t> decoded(lines * 64);
+    start = nowSeconds();
+    for (size_t i = 0; i < lines; i++) ok = qfHexDecode(&text[i * 128], 128, &decoded[i * 64]) && ok;
+    row("hex decode", nowSeconds() - start);
+    ok = ok && decoded == digests;
+
+    start = nowSeconds();
+    for (size_t i = 0; i < lines; i++) qfBase64Encode(&digests[i * 64], 64, &text[i * 88]);
+    row("base64 encode", nowSeconds() - start);
+    std::fill(decoded.begin(), decoded.end(), 0);
+    start = nowSeconds();
+    for (size_t i = 0; i < lines; i++) {
+        size_t outLen = 0;
+        ok = qfBase64Decode(&text[i * 88], 88, &decoded[i * 64], outLen) && outLen == 64 && ok;
+        sink += outLen;
+    }
+    row("base64 decode", nowSeconds() - start);
+    ok = ok && decoded == digests && sink == lines * 64;
+
+    // Manifests: "<hex>  <path>\n" per entry
+    std::vector<std::string> paths(lines);
+    for (size_t i = 0; i < lines; i++) paths[i] = "data/shard" + std::to_string(i % 97) + "/object_" + std::to_string(i) + ".bin";
+    std::string streamPath = (dir / "qf_bench_manifest_stream.txt").string();
+    std::string writerPath = (dir / "qf_bench_manifest_writer.txt").string();
+
+    start = nowSeconds();
+    {
+        std::ofstream out(streamPath, std::ios::binary);
+        for (size_t i = 0; i < lines; i++) out << toHex(&digests[i * 64], 64) << "  " << paths[i] << "\n";
+    }
+    double streamSeconds = nowSeconds() - start;
+
+    start = nowSeconds();
+    bool written = false;
+    int fd = qfOpenWrite(writerPath);
+    if (fd >= 0) {
+        QFManifestWriter writer(fd);
+        for (size_t i = 0; i < lines; i++) writer.add(&digests[i * 64], 64, paths[i]);
+        written = writer.flush() && writer.lines() == lines;
+        qfClose(fd);
+    }
+    double writerSeconds = nowSeconds() - start;
+
+    bool same = written;
+    if (same) {
+        std::ifstream a(streamPath, std::ios::binary), b(writerPath, std::ios::binary);
+        same = std::equal(std::istreambuf_iterator<char>(a), std::istreambuf_iterator<char>(),
+            std::istreambuf_iterator<char>(b), std::istreambuf_iterator<char>());
+    }
+    std::error_code ec;
+    std::filesystem::remove(streamPath, ec);
+    std::filesystem::remove(writerPath, ec);
+
+    std::printf("%-24s %10s %14s\n", "manifest", "seconds", "lines/s");
+    std::printf("%-24s %10.3f %14.0f\n", "iostream per line", streamSeconds, lines / streamSeconds);
+    std::printf("%-24s %10.3f %14.0f\n", "QFManifestWriter", writerSeconds, lines / writerSeconds);
+    std::cout << "[Bench] codecs match references: " << (ok ? "yes" : "NO") << "; manifests identical: "
+        << (same ? "yes" : "NO") << "\n";
+    return (ok && same) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// 23) async [MiB=64] [dir]
+//    - Hashes one regular file and the same bytes streamed through a
+//      pipe with each QFIoContext backend (io_uring, epoll, sync): the
+//      file through qfHashFileAsync on the loop thread, the pipe through
+//      QFAsyncHasher::updateAsync with the scheduler as executor.
+//    - Every digest must equal digestFile() of the file.  A backend the
+//      platform lacks falls back and is reported under its real name.
+// --------------------------------------------------------------------
+static bool makePipe(int fds[2]) {
+#if defined(_WIN32)
+    return _pipe(fds, 1 << 16, _O_BINARY) == 0;
+#else
+    return ::pipe(fds) == 0;
+#endif
+}
+
+static int benchAsync(const std::vector<std::string>& args) {
+    size_t bytes = (static_cast<size_t>(std::max<unsigned long long>(1, argOr(args, 0, 64))) << 20) + 77;
+    std::filesystem::path dir = args.size() > 1 ? std::filesystem::path(args[1])
+        : std::filesystem::temp_directory_path();
+    std::string path = (dir / "qf_bench_async.bin").string();
+
+    std::vector<uint8_t> data(bytes);
+    std::mt19937_64 rng(37);
+    for (size_t i = 0; i + 8 <= bytes; i += 8) {
+        uint64_t v = rng();
+        std::memcpy(&data[i], &v, 8);
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(bytes));
+    }
+    QFDigest expected{};
+    bool ok = digestFile(path, expected);
+    double mib = double(1 << 20);
+
+    std::printf("%-10s %-10s %10s %10s %8s\n", "requested", "backend", "source", "MiB/s", "match");
+    const struct { const char* name; QFIoBackend backend; } backends[] = {
+        { "io_uring", QFIoBackend::Uring }, { "epoll", QFIoBackend::Epoll }, { "sync", QFIoBackend::Sync } };
+    for (const auto& b : backends) {
+        QFIoContext io(64, b.backend);
+
+        QFDigest digest{};
+        double start = nowSeconds();
+        QFTask<bool> fileTask = qfHashFileAsync(io, path, digest.data(), digest.size());
+        bool good = qfRunSync(io, fileTask) && digest == expected;
+        std::printf("%-10s %-10s %10s %10.1f %8s\n", b.name, io.backendName(), "file",
+            bytes / mib / (nowSeconds() - start), good ? "yes" : "NO");
+        ok = ok && good;
+
+        int fds[2];
+        if (!makePipe(fds)) {
+            std::cerr << "[Bench] pipe() failed\n";
+            ok = false;
+            continue;
+        }
+        start = nowSeconds();
+        std::thread writer([&data, bytes, fd = fds[1]]() {
+            qfWriteAll(fd, data.data(), bytes);
+            qfClose(fd);
+        });
+        QFAsyncHasher hasher(io, &qfScheduler());
+        QFTask<bool> pipeTask = hasher.updateAsync(fds[0]);
+        good = qfRunSync(io, pipeTask);
+        writer.join();
+        qfClose(fds[0]);
+        hasher.finalize(digest.data(), digest.size());
+        good = good && digest == expected;
+        std::printf("%-10s %-10s %10s %10.1f %8s\n", b.name, io.backendName(), "pipe",
+            bytes / mib / (nowSeconds() - start), good ? "yes" : "NO");
+        ok = ok && good;
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    std::cout << "[Bench] " << bytes << " bytes; async digests match digestFile: " << (ok ? "yes" : "NO") << "\n";
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// --------------------------------------------------------------------
+// Registry
+// --------------------------------------------------------------------
+struct BenchEntry {
+    const char* name;
+    const char* help;
+    int (*run)(const std::vector<std::string>& args);
+};
+
+static const BenchEntry BENCHMARKS[] = {
+    { "scheduler", "[maxThreads=64] [totalMiB=32]  work-stealing scaling on mixed file sizes",
+      benchScheduler },
+    { "arena", "[bufferMiB=4] [rounds=64]  huge-page arena vs fresh read buffers",
+      benchArena },
+    { "smallfiles", "[files=1000000] [dir]  batched small-file reads (io_uring / pool) vs per-file",
+      benchSmallFiles },
+    { "sparse", "[logicalMiB=256] [dataMiB=16] [file]  extent-aware reads of a sparse image vs dense",
+      benchSparse },
+    { "multi", "[MiB=64] [file]  QF-512 + SHA-256 + CRC32C: three passes vs one",
+      benchMulti },
+    { "dupes", "[files=2000] [dir]  staged duplicate search: bytes read vs full hashing",
+      benchDupes },
+    { "manifest", "[entries=1000000] [memoryMiB=16]  external-sort manifest diff under a memory budget",
+      benchManifest },
+    { "short", "[iterations=200000]  qfHashShort vs init/absorb/squeeze for < 128-byte messages",
+      benchShort },
+    { "multiset", "[elements=1000000]  order-independent multiset hash vs sort + hash",
+      benchMultiset },
+    { "sketches", "[events=2000000] [distinct=500000]  HyperLogLog + Count-Min: add vs batched, merge, size",
+      benchSketches },
+    { "bloom", "[keys=2000000] [fpr=0.001] [file]  blocked Bloom filter: per-key vs batched, mapped view",
+      benchBloom },
+    { "routing", "[keys=1000000] [nodes=64]  jump / rendezvous routing and sampling decisions per second",
+      benchRouting },
+    { "delta", "[MiB=64] [edits=64] [dir]  rsync-style signature / delta / patch round trip",
+      benchDelta },
+    { "mlog", "[appends=200000] [threads=64] [dir]  group-committed Merkle audit log + proofs",
+      benchMerkleLog },
+    { "archive", "[members=2000] [dir]  per-member digests of tar / zip archives vs loose files",
+      benchArchive },
+    { "watch", "[files=20000] [changes=200] [dir]  incremental manifest from inotify vs full rescan",
+      benchWatch },
+    { "tree", "[files=100000] [changes=10] [dir]  bottom-up directory digests and change-proportional tree diff",
+      benchTree },
+    { "scrub", "[files=64] [MiB=4] [ioMiBps=64] [cpu=0.5] [dir]  throttled bit-rot scrub vs unthrottled",
+      benchScrub },
+    { "kdf", "[maxMiB=256] [passes=3] [lanes=4]  memory-hard KDF: time vs memory cost, lane scaling",
+      benchKdf },
+    { "aead", "[MiB=256] [chunkKiB=1024] [dir]  duplex encryption vs plain hashing, chunked seal/open",
+      benchAead },
+    { "ctr", "[MiB=256] [reads=2000] [dir]  counter-mode keystream: scalar vs x4 vs threads, random-access reads",
+      benchCtr },
+    { "encode", "[lines=1000000] [dir]  SIMD hex/base64 codecs and buffered manifest writer vs printf/iostream",
+      benchEncode },
+    { "async", "[MiB=64] [dir]  coroutine hashing per I/O backend on a file and a pipe vs digestFile",
+      benchAsync },
+};
+
+void listBenchmarks(std::ostream& os) {
+    os << "Benchmarks:\n";
+    for (const BenchEntry& b : BENCHMARKS) {
+        os << "  " << b.name << " " << b.help << "\n";
+    }
+}
+
+int runBenchmark(const std::string& name, const std::vector<std::string>& args) {
+    for (const BenchEntry& b : BENCHMARKS) {
+        if (name == b.name) {
+            return b.run(args);
+        }
+    }
+    std::cerr << "[Bench] Unknown benchmark: " << name << "\n";
+    listBenchmarks(std::cerr);
+    return EXIT_FAILURE;
+}
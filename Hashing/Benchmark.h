@@ -0,0 +1,20 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+//  Built-in benchmarks, run from the command line:
+//
+//      Hashing bench                 (list)
+//      Hashing bench <name> [args]
+//
+//  Each benchmark prints a small table to stdout and returns an exit code.
+// -----------------------------------------------------------------------------
+int runBenchmark(const std::string& name, const std::vector<std::string>& args);
+
+void listBenchmarks(std::ostream& os);
+
+#endif // BENCHMARK_H
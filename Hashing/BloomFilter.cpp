@@ -0,0 +1,266 @@
+#include "BloomFilter.h"
+#include "Performance.h"
+#include "QuantumProtection.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define QF_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define QF_PREFETCH(p) _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0)
+#else
+#define QF_PREFETCH(p) ((void)0)
+#endif
+
+// Keys per qfHashMany call, and how far ahead blocks are prefetched
+static const size_t BLOOM_BATCH = 1024;
+static const size_t BLOOM_PREFETCH_DISTANCE = 8;
+
+static const size_t BLOOM_HEADER_BYTES = 64;
+static const char BLOOM_MAGIC[8] = { 'Q', 'F', 'B', 'L', 'O', 'O', 'M', '1' };
+
+static uint64_t loadLE64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void storeLE64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static size_t digestBytes(unsigned k) {
+    return 8 + 2 * size_t(k);
+}
+
+// Block counts are capped at 2^32 (256 GiB) so this multiply-shift fits
+static uint64_t blockIndex(const uint8_t* digest, uint64_t blocks) {
+    return ((loadLE64(digest) >> 32) * blocks) >> 32;
+}
+
+static void setBits(QFBloomBlock& block, const uint8_t* digest, unsigned k) {
+    for (unsigned i = 0; i < k; i++) {
+        unsigned bit = (digest[8 + 2 * i] | (unsigned(digest[9 + 2 * i]) << 8)) & 511;
+        block.words[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+}
+
+static bool testBits(const QFBloomBlock& block, const uint8_t* digest, unsigned k) {
+    for (unsigned i = 0; i < k; i++) {
+        unsigned bit = (digest[8 + 2 * i] | (unsigned(digest[9 + 2 * i]) << 8)) & 511;
+        if ((block.words[bit >> 6] & (uint64_t(1) << (bit & 63))) == 0) return false;
+    }
+    return true;
+}
+
+static bool queryOne(const QFBloomBlock* blocks, uint64_t count, unsigned k,
+    const uint8_t* data, size_t len) {
+    uint8_t digest[128];
+    qfHashShort(data, len, digest, digestBytes(k));
+    return testBits(blocks[blockIndex(digest, count)], digest, k);
+}
+
+// Hash a batch, prefetch its blocks a few keys ahead, then test each key
+static void queryMany(const QFBloomBlock* blocks, uint64_t count, unsigned k,
+    const uint8_t* const* items, const size_t* lengths, size_t n, uint8_t* results) {
+    const size_t dlen = digestBytes(k);
+    std::vector<uint8_t> digests(BLOOM_BATCH * dlen);
+    uint64_t index[BLOOM_BATCH];
+    for (size_t first = 0; first < n; first += BLOOM_BATCH) {
+        size_t m = std::min(BLOOM_BATCH, n - first);
+        qfHashMany(items + first, lengths + first, m, digests.data(), dlen);
+        for (size_t i = 0; i < m; i++) index[i] = blockIndex(digests.data() + i * dlen, count);
+        for (size_t i = 0; i < std::min(m, BLOOM_PREFETCH_DISTANCE); i++) QF_PREFETCH(blocks + index[i]);
+        for (size_t i = 0; i < m; i++) {
+            if (i + BLOOM_PREFETCH_DISTANCE < m) QF_PREFETCH(blocks + index[i + BLOOM_PREFETCH_DISTANCE]);
+            results[first + i] = testBits(blocks[index[i]], digests.data() + i * dlen, k) ? 1 : 0;
+        }
+    }
+}
+
+// Parses the 64-byte header: magic | k (LE32) | reserved | blocks | items
+static bool parseHeader(const uint8_t* data, size_t size, const std::string& path,
+    uint64_t& blocks, unsigned& k, uint64_t& items) {
+    if (size < BLOOM_HEADER_BYTES || std::memcmp(data, BLOOM_MAGIC, sizeof(BLOOM_MAGIC)) != 0) {
+        std::cerr << "[BloomFilter] Not a Bloom filter file: " << path << "\n";
+        return false;
+    }
+    k = static_cast<unsigned>(loadLE64(data + 8) & 0xFFFFFFFFu);
+    blocks = loadLE64(data + 16);
+    items = loadLE64(data + 24);
+    if (k == 0 || k > QF_BLOOM_MAX_HASHES || blocks == 0 || blocks > (uint64_t(1) << 32)
+        || size - BLOOM_HEADER_BYTES != blocks * sizeof(QFBloomBlock)) {
+        std::cerr << "[BloomFilter] Corrupt header or truncated file: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Sizing
+// --------------------------------------------------------------------
+double qfBloomFalsePositiveRate(uint64_t blocks, unsigned hashes, uint64_t items) {
+    if (blocks == 0 || hashes == 0) return 1.0;
+    const double lambda = double(items) / double(blocks);
+    const double perBit = std::log1p(-1.0 / 512.0);
+    // Sum over the likely block loads j ~ Poisson(lambda)
+    size_t upper = static_cast<size_t>(lambda + 12.0 * std::sqrt(lambda) + 16.0);
+    double rate = 0.0;
+    for (size_t j = 0; j <= upper; j++) {
+        double logP = (lambda > 0.0 ? j * std::log(lambda) : (j == 0 ? 0.0 : -INFINITY))
+            - lambda - std::lgamma(double(j) + 1.0);
+        double filled = -std::expm1(perBit * double(j) * hashes);
+        rate += std::exp(logP) * std::pow(filled, double(hashes));
+    }
+    return std::min(rate, 1.0);
+}
+
+QFBloomSizing qfBloomSize(uint64_t expectedItems, double falsePositiveRate) {
+    double target = std::clamp(falsePositiveRate, 1e-12, 0.5);
+    uint64_t items = std::max<uint64_t>(expectedItems, 1);
+
+    // Start from the classic (unblocked) optimum and grow ~2% at a time;
+    // blocking costs a little extra space for the same rate
+    double bits = -double(items) * std::log(target) / (std::log(2.0) * std::log(2.0));
+    QFBloomSizing sizing;
+    for (uint64_t blocks = std::max<uint64_t>(1, static_cast<uint64_t>(bits / 512.0));;
+        blocks = std::max(blocks + 1, blocks + blocks / 50)) {
+        sizing.blocks = std::min<uint64_t>(blocks, uint64_t(1) << 32);
+        sizing.falsePositiveRate = 1.0;
+        for (unsigned k = 1; k <= QF_BLOOM_MAX_HASHES; k++) {
+            double rate = qfBloomFalsePositiveRate(sizing.blocks, k, items);
+            if (rate < sizing.falsePositiveRate) {
+                sizing.falsePositiveRate = rate;
+                sizing.hashes = k;
+            }
+        }
+        if (sizing.falsePositiveRate <= target || sizing.blocks == (uint64_t(1) << 32)) return sizing;
+    }
+}
+
+// --------------------------------------------------------------------
+// QFBloomFilter
+// --------------------------------------------------------------------
+QFBloomFilter::QFBloomFilter(uint64_t blockCount, unsigned hashes)
+    : blocks(std::clamp<uint64_t>(blockCount, 1, uint64_t(1) << 32)),
+      k(std::clamp(hashes, 1u, QF_BLOOM_MAX_HASHES)),
+      inserted(0) {
+    clear();
+}
+
+void QFBloomFilter::clear() {
+    std::memset(blocks.data(), 0, blocks.size() * sizeof(QFBloomBlock));
+    inserted = 0;
+}
+
+void QFBloomFilter::insert(const uint8_t* data, size_t len) {
+    uint8_t digest[128];
+    qfHashShort(data, len, digest, digestBytes(k));
+    setBits(blocks[blockIndex(digest, blocks.size())], digest, k);
+    inserted++;
+}
+
+bool QFBloomFilter::contains(const uint8_t* data, size_t len) const {
+    return queryOne(blocks.data(), blocks.size(), k, data, len);
+}
+
+void QFBloomFilter::insertMany(const uint8_t* const* items, const size_t* lengths, size_t count) {
+    const size_t dlen = digestBytes(k);
+    std::vector<uint8_t> digests(BLOOM_BATCH * dlen);
+    uint64_t index[BLOOM_BATCH];
+    for (size_t first = 0; first < count; first += BLOOM_BATCH) {
+        size_t m = std::min(BLOOM_BATCH, count - first);
+        qfHashMany(items + first, lengths + first, m, digests.data(), dlen);
+        for (size_t i = 0; i < m; i++) index[i] = blockIndex(digests.data() + i * dlen, blocks.size());
+        for (size_t i = 0; i < std::min(m, BLOOM_PREFETCH_DISTANCE); i++) QF_PREFETCH(&blocks[index[i]]);
+        for (size_t i = 0; i < m; i++) {
+            if (i + BLOOM_PREFETCH_DISTANCE < m) QF_PREFETCH(&blocks[index[i + BLOOM_PREFETCH_DISTANCE]]);
+            setBits(blocks[index[i]], digests.data() + i * dlen, k);
+        }
+    }
+    inserted += count;
+}
+
+void QFBloomFilter::containsMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+    uint8_t* results) const {
+    queryMany(blocks.data(), blocks.size(), k, items, lengths, count, results);
+}
+
+bool QFBloomFilter::save(const std::string& path) const {
+    uint8_t header[BLOOM_HEADER_BYTES] = { 0 };
+    std::memcpy(header, BLOOM_MAGIC, sizeof(BLOOM_MAGIC));
+    storeLE64(header + 8, k);
+    storeLE64(header + 16, blocks.size());
+    storeLE64(header + 24, inserted);
+
+    int fd = qfOpenWrite(path);
+    if (fd < 0) {
+        std::cerr << "[BloomFilter] Failed to create " << path << "\n";
+        return false;
+    }
+    bool ok = qfWriteAll(fd, header, sizeof(header)) >= 0
+        && qfWriteAll(fd, blocks.data(), blocks.size() * sizeof(QFBloomBlock)) >= 0;
+    qfClose(fd);
+    if (!ok) std::cerr << "[BloomFilter] Write error on " << path << "\n";
+    return ok;
+}
+
+bool QFBloomFilter::load(const std::string& path) {
+    QFMappedFile file;
+    if (!file.open(path, true)) {
+        std::cerr << "[BloomFilter] Could not open " << path << "\n";
+        return false;
+    }
+    uint64_t count, items;
+    unsigned hashes;
+    if (!parseHeader(file.data(), file.size(), path, count, hashes, items)) return false;
+    blocks.resize(count);
+    std::memcpy(blocks.data(), file.data() + BLOOM_HEADER_BYTES, count * sizeof(QFBloomBlock));
+    k = hashes;
+    inserted = items;
+    return true;
+}
+
+// --------------------------------------------------------------------
+// QFBloomFilterView
+// --------------------------------------------------------------------
+bool QFBloomFilterView::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        std::cerr << "[BloomFilter] Could not map " << path << "\n";
+        return false;
+    }
+    if (!parseHeader(file.data(), file.size(), path, count, k, inserted)) {
+        close();
+        return false;
+    }
+    // The mapping is page-aligned, so blocks after the 64-byte header are
+    // cache-line aligned
+    blocks = reinterpret_cast<const QFBloomBlock*>(file.data() + BLOOM_HEADER_BYTES);
+    return true;
+}
+
+void QFBloomFilterView::close() {
+    file.close();
+    blocks = nullptr;
+    count = 0;
+    k = 0;
+    inserted = 0;
+}
+
+bool QFBloomFilterView::contains(const uint8_t* data, size_t len) const {
+    if (!blocks) return false;
+    return queryOne(blocks, count, k, data, len);
+}
+
+void QFBloomFilterView::containsMany(const uint8_t* const* items, const size_t* lengths, size_t n,
+    uint8_t* results) const {
+    if (!blocks) {
+        std::memset(results, 0, n);
+        return;
+    }
+    queryMany(blocks, count, k, items, lengths, n, results);
+}
@@ -0,0 +1,106 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FileIO.h"
+
+// --------------------------------------------------------------------
+// Blocked Bloom filter
+//   - Every key lives in one 512-bit (cache-line) block, so a lookup is
+//     one cache miss however large k is.
+//   - One QF squeeze per key: bytes [0, 8) pick the block, each of the
+//     next k 16-bit words picks a bit (low 9 bits) inside it.  k <= 60
+//     keeps the squeeze within one 128-byte rate block.
+//   - insertMany/containsMany hash keys in batches through qfHashMany
+//     and prefetch the blocks a few keys ahead.
+//   - save() writes a 64-byte header plus the raw blocks (little-endian
+//     words); QFBloomFilterView maps that file and queries it in place.
+// --------------------------------------------------------------------
+
+struct alignas(64) QFBloomBlock {
+    uint64_t words[8];
+};
+
+struct QFBloomSizing {
+    uint64_t blocks = 0;
+    unsigned hashes = 0;
+    double falsePositiveRate = 0.0; // predicted at the expected item count
+
+    uint64_t bytes() const { return blocks * sizeof(QFBloomBlock); }
+};
+
+static const unsigned QF_BLOOM_MAX_HASHES = 60;
+
+// Predicted false-positive rate of a blocked filter holding `items` keys
+// (Poisson block loads, k bits per key within a 512-bit block)
+double qfBloomFalsePositiveRate(uint64_t blocks, unsigned hashes, uint64_t items);
+
+// Smallest filter (and best k for it) meeting the target rate
+QFBloomSizing qfBloomSize(uint64_t expectedItems, double falsePositiveRate);
+
+class QFBloomFilter {
+public:
+    QFBloomFilter(uint64_t blocks, unsigned hashes);
+    explicit QFBloomFilter(const QFBloomSizing& sizing)
+        : QFBloomFilter(sizing.blocks, sizing.hashes) {}
+
+    void insert(const uint8_t* data, size_t len);
+    bool contains(const uint8_t* data, size_t len) const;
+    void insert(const std::string& s) { insert(reinterpret_cast<const uint8_t*>(s.data()), s.size()); }
+    bool contains(const std::string& s) const {
+        return contains(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+
+    // results[i] = 1 if items[i] may be present, 0 if definitely absent
+    void insertMany(const uint8_t* const* items, const size_t* lengths, size_t count);
+    void containsMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+        uint8_t* results) const;
+
+    void clear();
+
+    uint64_t blockCount() const { return blocks.size(); }
+    unsigned hashCount() const { return k; }
+    uint64_t insertedItems() const { return inserted; }
+    double estimatedFalsePositiveRate() const {
+        return qfBloomFalsePositiveRate(blocks.size(), k, inserted);
+    }
+
+    // Returns false (after logging) on I/O errors or a malformed file
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    std::vector<QFBloomBlock> blocks;
+    unsigned k;
+    uint64_t inserted;
+};
+
+// Read-only filter queried straight from a saved file
+class QFBloomFilterView {
+public:
+    bool open(const std::string& path);
+    void close();
+
+    bool contains(const uint8_t* data, size_t len) const;
+    bool contains(const std::string& s) const {
+        return contains(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+    void containsMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+        uint8_t* results) const;
+
+    uint64_t blockCount() const { return count; }
+    unsigned hashCount() const { return k; }
+    uint64_t insertedItems() const { return inserted; }
+
+private:
+    QFMappedFile file;
+    const QFBloomBlock* blocks = nullptr;
+    uint64_t count = 0;
+    unsigned k = 0;
+    uint64_t inserted = 0;
+};
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,245 @@
+#include "BufferArena.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Uncomment to enable debug prints
+// #define ARENA_DEBUG
+
+#ifdef ARENA_DEBUG
+#define ARENA_LOG(msg) std::cerr << "[BufferArena] " << msg << "\n"
+#else
+#define ARENA_LOG(msg) /* no-op */
+#endif
+
+static const size_t HUGE_PAGE = 2 << 20;
+static const size_t SMALL_PAGE = 4096;
+
+static size_t roundUp(size_t v, size_t to) {
+    return ((v + to - 1) / to) * to;
+}
+
+// --------------------------------------------------------------------
+// Count 2 MiB pages backing [start, start+len) from /proc/self/smaps
+// (AnonHugePages for THP, the mapping's own size for hugetlbfs).
+// --------------------------------------------------------------------
+static size_t countHugePages(const uint8_t* start, size_t len, bool hugetlb) {
+    if (hugetlb) return len / HUGE_PAGE;
+#if defined(__linux__)
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    uintptr_t lo = reinterpret_cast<uintptr_t>(start);
+    uintptr_t hi = lo + len;
+    bool inRegion = false;
+    size_t kb = 0;
+    while (std::getline(smaps, line)) {
+        unsigned long long a, b;
+        char dash;
+        if (std::sscanf(line.c_str(), "%llx%c%llx", &a, &dash, &b) == 3 && dash == '-') {
+            inRegion = a < hi && b > lo;
+            continue;
+        }
+        if (inRegion && line.compare(0, 14, "AnonHugePages:") == 0) {
+            kb += std::strtoull(line.c_str() + 14, nullptr, 10);
+        }
+    }
+    return (kb * 1024) / HUGE_PAGE;
+#else
+    (void)start;
+    (void)len;
+    return 0;
+#endif
+}
+
+// --------------------------------------------------------------------
+// QFBufferArena
+// --------------------------------------------------------------------
+QFBufferArena::QFBufferArena(size_t bufferSize, size_t bufferCount, bool prefault) {
+    bufSize = roundUp(std::max<size_t>(bufferSize, SMALL_PAGE), SMALL_PAGE);
+    bufCount = std::max<size_t>(bufferCount, 1);
+    regionBytes = roundUp(bufSize * bufCount, HUGE_PAGE);
+
+#if defined(_WIN32)
+    SIZE_T large = GetLargePageMinimum();
+    if (large != 0) {
+        // Needs SeLockMemoryPrivilege; fails quietly otherwise
+        size_t bytes = roundUp(regionBytes, large);
+        mapBase = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (mapBase) {
+            mapBytes = bytes;
+            backing = QFArenaBacking::HugeTLB;
+        }
+    }
+    if (!mapBase) {
+        mapBytes = regionBytes;
+        mapBase = VirtualAlloc(nullptr, mapBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        backing = QFArenaBacking::Normal;
+    }
+    region = static_cast<uint8_t*>(mapBase);
+#else
+#if defined(MAP_HUGETLB)
+    void* mem = ::mmap(nullptr, regionBytes, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem != MAP_FAILED) {
+        mapBase = mem;
+        mapBytes = regionBytes;
+        region = static_cast<uint8_t*>(mem);
+        backing = QFArenaBacking::HugeTLB;
+    }
+#endif
+    if (!mapBase) {
+        // Over-map by one huge page so the region can start 2 MiB aligned,
+        // which THP needs to back it with huge pages
+        mapBytes = regionBytes + HUGE_PAGE;
+        void* mem2 = ::mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem2 != MAP_FAILED) {
+            mapBase = mem2;
+            uintptr_t aligned = roundUp(reinterpret_cast<uintptr_t>(mem2), HUGE_PAGE);
+            region = reinterpret_cast<uint8_t*>(aligned);
+            backing = QFArenaBacking::Normal;
+#if defined(MADV_HUGEPAGE)
+            if (::madvise(region, regionBytes, MADV_HUGEPAGE) == 0) {
+                backing = QFArenaBacking::TransparentHuge;
+            }
+#endif
+        }
+        else {
+            mapBytes = 0;
+        }
+    }
+#endif
+
+    if (!region) {
+        // Could not map anything: plain heap, still recycled
+        mapBytes = 0;
+        region = static_cast<uint8_t*>(std::malloc(regionBytes));
+        backing = QFArenaBacking::Normal;
+    }
+
+    if (!region) {
+        // Nothing to carve buffers from: every acquire() becomes an overflow
+        std::cerr << "[BufferArena] Failed to allocate a " << regionBytes << "-byte region\n";
+        regionBytes = 0;
+        bufCount = 0;
+    }
+    prefaultOnAcquire = prefault;
+
+    freeList.reserve(bufCount);
+    for (size_t i = bufCount; i-- > 0;) {
+        freeList.push_back(region + i * bufSize);
+    }
+    usedOnce.assign(bufCount, false);
+    ARENA_LOG("region " << regionBytes << " bytes, " << bufCount << " x " << bufSize);
+}
+
+QFBufferArena::~QFBufferArena() {
+#if defined(_WIN32)
+    if (mapBase) {
+        VirtualFree(mapBase, 0, MEM_RELEASE);
+        return;
+    }
+#else
+    if (mapBase) {
+        ::munmap(mapBase, mapBytes);
+        return;
+    }
+#endif
+    std::free(region);
+}
+
+bool QFBufferArena::owns(const uint8_t* p) const {
+    return p >= region && p < region + bufSize * bufCount;
+}
+
+uint8_t* QFBufferArena::acquire() {
+    uint8_t* p = nullptr;
+    bool firstUse = false;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        acquires++;
+        if (!freeList.empty()) {
+            p = freeList.back();
+            freeList.pop_back();
+            size_t index = static_cast<size_t>(p - region) / bufSize;
+            if (usedOnce[index]) reuses++;
+            firstUse = !usedOnce[index];
+            usedOnce[index] = true;
+        }
+        else {
+            overflows++;
+        }
+    }
+    if (p) {
+        if (firstUse && prefaultOnAcquire) {
+            // One write per small page commits this buffer now, so only
+            // buffers that are actually leased ever cost memory
+            for (size_t off = 0; off < bufSize; off += SMALL_PAGE) p[off] = 0;
+        }
+        return p;
+    }
+    p = static_cast<uint8_t*>(std::malloc(bufSize));
+    if (!p) {
+        std::cerr << "[BufferArena] Out of memory for a " << bufSize << "-byte overflow buffer\n";
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void QFBufferArena::release(uint8_t* buffer) {
+    if (buffer == nullptr) return;
+    if (!owns(buffer)) {
+        std::free(buffer);
+        return;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    freeList.push_back(buffer);
+}
+
+QFArenaStats QFBufferArena::stats() const {
+    QFArenaStats s;
+    std::lock_guard<std::mutex> guard(lock);
+    s.backing = backing;
+    s.bufferSize = bufSize;
+    s.bufferCount = bufCount;
+    s.regionBytes = regionBytes;
+    s.hugePages = (backing == QFArenaBacking::Normal) ? 0
+        : countHugePages(region, regionBytes, backing == QFArenaBacking::HugeTLB);
+    s.acquires = acquires;
+    s.reuses = reuses;
+    s.overflows = overflows;
+    return s;
+}
+
+// --------------------------------------------------------------------
+// Process-wide arena
+// --------------------------------------------------------------------
+QFBufferArena& qfIoArena() {
+    static QFBufferArena arena(QF_IO_BUFFER_SIZE,
+        std::min<size_t>(2 * static_cast<size_t>(qfDefaultThreadCount()), 16));
+    return arena;
+}
+
+void printArenaStats(const QFArenaStats& s, std::ostream& os) {
+    const char* name = (s.backing == QFArenaBacking::HugeTLB) ? "hugetlb"
+        : (s.backing == QFArenaBacking::TransparentHuge) ? "transparent huge pages" : "normal pages";
+    os << "[Arena] " << s.bufferCount << " x " << (s.bufferSize >> 10) << " KiB buffers, "
+        << (s.regionBytes >> 20) << " MiB region, backing = " << name
+        << ", huge pages obtained = " << s.hugePages
+        << " of " << (s.regionBytes / HUGE_PAGE) << "\n";
+    os << "[Arena] acquires = " << s.acquires << ", reuses = " << s.reuses
+        << ", overflows = " << s.overflows << "\n";
+}
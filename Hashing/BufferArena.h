@@ -0,0 +1,112 @@
+#ifndef BUFFER_ARENA_H
+#define BUFFER_ARENA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include <mutex>
+#include <vector>
+
+// --------------------------------------------------------------------
+// Huge-page backed arena of fixed-size I/O buffers.
+//
+// Multi-MiB read buffers pay for TLB misses and first-touch page faults
+// every time a fresh vector is allocated per file.  The arena maps one
+// region up front, backed by (in order of preference):
+//   1) explicit huge pages      (MAP_HUGETLB / MEM_LARGE_PAGES)
+//   2) transparent huge pages   (2 MiB aligned + madvise(MADV_HUGEPAGE))
+//   3) normal pages
+// and hands out buffers that are recycled across files.  Each buffer is
+// prefaulted the first time it is leased, so an arena sized for the
+// worst case only commits what is actually used.  Falling back is
+// silent; stats() reports what we actually got.
+// --------------------------------------------------------------------
+
+enum class QFArenaBacking {
+    HugeTLB,
+    TransparentHuge,
+    Normal
+};
+
+struct QFArenaStats {
+    QFArenaBacking backing;
+    size_t bufferSize;
+    size_t bufferCount;
+    size_t regionBytes;
+    size_t hugePages;       // 2 MiB pages actually backing the region
+    uint64_t acquires;
+    uint64_t reuses;        // acquires served by a recycled buffer
+    uint64_t overflows;     // arena empty => temporary heap buffer
+};
+
+class QFBufferArena {
+public:
+    // bufferSize is rounded up to a multiple of 4 KiB; prefault commits
+    // each buffer on its first acquire()
+    QFBufferArena(size_t bufferSize, size_t bufferCount, bool prefault = true);
+    ~QFBufferArena();
+
+    QFBufferArena(const QFBufferArena&) = delete;
+    QFBufferArena& operator=(const QFBufferArena&) = delete;
+
+    // Never blocks: when every buffer is leased a heap buffer is returned
+    // (and freed again by release()).  Throws std::bad_alloc if that
+    // heap buffer cannot be allocated.
+    uint8_t* acquire();
+    void release(uint8_t* buffer);
+
+    size_t bufferSize() const { return bufSize; }
+    QFArenaStats stats() const;
+
+private:
+    bool owns(const uint8_t* p) const;
+
+    uint8_t* region = nullptr;
+    size_t regionBytes = 0;
+    void* mapBase = nullptr;
+    size_t mapBytes = 0;
+    size_t bufSize = 0;
+    size_t bufCount = 0;
+    QFArenaBacking backing = QFArenaBacking::Normal;
+    bool prefaultOnAcquire = true;
+
+    mutable std::mutex lock;
+    std::vector<uint8_t*> freeList;
+    std::vector<bool> usedOnce;
+    uint64_t acquires = 0;
+    uint64_t reuses = 0;
+    uint64_t overflows = 0;
+};
+
+// --------------------------------------------------------------------
+// QFArenaLease: RAII acquire/release
+// --------------------------------------------------------------------
+class QFArenaLease {
+public:
+    explicit QFArenaLease(QFBufferArena& arena) : owner(arena), ptr(arena.acquire()) {}
+    ~QFArenaLease() { owner.release(ptr); }
+
+    QFArenaLease(const QFArenaLease&) = delete;
+    QFArenaLease& operator=(const QFArenaLease&) = delete;
+
+    uint8_t* data() const { return ptr; }
+    size_t size() const { return owner.bufferSize(); }
+
+private:
+    QFBufferArena& owner;
+    uint8_t* ptr;
+};
+
+// --------------------------------------------------------------------
+// Process-wide I/O arena for large-file reads
+//   - QF_IO_BUFFER_SIZE per buffer (a multiple of the 128-byte rate, so
+//     digests do not change), two buffers per scheduler thread, capped.
+//   - Created on first use; buffers are prefaulted as they are leased.
+// --------------------------------------------------------------------
+static const size_t QF_IO_BUFFER_SIZE = 4 << 20;
+
+QFBufferArena& qfIoArena();
+
+void printArenaStats(const QFArenaStats& stats, std::ostream& os);
+
+#endif // BUFFER_ARENA_H
@@ -0,0 +1,84 @@
+#include "Crc32c.h"
+#include <cstring>
+
+// The crc32 loop is built on every x86 target and picked at run time, so
+// it does not depend on -msse4.2: GCC / Clang compile it through a target
+// attribute, MSVC accepts the intrinsics without any flag.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <nmmintrin.h>
+#define QF_HAVE_CRC32_INSN 1
+#if defined(_MSC_VER)
+#include <intrin.h>     // for __cpuid
+#else
+#include <cpuid.h>      // for __get_cpuid
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define QF_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define QF_TARGET_SSE42
+#endif
+#endif
+
+// Reflected polynomial 0x82F63B78, one byte per step
+struct Crc32cTable {
+    uint32_t t[256];
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            t[i] = c;
+        }
+    }
+};
+
+static uint32_t crcTable(uint32_t crc, const uint8_t* data, size_t len) {
+    static const Crc32cTable TABLE;
+    while (len--) crc = TABLE.t[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#if defined(QF_HAVE_CRC32_INSN)
+QF_TARGET_SSE42 static uint32_t crcSse42(uint32_t crc, const uint8_t* data, size_t len) {
+#if defined(__x86_64__) || defined(_M_X64)
+    while (len >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        crc = static_cast<uint32_t>(_mm_crc32_u64(crc, word));
+        data += 8;
+        len -= 8;
+    }
+#endif
+    while (len--) crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+#endif
+
+// SSE4.2 is CPUID.1:ECX[20]
+static bool cpuHasSse42() {
+#if defined(QF_HAVE_CRC32_INSN) && defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[2] & (1 << 20)) != 0;
+#elif defined(QF_HAVE_CRC32_INSN)
+    unsigned a, b, c, d;
+    return __get_cpuid(1, &a, &b, &c, &d) && (c & (1u << 20));
+#else
+    return false;
+#endif
+}
+
+static bool useSse42() {
+    static const bool yes = cpuHasSse42();
+    return yes;
+}
+
+uint32_t qfCrc32c(uint32_t crc, const uint8_t* data, size_t len) {
+#if defined(QF_HAVE_CRC32_INSN)
+    if (useSse42()) return ~crcSse42(~crc, data, len);
+#endif
+    return ~crcTable(~crc, data, len);
+}
+
+const char* qfCrc32cImplementation() {
+    return useSse42() ? "sse4.2" : "table";
+}
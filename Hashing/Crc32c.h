@@ -0,0 +1,17 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+// --------------------------------------------------------------------
+// CRC-32C (Castagnoli), the quick integrity check next to the QF and
+// SHA-256 digests.  The SSE4.2 crc32 instruction when CPUID reports it
+// (no compiler flag needed), a table-driven fallback otherwise.
+//   - Streaming: crc = qfCrc32c(crc, chunk, len) starting from 0.
+// --------------------------------------------------------------------
+uint32_t qfCrc32c(uint32_t crc, const uint8_t* data, size_t len);
+
+const char* qfCrc32cImplementation();
+
+#endif // CRC32C_H
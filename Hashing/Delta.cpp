@@ -0,0 +1,730 @@
+#include "Delta.h"
+#include "BufferArena.h"
+#include "FileIO.h"
+#include "Performance.h"
+#include "QuantumProtection.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Uncomment to enable debug prints
+// #define DELTA_DEBUG
+
+#ifdef DELTA_DEBUG
+#define DELTA_LOG(msg) std::cerr << "[Delta] " << msg << "\n"
+#else
+#define DELTA_LOG(msg) /* no-op */
+#endif
+
+static const char SIGNATURE_MAGIC[8] = { 'Q', 'F', 'S', 'I', 'G', '1', 0, 0 };
+static const char DELTA_MAGIC[8] = { 'Q', 'F', 'D', 'L', 'T', '1', 0, 0 };
+static const size_t SIGNATURE_HEADER_BYTES = 24;  // magic | blockSize | strongBytes | oldSize
+static const size_t DELTA_HEADER_BYTES = 24;      // magic | blockSize | 0 | oldSize
+static const size_t DELTA_TRAILER_BYTES = 8 + QF_DIGEST_BYTES; // after OP_END: newSize | digest
+
+static const uint8_t OP_COPY = 'C';     // u64 first block, u32 block count
+static const uint8_t OP_LITERAL = 'L';  // u32 length, bytes
+static const uint8_t OP_END = 'E';
+
+// Blocks (or candidates) per task in the parallel strong-hash phases
+static const size_t STRONG_GROUP = 256;
+static const size_t OUTPUT_BUFFER = 1 << 20;
+static const size_t WEAK_FILTER_BITS = 20;
+
+static uint64_t loadLE(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void putLE(std::vector<uint8_t>& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+// --------------------------------------------------------------------
+// Weak checksum (rsync): a = sum x_i, b = sum (L - i) x_i, both mod 2^16
+// --------------------------------------------------------------------
+struct WeakSum {
+    uint32_t a = 0;
+    uint32_t b = 0;
+
+    uint32_t value() const { return (a & 0xFFFF) | (b << 16); }
+
+    void roll(uint8_t out, uint8_t in, uint32_t len) {
+        a += uint32_t(in) - uint32_t(out);
+        b += a - len * uint32_t(out);
+    }
+};
+
+// From scratch over one block; 32 bytes at a time with AVX2 (byte sums
+// from SAD, position-weighted sums from maddubs)
+static WeakSum weakBlock(const uint8_t* p, size_t len) {
+    WeakSum w;
+    const uint32_t L = static_cast<uint32_t>(len);
+    size_t o = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i ramp = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+        16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+    for (; o + 32 <= len; o += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + o));
+        __m256i sad = _mm256_sad_epu8(v, zero);
+        __m256i weighted = _mm256_madd_epi16(_mm256_maddubs_epi16(v, ramp), ones);
+        __m128i s = _mm_add_epi64(_mm256_castsi256_si128(sad), _mm256_extracti128_si256(sad, 1));
+        __m128i t = _mm_add_epi32(_mm256_castsi256_si128(weighted), _mm256_extracti128_si256(weighted, 1));
+        t = _mm_hadd_epi32(t, t);
+        t = _mm_hadd_epi32(t, t);
+        uint32_t sum = static_cast<uint32_t>(_mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1));
+        uint32_t dot = static_cast<uint32_t>(_mm_cvtsi128_si32(t));
+        // sum over the chunk of (L - o - t) x_t
+        w.a += sum;
+        w.b += (L - static_cast<uint32_t>(o)) * sum - dot;
+    }
+#endif
+    for (; o < len; o++) {
+        w.a += p[o];
+        w.b += (L - static_cast<uint32_t>(o)) * p[o];
+    }
+    return w;
+}
+
+static uint32_t weakFilterSlot(uint32_t weak) {
+    return (weak * 0x9E3779B1u) >> (32 - WEAK_FILTER_BITS);
+}
+
+// --------------------------------------------------------------------
+// Buffered sequential writer
+// --------------------------------------------------------------------
+namespace {
+
+class OutputFile {
+public:
+    bool open(const std::string& path) {
+        name = path;
+        fd = qfOpenWrite(path);
+        if (fd < 0) std::cerr << "[Delta] Failed to create " << path << "\n";
+        return fd >= 0;
+    }
+    ~OutputFile() {
+        if (fd >= 0) qfClose(fd);
+    }
+
+    void put(const void* data, size_t len) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        if (buffer.size() + len > OUTPUT_BUFFER) flush();
+        if (len >= OUTPUT_BUFFER) {
+            write(p, len);
+            return;
+        }
+        buffer.insert(buffer.end(), p, p + len);
+    }
+
+    bool close() {
+        flush();
+        qfClose(fd);
+        fd = -1;
+        if (error != 0) {
+            std::cerr << "[Delta] Write error on " << name << ": "
+                << std::strerror(static_cast<int>(-error)) << "\n";
+        }
+        return error == 0;
+    }
+    uint64_t bytes() const { return written + buffer.size(); }
+
+private:
+    void flush() {
+        if (!buffer.empty()) write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+    void write(const uint8_t* p, size_t len) {
+        long n = qfWriteAll(fd, p, len);
+        if (n < 0 && error == 0) error = n;
+        written += len;
+    }
+
+    std::string name;
+    int fd = -1;
+    long error = 0;
+    uint64_t written = 0;
+    std::vector<uint8_t> buffer;
+};
+
+// Delta instruction stream; consecutive block copies are merged into one
+class DeltaWriter {
+public:
+    explicit DeltaWriter(OutputFile& file) : out(file) {}
+
+    void copy(uint64_t block) {
+        if (runLength > 0 && block == runStart + runLength) {
+            runLength++;
+            return;
+        }
+        flushCopy();
+        runStart = block;
+        runLength = 1;
+    }
+    void literal(const uint8_t* data, size_t len) {
+        if (len == 0) return;
+        flushCopy();
+        std::vector<uint8_t> op;
+        op.push_back(OP_LITERAL);
+        putLE(op, len, 4);
+        out.put(op.data(), op.size());
+        out.put(data, len);
+        literalOps++;
+    }
+    void finish() {
+        flushCopy();
+        out.put(&OP_END, 1);
+    }
+    // Block the current copy run would continue with (UINT64_MAX if none)
+    uint64_t nextBlock() const { return runLength > 0 ? runStart + runLength : UINT64_MAX; }
+
+    uint64_t copyOps = 0;
+    uint64_t literalOps = 0;
+
+private:
+    void flushCopy() {
+        if (runLength == 0) return;
+        std::vector<uint8_t> op;
+        op.push_back(OP_COPY);
+        putLE(op, runStart, 8);
+        putLE(op, runLength, 4);
+        out.put(op.data(), op.size());
+        copyOps++;
+        runLength = 0;
+    }
+
+    OutputFile& out;
+    uint64_t runStart = 0;
+    uint32_t runLength = 0;
+};
+
+// Parsed signature file (mapped) plus the weak -> block lookup
+struct Signature {
+    QFMappedFile file;
+    uint32_t blockSize = 0;
+    uint32_t strongBytes = 0;
+    uint64_t oldSize = 0;
+    uint64_t blocks = 0;
+    uint64_t lastLength = 0;            // bytes in the final (possibly short) block
+    std::vector<uint64_t> entries;      // (weak << 32) | block, sorted; full blocks only
+    std::vector<uint64_t> filter;       // 2^WEAK_FILTER_BITS-bit presence filter
+
+    const uint8_t* record(uint64_t block) const {
+        return file.data() + SIGNATURE_HEADER_BYTES + block * (4 + strongBytes);
+    }
+    uint32_t weak(uint64_t block) const { return static_cast<uint32_t>(loadLE(record(block), 4)); }
+    const uint8_t* strong(uint64_t block) const { return record(block) + 4; }
+
+    bool mayContain(uint32_t weak) const {
+        uint32_t slot = weakFilterSlot(weak);
+        return (filter[slot >> 6] >> (slot & 63)) & 1;
+    }
+};
+
+} // namespace
+
+static uint32_t autoBlockSize(uint64_t fileSize) {
+    uint64_t bs = static_cast<uint64_t>(std::sqrt(static_cast<double>(fileSize)));
+    bs = (bs + 63) & ~uint64_t(63);
+    return static_cast<uint32_t>(std::clamp<uint64_t>(bs, 1024, 128 << 10));
+}
+
+static bool loadSignature(const std::string& path, Signature& sig) {
+    if (!sig.file.open(path, true)) {
+        std::cerr << "[Delta] Could not open signature " << path << "\n";
+        return false;
+    }
+    const uint8_t* p = sig.file.data();
+    if (sig.file.size() < SIGNATURE_HEADER_BYTES || std::memcmp(p, SIGNATURE_MAGIC, 8) != 0) {
+        std::cerr << "[Delta] Not a signature file: " << path << "\n";
+        return false;
+    }
+    sig.blockSize = static_cast<uint32_t>(loadLE(p + 8, 4));
+    sig.strongBytes = static_cast<uint32_t>(loadLE(p + 12, 4));
+    sig.oldSize = loadLE(p + 16, 8);
+    if (sig.blockSize == 0 || sig.strongBytes < 4 || sig.strongBytes > 64) {
+        std::cerr << "[Delta] Corrupt signature header: " << path << "\n";
+        return false;
+    }
+    sig.blocks = (sig.oldSize + sig.blockSize - 1) / sig.blockSize;
+    if (sig.blocks > (uint64_t(1) << 32)) {
+        std::cerr << "[Delta] Signature has more than 2^32 blocks: " << path << "\n";
+        return false;
+    }
+    sig.lastLength = sig.blocks ? sig.oldSize - (sig.blocks - 1) * sig.blockSize : 0;
+    if (sig.file.size() != SIGNATURE_HEADER_BYTES + sig.blocks * (4 + sig.strongBytes)) {
+        std::cerr << "[Delta] Truncated signature: " << path << "\n";
+        return false;
+    }
+
+    sig.filter.assign((size_t(1) << WEAK_FILTER_BITS) / 64, 0);
+    uint64_t fullBlocks = (sig.lastLength == sig.blockSize) ? sig.blocks : sig.blocks - (sig.blocks ? 1 : 0);
+    sig.entries.reserve(fullBlocks);
+    for (uint64_t b = 0; b < fullBlocks; b++) {
+        uint32_t w = sig.weak(b);
+        sig.entries.push_back((uint64_t(w) << 32) | b);
+        uint32_t slot = weakFilterSlot(w);
+        sig.filter[slot >> 6] |= uint64_t(1) << (slot & 63);
+    }
+    std::sort(sig.entries.begin(), sig.entries.end());
+    return true;
+}
+
+// Block whose weak + strong match, preferring `preferred` (keeps copy runs
+// contiguous when the old file has repeated blocks); UINT64_MAX if none
+static uint64_t matchBlock(const Signature& sig, uint32_t weak, const uint8_t* strong, uint64_t preferred) {
+    if (preferred < sig.blocks && (preferred + 1 < sig.blocks || sig.lastLength == sig.blockSize)
+        && sig.weak(preferred) == weak && std::memcmp(sig.strong(preferred), strong, sig.strongBytes) == 0) {
+        return preferred;
+    }
+    auto it = std::lower_bound(sig.entries.begin(), sig.entries.end(), uint64_t(weak) << 32);
+    for (; it != sig.entries.end() && (*it >> 32) == weak; ++it) {
+        uint64_t block = *it & 0xFFFFFFFFu;
+        if (std::memcmp(sig.strong(block), strong, sig.strongBytes) == 0) return block;
+    }
+    return UINT64_MAX;
+}
+
+static bool hasWeak(const Signature& sig, uint32_t weak) {
+    if (!sig.mayContain(weak)) return false;
+    auto it = std::lower_bound(sig.entries.begin(), sig.entries.end(), uint64_t(weak) << 32);
+    return it != sig.entries.end() && (*it >> 32) == weak;
+}
+
+// Truncated QF digests of `count` equal-length pieces, in parallel groups
+static void strongHashes(const uint8_t* const* pieces, const size_t* lengths, size_t count,
+    uint8_t* out, size_t strongBytes) {
+    size_t groups = (count + STRONG_GROUP - 1) / STRONG_GROUP;
+    qfScheduler().parallelFor(groups, [&](size_t g) {
+        size_t first = g * STRONG_GROUP;
+        size_t n = std::min(STRONG_GROUP, count - first);
+        qfHashMany(pieces + first, lengths + first, n, out + first * strongBytes, strongBytes);
+    });
+}
+
+// --------------------------------------------------------------------
+// writeSignature
+// --------------------------------------------------------------------
+bool writeSignature(const std::string& oldPath, const std::string& signaturePath,
+    const QFSignatureOptions& options) {
+    int fd = qfOpenRead(oldPath);
+    if (fd < 0) {
+        std::cerr << "[Delta] Failed to open " << oldPath << "\n";
+        return false;
+    }
+    int64_t size = qfFileSize(fd);
+    uint32_t bs = options.blockSize ? options.blockSize : autoBlockSize(size < 0 ? 0 : uint64_t(size));
+    // Block indices are 32-bit in the weak lookup, so at most 2^32 blocks
+    const uint64_t minBlock = std::max<uint64_t>(1, ((size < 0 ? 0 : uint64_t(size)) + 0xFFFFFFFFull) >> 32);
+    if (bs < minBlock) {
+        std::cerr << "[Delta] Block size " << bs << " is too small for " << oldPath << "; using " << minBlock << "\n";
+        bs = static_cast<uint32_t>(minBlock);
+    }
+    const uint32_t sb = std::clamp<uint32_t>(options.strongBytes, 4, 64);
+
+    QFBufferArena& arena = qfIoArena();
+    QFArenaLease lease(arena);
+    const size_t chunk = std::max<size_t>(bs, arena.bufferSize() / bs * bs);
+    std::vector<uint8_t> big;
+    uint8_t* buffer = lease.data();
+    if (chunk > arena.bufferSize()) {
+        big.resize(chunk);
+        buffer = big.data();
+    }
+
+    if (qfSameFile(signaturePath, oldPath)) {
+        std::cerr << "[Delta] Signature " << signaturePath << " is the same file as " << oldPath << "\n";
+        qfClose(fd);
+        return false;
+    }
+    OutputFile out;
+    if (!out.open(signaturePath)) {
+        qfClose(fd);
+        return false;
+    }
+    std::vector<uint8_t> header(SIGNATURE_MAGIC, SIGNATURE_MAGIC + 8);
+    putLE(header, bs, 4);
+    putLE(header, sb, 4);
+    putLE(header, size < 0 ? 0 : uint64_t(size), 8);
+    out.put(header.data(), header.size());
+
+    uint64_t total = 0;
+    long readError = 0;
+    std::vector<const uint8_t*> ptrs;
+    std::vector<size_t> lens;
+    std::vector<uint32_t> weaks;
+    std::vector<uint8_t> strongs;
+    while (true) {
+        long n = qfReadFull(fd, buffer, chunk);
+        if (n < 0) {
+            readError = n;
+            break;
+        }
+        if (n == 0) break;
+
+        size_t blocks = (static_cast<size_t>(n) + bs - 1) / bs;
+        ptrs.resize(blocks);
+        lens.resize(blocks);
+        weaks.resize(blocks);
+        strongs.resize(blocks * sb);
+        for (size_t b = 0; b < blocks; b++) {
+            ptrs[b] = buffer + b * bs;
+            lens[b] = std::min<size_t>(bs, static_cast<size_t>(n) - b * bs);
+        }
+        size_t groups = (blocks + STRONG_GROUP - 1) / STRONG_GROUP;
+        qfScheduler().parallelFor(groups, [&](size_t g) {
+            size_t first = g * STRONG_GROUP;
+            size_t count = std::min(STRONG_GROUP, blocks - first);
+            for (size_t b = first; b < first + count; b++) weaks[b] = weakBlock(ptrs[b], lens[b]).value();
+            qfHashMany(ptrs.data() + first, lens.data() + first, count, strongs.data() + first * sb, sb);
+        });
+
+        for (size_t b = 0; b < blocks; b++) {
+            uint8_t w[4] = { uint8_t(weaks[b]), uint8_t(weaks[b] >> 8), uint8_t(weaks[b] >> 16), uint8_t(weaks[b] >> 24) };
+            out.put(w, 4);
+            out.put(strongs.data() + b * sb, sb);
+        }
+        total += static_cast<uint64_t>(n);
+        if (static_cast<size_t>(n) < chunk) break;
+    }
+    qfClose(fd);
+
+    if (readError != 0) {
+        std::cerr << "[Delta] Read error on " << oldPath << ": "
+            << std::strerror(static_cast<int>(-readError)) << "\n";
+        out.close();
+        return false;
+    }
+    if (!out.close()) return false;
+    if (size < 0 || total != uint64_t(size)) {
+        std::cerr << "[Delta] " << oldPath << " changed size while being read\n";
+        return false;
+    }
+    DELTA_LOG(oldPath << ": " << total << " bytes, block " << bs << ", strong " << sb);
+    return true;
+}
+
+// --------------------------------------------------------------------
+// writeDelta
+//   Window = up to blockSize - 1 unprocessed bytes from the previous
+//   pass + one arena-sized read (absorbed into the new file's digest
+//   exactly as processFile would).  Per window, a greedy pass:
+//     1) roll the weak sum forward from the current position to the
+//        next offset that hits the signature, and from there keep
+//        chaining hits as if each one were confirmed (the next search
+//        starts a block later), so offsets an accepted copy would skip
+//        are never strong-hashed
+//     2) QF the chain in parallel, then walk it: copy at confirmed
+//        offsets, literal bytes between; a false hit resumes the
+//        search one byte after it (hashes already done are kept)
+// --------------------------------------------------------------------
+bool writeDelta(const std::string& signaturePath, const std::string& newPath,
+    const std::string& deltaPath, QFDeltaReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    report = QFDeltaReport();
+
+    Signature sig;
+    if (!loadSignature(signaturePath, sig)) return false;
+    const uint32_t bs = sig.blockSize;
+    const uint32_t sb = sig.strongBytes;
+
+    int fd = qfOpenRead(newPath);
+    if (fd < 0) {
+        std::cerr << "[Delta] Failed to open " << newPath << "\n";
+        return false;
+    }
+    if (qfSameFile(deltaPath, newPath) || qfSameFile(deltaPath, signaturePath)) {
+        std::cerr << "[Delta] Output " << deltaPath << " is the same file as an input\n";
+        qfClose(fd);
+        return false;
+    }
+    OutputFile out;
+    if (!out.open(deltaPath)) {
+        qfClose(fd);
+        return false;
+    }
+    // New size and digest go in the trailer, once known
+    std::vector<uint8_t> header(DELTA_MAGIC, DELTA_MAGIC + 8);
+    putLE(header, bs, 4);
+    putLE(header, 0, 4);
+    putLE(header, sig.oldSize, 8);
+    out.put(header.data(), header.size());
+    DeltaWriter delta(out);
+
+    QFBufferArena& arena = qfIoArena();
+    const size_t readSize = arena.bufferSize();
+    std::vector<uint8_t> window(readSize + bs);
+    QFState digest;
+    qfInit(digest);
+
+    // Weak hits hashed ahead of the greedy position, at most one block
+    // chain's worth of parallel work at a time
+    struct Candidate {
+        size_t offset;
+        uint32_t weak;
+    };
+    const size_t chainLimit = STRONG_GROUP * std::max<size_t>(1, qfScheduler().workerCount());
+    std::vector<Candidate> chain, pending;
+    std::vector<uint8_t> chainStrongs, pendingStrongs;
+    std::vector<size_t> missing;        // chain entries not hashed yet
+    std::vector<const uint8_t*> ptrs;
+    std::vector<size_t> lens;
+    std::vector<uint8_t> strongs;
+
+    size_t have = 0;
+    bool eof = false;
+    long readError = 0;
+    while (true) {
+        if (!eof) {
+            long n = qfReadFull(fd, window.data() + have, readSize);
+            if (n < 0) {
+                readError = n;
+                break;
+            }
+            processRaw(digest, window.data() + have, static_cast<size_t>(n));
+            have += static_cast<size_t>(n);
+            report.newBytes += static_cast<uint64_t>(n);
+            eof = static_cast<size_t>(n) < readSize;
+        }
+        const uint8_t* w = window.data();
+        const size_t limit = (have >= bs) ? have - bs + 1 : 0;
+
+        // 1) First offset >= x whose weak sum hits; rolls when the last
+        //    computed sum is just behind x, recomputes after a jump
+        WeakSum ws;
+        size_t wsAt = SIZE_MAX;
+        auto nextHit = [&](size_t x) -> size_t {
+            if (sig.entries.empty()) return limit;
+            for (; x < limit; x++) {
+                if (wsAt < x && x - wsAt <= 64) {
+                    for (; wsAt < x; wsAt++) ws.roll(w[wsAt], w[wsAt + bs], bs);
+                }
+                else if (wsAt != x) {
+                    ws = weakBlock(w + x, bs);
+                    wsAt = x;
+                }
+                if (hasWeak(sig, ws.value())) return x;
+            }
+            return limit;
+        };
+
+        size_t p = 0, literalStart = 0;
+        size_t hit = nextHit(0);
+        pending.clear();
+        while (hit < limit) {
+            chain.clear();
+            for (; hit < limit && chain.size() < chainLimit; hit = nextHit(hit + bs)) {
+                chain.push_back({ hit, ws.value() });
+            }
+
+            // 2) Strong hashes, reusing those of a chain cut short by a false hit
+            chainStrongs.resize(chain.size() * sb);
+            ptrs.clear();
+            missing.clear();
+            size_t k = 0;
+            for (size_t i = 0; i < chain.size(); i++) {
+                while (k < pending.size() && pending[k].offset < chain[i].offset) k++;
+                if (k < pending.size() && pending[k].offset == chain[i].offset) {
+                    std::memcpy(chainStrongs.data() + i * sb, pendingStrongs.data() + k * sb, sb);
+                    continue;
+                }
+                missing.push_back(i);
+                ptrs.push_back(w + chain[i].offset);
+            }
+            lens.assign(ptrs.size(), bs);
+            strongs.resize(ptrs.size() * sb);
+            strongHashes(ptrs.data(), lens.data(), ptrs.size(), strongs.data(), sb);
+            for (size_t m = 0; m < missing.size(); m++) {
+                std::memcpy(chainStrongs.data() + missing[m] * sb, strongs.data() + m * sb, sb);
+            }
+            report.candidates += missing.size();
+
+            size_t i = 0;
+            for (; i < chain.size(); i++) {
+                uint64_t block = matchBlock(sig, chain[i].weak, chainStrongs.data() + i * sb, delta.nextBlock());
+                if (block == UINT64_MAX) break;
+                delta.literal(w + literalStart, chain[i].offset - literalStart);
+                report.literalBytes += chain[i].offset - literalStart;
+                delta.copy(block);
+                report.copiedBytes += bs;
+                p = chain[i].offset + bs;
+                literalStart = p;
+            }
+            if (i == chain.size()) {
+                pending.clear();
+                continue;   // `hit` already follows the last copy
+            }
+            report.falseCandidates++;
+            pending.assign(chain.begin() + i + 1, chain.end());
+            pendingStrongs.assign(chainStrongs.begin() + (i + 1) * sb, chainStrongs.end());
+            p = chain[i].offset + 1;
+            wsAt = SIZE_MAX;
+            hit = nextHit(p);
+        }
+        p = std::max(p, limit);
+
+        if (eof) {
+            // A short final old block can only match the very end of the file
+            size_t tail = have;
+            if (sig.lastLength > 0 && sig.lastLength < bs && have - literalStart >= sig.lastLength
+                && p <= have - sig.lastLength) {
+                size_t at = have - static_cast<size_t>(sig.lastLength);
+                uint64_t last = sig.blocks - 1;
+                uint8_t strong[64];
+                qfHashShort(w + at, static_cast<size_t>(sig.lastLength), strong, sb);
+                if (weakBlock(w + at, static_cast<size_t>(sig.lastLength)).value() == sig.weak(last)
+                    && std::memcmp(strong, sig.strong(last), sb) == 0) {
+                    tail = at;
+                }
+            }
+            delta.literal(w + literalStart, tail - literalStart);
+            report.literalBytes += tail - literalStart;
+            if (tail < have) {
+                delta.copy(sig.blocks - 1);
+                report.copiedBytes += have - tail;
+            }
+            break;
+        }
+
+        // Keep the unprocessed bytes (< blockSize) for the next window
+        delta.literal(w + literalStart, p - literalStart);
+        report.literalBytes += p - literalStart;
+        std::memmove(window.data(), w + p, have - p);
+        have -= p;
+    }
+    qfClose(fd);
+
+    if (readError != 0) {
+        std::cerr << "[Delta] Read error on " << newPath << ": "
+            << std::strerror(static_cast<int>(-readError)) << "\n";
+        out.close();
+        return false;
+    }
+    delta.finish();
+    std::vector<uint8_t> trailer;
+    putLE(trailer, report.newBytes, 8);
+    trailer.resize(DELTA_TRAILER_BYTES);
+    qfSqueeze(digest, trailer.data() + 8, QF_DIGEST_BYTES);
+    out.put(trailer.data(), trailer.size());
+    report.copyOps = delta.copyOps;
+    report.literalOps = delta.literalOps;
+    report.deltaBytes = out.bytes();
+    if (!out.close()) return false;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    DELTA_LOG(newPath << ": " << report.copiedBytes << " copied, " << report.literalBytes << " literal");
+    return true;
+}
+
+// --------------------------------------------------------------------
+// applyDelta
+// --------------------------------------------------------------------
+bool applyDelta(const std::string& oldPath, const std::string& deltaPath, const std::string& outPath) {
+    QFMappedFile file;
+    if (!file.open(deltaPath, true)) {
+        std::cerr << "[Delta] Could not open delta " << deltaPath << "\n";
+        return false;
+    }
+    const uint8_t* p = file.data();
+    if (file.size() < DELTA_HEADER_BYTES + 1 + DELTA_TRAILER_BYTES || std::memcmp(p, DELTA_MAGIC, 8) != 0) {
+        std::cerr << "[Delta] Not a delta file: " << deltaPath << "\n";
+        return false;
+    }
+    const uint8_t* end = p + file.size() - DELTA_TRAILER_BYTES;
+    const uint64_t bs = loadLE(p + 8, 4);
+    const uint64_t oldSize = loadLE(p + 16, 8);
+    const uint64_t newSize = loadLE(end, 8);
+    QFDigest expected;
+    std::memcpy(expected.data(), end + 8, QF_DIGEST_BYTES);
+    p += DELTA_HEADER_BYTES;
+
+    int in = qfOpenRead(oldPath);
+    if (in < 0) {
+        std::cerr << "[Delta] Failed to open " << oldPath << "\n";
+        return false;
+    }
+    if (bs == 0 || qfFileSize(in) != static_cast<int64_t>(oldSize)) {
+        std::cerr << "[Delta] " << oldPath << " is not the file this delta was made against\n";
+        qfClose(in);
+        return false;
+    }
+    // Opening the output truncates it, so it must not be the old file
+    // (or the mapped delta)
+    if (qfSameFile(outPath, oldPath) || qfSameFile(outPath, deltaPath)) {
+        std::cerr << "[Delta] Output " << outPath << " is the same file as an input\n";
+        qfClose(in);
+        return false;
+    }
+    OutputFile out;
+    if (!out.open(outPath)) {
+        qfClose(in);
+        return false;
+    }
+
+    QFArenaLease lease(qfIoArena());
+    const size_t chunk = qfIoArena().bufferSize();
+    bool ok = true, ended = false;
+    while (ok && !ended && p < end) {
+        uint8_t op = *p++;
+        if (op == OP_END) {
+            ended = true;
+        }
+        else if (op == OP_COPY && end - p >= 12) {
+            uint64_t first = loadLE(p, 8), count = loadLE(p + 8, 4);
+            p += 12;
+            uint64_t from = first * bs;
+            uint64_t to = std::min(oldSize, (first + count) * bs);
+            if (first >= (oldSize + bs - 1) / bs || from >= to) {
+                ok = false;
+                break;
+            }
+            while (from < to) {
+                size_t n = static_cast<size_t>(std::min<uint64_t>(chunk, to - from));
+                if (qfReadFull(in, lease.data(), n, static_cast<int64_t>(from)) != static_cast<long>(n)) {
+                    std::cerr << "[Delta] Read error on " << oldPath << "\n";
+                    ok = false;
+                    break;
+                }
+                out.put(lease.data(), n);
+                from += n;
+            }
+        }
+        else if (op == OP_LITERAL && end - p >= 4 && uint64_t(end - p - 4) >= loadLE(p, 4)) {
+            size_t len = static_cast<size_t>(loadLE(p, 4));
+            out.put(p + 4, len);
+            p += 4 + len;
+        }
+        else {
+            ok = false;
+        }
+    }
+    qfClose(in);
+    uint64_t written = out.bytes();
+    if (!out.close()) return false;
+    if (!ok || !ended || p != end) {
+        std::cerr << "[Delta] Corrupt or truncated delta: " << deltaPath << "\n";
+        return false;
+    }
+    if (written != newSize) {
+        std::cerr << "[Delta] Rebuilt " << written << " bytes, expected " << newSize << "\n";
+        return false;
+    }
+
+    QFDigest actual;
+    if (!digestFile(outPath, actual)) return false;
+    if (actual != expected) {
+        std::cerr << "[Delta] Verification failed: " << outPath << " does not match the delta's digest\n";
+        return false;
+    }
+    return true;
+}
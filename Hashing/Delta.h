@@ -0,0 +1,49 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <cstdint>
+#include <string>
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Rsync-style signature / delta / patch
+//   signature: per fixed-size block of the old file, a 32-bit rolling
+//              weak checksum and a truncated QF strong hash.
+//   delta:     greedy scan of the new file with a rolling weak checksum;
+//              weak hits are confirmed with QF in parallel batches chosen
+//              as if each hit matched, so bytes inside an accepted copy
+//              are never hashed twice.  Emits copy (old block run) /
+//              literal instructions.
+//   patch:     rebuilds the new file from the old one + delta and checks
+//              digestFile(result) against the digest stored in the delta.
+//   All three stream through bounded buffers; only the signature table
+//   (8 + strongBytes per old block) is held in memory by delta.
+// --------------------------------------------------------------------
+
+struct QFSignatureOptions {
+    uint32_t blockSize = 0;     // 0 = ~sqrt(file size), 1 KiB..128 KiB; raised to
+                                // ceil(size / 2^32) so block indices fit 32 bits
+    uint32_t strongBytes = 16;  // truncated QF strong hash (4..64)
+};
+
+struct QFDeltaReport {
+    uint64_t newBytes = 0;
+    uint64_t copiedBytes = 0;
+    uint64_t literalBytes = 0;
+    uint64_t copyOps = 0;       // runs of consecutive old blocks
+    uint64_t literalOps = 0;
+    uint64_t candidates = 0;    // weak hits confirmed with QF
+    uint64_t falseCandidates = 0;
+    uint64_t deltaBytes = 0;
+    double seconds = 0.0;
+};
+
+// Returns false (after logging to stderr) on I/O errors or bad input files
+bool writeSignature(const std::string& oldPath, const std::string& signaturePath,
+    const QFSignatureOptions& options = QFSignatureOptions());
+bool writeDelta(const std::string& signaturePath, const std::string& newPath,
+    const std::string& deltaPath, QFDeltaReport& report);
+bool applyDelta(const std::string& oldPath, const std::string& deltaPath,
+    const std::string& outPath);
+
+#endif // DELTA_H
@@ -0,0 +1,227 @@
+#include "Dupes.h"
+#include "FileIO.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <ostream>
+
+// Uncomment to enable debug prints
+// #define DUPES_DEBUG
+
+#ifdef DUPES_DEBUG
+#define DUPES_LOG(msg) std::cerr << "[Dupes] " << msg << "\n"
+#else
+#define DUPES_LOG(msg) /* no-op */
+#endif
+
+namespace {
+
+// One read buffer per worker for the partial stage
+thread_local std::vector<uint8_t> partialBuffer;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// QF digest of head + tail.  Only compared between files of equal size,
+// so the layout does not need to encode the size.
+bool partialDigest(const std::string& path, uint64_t size, size_t partialBytes, QFDigest& out) {
+    int fd = qfOpenRead(path);
+    if (fd < 0) {
+        std::cerr << "[findDuplicates] Failed to open file: " << path << "\n";
+        return false;
+    }
+    partialBuffer.resize(2 * partialBytes);
+    long head = qfReadFull(fd, partialBuffer.data(), partialBytes, 0);
+    long tail = qfReadFull(fd, partialBuffer.data() + partialBytes, partialBytes,
+        static_cast<int64_t>(size - partialBytes));
+    qfClose(fd);
+    if (head != static_cast<long>(partialBytes) || tail != static_cast<long>(partialBytes)) {
+        std::cerr << "[findDuplicates] Short read (file changed?): " << path << "\n";
+        return false;
+    }
+    QFState qs;
+    qfInit(qs);
+    processRaw(qs, partialBuffer.data(), 2 * partialBytes);
+    qfSqueeze(qs, out.data(), out.size());
+    return true;
+}
+
+std::string jsonEscape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size() + 2);
+    for (unsigned char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+// --------------------------------------------------------------------
+// findDuplicates
+// --------------------------------------------------------------------
+void findDuplicates(const std::vector<std::string>& files, std::vector<QFDupeGroup>& groups,
+    QFDupesReport& report, const QFDupesOptions& options) {
+    QFScheduler& scheduler = qfScheduler();
+    report = QFDupesReport();
+    groups.clear();
+    report.files = files.size();
+    const size_t partial = std::max<size_t>(options.partialBytes, 1);
+
+    // ---------------- Stage 1: sizes ----------------
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> sizes(files.size(), 0);
+    std::vector<uint8_t> statOk(files.size(), 0);
+    scheduler.parallelFor(files.size(), [&](size_t i) {
+        std::error_code ec;
+        uint64_t sz = std::filesystem::file_size(files[i], ec);
+        if (!ec) {
+            sizes[i] = sz;
+            statOk[i] = 1;
+        }
+    }, QFTaskPriority::Bulk, 256);
+
+    std::map<uint64_t, std::vector<size_t>> bySize;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!statOk[i]) {
+            report.failures++;
+            continue;
+        }
+        report.totalBytes += sizes[i];
+        if (sizes[i] >= options.minSize) bySize[sizes[i]].push_back(i);
+    }
+    std::vector<size_t> candidates;
+    for (auto& bucket : bySize) {
+        if (bucket.second.size() > 1) {
+            candidates.insert(candidates.end(), bucket.second.begin(), bucket.second.end());
+        }
+    }
+    report.sizeCandidates = candidates.size();
+    report.seconds[0] = secondsSince(start);
+    DUPES_LOG("stage 1: " << candidates.size() << " of " << files.size() << " files share a size");
+
+    // ---------------- Stage 2: head + tail ----------------
+    // Small files are digested in full right away (no cheaper read exists)
+    start = std::chrono::steady_clock::now();
+    std::vector<QFDigest> digests(files.size());
+    std::vector<uint8_t> state(files.size(), 0);  // 0 = failed, 1 = partial, 2 = full
+    std::atomic<uint64_t> bytesRead{ 0 };
+    scheduler.parallelFor(candidates.size(), [&](size_t c) {
+        size_t i = candidates[c];
+        if (sizes[i] <= 2 * partial) {
+            if (digestFile(files[i], digests[i])) state[i] = 2;
+            bytesRead += sizes[i];
+        }
+        else {
+            if (partialDigest(files[i], sizes[i], partial, digests[i])) state[i] = 1;
+            bytesRead += 2 * partial;
+        }
+    }, QFTaskPriority::Bulk, 16);
+
+    // Regroup on (size, digest); singletons drop out
+    typedef std::pair<uint64_t, QFDigest> Key;
+    std::map<Key, std::vector<size_t>> byPartial;
+    for (size_t i : candidates) {
+        if (state[i] == 0) {
+            report.failures++;
+            continue;
+        }
+        byPartial[Key(sizes[i], digests[i])].push_back(i);
+    }
+    std::vector<size_t> needFull;
+    std::map<Key, std::vector<size_t>> byFull;
+    for (auto& bucket : byPartial) {
+        if (bucket.second.size() < 2) continue;
+        if (state[bucket.second.front()] == 2) {
+            byFull.insert(bucket);
+        }
+        else {
+            needFull.insert(needFull.end(), bucket.second.begin(), bucket.second.end());
+        }
+    }
+    report.partialCandidates = needFull.size();
+    report.seconds[1] = secondsSince(start);
+    DUPES_LOG("stage 2: " << needFull.size() << " files need a full digest");
+
+    // ---------------- Stage 3: full digests ----------------
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> fullOk(files.size(), 0);
+    scheduler.parallelFor(needFull.size(), [&](size_t c) {
+        size_t i = needFull[c];
+        fullOk[i] = digestFile(files[i], digests[i]) ? 1 : 0;
+        bytesRead += sizes[i];
+    }, QFTaskPriority::Bulk, 1);
+    for (size_t i : needFull) {
+        if (!fullOk[i]) {
+            report.failures++;
+            continue;
+        }
+        byFull[Key(sizes[i], digests[i])].push_back(i);
+    }
+    report.seconds[2] = secondsSince(start);
+    report.bytesRead = bytesRead.load();
+
+    for (auto& bucket : byFull) {
+        if (bucket.second.size() < 2) continue;
+        QFDupeGroup group;
+        group.size = bucket.first.first;
+        group.digest = bucket.first.second;
+        for (size_t i : bucket.second) group.files.push_back(files[i]);
+        std::sort(group.files.begin(), group.files.end());
+        report.duplicateFiles += group.files.size() - 1;
+        report.wastedBytes += group.size * (group.files.size() - 1);
+        groups.push_back(std::move(group));
+    }
+    std::stable_sort(groups.begin(), groups.end(), [](const QFDupeGroup& a, const QFDupeGroup& b) {
+        return a.size * (a.files.size() - 1) > b.size * (b.files.size() - 1);
+    });
+}
+
+// --------------------------------------------------------------------
+// writeDupesJson
+// --------------------------------------------------------------------
+void writeDupesJson(const std::vector<QFDupeGroup>& groups, const QFDupesReport& report,
+    std::ostream& os) {
+    os << "{\n  \"groups\": [";
+    for (size_t g = 0; g < groups.size(); g++) {
+        const QFDupeGroup& group = groups[g];
+        os << (g ? "," : "") << "\n    {\"size\": " << group.size
+            << ", \"digest\": \"" << toHex(group.digest.data(), group.digest.size())
+            << "\", \"files\": [";
+        for (size_t f = 0; f < group.files.size(); f++) {
+            os << (f ? ", " : "") << "\"" << jsonEscape(group.files[f]) << "\"";
+        }
+        os << "]}";
+    }
+    os << (groups.empty() ? "" : "\n  ") << "],\n";
+    os << "  \"summary\": {\"files\": " << report.files
+        << ", \"totalBytes\": " << report.totalBytes
+        << ", \"sizeCandidates\": " << report.sizeCandidates
+        << ", \"partialCandidates\": " << report.partialCandidates
+        << ", \"bytesRead\": " << report.bytesRead
+        << ", \"bytesAvoided\": " << report.bytesAvoided()
+        << ", \"duplicateFiles\": " << report.duplicateFiles
+        << ", \"wastedBytes\": " << report.wastedBytes
+        << ", \"failures\": " << report.failures << "}\n}\n";
+}
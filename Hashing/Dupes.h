@@ -0,0 +1,57 @@
+#ifndef DUPES_H
+#define DUPES_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Duplicate finder with staged narrowing
+//   1) size:    files with a unique size cannot have a duplicate
+//   2) partial: QF digest of the first and last partialBytes; files up
+//               to 2 * partialBytes are fully digested here already
+//   3) full:    digestFile() of the survivors
+//   Each stage runs on the global scheduler.  Only stage 3 reads whole
+//   files, and only for files that matched on size and on both ends.
+// --------------------------------------------------------------------
+
+struct QFDupesOptions {
+    size_t partialBytes = 64 << 10;
+    uint64_t minSize = 1;   // ignore smaller files (default: skip empty ones)
+};
+
+struct QFDupeGroup {
+    uint64_t size = 0;
+    QFDigest digest{};
+    std::vector<std::string> files;   // sorted
+};
+
+struct QFDupesReport {
+    uint64_t files = 0;
+    uint64_t totalBytes = 0;          // what full-hashing everything would read
+    uint64_t sizeCandidates = 0;      // files left after stage 1
+    uint64_t partialCandidates = 0;   // files left after stage 2 (need a full read)
+    uint64_t bytesRead = 0;           // actually read by stages 2 and 3
+    uint64_t duplicateFiles = 0;      // files beyond the first of each group
+    uint64_t wastedBytes = 0;         // bytes taken by those extra copies
+    uint64_t failures = 0;
+    double seconds[3] = { 0.0, 0.0, 0.0 };
+
+    // Negative when staging re-read more than it saved (head/tail of
+    // files that then needed a full digest anyway)
+    int64_t bytesAvoided() const {
+        return static_cast<int64_t>(totalBytes) - static_cast<int64_t>(bytesRead);
+    }
+};
+
+// groups are sorted by wasted space (largest first)
+void findDuplicates(const std::vector<std::string>& files, std::vector<QFDupeGroup>& groups,
+    QFDupesReport& report, const QFDupesOptions& options = QFDupesOptions());
+
+// {"groups":[{"size":..,"digest":"..","files":[..]}],"summary":{..}}
+void writeDupesJson(const std::vector<QFDupeGroup>& groups, const QFDupesReport& report,
+    std::ostream& os);
+
+#endif // DUPES_H
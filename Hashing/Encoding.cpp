@@ -0,0 +1,272 @@
+#include "Encoding.h"
+#include "FileIO.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h> // for the AVX2 codecs
+#endif
+
+// Uncomment to enable debug prints
+// #define ENCODING_DEBUG
+
+#ifdef ENCODING_DEBUG
+#define ENCODING_LOG(msg) std::cerr << "[Encoding] " << msg << "\n"
+#else
+#define ENCODING_LOG(msg) /* no-op */
+#endif
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+static const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// 0..63 for alphabet characters, 0xFF otherwise
+struct Base64Table {
+    uint8_t value[256];
+    Base64Table() {
+        std::memset(value, 0xFF, sizeof(value));
+        for (int i = 0; i < 64; i++) value[static_cast<uint8_t>(BASE64_ALPHABET[i])] = static_cast<uint8_t>(i);
+    }
+};
+static const Base64Table BASE64_TABLE;
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// --------------------------------------------------------------------
+// Hex
+// --------------------------------------------------------------------
+void qfHexEncode(const uint8_t* data, size_t len, char* out) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i digits = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(HEX_DIGITS)));
+    const __m256i lowNibble = _mm256_set1_epi16(0x000F);
+    for (; i + 16 <= len; i += 16) {
+        // Byte b widened to a 16-bit lane; the high nibble goes to the
+        // lane's first byte and the low nibble to its second
+        __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        __m256i hi = _mm256_srli_epi16(v, 4);
+        __m256i lo = _mm256_slli_epi16(_mm256_and_si256(v, lowNibble), 8);
+        __m256i chars = _mm256_shuffle_epi8(digits, _mm256_or_si256(hi, lo));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), chars);
+    }
+#endif
+    for (; i < len; i++) {
+        out[2 * i] = HEX_DIGITS[data[i] >> 4];
+        out[2 * i + 1] = HEX_DIGITS[data[i] & 0x0F];
+    }
+}
+
+bool qfHexDecode(const char* hex, size_t hexLen, uint8_t* out) {
+    if (hexLen % 2 != 0) return false;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i lowerA = _mm256_set1_epi8('a');
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i five = _mm256_set1_epi8(5);
+    const __m256i ten = _mm256_set1_epi8(10);
+    const __m256i weights = _mm256_set1_epi16(0x0110);   // high digit * 16 + low digit
+    for (; i + 32 <= hexLen; i += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hex + i));
+        __m256i digit = _mm256_sub_epi8(c, zero);
+        __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(c, caseBit), lowerA);
+        __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, nine), digit);
+        __m256i isAlpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, five), alpha);
+        if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isAlpha)) != -1) return false;
+        __m256i value = _mm256_blendv_epi8(_mm256_add_epi8(alpha, ten), digit, isDigit);
+        __m256i pairs = _mm256_maddubs_epi16(value, weights);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(pairs, pairs), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2), _mm256_castsi256_si128(packed));
+    }
+#endif
+    for (; i < hexLen; i += 2) {
+        int hi = hexValue(hex[i]), lo = hexValue(hex[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i / 2] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Base64
+// --------------------------------------------------------------------
+#if defined(__AVX2__)
+// 24 bytes (12 per 128-bit lane) -> 32 six-bit indexes -> 32 characters
+static inline __m256i base64EncodeBlock(const uint8_t* in) {
+    __m256i v = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12)), 1);
+    v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    __m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+    __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    __m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+    __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    __m256i indexes = _mm256_or_si256(t1, t3);
+
+    // Offset per range: A-Z, a-z, 0-9, '+', '/'
+    __m256i reduced = _mm256_subs_epu8(indexes, _mm256_set1_epi8(51));
+    __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indexes);
+    reduced = _mm256_or_si256(reduced, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+    const __m256i offsets = _mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(offsets, reduced), indexes);
+}
+
+// 32 characters -> 24 bytes in the low 24 bytes; false on a character
+// outside the alphabet (padding never reaches this path)
+static inline bool base64DecodeBlock(const char* in, __m256i& bytes) {
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+    __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(c, 4), _mm256_set1_epi8(0x0F));
+    __m256i loNibbles = _mm256_and_si256(c, _mm256_set1_epi8(0x0F));
+    const __m256i loClasses = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i hiClasses = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    __m256i lo = _mm256_shuffle_epi8(loClasses, loNibbles);
+    __m256i hi = _mm256_shuffle_epi8(hiClasses, hiNibbles);
+    if (!_mm256_testz_si256(lo, hi)) return false;
+
+    const __m256i rolls = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    __m256i isSlash = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/'));
+    __m256i values = _mm256_add_epi8(c, _mm256_shuffle_epi8(rolls, _mm256_add_epi8(isSlash, hiNibbles)));
+
+    // Four 6-bit values -> 24 bits per 32-bit lane, then bytes in order
+    __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    merged = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    bytes = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+    return true;
+}
+#endif
+
+void qfBase64Encode(const uint8_t* data, size_t len, char* out) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    // Each step loads 28 bytes (two 16-byte loads at 0 and 12)
+    for (; i + 28 <= len; i += 24, out += 32) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), base64EncodeBlock(data + i));
+    }
+#endif
+    for (; i + 3 <= len; i += 3, out += 4) {
+        uint32_t v = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+        out[0] = BASE64_ALPHABET[(v >> 18) & 63];
+        out[1] = BASE64_ALPHABET[(v >> 12) & 63];
+        out[2] = BASE64_ALPHABET[(v >> 6) & 63];
+        out[3] = BASE64_ALPHABET[v & 63];
+    }
+    if (i < len) {
+        uint32_t v = uint32_t(data[i]) << 16;
+        if (i + 1 < len) v |= uint32_t(data[i + 1]) << 8;
+        out[0] = BASE64_ALPHABET[(v >> 18) & 63];
+        out[1] = BASE64_ALPHABET[(v >> 12) & 63];
+        out[2] = i + 1 < len ? BASE64_ALPHABET[(v >> 6) & 63] : '=';
+        out[3] = '=';
+    }
+}
+
+bool qfBase64Decode(const char* text, size_t len, uint8_t* out, size_t& outLen) {
+    outLen = 0;
+    if (len % 4 != 0) return false;
+    size_t i = 0;
+    uint8_t* start = out;
+#if defined(__AVX2__)
+    // Stops 16 characters short of the end: the padded last group stays
+    // scalar and the 32-byte store never passes the output
+    for (; i + 48 <= len; i += 32, out += 24) {
+        __m256i bytes;
+        if (!base64DecodeBlock(text + i, bytes)) return false;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), bytes);
+    }
+#endif
+    const uint8_t* table = BASE64_TABLE.value;
+    for (; i < len; i += 4) {
+        bool last = i + 4 == len;
+        size_t pad = 0;
+        if (last && text[i + 3] == '=') pad = text[i + 2] == '=' ? 2 : 1;
+        uint32_t v = 0;
+        for (size_t k = 0; k < 4 - pad; k++) {
+            uint8_t d = table[static_cast<uint8_t>(text[i + k])];
+            if (d == 0xFF) return false;
+            v |= uint32_t(d) << (18 - 6 * k);
+        }
+        // Padding must not hide set bits (canonical encoding only)
+        if ((pad == 1 && (v & 0xFF) != 0) || (pad == 2 && (v & 0xFFFF) != 0)) return false;
+        *out++ = static_cast<uint8_t>(v >> 16);
+        if (pad < 2) *out++ = static_cast<uint8_t>(v >> 8);
+        if (pad < 1) *out++ = static_cast<uint8_t>(v);
+    }
+    outLen = static_cast<size_t>(out - start);
+    return true;
+}
+
+std::string toBase64(const uint8_t* data, size_t len) {
+    std::string text(qfBase64Length(len), '=');
+    qfBase64Encode(data, len, &text[0]);
+    return text;
+}
+
+// --------------------------------------------------------------------
+// QFManifestWriter
+// --------------------------------------------------------------------
+QFManifestWriter::QFManifestWriter(int fd, size_t bufferBytes)
+    : fd(fd), buffer(std::max<size_t>(bufferBytes, 4096)) {
+}
+
+void QFManifestWriter::add(const uint8_t* digest, size_t digestLen, std::string_view path) {
+    size_t need = qfHexLength(digestLen) + 2 + path.size() + 1;
+    if (used + need > buffer.size()) {
+        flush();
+        if (need > buffer.size()) buffer.resize(need);
+    }
+    char* p = buffer.data() + used;
+    qfHexEncode(digest, digestLen, p);
+    p += qfHexLength(digestLen);
+    *p++ = ' ';
+    *p++ = ' ';
+    std::memcpy(p, path.data(), path.size());
+    p[path.size()] = '\n';
+    used += need;
+    count++;
+}
+
+void QFManifestWriter::addText(const char* text, size_t len) {
+    if (used + len > buffer.size()) {
+        flush();
+        if (len > buffer.size()) {
+            if (good && qfWriteAll(fd, text, len) != static_cast<long>(len)) good = false;
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, text, len);
+    used += len;
+}
+
+bool QFManifestWriter::flush() {
+    if (used > 0) {
+        if (good && qfWriteAll(fd, buffer.data(), used) != static_cast<long>(used)) {
+            std::cerr << "[Encoding] Manifest write failed on fd " << fd << "\n";
+            good = false;
+        }
+        ENCODING_LOG("flushed " << used << " bytes");
+        used = 0;
+    }
+    return good;
+}
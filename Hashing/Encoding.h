@@ -0,0 +1,72 @@
+#ifndef ENCODING_H
+#define ENCODING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// --------------------------------------------------------------------
+// Hex / base64 codecs for digests
+//   - With AVX2 the hex encoder expands 16 bytes per step through a
+//     nibble shuffle, and the decoder validates and packs 32 digits per
+//     step (maddubs + pack).  Base64 follows Mula & Lemire: 24 bytes ->
+//     32 characters per step on encode, 32 characters -> 24 bytes with
+//     the validation folded into the nibble lookups on decode.
+//   - Tails (and builds without AVX2) take the scalar loops, which give
+//     the same bytes.  Hex output is lower case; decoding accepts both
+//     cases.  Base64 is the RFC 4648 alphabet with '=' padding.
+// --------------------------------------------------------------------
+
+inline size_t qfHexLength(size_t bytes) { return 2 * bytes; }
+inline size_t qfBase64Length(size_t bytes) { return 4 * ((bytes + 2) / 3); }
+
+// Writes exactly qfHexLength(len) / qfBase64Length(len) characters, no NUL
+void qfHexEncode(const uint8_t* data, size_t len, char* out);
+void qfBase64Encode(const uint8_t* data, size_t len, char* out);
+
+// hexLen must be even; out receives hexLen / 2 bytes.  False on any
+// non-hex digit (out is then unspecified).
+bool qfHexDecode(const char* hex, size_t hexLen, uint8_t* out);
+// len must be a multiple of 4; out needs room for 3 * len / 4 bytes and
+// outLen receives the decoded size.  False on bad characters or padding.
+bool qfBase64Decode(const char* text, size_t len, uint8_t* out, size_t& outLen);
+
+std::string toBase64(const uint8_t* data, size_t len);
+
+// --------------------------------------------------------------------
+// QFManifestWriter
+//   - "<hex>  <path>\n" lines formatted straight into a large buffer and
+//     written with qfWriteAll when it fills, so a million-line manifest
+//     costs a few hundred write calls and no printf / iostream per line.
+//   - Owns nothing: the fd (stdout by default) stays open.  Anything else
+//     written to the same fd must go through add*() to keep the order.
+// --------------------------------------------------------------------
+class QFManifestWriter {
+public:
+    explicit QFManifestWriter(int fd = 1, size_t bufferBytes = 1 << 20);
+    ~QFManifestWriter() { flush(); }
+
+    QFManifestWriter(const QFManifestWriter&) = delete;
+    QFManifestWriter& operator=(const QFManifestWriter&) = delete;
+
+    void add(const uint8_t* digest, size_t digestLen, std::string_view path);
+    // Raw text, e.g. a prefix before add() or a whole preformatted line
+    void addText(const char* text, size_t len);
+    void addText(std::string_view text) { addText(text.data(), text.size()); }
+
+    // False once any write has failed
+    bool flush();
+    bool ok() const { return good; }
+    uint64_t lines() const { return count; }
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    size_t used = 0;
+    uint64_t count = 0;
+    bool good = true;
+};
+
+#endif // ENCODING_H
@@ -0,0 +1,173 @@
+#include "FileCopy.h"
+#include "BufferArena.h"
+#include "FileIO.h"
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+// Uncomment to enable debug prints
+// #define COPY_DEBUG
+
+#ifdef COPY_DEBUG
+#define COPY_LOG(msg) std::cerr << "[FileCopy] " << msg << "\n"
+#else
+#define COPY_LOG(msg) /* no-op */
+#endif
+
+// Buffers in the read -> (write + absorb) ring
+static const int COPY_SLOTS = 3;
+
+// --------------------------------------------------------------------
+// copyAndHashFile
+//   - Reader (this thread): fill slot k, queue it for the writer, absorb
+//     it, move to slot k+1 once the writer has released it.
+//   - Writer thread: write queued slots strictly in order.
+// --------------------------------------------------------------------
+bool copyAndHashFile(const std::string& src, const std::string& dst,
+    const QFCopyOptions& options, QFCopyResult& result) {
+    auto start = std::chrono::steady_clock::now();
+    result = QFCopyResult();
+
+    int in = qfOpenRead(src);
+    if (in < 0) {
+        std::cerr << "[copyAndHashFile] Failed to open source: " << src << "\n";
+        return false;
+    }
+    // Opening dst truncates it, so copying a file onto itself (or onto a
+    // hard link to it) would destroy the source before it is read
+    if (qfSameFile(src, dst)) {
+        std::cerr << "[copyAndHashFile] Source and destination are the same file: " << dst << "\n";
+        qfClose(in);
+        return false;
+    }
+    int out = qfOpenWrite(dst);
+    if (out < 0) {
+        std::cerr << "[copyAndHashFile] Failed to create destination: " << dst << "\n";
+        qfClose(in);
+        return false;
+    }
+#if !defined(_WIN32)
+    // Keep the source's permission bits (deploy artifacts may be executable)
+    struct stat st;
+    if (::fstat(in, &st) == 0) ::fchmod(out, st.st_mode & 07777);
+#endif
+
+    QFBufferArena& arena = qfIoArena();
+    const size_t chunk = arena.bufferSize();
+    std::unique_ptr<QFArenaLease> leases[COPY_SLOTS];
+    size_t lengths[COPY_SLOTS] = { 0 };
+    bool busy[COPY_SLOTS] = { false };
+    for (int i = 0; i < COPY_SLOTS; i++) leases[i].reset(new QFArenaLease(arena));
+
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<int> toWrite;
+    bool readerDone = false;
+    long writeError = 0;
+
+    std::thread writer([&]() {
+        while (true) {
+            int slot;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                changed.wait(guard, [&]() { return !toWrite.empty() || readerDone; });
+                if (toWrite.empty()) return;
+                slot = toWrite.front();
+                toWrite.pop_front();
+            }
+            long n = qfWriteAll(out, leases[slot]->data(), lengths[slot]);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (n < 0 && writeError == 0) writeError = n;
+                busy[slot] = false;
+            }
+            changed.notify_all();
+        }
+    });
+
+    QFState qs;
+    qfInit(qs);
+    long readError = 0;
+    for (int slot = 0;; slot = (slot + 1) % COPY_SLOTS) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return !busy[slot] || writeError != 0; });
+            if (writeError != 0) break;
+        }
+        long n = qfReadFull(in, leases[slot]->data(), chunk);
+        if (n < 0) {
+            readError = n;
+            break;
+        }
+        if (n == 0) break;
+
+        lengths[slot] = static_cast<size_t>(n);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            busy[slot] = true;
+            toWrite.push_back(slot);
+        }
+        changed.notify_all();
+
+        // The writer only reads this buffer too, so absorbing it now is safe
+        processRaw(qs, leases[slot]->data(), lengths[slot]);
+        result.bytes += lengths[slot];
+        if (static_cast<size_t>(n) < chunk) break; // EOF
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        readerDone = true;
+    }
+    changed.notify_all();
+    writer.join();
+    qfClose(in);
+
+    bool ok = true;
+    if (readError != 0) {
+        std::cerr << "[copyAndHashFile] Read error on " << src << ": "
+            << std::strerror(static_cast<int>(-readError)) << "\n";
+        ok = false;
+    }
+    if (writeError != 0) {
+        std::cerr << "[copyAndHashFile] Write error on " << dst << ": "
+            << std::strerror(static_cast<int>(-writeError)) << "\n";
+        ok = false;
+    }
+    if (ok && options.sync && !qfDataSync(out)) {
+        std::cerr << "[copyAndHashFile] fdatasync failed on " << dst << "\n";
+        ok = false;
+    }
+    if (!qfClose(out) && ok) {
+        std::cerr << "[copyAndHashFile] close failed on " << dst << ": " << std::strerror(errno) << "\n";
+        ok = false;
+    }
+    if (!ok) return false;
+
+    qfSqueeze(qs, result.digest.data(), result.digest.size());
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    COPY_LOG(result.bytes << " bytes in " << result.seconds << " s");
+
+    if (options.verify) {
+        // Independent second pass over the destination
+        QFDigest check;
+        if (!digestFile(dst, check)) return false;
+        result.verified = (check == result.digest);
+        if (!result.verified) {
+            std::cerr << "[copyAndHashFile] Verification failed: " << dst
+                << " does not match the digest of " << src << "\n";
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef FILE_COPY_H
+#define FILE_COPY_H
+
+#include <cstdint>
+#include <string>
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Hash-while-copy
+//   - Every buffer is read from src once, handed to a writer thread for
+//     dst, and absorbed into the sponge while that write is in flight.
+//   - The digest equals digestFile(src) (and digestFile(dst) if the copy
+//     is intact), so a deploy step no longer has to re-read dst.
+// --------------------------------------------------------------------
+
+struct QFCopyOptions {
+    bool sync = false;     // fdatasync dst before reporting success
+    bool verify = false;   // re-read dst with processFile and compare
+};
+
+struct QFCopyResult {
+    uint64_t bytes = 0;
+    double seconds = 0.0;
+    QFDigest digest{};
+    bool verified = false; // only meaningful with options.verify
+};
+
+// Returns false (after logging to stderr) on any read, write, sync or
+// verification failure.
+bool copyAndHashFile(const std::string& src, const std::string& dst,
+    const QFCopyOptions& options, QFCopyResult& result);
+
+#endif // FILE_COPY_H
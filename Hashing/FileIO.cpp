@@ -0,0 +1,234 @@
+#include "FileIO.h"
+#include <cerrno>
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+int qfOpenRead(const std::string& path) {
+#if defined(_WIN32)
+    return _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    return ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+int qfOpenWrite(const std::string& path) {
+#if defined(_WIN32)
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+}
+
+int qfOpenReadWrite(const std::string& path) {
+#if defined(_WIN32)
+    return _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+#endif
+}
+
+bool qfClose(int fd) {
+    if (fd < 0) return true;
+#if defined(_WIN32)
+    return _close(fd) == 0;
+#else
+    // Linux releases the descriptor even when close() fails; never retry
+    return ::close(fd) == 0;
+#endif
+}
+
+bool qfSameFile(const std::string& a, const std::string& b) {
+    std::error_code ec;
+    return std::filesystem::equivalent(a, b, ec);
+}
+
+long qfReadAt(int fd, void* buf, size_t len, int64_t offset) {
+#if defined(_WIN32)
+    if (offset >= 0 && _lseeki64(fd, offset, SEEK_SET) < 0) return -errno;
+    int n = _read(fd, buf, static_cast<unsigned>(len));
+    return (n < 0) ? -errno : n;
+#else
+    ssize_t n;
+    do {
+        n = (offset >= 0) ? ::pread(fd, buf, len, static_cast<off_t>(offset))
+                          : ::read(fd, buf, len);
+    } while (n < 0 && errno == EINTR);
+    return (n < 0) ? -errno : static_cast<long>(n);
+#endif
+}
+
+long qfReadFull(int fd, void* buf, size_t len, int64_t offset) {
+    uint8_t* p = static_cast<uint8_t*>(buf);
+    size_t got = 0;
+    while (got < len) {
+        long n = qfReadAt(fd, p + got, len - got, (offset >= 0) ? offset + static_cast<int64_t>(got) : -1);
+        if (n < 0) return n;
+        if (n == 0) break;
+        got += static_cast<size_t>(n);
+    }
+    return static_cast<long>(got);
+}
+
+long qfWriteAll(int fd, const void* buf, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+    size_t done = 0;
+    while (done < len) {
+#if defined(_WIN32)
+        int n = _write(fd, p + done, static_cast<unsigned>(len - done));
+#else
+        ssize_t n = ::write(fd, p + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n < 0) return -errno;
+        done += static_cast<size_t>(n);
+    }
+    return static_cast<long>(done);
+}
+
+int64_t qfTell(int fd) {
+#if defined(_WIN32)
+    return _lseeki64(fd, 0, SEEK_CUR);
+#else
+    return static_cast<int64_t>(::lseek(fd, 0, SEEK_CUR));
+#endif
+}
+
+void qfSeek(int fd, int64_t offset) {
+#if defined(_WIN32)
+    _lseeki64(fd, offset, SEEK_SET);
+#else
+    ::lseek(fd, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+int64_t qfFileSize(int fd) {
+#if defined(_WIN32)
+    struct _stat64 st;
+    if (_fstat64(fd, &st) != 0) return -1;
+#else
+    struct stat st;
+    if (::fstat(fd, &st) != 0) return -1;
+#endif
+    return static_cast<int64_t>(st.st_size);
+}
+
+bool qfTruncate(int fd, int64_t size) {
+#if defined(_WIN32)
+    return _chsize_s(fd, size) == 0;
+#else
+    return ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+#endif
+}
+
+bool qfDataSync(int fd) {
+#if defined(_WIN32)
+    return _commit(fd) == 0;
+#elif defined(__APPLE__)
+    return ::fsync(fd) == 0;
+#else
+    return ::fdatasync(fd) == 0;
+#endif
+}
+
+void qfDropCache(int fd, int64_t offset, int64_t len) {
+#if defined(POSIX_FADV_DONTNEED)
+    ::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(len), POSIX_FADV_DONTNEED);
+#else
+    (void)fd;
+    (void)offset;
+    (void)len;
+#endif
+}
+
+int qfNextDataExtent(int fd, int64_t from, int64_t& start, int64_t& end) {
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    off_t data = ::lseek(fd, static_cast<off_t>(from), SEEK_DATA);
+    if (data < 0) {
+        // ENXIO: no data at or after `from`
+        return (errno == ENXIO) ? 0 : -1;
+    }
+    off_t hole = ::lseek(fd, data, SEEK_HOLE);
+    if (hole < 0) return -1;
+    start = static_cast<int64_t>(data);
+    end = static_cast<int64_t>(hole);
+    return 1;
+#else
+    (void)fd;
+    (void)from;
+    (void)start;
+    (void)end;
+    return -1;
+#endif
+}
+
+// --------------------------------------------------------------------
+// QFMappedFile
+// --------------------------------------------------------------------
+bool QFMappedFile::open(const std::string& path, bool sequential) {
+    close();
+    int fd = qfOpenRead(path);
+    if (fd < 0) return false;
+    int64_t size = qfFileSize(fd);
+    if (size < 0) {
+        qfClose(fd);
+        return false;
+    }
+    bytes = static_cast<size_t>(size);
+    if (bytes == 0) {
+        qfClose(fd);
+        opened = true;
+        return true;
+    }
+#if defined(_WIN32)
+    (void)sequential;
+    HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+        ptr = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    qfClose(fd);
+    if (!ptr) {
+        if (mapping) CloseHandle(mapping);
+        mapping = nullptr;
+        bytes = 0;
+        return false;
+    }
+#else
+    void* mem = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    qfClose(fd);
+    if (mem == MAP_FAILED) {
+        bytes = 0;
+        return false;
+    }
+    if (sequential) ::madvise(mem, bytes, MADV_SEQUENTIAL);
+    ptr = static_cast<const uint8_t*>(mem);
+#endif
+    opened = true;
+    return true;
+}
+
+void QFMappedFile::close() {
+    if (ptr) {
+#if defined(_WIN32)
+        UnmapViewOfFile(ptr);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        ::munmap(const_cast<uint8_t*>(ptr), bytes);
+#endif
+    }
+    ptr = nullptr;
+    bytes = 0;
+    opened = false;
+}
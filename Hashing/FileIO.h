@@ -0,0 +1,96 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// --------------------------------------------------------------------
+// Thin portable wrappers over raw file descriptors (POSIX, or the
+// _open/_read family on Windows).  Errors come back as -errno so
+// callers can tell "0 = EOF" from a failure without touching errno.
+// --------------------------------------------------------------------
+
+// Open for reading; returns -1 on failure
+int qfOpenRead(const std::string& path);
+
+// Create/truncate for writing (mode 0644 on POSIX); returns -1 on failure
+int qfOpenWrite(const std::string& path);
+
+// Open (creating if needed, never truncating) for reading and writing;
+// returns -1 on failure
+int qfOpenReadWrite(const std::string& path);
+
+// False if close() reports an error (e.g. a deferred write error on a
+// network file system), EINTR included: the descriptor is gone either
+// way and the outcome of its pending writes is unknown.  fd < 0 is a
+// no-op that succeeds.
+bool qfClose(int fd);
+
+// True if both paths name the same existing file, hard links included.
+// Writers that truncate their output check this first so they cannot
+// destroy the input they are about to read.
+bool qfSameFile(const std::string& a, const std::string& b);
+
+// One read at offset (offset < 0 => current position, for pipes)
+long qfReadAt(int fd, void* buf, size_t len, int64_t offset);
+
+// Keep reading until len bytes or EOF; short only at EOF
+long qfReadFull(int fd, void* buf, size_t len, int64_t offset = -1);
+
+// Write everything (retries short writes); bytes written or -errno
+long qfWriteAll(int fd, const void* buf, size_t len);
+
+int64_t qfTell(int fd);
+void qfSeek(int fd, int64_t offset);
+
+// Size of an open file, or -1
+int64_t qfFileSize(int fd);
+
+// Next allocated extent [start, end) at or after `from`, via
+// SEEK_DATA/SEEK_HOLE.  Returns 1 if found, 0 if only holes remain,
+// -1 if the platform or file system cannot tell (treat all as data).
+int qfNextDataExtent(int fd, int64_t from, int64_t& start, int64_t& end);
+
+// Cut (or extend with zeros) an open file to `size` bytes
+bool qfTruncate(int fd, int64_t size);
+
+// Flush file data to stable storage (fdatasync / _commit)
+bool qfDataSync(int fd);
+
+// Hint that [offset, offset + len) will not be read again, so a
+// background pass does not evict other processes' page cache
+// (POSIX_FADV_DONTNEED; no-op where unsupported)
+void qfDropCache(int fd, int64_t offset, int64_t len);
+
+// --------------------------------------------------------------------
+// QFMappedFile
+//   - Read-only mapping of a whole file (mmap / MapViewOfFile).  An
+//     empty file maps to data() == nullptr, size() == 0 and is valid.
+// --------------------------------------------------------------------
+class QFMappedFile {
+public:
+    QFMappedFile() = default;
+    ~QFMappedFile() { close(); }
+
+    QFMappedFile(const QFMappedFile&) = delete;
+    QFMappedFile& operator=(const QFMappedFile&) = delete;
+
+    // sequential: hint the kernel to read ahead aggressively
+    bool open(const std::string& path, bool sequential = false);
+    void close();
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return bytes; }
+    bool isOpen() const { return opened; }
+
+private:
+    const uint8_t* ptr = nullptr;
+    size_t bytes = 0;
+    bool opened = false;
+#if defined(_WIN32)
+    void* mapping = nullptr;
+#endif
+};
+
+#endif // FILE_IO_H
@@ -0,0 +1,262 @@
+#include "Inflate.h"
+#include <cstring>
+#include <vector>
+
+static const int MAX_BITS = 15;
+static const int FAST_BITS = 10;        // codes up to this long decode with one lookup
+static const size_t WINDOW = 32768;
+
+static const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+namespace {
+
+// LSB-first bit reader; reads past the end as zeros and remembers it
+struct BitReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t buf = 0;
+    int count = 0;
+    int padded = 0;     // zero bits appended past the end
+
+    void need(int n) {
+        while (count < n) {
+            if (p < end) buf |= uint64_t(*p++) << count;
+            else padded += 8;
+            count += 8;
+        }
+    }
+    uint32_t bits(int n) {
+        if (n == 0) return 0;
+        need(n);
+        uint32_t v = static_cast<uint32_t>(buf & ((uint64_t(1) << n) - 1));
+        buf >>= n;
+        count -= n;
+        return v;
+    }
+    // True once a padding bit has actually been consumed
+    bool overrun() const { return padded > count; }
+};
+
+// Canonical Huffman table: puff-style counts/symbols plus a fast table
+// indexed by the next FAST_BITS stream bits: (symbol << 4) | length
+struct Huffman {
+    uint16_t count[MAX_BITS + 1];
+    uint16_t symbol[288];
+    uint16_t fast[1 << FAST_BITS];
+
+    bool build(const uint8_t* lengths, int n) {
+        std::memset(count, 0, sizeof(count));
+        std::memset(fast, 0, sizeof(fast));
+        for (int i = 0; i < n; i++) count[lengths[i]]++;
+        count[0] = 0;
+        int left = 1;
+        for (int len = 1; len <= MAX_BITS; len++) {
+            left <<= 1;
+            left -= count[len];
+            if (left < 0) return false;     // over-subscribed
+        }
+        uint16_t offs[MAX_BITS + 1];
+        uint32_t next[MAX_BITS + 1];
+        offs[1] = 0;
+        next[1] = 0;
+        for (int len = 1; len < MAX_BITS; len++) {
+            offs[len + 1] = offs[len] + count[len];
+            next[len + 1] = (next[len] + count[len]) << 1;
+        }
+        for (int sym = 0; sym < n; sym++) {
+            int len = lengths[sym];
+            if (len == 0) continue;
+            symbol[offs[len]++] = static_cast<uint16_t>(sym);
+            uint32_t code = next[len]++;
+            if (len > FAST_BITS) continue;
+            uint32_t rev = 0;
+            for (int i = 0; i < len; i++) rev |= ((code >> i) & 1) << (len - 1 - i);
+            for (uint32_t k = rev; k < (1u << FAST_BITS); k += 1u << len) {
+                fast[k] = static_cast<uint16_t>((sym << 4) | len);
+            }
+        }
+        return true;
+    }
+
+    int decode(BitReader& in) const {
+        in.need(MAX_BITS);
+        uint16_t e = fast[in.buf & ((1u << FAST_BITS) - 1)];
+        if (e != 0) {
+            in.bits(e & 15);
+            return e >> 4;
+        }
+        // Long code: walk the canonical lengths one bit at a time
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len <= MAX_BITS; len++) {
+            code |= static_cast<int>(in.bits(1));
+            int c = count[len];
+            if (code - c < first) return symbol[index + (code - first)];
+            index += c;
+            first += c;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+};
+
+// Output window: pieces of `chunk` bytes go to the sink, the last 32 KiB
+// stay behind for back-references
+struct Output {
+    std::vector<uint8_t> buf;
+    size_t chunk;
+    size_t start = 0;
+    size_t pos = 0;
+    uint64_t total = 0;
+    const QFInflateSink& sink;
+
+    Output(size_t chunkSize, const QFInflateSink& s) : buf(WINDOW + chunkSize), chunk(chunkSize), sink(s) {}
+
+    void flushFull() {
+        sink(buf.data() + start, pos - start);
+        if (pos > WINDOW) {
+            std::memmove(buf.data(), buf.data() + pos - WINDOW, WINDOW);
+            pos = WINDOW;
+        }
+        start = pos;
+    }
+    void put(uint8_t b) {
+        buf[pos++] = b;
+        total++;
+        if (pos - start == chunk) flushFull();
+    }
+    bool copy(size_t dist, size_t len) {
+        if (dist > pos) return false;       // before the start of the stream
+        while (len-- > 0) put(buf[pos - dist]);
+        return true;
+    }
+    void finish() {
+        if (pos > start) sink(buf.data() + start, pos - start);
+    }
+};
+
+bool inflateBlock(BitReader& in, Output& out, const Huffman& lit, const Huffman& dist) {
+    while (true) {
+        int sym = lit.decode(in);
+        if (sym < 0 || in.overrun()) return false;
+        if (sym < 256) {
+            out.put(static_cast<uint8_t>(sym));
+            continue;
+        }
+        if (sym == 256) return true;
+        sym -= 257;
+        if (sym >= 29) return false;
+        size_t len = LENGTH_BASE[sym] + in.bits(LENGTH_EXTRA[sym]);
+        int d = dist.decode(in);
+        if (d < 0 || d >= 30) return false;
+        size_t distance = DIST_BASE[d] + in.bits(DIST_EXTRA[d]);
+        if (in.overrun() || !out.copy(distance, len)) return false;
+    }
+}
+
+bool dynamicTables(BitReader& in, Huffman& lit, Huffman& dist) {
+    int nlen = static_cast<int>(in.bits(5)) + 257;
+    int ndist = static_cast<int>(in.bits(5)) + 1;
+    int ncode = static_cast<int>(in.bits(4)) + 4;
+    if (nlen > 286 || ndist > 30) return false;
+
+    uint8_t lengths[320] = { 0 };
+    for (int i = 0; i < ncode; i++) lengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(in.bits(3));
+    Huffman codes;
+    if (!codes.build(lengths, 19)) return false;
+
+    std::memset(lengths, 0, sizeof(lengths));
+    int i = 0;
+    while (i < nlen + ndist) {
+        int sym = codes.decode(in);
+        if (sym < 0 || in.overrun()) return false;
+        if (sym < 16) {
+            lengths[i++] = static_cast<uint8_t>(sym);
+            continue;
+        }
+        uint8_t value = 0;
+        int repeat;
+        if (sym == 16) {
+            if (i == 0) return false;
+            value = lengths[i - 1];
+            repeat = 3 + static_cast<int>(in.bits(2));
+        }
+        else if (sym == 17) {
+            repeat = 3 + static_cast<int>(in.bits(3));
+        }
+        else {
+            repeat = 11 + static_cast<int>(in.bits(7));
+        }
+        if (i + repeat > nlen + ndist) return false;
+        while (repeat-- > 0) lengths[i++] = value;
+    }
+    if (lengths[256] == 0) return false;    // no end-of-block code
+    return lit.build(lengths, nlen) && dist.build(lengths + nlen, ndist);
+}
+
+} // namespace
+
+// --------------------------------------------------------------------
+// qfInflate
+// --------------------------------------------------------------------
+bool qfInflate(const uint8_t* in, size_t inLen, size_t chunk, const QFInflateSink& sink, uint64_t* outBytes) {
+    BitReader reader{ in, in + inLen };
+    Output out(chunk == 0 ? WINDOW : chunk, sink);
+
+    static Huffman fixedLit, fixedDist;
+    static const bool fixedReady = []() {
+        uint8_t lengths[288];
+        int i = 0;
+        for (; i < 144; i++) lengths[i] = 8;
+        for (; i < 256; i++) lengths[i] = 9;
+        for (; i < 280; i++) lengths[i] = 7;
+        for (; i < 288; i++) lengths[i] = 8;
+        fixedLit.build(lengths, 288);
+        for (i = 0; i < 30; i++) lengths[i] = 5;
+        fixedDist.build(lengths, 30);
+        return true;
+    }();
+    (void)fixedReady;
+
+    Huffman lit, dist;
+    bool last = false;
+    while (!last) {
+        last = reader.bits(1) != 0;
+        uint32_t type = reader.bits(2);
+        bool ok;
+        if (type == 0) {
+            // Stored: byte-align, LEN / NLEN, raw bytes
+            reader.bits(reader.count & 7);
+            uint32_t len = reader.bits(16);
+            uint32_t nlen = reader.bits(16);
+            ok = !reader.overrun() && (len ^ 0xFFFF) == nlen;
+            while (ok && len > 0 && reader.count >= 8) {
+                out.put(static_cast<uint8_t>(reader.bits(8)));
+                len--;
+            }
+            if (ok && static_cast<size_t>(reader.end - reader.p) < len) ok = false;
+            for (; ok && len > 0; len--) out.put(*reader.p++);
+        }
+        else if (type == 1) {
+            ok = inflateBlock(reader, out, fixedLit, fixedDist);
+        }
+        else if (type == 2) {
+            ok = dynamicTables(reader, lit, dist) && inflateBlock(reader, out, lit, dist);
+        }
+        else {
+            ok = false;
+        }
+        if (!ok || reader.overrun()) return false;
+    }
+    out.finish();
+    if (outBytes) *outBytes = out.total;
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// --------------------------------------------------------------------
+// Raw DEFLATE (RFC 1951) decoder for zip members
+//   - Input is fully in memory (a mapped archive); output is streamed
+//     to `sink` in pieces of exactly `chunk` bytes (the last may be
+//     shorter), keeping only chunk + 32 KiB of history in memory.
+//   - Feeding those pieces to processRaw gives the same digest as
+//     digestFile() of the extracted member when chunk is the arena
+//     buffer size.
+//   - Returns false on malformed or truncated streams.
+// --------------------------------------------------------------------
+
+using QFInflateSink = std::function<void(const uint8_t* data, size_t len)>;
+
+bool qfInflate(const uint8_t* in, size_t inLen, size_t chunk, const QFInflateSink& sink,
+    uint64_t* outBytes = nullptr);
+
+#endif // INFLATE_H
@@ -0,0 +1,159 @@
+#include "IoUring.h"
+
+#if defined(QF_HAVE_IO_URING)
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Uncomment to enable debug prints
+// #define URING_DEBUG
+
+#ifdef URING_DEBUG
+#define URING_LOG(msg) std::cerr << "[IoUring] " << msg << "\n"
+#else
+#define URING_LOG(msg) /* no-op */
+#endif
+
+bool QFUring::init(unsigned depth, bool withEventFd) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+    if (ringFd < 0) {
+        URING_LOG("io_uring_setup failed: " << std::strerror(errno));
+        return false;
+    }
+    featureBits = params.features;
+
+    sqRingLen = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingLen = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) sqRingLen = cqRingLen = (sqRingLen > cqRingLen) ? sqRingLen : cqRingLen;
+
+    sqRing = ::mmap(nullptr, sqRingLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) { sqRing = nullptr; return false; }
+    if (single) {
+        cqRing = sqRing;
+    }
+    else {
+        cqRing = ::mmap(nullptr, cqRingLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) { cqRing = nullptr; return false; }
+    }
+    sqesLen = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqesMem = ::mmap(nullptr, sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ringFd, IORING_OFF_SQES);
+    if (sqesMem == MAP_FAILED) return false;
+    sqes = static_cast<io_uring_sqe*>(sqesMem);
+
+    uint8_t* sq = static_cast<uint8_t*>(sqRing);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqCount = params.sq_entries;
+
+    uint8_t* cq = static_cast<uint8_t*>(cqRing);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    cqCount = params.cq_entries;
+
+    if (withEventFd) {
+        evFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (evFd < 0) return false;
+        if (::syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_EVENTFD, &evFd, 1) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QFUring::~QFUring() {
+    if (sqes) ::munmap(sqes, sqesLen);
+    if (cqRing && cqRing != sqRing) ::munmap(cqRing, cqRingLen);
+    if (sqRing) ::munmap(sqRing, sqRingLen);
+    if (evFd >= 0) ::close(evFd);
+    if (ringFd >= 0) ::close(ringFd);
+}
+
+io_uring_sqe* QFUring::nextSqe() {
+    unsigned tail = *sqTail;
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= sqCount) return nullptr;
+    unsigned index = tail & sqMask;
+    io_uring_sqe* sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    unsubmitted++;
+    return sqe;
+}
+
+bool QFUring::prepRead(int fd, void* buf, size_t len, int64_t offset, uint64_t userData) {
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = static_cast<uint32_t>(len);
+    sqe->off = (offset >= 0) ? static_cast<uint64_t>(offset) : ~0ULL;
+    sqe->user_data = userData;
+    return true;
+}
+
+bool QFUring::prepOpenAt(int dirFd, const char* path, int flags, uint64_t userData) {
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = dirFd;
+    sqe->addr = reinterpret_cast<uint64_t>(path);
+    sqe->open_flags = static_cast<uint32_t>(flags);
+    sqe->user_data = userData;
+    return true;
+}
+
+bool QFUring::prepClose(int fd, uint64_t userData) {
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) return false;
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->user_data = userData;
+    return true;
+}
+
+int QFUring::submit(unsigned waitFor) {
+    unsigned flags = (waitFor > 0) ? IORING_ENTER_GETEVENTS : 0;
+    if (unsubmitted == 0 && waitFor == 0) return 0;
+    long r;
+    while ((r = ::syscall(__NR_io_uring_enter, ringFd, unsubmitted, waitFor, flags, nullptr, 0)) < 0
+        && errno == EINTR) {
+    }
+    if (r < 0) return -errno;
+    unsubmitted -= (static_cast<unsigned>(r) < unsubmitted) ? static_cast<unsigned>(r) : unsubmitted;
+    return static_cast<int>(r);
+}
+
+size_t QFUring::drain(const std::function<void(uint64_t userData, int res)>& onCompletion) {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    size_t handled = 0;
+    while (head != tail) {
+        const io_uring_cqe& cqe = cqes[head & cqMask];
+        uint64_t id = cqe.user_data;
+        int res = cqe.res;
+        head++;
+        // Release the slot before the callback, which may queue more work
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        onCompletion(id, res);
+        handled++;
+    }
+    return handled;
+}
+
+#endif // QF_HAVE_IO_URING
@@ -0,0 +1,74 @@
+#ifndef IO_URING_H
+#define IO_URING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// --------------------------------------------------------------------
+// Minimal io_uring wrapper (raw syscalls, no liburing dependency).
+// QF_HAVE_IO_URING is defined when the kernel headers are available;
+// init() can still fail at runtime (old kernel, seccomp, containers),
+// so every user keeps a non-uring fallback.
+//
+// Not thread-safe: callers serialize access to one QFUring.
+// --------------------------------------------------------------------
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define QF_HAVE_IO_URING 1
+#endif
+
+#if defined(QF_HAVE_IO_URING)
+
+class QFUring {
+public:
+    QFUring() = default;
+    ~QFUring();
+
+    QFUring(const QFUring&) = delete;
+    QFUring& operator=(const QFUring&) = delete;
+
+    // Set up a ring with `depth` SQ entries.  withEventFd registers an
+    // eventfd that becomes readable on every completion.
+    bool init(unsigned depth, bool withEventFd = false);
+
+    // Queue one operation; false when the SQ is full
+    bool prepRead(int fd, void* buf, size_t len, int64_t offset, uint64_t userData);
+    bool prepOpenAt(int dirFd, const char* path, int flags, uint64_t userData);
+    bool prepClose(int fd, uint64_t userData);
+
+    // Hand queued SQEs to the kernel; waits for at least waitFor
+    // completions.  Returns the kernel's result (negative errno on error).
+    int submit(unsigned waitFor = 0);
+
+    // Pop every available completion; returns how many were handled
+    size_t drain(const std::function<void(uint64_t userData, int res)>& onCompletion);
+
+    unsigned sqEntries() const { return sqCount; }
+    unsigned cqEntries() const { return cqCount; }
+    uint32_t features() const { return featureBits; }
+    int eventFd() const { return evFd; }
+
+private:
+    io_uring_sqe* nextSqe();
+
+    int ringFd = -1;
+    int evFd = -1;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingLen = 0, cqRingLen = 0, sqesLen = 0;
+    io_uring_sqe* sqes = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned sqMask = 0, cqMask = 0, sqCount = 0, cqCount = 0;
+    uint32_t featureBits = 0;
+    unsigned unsubmitted = 0;
+};
+
+#endif // QF_HAVE_IO_URING
+
+#endif // IO_URING_H
@@ -0,0 +1,290 @@
+#include "Kdf.h"
+#include "Performance.h"
+#include "TaskScheduler.h"
+#include "UniversalData.h"
+#include "Wipe.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Uncomment to enable debug prints
+// #define KDF_DEBUG
+
+#ifdef KDF_DEBUG
+#define KDF_LOG(msg) std::cerr << "[Kdf] " << msg << "\n"
+#else
+#define KDF_LOG(msg) /* no-op */
+#endif
+
+static const uint32_t KDF_VERSION = 1;
+static const uint32_t KDF_TYPE_ID = 2;        // Argon2id-style hybrid indexing
+static const uint32_t SYNC_POINTS = 4;
+static const size_t BLOCK_WORDS = QFState::STATE_WORDS * QF_LANES;   // 128 x u64 = 1 KiB
+static const size_t BLOCK_BYTES = BLOCK_WORDS * 8;
+
+typedef QFStateX4 Block;
+
+static inline uint64_t* words(Block& b) { return &b.w[0][0]; }
+static inline const uint64_t* words(const Block& b) { return &b.w[0][0]; }
+
+static void putLE32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+// --------------------------------------------------------------------
+// Compression G(X, Y): two 4-way permutations with a 4x4 word transpose
+// between them, so every output word depends on all 1024 input bytes
+// --------------------------------------------------------------------
+static void compress(const Block& x, const Block& y, Block& out, bool xorInto) {
+    Block r, q;
+    const uint64_t* xw = words(x);
+    const uint64_t* yw = words(y);
+    uint64_t* rw = words(r);
+    for (size_t i = 0; i < BLOCK_WORDS; i++) rw[i] = xw[i] ^ yw[i];
+    q = r;
+    qfPermutationX4(q);
+    for (int g = 0; g < QFState::STATE_WORDS; g += QF_LANES) {
+        for (int j = 0; j < QF_LANES; j++) {
+            for (int lane = j + 1; lane < QF_LANES; lane++) std::swap(q.w[g + j][lane], q.w[g + lane][j]);
+        }
+    }
+    qfPermutationX4(q);
+    uint64_t* ow = words(out);
+    const uint64_t* qw = words(q);
+    if (xorInto) {
+        for (size_t i = 0; i < BLOCK_WORDS; i++) ow[i] ^= qw[i] ^ rw[i];
+    }
+    else {
+        for (size_t i = 0; i < BLOCK_WORDS; i++) ow[i] = qw[i] ^ rw[i];
+    }
+}
+
+// H'(prefix || a || b) stretched to one block by squeezing 1 KiB
+static void initialBlock(const uint8_t* h0, size_t h0Len, uint32_t a, uint32_t b, Block& out) {
+    std::vector<uint8_t> input(h0, h0 + h0Len);
+    putLE32(input, a);
+    putLE32(input, b);
+    QFState qs;
+    qfInit(qs);
+    processRaw(qs, input.data(), input.size());
+    uint8_t bytes[BLOCK_BYTES];
+    qfSqueeze(qs, bytes, sizeof(bytes));
+    std::memcpy(words(out), bytes, BLOCK_BYTES);
+    qfWipe(bytes, sizeof(bytes));
+    qfWipe(input.data(), input.size());
+}
+
+namespace {
+
+struct Instance {
+    std::vector<Block> memory;
+    uint32_t lanes, laneLength, segmentLength, passes, blocks;
+
+    Block& at(uint32_t lane, uint32_t index) { return memory[size_t(lane) * laneLength + index]; }
+
+    // One lane's segment of one slice (RFC 9106 3.4)
+    void fillSegment(uint32_t pass, uint32_t lane, uint32_t slice) {
+        const bool independent = (pass == 0 && slice < SYNC_POINTS / 2);
+        Block address{}, input{}, zero{};
+        uint64_t* in = words(input);
+        if (independent) {
+            in[0] = pass;
+            in[1] = lane;
+            in[2] = slice;
+            in[3] = blocks;
+            in[4] = passes;
+            in[5] = KDF_TYPE_ID;
+        }
+        auto nextAddresses = [&]() {
+            in[6]++;
+            compress(zero, input, address, false);
+            compress(zero, address, address, false);
+        };
+
+        uint32_t start = 0;
+        if (pass == 0 && slice == 0) {
+            start = 2;   // blocks 0 and 1 come from H'
+            if (independent) nextAddresses();
+        }
+        uint32_t current = slice * segmentLength + start;
+        uint32_t previous = (current % laneLength == 0) ? current + laneLength - 1 : current - 1;
+
+        for (uint32_t i = start; i < segmentLength; i++, current++, previous++) {
+            if (current % laneLength == 1) previous = current - 1;
+            uint64_t pseudo;
+            if (independent) {
+                if (i % BLOCK_WORDS == 0) nextAddresses();
+                pseudo = words(address)[i % BLOCK_WORDS];
+            }
+            else pseudo = words(at(lane, previous))[0];
+
+            uint32_t refLane = (pass == 0 && slice == 0) ? lane : static_cast<uint32_t>((pseudo >> 32) % lanes);
+            bool sameLane = (refLane == lane);
+            uint64_t area;
+            if (pass == 0) {
+                area = sameLane ? slice * segmentLength + i - 1
+                    : slice * segmentLength - (i == 0 ? 1 : 0);
+            }
+            else {
+                area = sameLane ? laneLength - segmentLength + i - 1
+                    : laneLength - segmentLength - (i == 0 ? 1 : 0);
+            }
+            uint64_t j1 = pseudo & 0xFFFFFFFFu;
+            uint64_t relative = area - 1 - ((area * ((j1 * j1) >> 32)) >> 32);
+            uint64_t startPos = (pass == 0 || slice == SYNC_POINTS - 1) ? 0 : (slice + 1) * segmentLength;
+            uint32_t refIndex = static_cast<uint32_t>((startPos + relative) % laneLength);
+
+            compress(at(lane, previous), at(refLane, refIndex), at(lane, current), pass > 0);
+        }
+        qfWipe(&address, sizeof(address));
+        qfWipe(&input, sizeof(input));
+    }
+};
+
+} // namespace
+
+bool qfKdf(const uint8_t* password, size_t passwordLen, const uint8_t* salt, size_t saltLen,
+    const QFKdfParams& params, uint8_t* out, size_t outLen,
+    const uint8_t* secret, size_t secretLen, const uint8_t* ad, size_t adLen) {
+    if (saltLen < 8 || params.passes == 0 || params.lanes == 0 || outLen < 4) {
+        std::cerr << "[qfKdf] Need a salt of at least 8 bytes, passes >= 1, lanes >= 1 and outLen >= 4\n";
+        return false;
+    }
+    Instance inst;
+    inst.lanes = params.lanes;
+    inst.passes = params.passes;
+    uint32_t blocks = std::max(params.memoryKiB, 2 * SYNC_POINTS * params.lanes);
+    inst.segmentLength = blocks / (params.lanes * SYNC_POINTS);
+    inst.laneLength = inst.segmentLength * SYNC_POINTS;
+    inst.blocks = inst.laneLength * params.lanes;
+    try {
+        inst.memory.resize(inst.blocks);
+    }
+    catch (const std::bad_alloc&) {
+        std::cerr << "[qfKdf] Cannot allocate " << inst.blocks << " KiB\n";
+        return false;
+    }
+
+    // H0 binds every parameter and input
+    std::vector<uint8_t> h0Input;
+    putLE32(h0Input, params.lanes);
+    putLE32(h0Input, static_cast<uint32_t>(outLen));
+    putLE32(h0Input, params.memoryKiB);
+    putLE32(h0Input, params.passes);
+    putLE32(h0Input, KDF_VERSION);
+    putLE32(h0Input, KDF_TYPE_ID);
+    auto field = [&](const uint8_t* p, size_t n) {
+        putLE32(h0Input, static_cast<uint32_t>(n));
+        if (n > 0) h0Input.insert(h0Input.end(), p, p + n);
+    };
+    field(password, passwordLen);
+    field(salt, saltLen);
+    field(secret, secretLen);
+    field(ad, adLen);
+    uint8_t h0[64];
+    {
+        QFState qs;
+        qfInit(qs);
+        processRaw(qs, h0Input.data(), h0Input.size());
+        qfSqueeze(qs, h0, sizeof(h0));
+    }
+    qfWipe(h0Input.data(), h0Input.size());
+
+    for (uint32_t lane = 0; lane < inst.lanes; lane++) {
+        initialBlock(h0, sizeof(h0), 0, lane, inst.at(lane, 0));
+        initialBlock(h0, sizeof(h0), 1, lane, inst.at(lane, 1));
+    }
+    qfWipe(h0, sizeof(h0));
+
+    // Slices in order; within a slice every lane runs on the scheduler
+    for (uint32_t pass = 0; pass < inst.passes; pass++) {
+        for (uint32_t slice = 0; slice < SYNC_POINTS; slice++) {
+            qfScheduler().parallelFor(inst.lanes, [&](size_t lane) {
+                inst.fillSegment(pass, static_cast<uint32_t>(lane), slice);
+            }, QFTaskPriority::Interactive);
+        }
+    }
+
+    // Tag = QF(outLen || XOR of every lane's last block)
+    Block final = inst.at(0, inst.laneLength - 1);
+    for (uint32_t lane = 1; lane < inst.lanes; lane++) {
+        const uint64_t* last = words(inst.at(lane, inst.laneLength - 1));
+        for (size_t i = 0; i < BLOCK_WORDS; i++) words(final)[i] ^= last[i];
+    }
+    std::vector<uint8_t> tagInput;
+    putLE32(tagInput, static_cast<uint32_t>(outLen));
+    const uint8_t* fb = reinterpret_cast<const uint8_t*>(words(final));
+    tagInput.insert(tagInput.end(), fb, fb + BLOCK_BYTES);
+    QFState qs;
+    qfInit(qs);
+    processRaw(qs, tagInput.data(), tagInput.size());
+    qfSqueeze(qs, out, outLen);
+
+    qfWipe(tagInput.data(), tagInput.size());
+    qfWipe(&final, sizeof(final));
+    qfWipe(inst.memory.data(), inst.memory.size() * sizeof(Block));
+    KDF_LOG(inst.blocks << " KiB, " << inst.passes << " passes, " << inst.lanes << " lanes");
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Encoded verifier
+// --------------------------------------------------------------------
+static bool fromHex(const std::string& hex, std::vector<uint8_t>& out) {
+    if (hex.size() % 2 != 0) return false;
+    out.clear();
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        int v = 0;
+        for (int k = 0; k < 2; k++) {
+            char c = hex[i + k];
+            int d = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if (d < 0) return false;
+            v = (v << 4) | d;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+    return true;
+}
+
+bool qfKdfEncode(const std::string& password, const uint8_t* salt, size_t saltLen,
+    const QFKdfParams& params, size_t outLen, std::string& encoded) {
+    std::vector<uint8_t> key(outLen);
+    if (!qfKdf(reinterpret_cast<const uint8_t*>(password.data()), password.size(), salt, saltLen,
+        params, key.data(), key.size())) {
+        return false;
+    }
+    encoded = "$qfkdf$v=" + std::to_string(KDF_VERSION) + "$m=" + std::to_string(params.memoryKiB)
+        + ",t=" + std::to_string(params.passes) + ",p=" + std::to_string(params.lanes) + "$"
+        + toHex(salt, saltLen) + "$" + toHex(key.data(), key.size());
+    qfWipe(key.data(), key.size());
+    return true;
+}
+
+bool qfKdfVerify(const std::string& password, const std::string& encoded) {
+    QFKdfParams params;
+    unsigned version = 0, m = 0, t = 0, p = 0;
+    char saltHex[1025] = { 0 }, keyHex[1025] = { 0 };
+    if (std::sscanf(encoded.c_str(), "$qfkdf$v=%u$m=%u,t=%u,p=%u$%1024[0-9a-fA-F]$%1024[0-9a-fA-F]",
+        &version, &m, &t, &p, saltHex, keyHex) != 6 || version != KDF_VERSION) {
+        std::cerr << "[qfKdfVerify] Malformed verifier\n";
+        return false;
+    }
+    std::vector<uint8_t> salt, expected;
+    if (!fromHex(saltHex, salt) || !fromHex(keyHex, expected)) return false;
+    params.memoryKiB = m;
+    params.passes = t;
+    params.lanes = p;
+    std::vector<uint8_t> key(expected.size());
+    if (!qfKdf(reinterpret_cast<const uint8_t*>(password.data()), password.size(), salt.data(), salt.size(),
+        params, key.data(), key.size())) {
+        return false;
+    }
+    uint8_t diff = 0;
+    for (size_t i = 0; i < key.size(); i++) diff |= static_cast<uint8_t>(key[i] ^ expected[i]);
+    qfWipe(key.data(), key.size());
+    return diff == 0;
+}
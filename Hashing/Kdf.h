@@ -0,0 +1,44 @@
+#ifndef KDF_H
+#define KDF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// --------------------------------------------------------------------
+// Memory-hard key derivation (Argon2id structure on qfPermutation)
+//   - Memory is memoryKiB 1 KiB blocks in `lanes` rows, each row cut
+//     into four segments.  Within a slice the lanes fill their segment
+//     in parallel on the scheduler and only reference finished slices
+//     of other lanes (Argon2's sync points).
+//   - A block is one QFStateX4: the compression G(X, Y) runs
+//     qfPermutationX4 over R = X ^ Y, transposes 4x4 word groups across
+//     the four sub-states, runs it again and returns the result ^ R, so
+//     every block costs two 4-way SIMD permutations.
+//   - Reference blocks follow RFC 9106 (hybrid "id" indexing: the first
+//     half of pass 0 uses data-independent addresses, the rest uses the
+//     previous block's first word).
+//   - Memory is wiped before returning.
+// --------------------------------------------------------------------
+
+struct QFKdfParams {
+    uint32_t memoryKiB = 64 << 10;   // rounded down to a multiple of 4 * lanes, at least 8 * lanes
+    uint32_t passes = 3;
+    uint32_t lanes = 4;
+};
+
+// Returns false (after logging) for salts under 8 bytes, zero passes,
+// zero lanes or outLen under 4.  secret / ad may be null.
+bool qfKdf(const uint8_t* password, size_t passwordLen, const uint8_t* salt, size_t saltLen,
+    const QFKdfParams& params, uint8_t* out, size_t outLen,
+    const uint8_t* secret = nullptr, size_t secretLen = 0,
+    const uint8_t* ad = nullptr, size_t adLen = 0);
+
+// "$qfkdf$v=1$m=<KiB>,t=<passes>,p=<lanes>$<salt hex>$<key hex>" for
+// storing a passphrase verifier; qfKdfVerify recomputes with the
+// encoded parameters and compares in constant time
+bool qfKdfEncode(const std::string& password, const uint8_t* salt, size_t saltLen,
+    const QFKdfParams& params, size_t outLen, std::string& encoded);
+bool qfKdfVerify(const std::string& password, const std::string& encoded);
+
+#endif // KDF_H
@@ -0,0 +1,278 @@
+#include "Keystream.h"
+#include "FileIO.h"
+#include "TaskScheduler.h"
+#include "Wipe.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Uncomment to enable debug prints
+// #define KEYSTREAM_DEBUG
+
+#ifdef KEYSTREAM_DEBUG
+#define KEYSTREAM_LOG(msg) std::cerr << "[Keystream] " << msg << "\n"
+#else
+#define KEYSTREAM_LOG(msg) /* no-op */
+#endif
+
+static const uint8_t CTR_MAGIC[8] = { 'Q', 'F', 'C', 'T', 'R', '0', '0', '1' };
+static const size_t RATE_WORDS = QF_RATE_BYTES / 8;
+static const size_t BATCH_BLOCKS = 32;                  // 4 KiB of keystream per apply() step
+static const size_t SEGMENT_BYTES = size_t(1) << 20;    // applyParallel task size
+static const size_t WINDOW_BYTES = size_t(64) << 20;    // file buffer per write
+static const size_t PARALLEL_READ = size_t(4) << 20;    // readAt goes parallel from here
+
+// Domain words XORed into the last capacity word of each padded block
+static const uint64_t DOMAIN_KEY = 0x11;
+static const uint64_t DOMAIN_NONCE = 0x12;
+static const uint64_t DOMAIN_BLOCK = 0x13;
+static const uint64_t PAD_LAST = 0x80ULL << 56;         // 10*1 end bit, byte 127 of the rate
+
+// Short input (< 128 bytes) as one padded block, then the permutation
+static void absorbBlock(QFState& qs, const uint8_t* data, size_t len, uint64_t domain) {
+    uint8_t* rate = reinterpret_cast<uint8_t*>(qs.state);
+    for (size_t i = 0; i < len; i++) rate[i] ^= data[i];
+    rate[len] ^= 0x01;
+    rate[QF_RATE_BYTES - 1] ^= 0x80;
+    qs.state[QFState::STATE_WORDS - 1] ^= domain;
+    qfPermutation(qs);
+}
+
+static inline void xorInto(const uint8_t* in, const uint8_t* ks, uint8_t* out, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t a, b;
+        std::memcpy(&a, in + i, 8);
+        std::memcpy(&b, ks + i, 8);
+        a ^= b;
+        std::memcpy(out + i, &a, 8);
+    }
+    for (; i < len; i++) out[i] = in[i] ^ ks[i];
+}
+
+// --------------------------------------------------------------------
+// QFKeystream
+// --------------------------------------------------------------------
+QFKeystream::QFKeystream(const uint8_t key[QF_AEAD_KEY_BYTES], const uint8_t nonce[QF_AEAD_NONCE_BYTES]) {
+    qfInit(nonced);
+    absorbBlock(nonced, key, QF_AEAD_KEY_BYTES, DOMAIN_KEY);
+    absorbBlock(nonced, nonce, QF_AEAD_NONCE_BYTES, DOMAIN_NONCE);
+    for (int w = 0; w < QFState::STATE_WORDS; w++) {
+        for (int l = 0; l < QF_LANES; l++) noncedX4.w[w][l] = nonced.state[w];
+    }
+}
+
+QFKeystream::~QFKeystream() {
+    qfWipe(&nonced, sizeof(nonced));
+    qfWipe(&noncedX4, sizeof(noncedX4));
+}
+
+// The counter fills word 0; padding and domain are the same word-level
+// XORs in the scalar and 4-way paths, so both produce identical blocks
+void QFKeystream::block(uint64_t index, uint8_t out[QF_KEYSTREAM_BLOCK_BYTES]) const {
+    QFState qs = nonced;
+    qs.state[0] ^= index;
+    qs.state[1] ^= 0x01;
+    qs.state[RATE_WORDS - 1] ^= PAD_LAST;
+    qs.state[QFState::STATE_WORDS - 1] ^= DOMAIN_BLOCK;
+    qfPermutation(qs);
+    std::memcpy(out, qs.state, QF_KEYSTREAM_BLOCK_BYTES);
+    qfWipe(&qs, sizeof(qs));
+}
+
+void QFKeystream::blocks(uint64_t first, size_t count, uint8_t* out) const {
+    QFStateX4 s;
+    for (size_t done = 0; done < count; done += QF_LANES) {
+        size_t n = std::min<size_t>(QF_LANES, count - done);
+        s = noncedX4;
+        for (int l = 0; l < QF_LANES; l++) {
+            s.w[0][l] ^= first + done + l;
+            s.w[1][l] ^= 0x01;
+            s.w[RATE_WORDS - 1][l] ^= PAD_LAST;
+            s.w[QFState::STATE_WORDS - 1][l] ^= DOMAIN_BLOCK;
+        }
+        qfPermutationX4(s);
+        for (size_t l = 0; l < n; l++) {
+            uint8_t* dst = out + (done + l) * QF_KEYSTREAM_BLOCK_BYTES;
+            for (size_t w = 0; w < RATE_WORDS; w++) std::memcpy(dst + 8 * w, &s.w[w][l], 8);
+        }
+    }
+    qfWipe(&s, sizeof(s));
+}
+
+void QFKeystream::apply(uint64_t offset, const uint8_t* in, uint8_t* out, size_t len) const {
+    alignas(32) uint8_t ks[BATCH_BLOCKS * QF_KEYSTREAM_BLOCK_BYTES];
+    uint64_t index = offset / QF_KEYSTREAM_BLOCK_BYTES;
+    size_t skip = static_cast<size_t>(offset % QF_KEYSTREAM_BLOCK_BYTES);
+    while (len > 0) {
+        size_t want = std::min(BATCH_BLOCKS, (skip + len + QF_KEYSTREAM_BLOCK_BYTES - 1) / QF_KEYSTREAM_BLOCK_BYTES);
+        blocks(index, want, ks);
+        size_t n = std::min(len, want * QF_KEYSTREAM_BLOCK_BYTES - skip);
+        xorInto(in, ks + skip, out, n);
+        in += n;
+        out += n;
+        len -= n;
+        index += want;
+        skip = 0;
+    }
+    qfWipe(ks, sizeof(ks));
+}
+
+void QFKeystream::applyParallel(uint64_t offset, const uint8_t* in, uint8_t* out, size_t len) const {
+    size_t segments = (len + SEGMENT_BYTES - 1) / SEGMENT_BYTES;
+    if (segments <= 1) {
+        apply(offset, in, out, len);
+        return;
+    }
+    qfScheduler().parallelFor(segments, [&](size_t i) {
+        size_t at = i * SEGMENT_BYTES;
+        apply(offset + at, in + at, out + at, std::min(SEGMENT_BYTES, len - at));
+    });
+}
+
+// --------------------------------------------------------------------
+// Files
+// --------------------------------------------------------------------
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// XORs src with the keystream window by window and appends it to fd
+static bool xorToFile(const QFKeystream& stream, const uint8_t* src, size_t size, int fd) {
+    std::vector<uint8_t> buffer(std::min(size, WINDOW_BYTES));
+    for (size_t pos = 0; pos < size; pos += WINDOW_BYTES) {
+        size_t n = std::min(WINDOW_BYTES, size - pos);
+        stream.applyParallel(pos, src + pos, buffer.data(), n);
+        if (qfWriteAll(fd, buffer.data(), n) != static_cast<long>(n)) return false;
+        KEYSTREAM_LOG("window at " << pos << ", " << n << " bytes");
+    }
+    return true;
+}
+
+bool qfCtrEncryptFile(const std::string& inPath, const std::string& outPath, const uint8_t key[QF_AEAD_KEY_BYTES],
+    QFCtrReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    report = QFCtrReport();
+    // The output is truncated while the input is still mapped
+    if (qfSameFile(inPath, outPath)) {
+        std::cerr << "[Keystream] Input and output are the same file: " << outPath << "\n";
+        return false;
+    }
+    QFMappedFile in;
+    if (!in.open(inPath, true)) {
+        std::cerr << "[Keystream] Cannot read " << inPath << "\n";
+        return false;
+    }
+
+    uint8_t header[QF_CTR_HEADER_BYTES];
+    std::memcpy(header, CTR_MAGIC, sizeof(CTR_MAGIC));
+    uint8_t* nonce = header + sizeof(CTR_MAGIC);
+    std::random_device rd;
+    for (size_t i = 0; i < QF_AEAD_NONCE_BYTES; i += 4) {
+        uint32_t r = rd();
+        std::memcpy(nonce + i, &r, 4);
+    }
+    QFKeystream stream(key, nonce);
+
+    int fd = qfOpenWrite(outPath);
+    if (fd < 0) {
+        std::cerr << "[Keystream] Cannot create " << outPath << "\n";
+        return false;
+    }
+    bool ok = qfWriteAll(fd, header, sizeof(header)) == static_cast<long>(sizeof(header))
+        && xorToFile(stream, in.data(), in.size(), fd);
+    ok = qfClose(fd) && ok;
+    if (!ok) {
+        std::cerr << "[Keystream] Write failed: " << outPath << "\n";
+        std::remove(outPath.c_str());
+        return false;
+    }
+    report.bytes = in.size();
+    report.seconds = secondsSince(start);
+    return true;
+}
+
+bool qfCtrDecryptFile(const std::string& inPath, const std::string& outPath, const uint8_t key[QF_AEAD_KEY_BYTES],
+    QFCtrReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    report = QFCtrReport();
+    // The output is truncated while the input is still mapped
+    if (qfSameFile(inPath, outPath)) {
+        std::cerr << "[Keystream] Input and output are the same file: " << outPath << "\n";
+        return false;
+    }
+    QFMappedFile in;
+    if (!in.open(inPath, true)) {
+        std::cerr << "[Keystream] Cannot read " << inPath << "\n";
+        return false;
+    }
+    if (in.size() < QF_CTR_HEADER_BYTES || std::memcmp(in.data(), CTR_MAGIC, sizeof(CTR_MAGIC)) != 0) {
+        std::cerr << "[Keystream] Not an encrypted file: " << inPath << "\n";
+        return false;
+    }
+    QFKeystream stream(key, in.data() + sizeof(CTR_MAGIC));
+
+    int fd = qfOpenWrite(outPath);
+    if (fd < 0) {
+        std::cerr << "[Keystream] Cannot create " << outPath << "\n";
+        return false;
+    }
+    size_t size = in.size() - QF_CTR_HEADER_BYTES;
+    bool ok = xorToFile(stream, in.data() + QF_CTR_HEADER_BYTES, size, fd);
+    ok = qfClose(fd) && ok;
+    if (!ok) {
+        std::cerr << "[Keystream] Write failed: " << outPath << "\n";
+        std::remove(outPath.c_str());
+        return false;
+    }
+    report.bytes = size;
+    report.seconds = secondsSince(start);
+    return true;
+}
+
+// --------------------------------------------------------------------
+// QFCtrReader
+// --------------------------------------------------------------------
+bool QFCtrReader::open(const std::string& path, const uint8_t key[QF_AEAD_KEY_BYTES]) {
+    close();
+    fd = qfOpenRead(path);
+    if (fd < 0) {
+        std::cerr << "[Keystream] Cannot read " << path << "\n";
+        return false;
+    }
+    uint8_t header[QF_CTR_HEADER_BYTES];
+    int64_t fileSize = qfFileSize(fd);
+    if (fileSize < static_cast<int64_t>(QF_CTR_HEADER_BYTES)
+        || qfReadFull(fd, header, sizeof(header), 0) != static_cast<long>(sizeof(header))
+        || std::memcmp(header, CTR_MAGIC, sizeof(CTR_MAGIC)) != 0) {
+        std::cerr << "[Keystream] Not an encrypted file: " << path << "\n";
+        close();
+        return false;
+    }
+    plainSize = static_cast<uint64_t>(fileSize) - QF_CTR_HEADER_BYTES;
+    stream.reset(new QFKeystream(key, header + sizeof(CTR_MAGIC)));
+    return true;
+}
+
+void QFCtrReader::close() {
+    if (fd >= 0) qfClose(fd);
+    fd = -1;
+    plainSize = 0;
+    stream.reset();
+}
+
+long QFCtrReader::readAt(void* buf, size_t len, uint64_t offset) {
+    if (fd < 0) return -1;
+    if (offset >= plainSize) return 0;
+    len = static_cast<size_t>(std::min<uint64_t>(len, plainSize - offset));
+    long got = qfReadFull(fd, buf, len, static_cast<int64_t>(QF_CTR_HEADER_BYTES + offset));
+    if (got <= 0) return got;
+    uint8_t* bytes = static_cast<uint8_t*>(buf);
+    if (static_cast<size_t>(got) >= PARALLEL_READ) stream->applyParallel(offset, bytes, bytes, static_cast<size_t>(got));
+    else stream->apply(offset, bytes, bytes, static_cast<size_t>(got));
+    return got;
+}
@@ -0,0 +1,91 @@
+#ifndef KEYSTREAM_H
+#define KEYSTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "Aead.h"
+#include "Performance.h"
+
+// --------------------------------------------------------------------
+// Random-access counter-mode keystream
+//   - The key and the nonce are absorbed once (padded, domain
+//     separated).  Keystream block i is the 128-byte rate squeezed after
+//     absorbing the 64-bit counter i into a copy of that state, so any
+//     block costs one permutation and none depends on another.
+//   - blocks() runs four counters per qfPermutationX4; the *Parallel
+//     calls split the range over the scheduler.  Encryption and
+//     decryption are the same XOR at a byte offset, which is also the
+//     seek: no state before the offset is needed.
+//   - Confidentiality only.  Use seal / unseal (Aead.h) when tampering
+//     must be detected; CTR suits in-place, random-access images.
+// --------------------------------------------------------------------
+
+static const size_t QF_KEYSTREAM_BLOCK_BYTES = 128;
+
+class QFKeystream {
+public:
+    QFKeystream(const uint8_t key[QF_AEAD_KEY_BYTES], const uint8_t nonce[QF_AEAD_NONCE_BYTES]);
+    ~QFKeystream();
+
+    QFKeystream(const QFKeystream&) = delete;
+    QFKeystream& operator=(const QFKeystream&) = delete;
+
+    // One block with the scalar permutation
+    void block(uint64_t index, uint8_t out[QF_KEYSTREAM_BLOCK_BYTES]) const;
+    // Blocks [first, first + count) into out (count * 128 bytes), four per permutation
+    void blocks(uint64_t first, size_t count, uint8_t* out) const;
+
+    // out = in ^ keystream starting at byte `offset`; in may equal out
+    void apply(uint64_t offset, const uint8_t* in, uint8_t* out, size_t len) const;
+    void applyParallel(uint64_t offset, const uint8_t* in, uint8_t* out, size_t len) const;
+
+private:
+    QFState nonced;
+    QFStateX4 noncedX4;    // nonced broadcast to all four lanes
+};
+
+// --------------------------------------------------------------------
+// Encrypted file format: "QFCTR001" | nonce (24) | ciphertext, the same
+// length as the plaintext, so plaintext byte n sits at offset 32 + n.
+// --------------------------------------------------------------------
+
+static const size_t QF_CTR_HEADER_BYTES = 32;
+
+struct QFCtrReport {
+    uint64_t bytes = 0;
+    double seconds = 0.0;
+};
+
+// Whole-file encrypt / decrypt in parallel windows; a failed run removes
+// the output.  An output that is the input file itself is refused.
+bool qfCtrEncryptFile(const std::string& inPath, const std::string& outPath, const uint8_t key[QF_AEAD_KEY_BYTES],
+    QFCtrReport& report);
+bool qfCtrDecryptFile(const std::string& inPath, const std::string& outPath, const uint8_t key[QF_AEAD_KEY_BYTES],
+    QFCtrReport& report);
+
+// Seekable plaintext view of an encrypted file: readAt decrypts only the
+// requested range
+class QFCtrReader {
+public:
+    QFCtrReader() = default;
+    ~QFCtrReader() { close(); }
+
+    QFCtrReader(const QFCtrReader&) = delete;
+    QFCtrReader& operator=(const QFCtrReader&) = delete;
+
+    bool open(const std::string& path, const uint8_t key[QF_AEAD_KEY_BYTES]);
+    void close();
+
+    uint64_t size() const { return plainSize; }
+    // Bytes read (short at end of file), or -1 on error
+    long readAt(void* buf, size_t len, uint64_t offset);
+
+private:
+    int fd = -1;
+    uint64_t plainSize = 0;
+    std::unique_ptr<QFKeystream> stream;
+};
+
+#endif // KEYSTREAM_H
@@ -0,0 +1,468 @@
+#include "ManifestDiff.h"
+#include "FileIO.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+// Uncomment to enable debug prints
+// #define MDIFF_DEBUG
+
+#ifdef MDIFF_DEBUG
+#define MDIFF_LOG(msg) std::cerr << "[ManifestDiff] " << msg << "\n"
+#else
+#define MDIFF_LOG(msg) /* no-op */
+#endif
+
+namespace {
+
+// --------------------------------------------------------------------
+// In-memory record: points into the mapped manifest, no copies.
+// key = first 8 path bytes, big-endian, zero padded, so comparing keys
+// agrees with byte-wise path order.
+// --------------------------------------------------------------------
+struct Record {
+    uint64_t key;
+    const char* path;
+    const char* hex;
+    uint32_t pathLen;
+    uint32_t hexLen;
+};
+
+static const size_t WRITE_BUFFER = 1 << 20;
+
+uint64_t pathKey(const char* path, size_t len) {
+    uint64_t key = 0;
+    for (size_t i = 0; i < 8; i++) {
+        key = (key << 8) | ((i < len) ? static_cast<uint8_t>(path[i]) : 0);
+    }
+    return key;
+}
+
+int comparePaths(const char* a, size_t aLen, const char* b, size_t bLen) {
+    int c = std::memcmp(a, b, std::min(aLen, bLen));
+    if (c != 0) return c;
+    return (aLen < bLen) ? -1 : (aLen > bLen) ? 1 : 0;
+}
+
+bool isHex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// "<hex>  <path>" or "<hex> *<path>"; false for anything else
+bool parseLine(const char* line, size_t len, Record& rec) {
+    if (len > 0 && line[len - 1] == '\r') len--;
+    size_t h = 0;
+    while (h < len && isHex(line[h])) h++;
+    if (h == 0 || h + 2 >= len || line[h] != ' ' || (line[h + 1] != ' ' && line[h + 1] != '*')) {
+        return false;
+    }
+    rec.hex = line;
+    rec.hexLen = static_cast<uint32_t>(h);
+    rec.path = line + h + 2;
+    rec.pathLen = static_cast<uint32_t>(len - h - 2);
+    rec.key = pathKey(rec.path, rec.pathLen);
+    return true;
+}
+
+// --------------------------------------------------------------------
+// LSD radix sort on the 64-bit key (16-bit digits, constant digits are
+// skipped), then ties broken by full path and, last, by position in the
+// manifest so the first occurrence of a path sorts first.
+// --------------------------------------------------------------------
+void sortRecords(std::vector<Record>& recs, std::vector<Record>& tmp) {
+    tmp.resize(recs.size());
+    std::vector<size_t> counts(1 << 16);
+    for (int shift = 0; shift < 64; shift += 16) {
+        std::fill(counts.begin(), counts.end(), 0);
+        for (const Record& r : recs) counts[(r.key >> shift) & 0xFFFF]++;
+        if (!recs.empty() && counts[(recs[0].key >> shift) & 0xFFFF] == recs.size()) continue;
+        size_t sum = 0;
+        for (size_t& c : counts) {
+            size_t n = c;
+            c = sum;
+            sum += n;
+        }
+        for (const Record& r : recs) tmp[counts[(r.key >> shift) & 0xFFFF]++] = r;
+        recs.swap(tmp);
+    }
+
+    auto less = [](const Record& a, const Record& b) {
+        int c = comparePaths(a.path, a.pathLen, b.path, b.pathLen);
+        return (c != 0) ? c < 0 : a.path < b.path;
+    };
+    size_t i = 0;
+    while (i < recs.size()) {
+        size_t j = i + 1;
+        while (j < recs.size() && recs[j].key == recs[i].key) j++;
+        if (j - i > 1) std::sort(recs.begin() + i, recs.begin() + j, less);
+        i = j;
+    }
+}
+
+// --------------------------------------------------------------------
+// Run files: [u32 pathLen][u32 hexLen][path][hex] per record
+// --------------------------------------------------------------------
+class RunWriter {
+public:
+    bool open(const std::string& path) {
+        fd = qfOpenWrite(path);
+        buffer.reserve(WRITE_BUFFER);
+        return fd >= 0;
+    }
+    ~RunWriter() { qfClose(fd); }
+
+    bool add(const char* path, uint32_t pathLen, const char* hex, uint32_t hexLen) {
+        if (buffer.size() + 8 + pathLen + hexLen > WRITE_BUFFER && !flush()) return false;
+        const char* lens[2] = { reinterpret_cast<const char*>(&pathLen), reinterpret_cast<const char*>(&hexLen) };
+        buffer.insert(buffer.end(), lens[0], lens[0] + 4);
+        buffer.insert(buffer.end(), lens[1], lens[1] + 4);
+        buffer.insert(buffer.end(), path, path + pathLen);
+        buffer.insert(buffer.end(), hex, hex + hexLen);
+        return true;
+    }
+
+    bool finish() {
+        bool ok = flush();
+        qfClose(fd);
+        fd = -1;
+        return ok;
+    }
+
+private:
+    bool flush() {
+        if (buffer.empty()) return true;
+        bool ok = qfWriteAll(fd, buffer.data(), buffer.size()) >= 0;
+        buffer.clear();
+        return ok;
+    }
+
+    int fd = -1;
+    std::vector<char> buffer;
+};
+
+class RunReader {
+public:
+    bool open(const std::string& path) {
+        if (!file.open(path, true)) return false;
+        return next();
+    }
+
+    // Advance to the next record; false at the end
+    bool next() {
+        if (pos + 8 > file.size()) {
+            valid = false;
+            return false;
+        }
+        const uint8_t* p = file.data() + pos;
+        std::memcpy(&pathLen, p, 4);
+        std::memcpy(&hexLen, p + 4, 4);
+        path = reinterpret_cast<const char*>(p + 8);
+        hex = path + pathLen;
+        pos += 8 + static_cast<size_t>(pathLen) + hexLen;
+        valid = pos <= file.size();
+        return valid;
+    }
+
+    bool valid = false;
+    const char* path = nullptr;
+    const char* hex = nullptr;
+    uint32_t pathLen = 0;
+    uint32_t hexLen = 0;
+
+private:
+    QFMappedFile file;
+    size_t pos = 0;
+};
+
+// --------------------------------------------------------------------
+// K-way merge over run readers: binary heap ordered by (path, run
+// index).  Runs are numbered in manifest order, so for duplicate paths
+// the earliest line comes out first and the rest are skipped.
+// --------------------------------------------------------------------
+class MergedStream {
+public:
+    bool open(const std::vector<std::string>& runs) {
+        readers.resize(runs.size());
+        for (size_t i = 0; i < runs.size(); i++) {
+            readers[i].reset(new RunReader());
+            if (readers[i]->open(runs[i])) heap.push_back(i);
+            else if (!std::filesystem::is_regular_file(runs[i])) return false;
+        }
+        std::make_heap(heap.begin(), heap.end(), Greater{ this });
+        return true;
+    }
+
+    // Next distinct path; false at the end.  path/hex stay valid until
+    // the next call (they point into the mapped runs).
+    bool next(std::string_view& path, std::string_view& hex) {
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), Greater{ this });
+            RunReader& r = *readers[heap.back()];
+            std::string_view p(r.path, r.pathLen);
+            std::string_view h(r.hex, r.hexLen);
+            if (r.next()) std::push_heap(heap.begin(), heap.end(), Greater{ this });
+            else heap.pop_back();
+            if (havePrevious && p == previous) continue;  // duplicate path
+            previous = p;
+            havePrevious = true;
+            path = p;
+            hex = h;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    struct Greater {
+        const MergedStream* self;
+        bool operator()(size_t a, size_t b) const {
+            const RunReader& x = *self->readers[a];
+            const RunReader& y = *self->readers[b];
+            int c = comparePaths(x.path, x.pathLen, y.path, y.pathLen);
+            return (c != 0) ? c > 0 : a > b;
+        }
+    };
+
+    std::vector<std::unique_ptr<RunReader>> readers;
+    std::vector<size_t> heap;
+    std::string_view previous;
+    bool havePrevious = false;
+};
+
+// --------------------------------------------------------------------
+// Temporary run files, removed on destruction
+// --------------------------------------------------------------------
+class RunFiles {
+public:
+    explicit RunFiles(const std::string& dir) {
+        std::filesystem::path base = dir.empty() ? std::filesystem::temp_directory_path()
+                                                 : std::filesystem::path(dir);
+        std::random_device rd;
+        prefix = (base / ("qf_manifest_" + std::to_string(rd()) + "_" + std::to_string(rd()))).string();
+    }
+    ~RunFiles() {
+        std::error_code ec;
+        for (const std::string& p : created) std::filesystem::remove(p, ec);
+    }
+
+    std::string create() {
+        std::lock_guard<std::mutex> guard(lock);
+        created.push_back(prefix + "_" + std::to_string(created.size()) + ".run");
+        return created.back();
+    }
+    void remove(const std::string& path) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+
+private:
+    std::string prefix;
+    std::mutex lock;
+    std::vector<std::string> created;
+};
+
+// --------------------------------------------------------------------
+// Run generation for one manifest.  The mapped manifest is cut into
+// chunks of at most chunkRecords lines; up to `parallel` chunks are
+// parsed, sorted and written at once on the scheduler.
+// --------------------------------------------------------------------
+bool buildRuns(const QFMappedFile& manifest, size_t chunkRecords, size_t parallel, RunFiles& files,
+    std::vector<std::string>& runs, uint64_t& entries, uint64_t& malformed, size_t& peakBytes) {
+    QFScheduler& scheduler = qfScheduler();
+    const char* data = reinterpret_cast<const char*>(manifest.data());
+    const char* end = data + manifest.size();
+    std::atomic<bool> failed{ false };
+    std::atomic<uint64_t> good{ 0 }, bad{ 0 };
+
+    const char* cursor = data;
+    while (cursor < end && !failed.load()) {
+        // Cut up to `parallel` chunks at line boundaries (memchr scan only)
+        std::vector<std::pair<const char*, const char*>> wave;
+        while (cursor < end && wave.size() < parallel) {
+            const char* chunkStart = cursor;
+            for (size_t lines = 0; lines < chunkRecords && cursor < end; lines++) {
+                const char* nl = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+                cursor = nl ? nl + 1 : end;
+            }
+            wave.emplace_back(chunkStart, cursor);
+            runs.push_back(files.create());
+        }
+        peakBytes = std::max(peakBytes, wave.size() * (chunkRecords * 2 * sizeof(Record) + WRITE_BUFFER));
+
+        size_t firstRun = runs.size() - wave.size();
+        QFTaskGroup group(scheduler);
+        for (size_t w = 0; w < wave.size(); w++) {
+            group.run([&, w]() {
+                std::vector<Record> recs, tmp;
+                recs.reserve(chunkRecords);
+                const char* p = wave[w].first;
+                const char* stop = wave[w].second;
+                uint64_t badLines = 0;
+                while (p < stop) {
+                    const char* nl = static_cast<const char*>(std::memchr(p, '\n', stop - p));
+                    const char* lineEnd = nl ? nl : stop;
+                    Record rec;
+                    if (parseLine(p, static_cast<size_t>(lineEnd - p), rec)) recs.push_back(rec);
+                    else if (lineEnd > p) badLines++;
+                    p = nl ? nl + 1 : stop;
+                }
+                sortRecords(recs, tmp);
+                tmp = std::vector<Record>();
+
+                RunWriter writer;
+                bool ok = writer.open(runs[firstRun + w]);
+                for (size_t i = 0; ok && i < recs.size(); i++) {
+                    ok = writer.add(recs[i].path, recs[i].pathLen, recs[i].hex, recs[i].hexLen);
+                }
+                ok = writer.finish() && ok;
+                if (!ok) {
+                    std::cerr << "[diffManifests] Failed to write run file: " << runs[firstRun + w] << "\n";
+                    failed.store(true);
+                }
+                good += recs.size();
+                bad += badLines;
+            });
+        }
+        group.wait();
+    }
+    entries = good.load();
+    malformed = bad.load();
+    return !failed.load();
+}
+
+// --------------------------------------------------------------------
+// Reduce runs to at most fanIn by merging groups of fanIn (in parallel)
+// --------------------------------------------------------------------
+bool reduceRuns(std::vector<std::string>& runs, size_t fanIn, RunFiles& files) {
+    QFScheduler& scheduler = qfScheduler();
+    while (runs.size() > fanIn) {
+        std::vector<std::string> next((runs.size() + fanIn - 1) / fanIn);
+        std::atomic<bool> failed{ false };
+        QFTaskGroup group(scheduler);
+        for (size_t g = 0; g < next.size(); g++) {
+            next[g] = files.create();
+            group.run([&, g]() {
+                std::vector<std::string> inputs(runs.begin() + g * fanIn,
+                    runs.begin() + std::min(runs.size(), (g + 1) * fanIn));
+                MergedStream merged;
+                RunWriter writer;
+                bool ok = merged.open(inputs) && writer.open(next[g]);
+                std::string_view path, hex;
+                while (ok && merged.next(path, hex)) {
+                    ok = writer.add(path.data(), static_cast<uint32_t>(path.size()),
+                        hex.data(), static_cast<uint32_t>(hex.size()));
+                }
+                ok = writer.finish() && ok;
+                if (!ok) failed.store(true);
+            });
+        }
+        group.wait();
+        if (failed.load()) {
+            std::cerr << "[diffManifests] Failed to merge intermediate runs.\n";
+            return false;
+        }
+        for (const std::string& r : runs) files.remove(r);
+        runs.swap(next);
+        MDIFF_LOG("merge level: " << runs.size() << " runs left");
+    }
+    return true;
+}
+
+} // namespace
+
+// --------------------------------------------------------------------
+// diffManifests
+// --------------------------------------------------------------------
+bool diffManifests(const std::string& oldManifest, const std::string& newManifest,
+    const QFDiffCallback& onDiff, QFManifestDiffReport& report, const QFManifestDiffOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    report = QFManifestDiffReport();
+
+    QFMappedFile oldFile, newFile;
+    if (!oldFile.open(oldManifest, true)) {
+        std::cerr << "[diffManifests] Failed to open manifest: " << oldManifest << "\n";
+        return false;
+    }
+    if (!newFile.open(newManifest, true)) {
+        std::cerr << "[diffManifests] Failed to open manifest: " << newManifest << "\n";
+        return false;
+    }
+
+    // Budget: `parallel` chunks in flight, each needing two Record arrays
+    // (radix sort ping-pong); write buffers are small next to that.
+    size_t parallel = std::max<unsigned>(qfScheduler().workerCount(), 1);
+    size_t perChunk = options.memoryBudget / parallel;
+    size_t chunkRecords = (perChunk > WRITE_BUFFER) ? (perChunk - WRITE_BUFFER) / (2 * sizeof(Record)) : 0;
+    if (chunkRecords < 1024) {
+        // Tiny budget: fewer chunks in flight rather than tiny runs
+        parallel = std::max<size_t>(options.memoryBudget / (1024 * 2 * sizeof(Record) + WRITE_BUFFER), 1);
+        chunkRecords = 1024;
+    }
+    const size_t fanIn = std::max<size_t>(options.maxFanIn, 2);
+
+    RunFiles files(options.tempDir);
+    std::vector<std::string> oldRuns, newRuns;
+    uint64_t oldBad = 0, newBad = 0;
+    if (!buildRuns(oldFile, chunkRecords, parallel, files, oldRuns, report.oldEntries, oldBad, report.peakSortBytes)
+        || !buildRuns(newFile, chunkRecords, parallel, files, newRuns, report.newEntries, newBad, report.peakSortBytes)) {
+        return false;
+    }
+    report.malformedLines = oldBad + newBad;
+    report.oldRuns = oldRuns.size();
+    report.newRuns = newRuns.size();
+    oldFile.close();
+    newFile.close();
+
+    if (!reduceRuns(oldRuns, fanIn, files) || !reduceRuns(newRuns, fanIn, files)) {
+        return false;
+    }
+
+    MergedStream a, b;
+    if (!a.open(oldRuns) || !b.open(newRuns)) {
+        std::cerr << "[diffManifests] Failed to open run files.\n";
+        return false;
+    }
+
+    // Merge-join of the two sorted streams
+    std::string_view aPath, aHex, bPath, bHex;
+    bool haveA = a.next(aPath, aHex);
+    bool haveB = b.next(bPath, bHex);
+    while (haveA || haveB) {
+        int c = !haveA ? 1 : !haveB ? -1
+            : comparePaths(aPath.data(), aPath.size(), bPath.data(), bPath.size());
+        if (c < 0) {
+            report.removed++;
+            onDiff(QFDiffKind::Removed, aPath, aHex, std::string_view());
+            haveA = a.next(aPath, aHex);
+        }
+        else if (c > 0) {
+            report.added++;
+            onDiff(QFDiffKind::Added, bPath, std::string_view(), bHex);
+            haveB = b.next(bPath, bHex);
+        }
+        else {
+            if (aHex.size() == bHex.size()
+                && std::equal(aHex.begin(), aHex.end(), bHex.begin(),
+                    [](char x, char y) { return (x | 0x20) == (y | 0x20); })) {
+                report.unchanged++;
+            }
+            else {
+                report.changed++;
+                onDiff(QFDiffKind::Changed, aPath, aHex, bHex);
+            }
+            haveA = a.next(aPath, aHex);
+            haveB = b.next(bPath, bHex);
+        }
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef MANIFEST_DIFF_H
+#define MANIFEST_DIFF_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// --------------------------------------------------------------------
+// Manifest diff with bounded memory
+//   - A manifest is the "<hex digest>  <path>" text the bulk modes print
+//     (sha256sum style; "<hex> *<path>" is accepted too).
+//   - Each manifest is mapped, cut into chunks that fit the budget, and
+//     every chunk is radix-sorted by path prefix (ties by full path) on
+//     the scheduler and written as a run file.  Runs are k-way merged
+//     through mmap (intermediate merge levels when there are more than
+//     maxFanIn runs), and the two sorted streams are merge-joined.
+//   - Differences are streamed to the callback in path order; nothing
+//     proportional to the manifest size stays in memory.
+//   - If a path appears twice in one manifest, the first line wins.
+// --------------------------------------------------------------------
+
+enum class QFDiffKind { Added, Removed, Changed };
+
+// oldDigest is empty for Added, newDigest is empty for Removed
+typedef std::function<void(QFDiffKind kind, std::string_view path,
+    std::string_view oldDigest, std::string_view newDigest)> QFDiffCallback;
+
+struct QFManifestDiffOptions {
+    size_t memoryBudget = 256 << 20;  // for sort buffers; mmaps are page cache
+    size_t maxFanIn = 64;             // runs merged at once
+    std::string tempDir;              // empty => system temp directory
+};
+
+struct QFManifestDiffReport {
+    uint64_t oldEntries = 0;
+    uint64_t newEntries = 0;
+    uint64_t malformedLines = 0;
+    uint64_t added = 0;
+    uint64_t removed = 0;
+    uint64_t changed = 0;
+    uint64_t unchanged = 0;
+    size_t oldRuns = 0;
+    size_t newRuns = 0;
+    size_t peakSortBytes = 0;         // largest sort buffer footprint in flight
+    double seconds = 0.0;
+};
+
+// Returns false (after logging to stderr) if a manifest cannot be read or
+// a temporary run cannot be written.  Run files are always removed.
+bool diffManifests(const std::string& oldManifest, const std::string& newManifest,
+    const QFDiffCallback& onDiff, QFManifestDiffReport& report,
+    const QFManifestDiffOptions& options = QFManifestDiffOptions());
+
+#endif // MANIFEST_DIFF_H
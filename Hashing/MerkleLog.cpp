@@ -0,0 +1,444 @@
+#include "MerkleLog.h"
+#include "FileIO.h"
+#include "Performance.h"
+#include "QuantumProtection.h"
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// Uncomment to enable debug prints
+// #define MLOG_DEBUG
+
+#ifdef MLOG_DEBUG
+#define MLOG_LOG(msg) std::cerr << "[MerkleLog] " << msg << "\n"
+#else
+#define MLOG_LOG(msg) /* no-op */
+#endif
+
+static const char LOG_MAGIC[8] = { 'Q', 'F', 'M', 'L', 'O', 'G', '1', 0 };
+static const size_t RECORD_HEADER = 4 + QF_DIGEST_BYTES;   // u32 length | leaf hash
+static const size_t LEAF_PREFIX = 1 + 8;                   // 0x00 | u64 length
+
+static const size_t NODE_INPUT = 1 + 2 * QF_DIGEST_BYTES;  // 0x01 | left | right
+
+static QFDigest nodeHash(const QFDigest& left, const QFDigest& right) {
+    uint8_t buf[NODE_INPUT];
+    buf[0] = 0x01;
+    std::memcpy(buf + 1, left.data(), QF_DIGEST_BYTES);
+    std::memcpy(buf + 1 + QF_DIGEST_BYTES, right.data(), QF_DIGEST_BYTES);
+    QFDigest out;
+    qfHashShort(buf, sizeof(buf), out.data(), out.size());
+    return out;
+}
+
+static QFDigest emptyRoot() {
+    QFDigest out;
+    qfHashShort(nullptr, 0, out.data(), out.size());
+    return out;
+}
+
+// Largest power of two strictly below n (n >= 2)
+static uint64_t splitPoint(uint64_t n) {
+    uint64_t k = 1;
+    while (k * 2 < n) k *= 2;
+    return k;
+}
+
+// 0x00 || u64 length || entry: the sponge does not pad, so without the
+// length "x" and "x\0" would share a leaf hash
+static std::vector<uint8_t> leafInput(const uint8_t* data, size_t len) {
+    std::vector<uint8_t> buf(LEAF_PREFIX + len);
+    buf[0] = 0x00;
+    for (int b = 0; b < 8; b++) buf[1 + b] = static_cast<uint8_t>(static_cast<uint64_t>(len) >> (8 * b));
+    if (len > 0) std::memcpy(buf.data() + LEAF_PREFIX, data, len);
+    return buf;
+}
+
+QFDigest qfLogLeafHash(const uint8_t* data, size_t len) {
+    std::vector<uint8_t> buf = leafInput(data, len);
+    QFDigest out;
+    qfHashShort(buf.data(), buf.size(), out.data(), out.size());
+    return out;
+}
+
+// --------------------------------------------------------------------
+// open / close
+// --------------------------------------------------------------------
+bool QFMerkleLog::open(const std::string& path, const QFLogOptions& options) {
+    close();
+    name = path;
+    opts = options;
+    fd = qfOpenReadWrite(path);
+    if (fd < 0) {
+        std::cerr << "[MerkleLog] Failed to open " << path << "\n";
+        return false;
+    }
+
+    int64_t size = qfFileSize(fd);
+    if (size == 0) {
+        if (qfWriteAll(fd, LOG_MAGIC, sizeof(LOG_MAGIC)) < 0 || (opts.sync && !qfDataSync(fd))) {
+            std::cerr << "[MerkleLog] Failed to initialize " << path << "\n";
+            close();
+            return false;
+        }
+        fileEnd = sizeof(LOG_MAGIC);
+        return true;
+    }
+
+    // Replay existing records
+    QFMappedFile file;
+    if (!file.open(path, true) || file.size() < sizeof(LOG_MAGIC)
+        || std::memcmp(file.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+        std::cerr << "[MerkleLog] Not a Merkle log: " << path << "\n";
+        close();
+        return false;
+    }
+    const uint8_t* base = file.data();
+    const size_t total = file.size();
+    size_t pos = sizeof(LOG_MAGIC);
+    std::vector<QFDigest> leaves;
+    std::vector<uint64_t> offsets;
+    bool torn = false;
+    while (pos < total) {
+        if (total - pos < RECORD_HEADER) {
+            torn = true;
+            break;
+        }
+        uint32_t len = uint32_t(base[pos]) | (uint32_t(base[pos + 1]) << 8)
+            | (uint32_t(base[pos + 2]) << 16) | (uint32_t(base[pos + 3]) << 24);
+        if (total - pos - RECORD_HEADER < len) {
+            torn = true;
+            break;
+        }
+        QFDigest stored, actual = qfLogLeafHash(base + pos + RECORD_HEADER, len);
+        std::memcpy(stored.data(), base + pos + 4, QF_DIGEST_BYTES);
+        if (stored != actual) {
+            if (pos + RECORD_HEADER + len == total) {
+                // Last record: most likely an interrupted write, but say so
+                // rather than drop an intact-length entry without a trace
+                std::cerr << "[MerkleLog] Final record " << leaves.size() << " of " << path
+                    << " does not match its leaf hash (offset " << pos << ")\n";
+                torn = true;
+                break;
+            }
+            std::cerr << "[MerkleLog] Record " << leaves.size() << " of " << path
+                << " does not match its leaf hash (offset " << pos << ")\n";
+            close();
+            return false;
+        }
+        leaves.push_back(stored);
+        offsets.push_back(pos);
+        pos += RECORD_HEADER + len;
+    }
+    file.close();
+
+    if (torn) {
+        std::cerr << "[MerkleLog] Dropping a torn final record of " << path
+            << " (" << (total - pos) << " bytes)\n";
+        if (!qfTruncate(fd, static_cast<int64_t>(pos)) || !qfDataSync(fd)) {
+            std::cerr << "[MerkleLog] Failed to truncate " << path << "\n";
+            close();
+            return false;
+        }
+    }
+    fileEnd = static_cast<int64_t>(pos);
+    qfSeek(fd, fileEnd);
+    addLeaves(leaves, offsets);
+    enqueued = durable = leaves.size();
+    MLOG_LOG(path << ": " << leaves.size() << " entries");
+    return true;
+}
+
+void QFMerkleLog::close() {
+    if (fd >= 0) qfClose(fd);
+    fd = -1;
+    fileEnd = 0;
+    std::unique_lock<std::shared_mutex> guard(treeLock);
+    levels.clear();
+    entryOffsets.clear();
+    commitCount = 0;
+    pending.clear();
+    enqueued = durable = 0;
+    committing = failed = false;
+}
+
+// --------------------------------------------------------------------
+// Group commit
+// --------------------------------------------------------------------
+bool QFMerkleLog::append(const uint8_t* data, size_t len, uint64_t* index) {
+    if (len > 0xFFFFFFFFu) {
+        std::cerr << "[MerkleLog] Entry too large (" << len << " bytes)\n";
+        return false;
+    }
+    std::vector<uint8_t> record = leafInput(data, len);
+
+    std::unique_lock<std::mutex> guard(queueLock);
+    if (fd < 0 || failed) return false;
+    uint64_t mine = enqueued++;
+    pending.push_back(std::move(record));
+
+    while (durable <= mine && !failed) {
+        if (committing) {
+            committed.wait(guard);
+            continue;
+        }
+        // Lead this group: take everything queued so far
+        committing = true;
+        guard.unlock();
+        std::this_thread::yield();
+        guard.lock();
+        std::vector<std::vector<uint8_t>> batch;
+        batch.swap(pending);
+        guard.unlock();
+        bool ok = commit(batch);
+        guard.lock();
+        if (ok) durable += batch.size();
+        else failed = true;
+        committing = false;
+        committed.notify_all();
+    }
+    if (durable <= mine) return false;
+    if (index) *index = mine;
+    return true;
+}
+
+bool QFMerkleLog::commit(std::vector<std::vector<uint8_t>>& batch) {
+    const size_t n = batch.size();
+    std::vector<const uint8_t*> ptrs(n);
+    std::vector<size_t> lens(n);
+    size_t bytes = 0;
+    for (size_t i = 0; i < n; i++) {
+        ptrs[i] = batch[i].data();
+        lens[i] = batch[i].size();
+        bytes += RECORD_HEADER + batch[i].size() - LEAF_PREFIX;
+    }
+    std::vector<QFDigest> leaves(n);
+    qfHashMany(ptrs.data(), lens.data(), n, leaves[0].data(), QF_DIGEST_BYTES);
+
+    std::vector<uint8_t> out;
+    out.reserve(bytes);
+    std::vector<uint64_t> offsets(n);
+    for (size_t i = 0; i < n; i++) {
+        uint32_t len = static_cast<uint32_t>(batch[i].size() - LEAF_PREFIX);
+        offsets[i] = static_cast<uint64_t>(fileEnd) + out.size();
+        for (int b = 0; b < 4; b++) out.push_back(static_cast<uint8_t>(len >> (8 * b)));
+        out.insert(out.end(), leaves[i].begin(), leaves[i].end());
+        out.insert(out.end(), batch[i].begin() + LEAF_PREFIX, batch[i].end());
+    }
+
+    long written = qfWriteAll(fd, out.data(), out.size());
+    if (written < 0) {
+        std::cerr << "[MerkleLog] Write error on " << name << ": "
+            << std::strerror(static_cast<int>(-written)) << "\n";
+        return false;
+    }
+    if (opts.sync && !qfDataSync(fd)) {
+        std::cerr << "[MerkleLog] fdatasync failed on " << name << "\n";
+        return false;
+    }
+    fileEnd += static_cast<int64_t>(out.size());
+    addLeaves(leaves, offsets);
+    MLOG_LOG("commit of " << n << " entries, " << out.size() << " bytes");
+    return true;
+}
+
+void QFMerkleLog::addLeaves(const std::vector<QFDigest>& leaves, const std::vector<uint64_t>& offsets) {
+    std::unique_lock<std::shared_mutex> guard(treeLock);
+    if (levels.empty()) levels.emplace_back();
+    levels[0].insert(levels[0].end(), leaves.begin(), leaves.end());
+    entryOffsets.insert(entryOffsets.end(), offsets.begin(), offsets.end());
+
+    // Nodes completed by this batch, one level at a time: every new pair
+    // on level k closes a node on level k + 1, hashed four per permutation
+    std::vector<uint8_t> inputs;
+    std::vector<const uint8_t*> ptrs;
+    std::vector<size_t> lens;
+    for (size_t k = 0; levels[k].size() / 2 > (levels.size() > k + 1 ? levels[k + 1].size() : 0); k++) {
+        if (levels.size() == k + 1) levels.emplace_back();
+        const std::vector<QFDigest>& level = levels[k];
+        size_t first = levels[k + 1].size(), count = level.size() / 2 - first;
+        inputs.resize(count * NODE_INPUT);
+        ptrs.resize(count);
+        lens.assign(count, NODE_INPUT);
+        for (size_t i = 0; i < count; i++) {
+            uint8_t* in = inputs.data() + i * NODE_INPUT;
+            in[0] = 0x01;
+            std::memcpy(in + 1, level[2 * (first + i)].data(), QF_DIGEST_BYTES);
+            std::memcpy(in + 1 + QF_DIGEST_BYTES, level[2 * (first + i) + 1].data(), QF_DIGEST_BYTES);
+            ptrs[i] = in;
+        }
+        levels[k + 1].resize(first + count);
+        qfHashMany(ptrs.data(), lens.data(), count, levels[k + 1][first].data(), QF_DIGEST_BYTES);
+    }
+    if (!leaves.empty()) commitCount++;
+}
+
+// --------------------------------------------------------------------
+// Queries
+// --------------------------------------------------------------------
+uint64_t QFMerkleLog::size() const {
+    std::shared_lock<std::shared_mutex> guard(treeLock);
+    return levels.empty() ? 0 : levels[0].size();
+}
+
+uint64_t QFMerkleLog::commits() const {
+    std::shared_lock<std::shared_mutex> guard(treeLock);
+    return commitCount;
+}
+
+// MTH(D[lo:hi]); the left half of every split is a complete subtree
+QFDigest QFMerkleLog::subtree(uint64_t lo, uint64_t hi) const {
+    uint64_t n = hi - lo;
+    if ((n & (n - 1)) == 0 && lo % n == 0) {
+        size_t k = 0;
+        while ((uint64_t(1) << k) < n) k++;
+        return levels[k][lo >> k];
+    }
+    uint64_t k = splitPoint(n);
+    return nodeHash(subtree(lo, lo + k), subtree(lo + k, hi));
+}
+
+QFDigest QFMerkleLog::root(uint64_t treeSize) const {
+    std::shared_lock<std::shared_mutex> guard(treeLock);
+    uint64_t have = levels.empty() ? 0 : levels[0].size();
+    if (treeSize > have) treeSize = have;
+    return treeSize == 0 ? emptyRoot() : subtree(0, treeSize);
+}
+
+QFDigest QFMerkleLog::leafHash(uint64_t index) const {
+    std::shared_lock<std::shared_mutex> guard(treeLock);
+    if (levels.empty() || index >= levels[0].size()) return QFDigest{};
+    return levels[0][index];
+}
+
+// PATH(m, D[lo:hi]) from RFC 6962, deepest sibling first
+void QFMerkleLog::inclusionPath(uint64_t m, uint64_t lo, uint64_t hi, std::vector<QFDigest>& out) const {
+    if (hi - lo <= 1) return;
+    uint64_t k = splitPoint(hi - lo);
+    if (m < lo + k) {
+        inclusionPath(m, lo, lo + k, out);
+        out.push_back(subtree(lo + k, hi));
+    }
+    else {
+        inclusionPath(m, lo + k, hi, out);
+        out.push_back(subtree(lo, lo + k));
+    }
+}
+
+// SUBPROOF(m, D[lo:hi], whole) from RFC 6962
+void QFMerkleLog::consistencyPath(uint64_t m, uint64_t lo, uint64_t hi, bool whole,
+    std::vector<QFDigest>& out) const {
+    uint64_t n = hi - lo;
+    if (m == n) {
+        if (!whole) out.push_back(subtree(lo, hi));
+        return;
+    }
+    uint64_t k = splitPoint(n);
+    if (m <= k) {
+        consistencyPath(m, lo, lo + k, whole, out);
+        out.push_back(subtree(lo + k, hi));
+    }
+    else {
+        consistencyPath(m - k, lo + k, hi, false, out);
+        out.push_back(subtree(lo, lo + k));
+    }
+}
+
+bool QFMerkleLog::inclusionProof(uint64_t index, uint64_t treeSize, QFInclusionProof& proof) const {
+    std::shared_lock<std::shared_mutex> guard(treeLock);
+    uint64_t have = levels.empty() ? 0 : levels[0].size();
+    if (index >= treeSize || treeSize > have) return false;
+    proof.index = index;
+    proof.treeSize = treeSize;
+    proof.path.clear();
+    inclusionPath(index, 0, treeSize, proof.path);
+    return true;
+}
+
+bool QFMerkleLog::consistencyProof(uint64_t oldSize, uint64_t newSize, QFConsistencyProof& proof) const {
+    std::shared_lock<std::shared_mutex> guard(treeLock);
+    uint64_t have = levels.empty() ? 0 : levels[0].size();
+    if (oldSize > newSize || newSize > have) return false;
+    proof.oldSize = oldSize;
+    proof.newSize = newSize;
+    proof.path.clear();
+    if (oldSize > 0 && oldSize < newSize) consistencyPath(oldSize, 0, newSize, true, proof.path);
+    return true;
+}
+
+bool QFMerkleLog::readEntry(uint64_t index, std::vector<uint8_t>& entry) const {
+    uint64_t offset;
+    {
+        std::shared_lock<std::shared_mutex> guard(treeLock);
+        if (index >= entryOffsets.size()) return false;
+        offset = entryOffsets[index];
+    }
+    uint8_t header[RECORD_HEADER];
+    if (qfReadFull(fd, header, sizeof(header), static_cast<int64_t>(offset)) != static_cast<long>(sizeof(header))) {
+        return false;
+    }
+    uint32_t len = uint32_t(header[0]) | (uint32_t(header[1]) << 8)
+        | (uint32_t(header[2]) << 16) | (uint32_t(header[3]) << 24);
+    entry.resize(len);
+    return qfReadFull(fd, entry.data(), len, static_cast<int64_t>(offset + RECORD_HEADER)) == static_cast<long>(len);
+}
+
+// --------------------------------------------------------------------
+// Client-side verification (RFC 9162, 2.1.3.2 and 2.1.4.2)
+// --------------------------------------------------------------------
+bool qfVerifyInclusion(const QFDigest& leafHash, const QFInclusionProof& proof, const QFDigest& root) {
+    if (proof.index >= proof.treeSize) return false;
+    uint64_t fn = proof.index, sn = proof.treeSize - 1;
+    QFDigest r = leafHash;
+    for (const QFDigest& p : proof.path) {
+        if (sn == 0) return false;
+        if ((fn & 1) || fn == sn) {
+            r = nodeHash(p, r);
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        }
+        else {
+            r = nodeHash(r, p);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && r == root;
+}
+
+bool qfVerifyConsistency(const QFConsistencyProof& proof, const QFDigest& oldRoot, const QFDigest& newRoot) {
+    if (proof.oldSize > proof.newSize) return false;
+    if (proof.oldSize == proof.newSize) return proof.path.empty() && oldRoot == newRoot;
+    if (proof.oldSize == 0) return proof.path.empty();
+    if (proof.path.empty()) return false;
+
+    std::vector<QFDigest> path;
+    if ((proof.oldSize & (proof.oldSize - 1)) == 0) path.push_back(oldRoot);
+    path.insert(path.end(), proof.path.begin(), proof.path.end());
+
+    uint64_t fn = proof.oldSize - 1, sn = proof.newSize - 1;
+    while (fn & 1) {
+        fn >>= 1;
+        sn >>= 1;
+    }
+    QFDigest fr = path[0], sr = path[0];
+    for (size_t i = 1; i < path.size(); i++) {
+        if (sn == 0) return false;
+        if ((fn & 1) || fn == sn) {
+            fr = nodeHash(path[i], fr);
+            sr = nodeHash(path[i], sr);
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        }
+        else {
+            sr = nodeHash(sr, path[i]);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && fr == oldRoot && sr == newRoot;
+}
@@ -0,0 +1,111 @@
+#ifndef MERKLE_LOG_H
+#define MERKLE_LOG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Append-only verifiable log (RFC 6962 / 9162 Merkle tree over QF)
+//   - leaf = QF(0x00 || u64le(length) || entry), node =
+//     QF(0x01 || left || right), empty tree = QF("").  The length keeps
+//     leaves injective: QF itself does not pad, so "x" and "x\0" would
+//     otherwise collide.
+//   - One file: 8-byte magic, then per entry u32 length |
+//     leaf hash | entry bytes.  open() replays it (recomputing every leaf
+//     hash) and cuts a torn final record left by a crash; a final
+//     record whose hash does not match is reported before it is cut.
+//   - append() is thread-safe and returns once the entry is durable.
+//     Concurrent appenders are group-committed: whichever thread finds
+//     no commit in flight yields once so the others can queue, takes
+//     everything queued so far, hashes it with qfHashMany, writes it
+//     with one write + one fdatasync and wakes the rest.  New interior
+//     nodes are hashed level by level, four per permutation.
+//   - Inclusion and consistency proofs for any sizes up to size();
+//     the qfVerify* functions check them without access to the log.
+// --------------------------------------------------------------------
+
+struct QFLogOptions {
+    bool sync = true;   // fdatasync every group commit
+};
+
+struct QFInclusionProof {
+    uint64_t index = 0;
+    uint64_t treeSize = 0;
+    std::vector<QFDigest> path;
+};
+
+struct QFConsistencyProof {
+    uint64_t oldSize = 0;
+    uint64_t newSize = 0;
+    std::vector<QFDigest> path;
+};
+
+class QFMerkleLog {
+public:
+    QFMerkleLog() = default;
+    ~QFMerkleLog() { close(); }
+
+    QFMerkleLog(const QFMerkleLog&) = delete;
+    QFMerkleLog& operator=(const QFMerkleLog&) = delete;
+
+    // Returns false (after logging) on I/O errors or a corrupt log
+    bool open(const std::string& path, const QFLogOptions& options = QFLogOptions());
+    void close();
+
+    // index (optional) receives the entry's leaf index
+    bool append(const uint8_t* data, size_t len, uint64_t* index = nullptr);
+    bool append(const std::string& s, uint64_t* index = nullptr) {
+        return append(reinterpret_cast<const uint8_t*>(s.data()), s.size(), index);
+    }
+
+    uint64_t size() const;
+    QFDigest root() const { return root(size()); }
+    QFDigest root(uint64_t treeSize) const;   // any treeSize <= size()
+    QFDigest leafHash(uint64_t index) const;
+
+    bool inclusionProof(uint64_t index, uint64_t treeSize, QFInclusionProof& proof) const;
+    bool consistencyProof(uint64_t oldSize, uint64_t newSize, QFConsistencyProof& proof) const;
+    bool readEntry(uint64_t index, std::vector<uint8_t>& entry) const;
+
+    uint64_t commits() const;   // group commits (= fsyncs with options.sync)
+
+private:
+    bool commit(std::vector<std::vector<uint8_t>>& batch);
+    void addLeaves(const std::vector<QFDigest>& leaves, const std::vector<uint64_t>& offsets);
+    QFDigest subtree(uint64_t lo, uint64_t hi) const;
+    void inclusionPath(uint64_t m, uint64_t lo, uint64_t hi, std::vector<QFDigest>& out) const;
+    void consistencyPath(uint64_t m, uint64_t lo, uint64_t hi, bool whole, std::vector<QFDigest>& out) const;
+
+    std::string name;
+    QFLogOptions opts;
+    int fd = -1;
+    int64_t fileEnd = 0;
+
+    // Tree: levels[k][i] = hash of the complete subtree of leaves
+    // [i * 2^k, (i + 1) * 2^k)
+    mutable std::shared_mutex treeLock;
+    std::vector<std::vector<QFDigest>> levels;
+    std::vector<uint64_t> entryOffsets;
+    uint64_t commitCount = 0;
+
+    // Group commit
+    std::mutex queueLock;
+    std::condition_variable committed;
+    std::vector<std::vector<uint8_t>> pending;  // 0x00 || u64 length || entry
+    uint64_t enqueued = 0;
+    uint64_t durable = 0;
+    bool committing = false;
+    bool failed = false;
+};
+
+QFDigest qfLogLeafHash(const uint8_t* data, size_t len);
+
+bool qfVerifyInclusion(const QFDigest& leafHash, const QFInclusionProof& proof, const QFDigest& root);
+bool qfVerifyConsistency(const QFConsistencyProof& proof, const QFDigest& oldRoot, const QFDigest& newRoot);
+
+#endif // MERKLE_LOG_H
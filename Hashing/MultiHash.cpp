@@ -0,0 +1,178 @@
+#include "MultiHash.h"
+#include "BufferArena.h"
+#include "FileIO.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Uncomment to enable debug prints
+// #define MULTI_DEBUG
+
+#ifdef MULTI_DEBUG
+#define MULTI_LOG(msg) std::cerr << "[MultiHash] " << msg << "\n"
+#else
+#define MULTI_LOG(msg) /* no-op */
+#endif
+
+// Buffers in flight between the reader and the QF thread
+static const int MULTI_SLOTS = 3;
+
+bool parseHashAlgorithms(const std::string& list, unsigned& mask) {
+    mask = 0;
+    std::stringstream ss(list);
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+        if (name == "qf" || name == "qf512") mask |= QF_ALG_QF512;
+        else if (name == "sha256") mask |= QF_ALG_SHA256;
+        else if (name == "crc32c") mask |= QF_ALG_CRC32C;
+        else if (name == "all") mask |= QF_ALG_ALL;
+        else return false;
+    }
+    return mask != 0;
+}
+
+// --------------------------------------------------------------------
+// hashFileMulti
+//   - Reader (this thread): processFdChunks fills slot k (holes of
+//     sparse files are not read), we queue it for the QF thread, run
+//     SHA-256/CRC32C over it, and move on once slot k+1 is free.
+//   - QF thread (only when QF is combined with a fast algorithm):
+//     absorb queued slots strictly in order.
+// --------------------------------------------------------------------
+bool hashFileMulti(const std::string& filename, unsigned algorithms, QFMultiDigest& out) {
+    out = QFMultiDigest();
+    out.algorithms = algorithms & QF_ALG_ALL;
+
+    int fd = qfOpenRead(filename);
+    if (fd < 0) {
+        std::cerr << "[hashFileMulti] Failed to open file: " << filename << "\n";
+        return false;
+    }
+
+    const bool wantQf = (out.algorithms & QF_ALG_QF512) != 0;
+    const bool wantSha = (out.algorithms & QF_ALG_SHA256) != 0;
+    const bool wantCrc = (out.algorithms & QF_ALG_CRC32C) != 0;
+    const bool qfThread = wantQf && (wantSha || wantCrc);
+
+    QFBufferArena& arena = qfIoArena();
+    const size_t chunk = arena.bufferSize();
+    const int slots = qfThread ? MULTI_SLOTS : 1;
+    std::unique_ptr<QFArenaLease> leases[MULTI_SLOTS];
+    bool busy[MULTI_SLOTS] = { false };
+    for (int i = 0; i < slots; i++) leases[i].reset(new QFArenaLease(arena));
+
+    QFState qs;
+    qfInit(qs);
+    QFSha256 sha;
+    uint32_t crc = 0;
+
+    // Queued for the QF thread in file order: a slot and its length, or
+    // slot -1 for a run of hole zeros
+    struct Piece {
+        int slot;
+        size_t len;
+    };
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<Piece> toAbsorb;
+    bool readerDone = false;
+
+    std::thread absorber;
+    if (qfThread) {
+        absorber = std::thread([&]() {
+            while (true) {
+                Piece piece;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    changed.wait(guard, [&]() { return !toAbsorb.empty() || readerDone; });
+                    if (toAbsorb.empty()) return;
+                    piece = toAbsorb.front();
+                    toAbsorb.pop_front();
+                }
+                if (piece.slot < 0) {
+                    qfAbsorbZeros(qs, piece.len);
+                    continue;
+                }
+                processRaw(qs, leases[piece.slot]->data(), piece.len);
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    busy[piece.slot] = false;
+                }
+                changed.notify_all();
+            }
+        });
+    }
+
+    // processFdChunks does the reading (and skips holes of sparse files);
+    // each buffer it asks for is the next slot, once the QF thread is done
+    // with that slot
+    int slot = -1;
+    auto nextBuffer = [&]() {
+        slot = (slot + 1) % slots;
+        if (qfThread) {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return !busy[slot]; });
+        }
+        return leases[slot]->data();
+    };
+    std::vector<uint8_t> zeros;
+    auto onChunk = [&](const uint8_t* data, size_t len) {
+        if (qfThread) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (data) busy[slot] = true;
+                toAbsorb.push_back(Piece{ data ? slot : -1, len });
+            }
+            changed.notify_all();
+        }
+        else if (wantQf) {
+            if (data) processRaw(qs, data, len);
+            else qfAbsorbZeros(qs, len);
+        }
+        out.bytes += len;
+        if (!wantSha && !wantCrc) return;
+        if (!data) {
+            // A hole: SHA-256 / CRC32C still see every zero byte
+            zeros.resize(std::min(len, chunk));
+            for (size_t done = 0; done < len; done += zeros.size()) {
+                size_t n = std::min(zeros.size(), len - done);
+                if (wantSha) sha.update(zeros.data(), n);
+                if (wantCrc) crc = qfCrc32c(crc, zeros.data(), n);
+            }
+            return;
+        }
+        // The QF thread only reads this buffer too
+        if (wantSha) sha.update(data, len);
+        if (wantCrc) crc = qfCrc32c(crc, data, len);
+    };
+    long readError = processFdChunks(fd, chunk, nextBuffer, onChunk);
+
+    if (qfThread) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            readerDone = true;
+        }
+        changed.notify_all();
+        absorber.join();
+    }
+    qfClose(fd);
+
+    if (readError != 0) {
+        std::cerr << "[hashFileMulti] Read error on " << filename << ": "
+            << std::strerror(static_cast<int>(-readError)) << "\n";
+        return false;
+    }
+    if (wantQf) qfSqueeze(qs, out.qf.data(), out.qf.size());
+    if (wantSha) sha.finalize(out.sha256);
+    if (wantCrc) out.crc32c = crc;
+    MULTI_LOG(filename << ": " << out.bytes << " bytes, sha256 " << QFSha256::implementation()
+        << ", crc32c " << qfCrc32cImplementation() << (qfThread ? ", QF on its own thread" : ""));
+    return true;
+}
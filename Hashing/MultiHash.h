@@ -0,0 +1,44 @@
+#ifndef MULTI_HASH_H
+#define MULTI_HASH_H
+
+#include <cstdint>
+#include <string>
+#include "Crc32c.h"
+#include "Sha256.h"
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Multi-algorithm single pass
+//   - Any combination of QF-512, SHA-256 and CRC32C from ONE read of
+//     the file, read by processFile's own chunk reader (processFdChunks:
+//     same chunk boundaries, so the QF digest equals digestFile(), and
+//     holes of sparse files are not read; SHA-256 / CRC32C are fed
+//     their zeros from memory).
+//   - QF is an order of magnitude slower than SHA-NI / SSE4.2 CRC, so
+//     when it is combined with another algorithm it runs on its own
+//     thread: the reader thread computes SHA-256/CRC32C on each buffer
+//     while the QF thread absorbs the previous ones.
+// --------------------------------------------------------------------
+
+enum QFHashAlgorithm : unsigned {
+    QF_ALG_QF512 = 1u << 0,
+    QF_ALG_SHA256 = 1u << 1,
+    QF_ALG_CRC32C = 1u << 2,
+    QF_ALG_ALL = QF_ALG_QF512 | QF_ALG_SHA256 | QF_ALG_CRC32C
+};
+
+struct QFMultiDigest {
+    unsigned algorithms = 0;  // which fields below are valid
+    uint64_t bytes = 0;
+    QFDigest qf{};
+    QFSha256Digest sha256{};
+    uint32_t crc32c = 0;
+};
+
+// "qf,sha256,crc32c" (any subset, or "all") -> mask; false on unknown names
+bool parseHashAlgorithms(const std::string& list, unsigned& mask);
+
+// Returns false (after logging to stderr) if the file cannot be read
+bool hashFileMulti(const std::string& filename, unsigned algorithms, QFMultiDigest& out);
+
+#endif // MULTI_HASH_H
@@ -0,0 +1,172 @@
+#include "MultisetHash.h"
+#include "Performance.h"
+#include "QuantumProtection.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+// Elements per task in addMany (enough to keep qfHashMany's lanes full)
+static const size_t MULTISET_GRAIN = 1024;
+static const size_t ELEMENT_BYTES = QFMultisetHash::LIMBS * 8;
+
+static uint64_t loadLE64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void storeLE64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+// acc += x (mod 2^1024)
+static void addLimbs(uint64_t* acc, const uint64_t* x) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < QFMultisetHash::LIMBS; i++) {
+        uint64_t t = acc[i] + carry;
+        carry = (t < carry) ? 1 : 0;
+        uint64_t r = t + x[i];
+        carry += (r < t) ? 1 : 0;
+        acc[i] = r;
+    }
+}
+
+// acc -= x (mod 2^1024)
+static void subLimbs(uint64_t* acc, const uint64_t* x) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < QFMultisetHash::LIMBS; i++) {
+        uint64_t t = acc[i] - borrow;
+        borrow = (acc[i] < borrow) ? 1 : 0;
+        borrow += (t < x[i]) ? 1 : 0;
+        acc[i] = t - x[i];
+    }
+}
+
+// Element bytes as hashed: 8-byte little-endian length, then the data, so
+// no element is a zero-extended copy of another ("a" vs "a\0")
+static size_t encodeElement(const uint8_t* data, size_t len, uint8_t* out) {
+    storeLE64(out, len);
+    if (len > 0) std::memcpy(out + 8, data, len);
+    return len + 8;
+}
+
+static void hashElement(const uint8_t* data, size_t len, uint8_t digest[ELEMENT_BYTES]) {
+    uint8_t small[QF_RATE_BYTES];
+    std::vector<uint8_t> large;
+    uint8_t* buf = small;
+    if (len + 8 > sizeof(small)) {
+        large.resize(len + 8);
+        buf = large.data();
+    }
+    qfHashShort(buf, encodeElement(data, len, buf), digest, ELEMENT_BYTES);
+}
+
+static void elementLimbs(const uint8_t* digest, uint64_t* limbs) {
+    for (size_t i = 0; i < QFMultisetHash::LIMBS; i++) limbs[i] = loadLE64(digest + 8 * i);
+}
+
+// --------------------------------------------------------------------
+// QFMultisetHash
+// --------------------------------------------------------------------
+void QFMultisetHash::clear() {
+    std::memset(sum, 0, sizeof(sum));
+    elements = 0;
+}
+
+void QFMultisetHash::add(const uint8_t* data, size_t len) {
+    uint8_t digest[ELEMENT_BYTES];
+    uint64_t limbs[LIMBS];
+    hashElement(data, len, digest);
+    elementLimbs(digest, limbs);
+    addLimbs(sum, limbs);
+    elements++;
+}
+
+void QFMultisetHash::remove(const uint8_t* data, size_t len) {
+    uint8_t digest[ELEMENT_BYTES];
+    uint64_t limbs[LIMBS];
+    hashElement(data, len, digest);
+    elementLimbs(digest, limbs);
+    subLimbs(sum, limbs);
+    elements--;
+}
+
+void QFMultisetHash::addMany(const uint8_t* const* data, const size_t* lengths, size_t count) {
+    std::mutex lock;
+    size_t tasks = (count + MULTISET_GRAIN - 1) / MULTISET_GRAIN;
+    qfScheduler().parallelFor(tasks, [&](size_t t) {
+        size_t first = t * MULTISET_GRAIN;
+        size_t n = std::min(MULTISET_GRAIN, count - first);
+
+        // Length-prefixed copies of this task's elements, one allocation
+        size_t total = 0;
+        for (size_t i = 0; i < n; i++) total += lengths[first + i] + 8;
+        std::vector<uint8_t> encoded(total);
+        std::vector<const uint8_t*> ptrs(n);
+        std::vector<size_t> lens(n);
+        size_t at = 0;
+        for (size_t i = 0; i < n; i++) {
+            ptrs[i] = encoded.data() + at;
+            lens[i] = encodeElement(data[first + i], lengths[first + i], encoded.data() + at);
+            at += lens[i];
+        }
+
+        std::vector<uint8_t> digests(n * ELEMENT_BYTES);
+        qfHashMany(ptrs.data(), lens.data(), n, digests.data(), ELEMENT_BYTES);
+
+        // Partial sum per task, one locked merge at the end
+        uint64_t partial[LIMBS] = { 0 };
+        uint64_t limbs[LIMBS];
+        for (size_t i = 0; i < n; i++) {
+            elementLimbs(digests.data() + i * ELEMENT_BYTES, limbs);
+            addLimbs(partial, limbs);
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        addLimbs(sum, partial);
+        elements += n;
+    });
+}
+
+void QFMultisetHash::addMany(const std::vector<std::string>& items) {
+    std::vector<const uint8_t*> ptrs(items.size());
+    std::vector<size_t> lens(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        ptrs[i] = reinterpret_cast<const uint8_t*>(items[i].data());
+        lens[i] = items[i].size();
+    }
+    addMany(ptrs.data(), lens.data(), items.size());
+}
+
+void QFMultisetHash::merge(const QFMultisetHash& other) {
+    addLimbs(sum, other.sum);
+    elements += other.elements;
+}
+
+void QFMultisetHash::subtract(const QFMultisetHash& other) {
+    subLimbs(sum, other.sum);
+    elements -= other.elements;
+}
+
+void QFMultisetHash::serialize(uint8_t out[STATE_BYTES]) const {
+    for (size_t i = 0; i < LIMBS; i++) storeLE64(out + 8 * i, sum[i]);
+    storeLE64(out + 8 * LIMBS, elements);
+}
+
+void QFMultisetHash::deserialize(const uint8_t in[STATE_BYTES]) {
+    for (size_t i = 0; i < LIMBS; i++) sum[i] = loadLE64(in + 8 * i);
+    elements = loadLE64(in + 8 * LIMBS);
+}
+
+void QFMultisetHash::digest(QFDigest& out) const {
+    uint8_t state[STATE_BYTES];
+    serialize(state);
+    QFState qs;
+    qfInit(qs);
+    qfAbsorb(qs, state, sizeof(state));
+    qfSqueeze(qs, out.data(), out.size());
+}
+
+bool QFMultisetHash::operator==(const QFMultisetHash& other) const {
+    return elements == other.elements && std::memcmp(sum, other.sum, sizeof(sum)) == 0;
+}
@@ -0,0 +1,64 @@
+#ifndef MULTISET_HASH_H
+#define MULTISET_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Order-independent multiset hash (additive, MSet-Add-Hash style)
+//   - Each element is mapped through QF to a 1024-bit integer (one
+//     128-byte squeeze = one permutation) and added mod 2^1024.  The
+//     element is hashed as its 8-byte little-endian length followed by
+//     the bytes, so "a" and "a\0" are different elements.
+//   - add/remove are O(1); partial sums from different threads or
+//     replicas combine with merge() in any order.
+//   - digest() = QF(sum || element count), so the same multiset gives
+//     the same digest no matter how it was assembled.
+//   - Additive multiset hashes are only collision resistant for elements
+//     an attacker cannot choose adaptively in bulk (generalized birthday
+//     attacks); the wide 1024-bit sum keeps that cost far out of reach
+//     for replica comparison.
+// --------------------------------------------------------------------
+
+class QFMultisetHash {
+public:
+    static const size_t LIMBS = 16;                  // 16 x 64 = 1024 bits
+    static const size_t STATE_BYTES = LIMBS * 8 + 8; // sum + count
+
+    QFMultisetHash() { clear(); }
+
+    void clear();
+
+    void add(const uint8_t* data, size_t len);
+    void remove(const uint8_t* data, size_t len);
+    void add(const std::string& s) { add(reinterpret_cast<const uint8_t*>(s.data()), s.size()); }
+    void remove(const std::string& s) { remove(reinterpret_cast<const uint8_t*>(s.data()), s.size()); }
+
+    // Batched add through qfHashMany, split across the global scheduler
+    void addMany(const uint8_t* const* elements, const size_t* lengths, size_t count);
+    void addMany(const std::vector<std::string>& elements);
+
+    // Combine with (or take away) another partial hash
+    void merge(const QFMultisetHash& other);
+    void subtract(const QFMultisetHash& other);
+
+    uint64_t count() const { return elements; }
+    void digest(QFDigest& out) const;
+
+    // Raw accumulator (little-endian limbs, then the count), for shipping
+    // partial sums between processes
+    void serialize(uint8_t out[STATE_BYTES]) const;
+    void deserialize(const uint8_t in[STATE_BYTES]);
+
+    bool operator==(const QFMultisetHash& other) const;
+    bool operator!=(const QFMultisetHash& other) const { return !(*this == other); }
+
+private:
+    uint64_t sum[LIMBS];
+    uint64_t elements;
+};
+
+#endif // MULTISET_HASH_H
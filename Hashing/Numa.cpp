@@ -0,0 +1,307 @@
+#include "Numa.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Uncomment to enable debug prints
+// #define NUMA_DEBUG
+
+#ifdef NUMA_DEBUG
+#define NUMA_LOG(msg) std::cerr << "[Numa] " << msg << "\n"
+#else
+#define NUMA_LOG(msg) /* no-op */
+#endif
+
+// Memory-policy constants from <numaif.h>, which may not be installed
+static const int QF_MPOL_BIND = 2;
+static const unsigned long QF_MPOL_F_NODE = 1UL << 0;
+static const unsigned long QF_MPOL_F_ADDR = 1UL << 1;
+
+// --------------------------------------------------------------------
+// Topology
+// --------------------------------------------------------------------
+
+// Parse a sysfs cpulist such as "0-3,8-11"
+static std::vector<unsigned> parseCpuList(const std::string& text) {
+    std::vector<unsigned> cpus;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        unsigned first = static_cast<unsigned>(std::strtoul(range.c_str(), nullptr, 10));
+        unsigned last = (dash == std::string::npos) ? first
+            : static_cast<unsigned>(std::strtoul(range.c_str() + dash + 1, nullptr, 10));
+        for (unsigned c = first; c <= last; c++) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+bool QFNumaTopology::multiNode() const {
+    unsigned populated = 0;
+    for (const auto& cpus : nodeCpus) {
+        if (!cpus.empty()) populated++;
+    }
+    return populated > 1;
+}
+
+static QFNumaTopology detectTopology() {
+    QFNumaTopology topo;
+#if defined(__linux__)
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, 4, "node") != 0 || name.size() < 5) continue;
+        if (name.find_first_not_of("0123456789", 4) != std::string::npos) continue;
+        unsigned id = static_cast<unsigned>(std::strtoul(name.c_str() + 4, nullptr, 10));
+
+        std::ifstream in(entry.path() / "cpulist");
+        std::string line;
+        std::getline(in, line);
+        if (topo.nodeCpus.size() <= id) topo.nodeCpus.resize(id + 1);
+        topo.nodeCpus[id] = parseCpuList(line);
+    }
+#endif
+    if (topo.nodeCpus.empty()) {
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        topo.nodeCpus.resize(1);
+        for (unsigned c = 0; c < hw; c++) topo.nodeCpus[0].push_back(c);
+    }
+    NUMA_LOG("detected " << topo.nodeCount() << " node(s)");
+    return topo;
+}
+
+const QFNumaTopology& qfNumaTopology() {
+    static const QFNumaTopology topo = detectTopology();
+    return topo;
+}
+
+int qfCurrentNumaNode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return static_cast<int>(node);
+    }
+#endif
+    return 0;
+}
+
+int qfNumaNodeOfAddress(const void* addr) {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+    int node = -1;
+    if (::syscall(SYS_get_mempolicy, &node, nullptr, 0UL, addr, QF_MPOL_F_NODE | QF_MPOL_F_ADDR) == 0) {
+        return node;
+    }
+#else
+    (void)addr;
+#endif
+    return -1;
+}
+
+// --------------------------------------------------------------------
+// QFNumaBuffer
+//   - mmap + mbind(MPOL_BIND) to the requested node, then touch every
+//     page so the first read does not pay the fault.
+// --------------------------------------------------------------------
+QFNumaBuffer::QFNumaBuffer(size_t size, int node) : bytes(size) {
+    if (node < 0) node = qfCurrentNumaNode();
+#if defined(__linux__)
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    mappedBytes = ((size + page - 1) / page) * page;
+    void* mem = ::mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem != MAP_FAILED) {
+        ptr = static_cast<uint8_t*>(mem);
+        if (qfNumaTopology().multiNode()) {
+            unsigned long mask[16] = { 0 };
+            if (node < static_cast<int>(sizeof(mask) * 8)) {
+                mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+#if defined(SYS_mbind)
+                if (::syscall(SYS_mbind, ptr, mappedBytes, QF_MPOL_BIND, mask, sizeof(mask) * 8 + 1, 0) == 0) {
+                    boundNode = node;
+                }
+#endif
+            }
+        }
+        std::memset(ptr, 0, mappedBytes); // prefault on the bound node
+        return;
+    }
+    mappedBytes = 0;
+#endif
+    ptr = static_cast<uint8_t*>(std::malloc(size));
+    (void)node;
+}
+
+QFNumaBuffer::~QFNumaBuffer() {
+#if defined(__linux__)
+    if (mappedBytes > 0) {
+        ::munmap(ptr, mappedBytes);
+        return;
+    }
+#endif
+    std::free(ptr);
+}
+
+// --------------------------------------------------------------------
+// numastat counters (pages) for one node
+// --------------------------------------------------------------------
+struct NumaStat {
+    uint64_t hit = 0, miss = 0, other = 0;
+};
+
+static NumaStat readNumaStat(unsigned node) {
+    NumaStat st;
+#if defined(__linux__)
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/numastat");
+    std::string key;
+    uint64_t value;
+    while (in >> key >> value) {
+        if (key == "numa_hit") st.hit = value;
+        else if (key == "numa_miss") st.miss = value;
+        else if (key == "other_node") st.other = value;
+    }
+#else
+    (void)node;
+#endif
+    return st;
+}
+
+void printNumaReport(const QFNumaReport& r, std::ostream& os) {
+    os << "[Numa] mode " << (r.enabled ? "enabled" : "disabled (single node)")
+        << ", nodes = " << r.nodes << "\n";
+    char line[160];
+    std::snprintf(line, sizeof(line), "[Numa] %zu MiB in %.3f s = %.1f MiB/s\n",
+        static_cast<size_t>(r.totalBytes >> 20), r.seconds,
+        r.seconds > 0 ? (r.totalBytes / 1048576.0) / r.seconds : 0.0);
+    os << line;
+    for (size_t n = 0; n < r.perNode.size(); n++) {
+        const QFNumaNodeReport& nr = r.perNode[n];
+        if (nr.files == 0 && nr.numaHit == 0 && nr.numaMiss == 0) continue;
+        std::snprintf(line, sizeof(line),
+            "[Numa]   node %zu: %llu files, %llu MiB, %.1f MiB/s/worker-time, "
+            "numa_hit %llu, numa_miss %llu, other_node %llu pages\n",
+            n, static_cast<unsigned long long>(nr.files),
+            static_cast<unsigned long long>(nr.bytes >> 20),
+            nr.busySeconds > 0 ? (nr.bytes / 1048576.0) / nr.busySeconds : 0.0,
+            static_cast<unsigned long long>(nr.numaHit),
+            static_cast<unsigned long long>(nr.numaMiss),
+            static_cast<unsigned long long>(nr.otherNode));
+        os << line;
+    }
+    os << "[Numa] remote buffers = " << r.remoteBuffers
+        << ", cross-node steals = " << r.crossNodeSteals << "\n";
+}
+
+// --------------------------------------------------------------------
+// hashFilesNuma
+// --------------------------------------------------------------------
+
+// One read buffer per worker thread, allocated on that worker's node the
+// first time it is needed and reused for every later file.
+static thread_local std::unique_ptr<QFNumaBuffer> workerBuffer;
+
+void hashFilesNuma(const std::vector<std::string>& files, std::vector<QFDigest>& digests,
+    std::vector<bool>& ok, QFNumaReport& report, size_t chunkSize) {
+    const QFNumaTopology& topo = qfNumaTopology();
+    QFScheduler& scheduler = qfScheduler();
+
+    report = QFNumaReport();
+    report.nodes = topo.nodeCount();
+    report.enabled = topo.multiNode();
+    report.perNode.resize(report.nodes);
+    digests.assign(files.size(), QFDigest());
+    ok.assign(files.size(), false);
+
+    std::vector<NumaStat> before(report.nodes);
+    for (unsigned n = 0; n < report.nodes; n++) before[n] = readNumaStat(n);
+    uint64_t stealsBefore = scheduler.stats().crossNodeStolen;
+
+    // Workers of each node (all on node 0 when NUMA is off)
+    std::vector<std::vector<unsigned>> nodeWorkers(report.nodes);
+    for (unsigned w = 0; w < scheduler.workerCount(); w++) {
+        unsigned node = report.enabled ? static_cast<unsigned>(scheduler.workerNode(w)) : 0;
+        if (node >= report.nodes) node = 0;
+        nodeWorkers[node].push_back(w);
+    }
+
+    // Shard by size: biggest files first, each to the least-loaded node
+    std::vector<uint64_t> sizes(files.size(), 0);
+    std::vector<size_t> order(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        std::error_code ec;
+        uint64_t sz = std::filesystem::file_size(files[i], ec);
+        sizes[i] = ec ? 0 : sz;
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    std::vector<uint64_t> nodeLoad(report.nodes, 0);
+    std::vector<size_t> nodeNext(report.nodes, 0);
+    std::mutex reportLock;
+    auto start = std::chrono::steady_clock::now();
+    {
+        QFTaskGroup group(scheduler);
+        for (size_t idx : order) {
+            unsigned target = 0;
+            for (unsigned n = 0; n < report.nodes; n++) {
+                if (nodeWorkers[n].empty()) continue;
+                if (nodeWorkers[target].empty() || nodeLoad[n] < nodeLoad[target]) target = n;
+            }
+            nodeLoad[target] += sizes[idx] + 1;
+            int hint = nodeWorkers[target].empty() ? -1
+                : static_cast<int>(nodeWorkers[target][nodeNext[target]++ % nodeWorkers[target].size()]);
+
+            group.run([&, idx]() {
+                auto t0 = std::chrono::steady_clock::now();
+                int node = report.enabled ? qfCurrentNumaNode() : 0;
+                bool remote = false;
+                if (!workerBuffer || workerBuffer->size() < chunkSize) {
+                    workerBuffer.reset(new QFNumaBuffer(chunkSize, node));
+                    int actual = qfNumaNodeOfAddress(workerBuffer->data());
+                    remote = report.enabled && actual >= 0 && actual != node;
+                }
+
+                QFState qs;
+                qfInit(qs);
+                bool good = processFile(qs, files[idx], workerBuffer->data(), chunkSize);
+                if (good) qfSqueeze(qs, digests[idx].data(), digests[idx].size());
+                double busy = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+                std::lock_guard<std::mutex> guard(reportLock);
+                ok[idx] = good;
+                unsigned slot = (node >= 0 && static_cast<unsigned>(node) < report.nodes) ? node : 0;
+                report.perNode[slot].files++;
+                report.perNode[slot].bytes += sizes[idx];
+                report.perNode[slot].busySeconds += busy;
+                report.totalBytes += sizes[idx];
+                if (remote) report.remoteBuffers++;
+            }, hint);
+        }
+        group.wait();
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (unsigned n = 0; n < report.nodes; n++) {
+        NumaStat after = readNumaStat(n);
+        report.perNode[n].numaHit = after.hit - before[n].hit;
+        report.perNode[n].numaMiss = after.miss - before[n].miss;
+        report.perNode[n].otherNode = after.other - before[n].other;
+    }
+    report.crossNodeSteals = scheduler.stats().crossNodeStolen - stealsBefore;
+}
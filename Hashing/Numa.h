@@ -0,0 +1,100 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Optional NUMA mode for bulk hashing.
+//
+// On multi-socket hosts:
+//   - scheduler workers are pinned node by node (see QFScheduler with
+//     pinWorkers = true) and prefer to steal from their own node,
+//   - files are sharded across nodes by size,
+//   - every read buffer is allocated on the node of the worker that
+//     consumes it (mbind, no libnuma dependency).
+// On single-node machines (and non-Linux builds) all of this collapses
+// to the ordinary path: one node, plain buffers, no pinning.
+// --------------------------------------------------------------------
+
+struct QFNumaTopology {
+    // CPUs of each online node; index = node id (empty for gaps)
+    std::vector<std::vector<unsigned>> nodeCpus;
+
+    unsigned nodeCount() const { return static_cast<unsigned>(nodeCpus.size()); }
+    bool multiNode() const;
+};
+
+// Read once from /sys/devices/system/node and cached
+const QFNumaTopology& qfNumaTopology();
+
+// Node of the CPU the calling thread is running on (0 if unknown)
+int qfCurrentNumaNode();
+
+// Node backing the page at addr, or -1 if unknown
+int qfNumaNodeOfAddress(const void* addr);
+
+// --------------------------------------------------------------------
+// QFNumaBuffer
+//   - Page-aligned buffer bound to one node and prefaulted there.
+//   - node < 0 => the calling thread's node.
+// --------------------------------------------------------------------
+class QFNumaBuffer {
+public:
+    QFNumaBuffer(size_t bytes, int node = -1);
+    ~QFNumaBuffer();
+
+    QFNumaBuffer(const QFNumaBuffer&) = delete;
+    QFNumaBuffer& operator=(const QFNumaBuffer&) = delete;
+
+    uint8_t* data() const { return ptr; }
+    size_t size() const { return bytes; }
+    int node() const { return boundNode; }
+
+private:
+    uint8_t* ptr = nullptr;
+    size_t bytes = 0;
+    size_t mappedBytes = 0;
+    int boundNode = -1;
+};
+
+// --------------------------------------------------------------------
+// Reporting
+// --------------------------------------------------------------------
+struct QFNumaNodeReport {
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    double busySeconds = 0.0;    // summed worker time spent on this node
+    // Deltas of /sys/devices/system/node/nodeN/numastat (pages)
+    uint64_t numaHit = 0;
+    uint64_t numaMiss = 0;
+    uint64_t otherNode = 0;
+};
+
+struct QFNumaReport {
+    bool enabled = false;        // false => single node, plain path
+    unsigned nodes = 1;
+    std::vector<QFNumaNodeReport> perNode;
+    uint64_t remoteBuffers = 0;  // buffers that ended up off their worker's node
+    uint64_t crossNodeSteals = 0;
+    uint64_t totalBytes = 0;
+    double seconds = 0.0;
+};
+
+void printNumaReport(const QFNumaReport& report, std::ostream& os);
+
+// --------------------------------------------------------------------
+// hashFilesNuma
+//   - Digest every file (same digest as digestFile()) on the global
+//     scheduler.  digests/ok are resized to files.size().
+//   - Call qfSetSchedulerThreads(n, true) before the first use of the
+//     global scheduler to get node-pinned workers.
+// --------------------------------------------------------------------
+void hashFilesNuma(const std::vector<std::string>& files, std::vector<QFDigest>& digests,
+    std::vector<bool>& ok, QFNumaReport& report, size_t chunkSize = 1 << 20);
+
+#endif // NUMA_H
@@ -1,6 +1,7 @@
 #include "Performance.h"
 #include <immintrin.h> // for AVX2 intrinsics
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 
 // Uncomment to enable debug prints
@@ -90,3 +91,168 @@ void speedOptimize(QFState& qs) {
 
     PERF_LOG("speedOptimize complete.");
 }
+
+// -----------------------------------------------------------------------------
+//  Rotation schedule of qfPermutation(), precomputed per round so the SIMD
+//  path does not redo the modulo arithmetic for every word.
+// -----------------------------------------------------------------------------
+struct RotationSchedule {
+    uint8_t pairA[QF_ROUNDS][QFState::STATE_WORDS / 2];
+    uint8_t pairB[QF_ROUNDS][QFState::STATE_WORDS / 2];
+    uint8_t cross[QF_ROUNDS][QFState::STATE_WORDS];
+
+    RotationSchedule() {
+        for (int round = 0; round < QF_ROUNDS; round++) {
+            for (int i = 0; i < 32; i += 2) {
+                pairA[round][i / 2] = static_cast<uint8_t>((i + round) % 63);
+                pairB[round][i / 2] = static_cast<uint8_t>(((i * 3) + round) % 59);
+            }
+            for (int i = 0; i < 32; i++) {
+                cross[round][i] = static_cast<uint8_t>(((i + round) % 7) + 1);
+            }
+        }
+    }
+};
+static const RotationSchedule ROTATIONS;
+
+void qfLoadLane(QFStateX4& s, int lane, const QFState& qs) {
+    for (int i = 0; i < QFState::STATE_WORDS; i++) s.w[i][lane] = qs.state[i];
+}
+
+void qfStoreLane(const QFStateX4& s, int lane, QFState& qs) {
+    for (int i = 0; i < QFState::STATE_WORDS; i++) qs.state[i] = s.w[i][lane];
+}
+
+#if defined(__AVX2__)
+// Rotate each 64-bit lane left by n (n = 0 gives x, as in the scalar code)
+static inline __m256i rotl64x4(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_sll_epi64(x, _mm_cvtsi32_si128(n)),
+        _mm256_srl_epi64(x, _mm_cvtsi32_si128(64 - n)));
+}
+#endif
+
+// -----------------------------------------------------------------------------
+//  qfPermutationX4
+//    Same three steps as qfPermutation(), in the same order (step 3 is
+//    sequential: words 27..31 read already-updated words 0..4).
+// -----------------------------------------------------------------------------
+void qfPermutationX4(QFStateX4& s) {
+#if defined(__AVX2__)
+    __m256i w[QFState::STATE_WORDS];
+    for (int i = 0; i < QFState::STATE_WORDS; i++) {
+        w[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(s.w[i]));
+    }
+
+    for (int round = 0; round < QF_ROUNDS; round++) {
+        const int rc = round % QFState::STATE_WORDS;
+        w[rc] = _mm256_xor_si256(w[rc], _mm256_set1_epi64x(static_cast<long long>(QF_ROUND_CONSTANTS[round])));
+
+        for (int i = 0; i < 32; i += 2) {
+            __m256i a = rotl64x4(_mm256_xor_si256(w[i], w[i + 1]), ROTATIONS.pairA[round][i / 2]);
+            __m256i b = rotl64x4(_mm256_xor_si256(w[i + 1], a), ROTATIONS.pairB[round][i / 2]);
+            w[i] = a;
+            w[i + 1] = b;
+        }
+
+        for (int i = 0; i < 32; i++) {
+            w[i] = _mm256_xor_si256(w[i], rotl64x4(w[(i + 5) % 32], ROTATIONS.cross[round][i]));
+        }
+    }
+
+    for (int i = 0; i < QFState::STATE_WORDS; i++) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(s.w[i]), w[i]);
+    }
+#else
+    QFState lane;
+    for (int l = 0; l < QF_LANES; l++) {
+        qfStoreLane(s, l, lane);
+        qfPermutation(lane);
+        qfLoadLane(s, l, lane);
+    }
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//  qfHashMany
+//    Each message is a sequence of steps, each "XOR input, then permute":
+//      steps 0..nb-1 : the nb full rate blocks (qfAbsorb)
+//      step  nb      : the partial tail (possibly empty) followed by the
+//                      permutation qfSqueeze always starts with
+//    After the last step the lane holds exactly the state qfSqueeze reads
+//    its first output block from.
+// -----------------------------------------------------------------------------
+void qfHashMany(const uint8_t* const* messages, const size_t* lengths, size_t count,
+    uint8_t* digests, size_t digestLen) {
+    QFState init;
+    qfInit(init);
+    qfHashManyFrom(init, messages, lengths, count, digests, digestLen);
+}
+
+void qfHashManyFrom(const QFState& init, const uint8_t* const* messages, const size_t* lengths,
+    size_t count, uint8_t* digests, size_t digestLen) {
+    struct Lane {
+        size_t msg;
+        size_t step;
+        size_t steps;
+        bool active;
+    };
+
+    QFStateX4 s;
+    Lane lanes[QF_LANES];
+    size_t next = 0;
+
+    auto refill = [&](int l) {
+        if (next < count) {
+            lanes[l] = Lane{ next, 0, lengths[next] / QF_RATE_BYTES + 1, true };
+            qfLoadLane(s, l, init);
+            next++;
+        }
+        else {
+            lanes[l].active = false;
+        }
+    };
+    for (int l = 0; l < QF_LANES; l++) refill(l);
+
+    const int RATE_WORDS = static_cast<int>(QF_RATE_BYTES / 8);
+    while (lanes[0].active || lanes[1].active || lanes[2].active || lanes[3].active) {
+        for (int l = 0; l < QF_LANES; l++) {
+            Lane& lane = lanes[l];
+            if (!lane.active) continue;
+            const uint8_t* msg = messages[lane.msg];
+            size_t len = lengths[lane.msg];
+            size_t offset = lane.step * QF_RATE_BYTES;
+            size_t take = (len - offset < QF_RATE_BYTES) ? len - offset : QF_RATE_BYTES;
+
+            uint64_t block[QF_RATE_BYTES / 8];
+            if (take == QF_RATE_BYTES) {
+                std::memcpy(block, msg + offset, QF_RATE_BYTES);
+            }
+            else {
+                std::memset(block, 0, sizeof(block));
+                if (take > 0) std::memcpy(block, msg + offset, take);
+            }
+            for (int i = 0; i < RATE_WORDS; i++) s.w[i][l] ^= block[i];
+        }
+
+        qfPermutationX4(s);
+
+        for (int l = 0; l < QF_LANES; l++) {
+            Lane& lane = lanes[l];
+            if (!lane.active || ++lane.step < lane.steps) continue;
+
+            // Squeeze (continues like qfSqueeze for digests past one block)
+            QFState qs;
+            qfStoreLane(s, l, qs);
+            uint8_t* out = digests + lane.msg * digestLen;
+            size_t remaining = digestLen;
+            while (remaining > 0) {
+                size_t take = (remaining < QF_RATE_BYTES) ? remaining : QF_RATE_BYTES;
+                std::memcpy(out, qs.state, take);
+                out += take;
+                remaining -= take;
+                if (remaining > 0) qfPermutation(qs);
+            }
+            refill(l);
+        }
+    }
+}
@@ -10,4 +10,37 @@
 // -----------------------------------------------------------------------------
 void speedOptimize(QFState& qs);
 
+// -----------------------------------------------------------------------------
+//  Multi-buffer permutation: four independent states, word-interleaved
+//  (w[i][lane]) so one AVX2 instruction advances all four lanes.  Falls back
+//  to four scalar qfPermutation() calls when AVX2 is not compiled in.
+// -----------------------------------------------------------------------------
+static const int QF_LANES = 4;
+
+struct QFStateX4 {
+    alignas(32) uint64_t w[QFState::STATE_WORDS][QF_LANES];
+};
+
+void qfPermutationX4(QFStateX4& s);
+
+// Copy one lane in/out of the interleaved layout
+void qfLoadLane(QFStateX4& s, int lane, const QFState& qs);
+void qfStoreLane(const QFStateX4& s, int lane, QFState& qs);
+
+// -----------------------------------------------------------------------------
+//  qfHashMany
+//    Digest `count` independent messages: digests + i*digestLen receives
+//    qfInit + qfAbsorb(messages[i], lengths[i]) + qfSqueeze for every i
+//    (the same bytes processRaw/digestFile produce on little-endian hosts).
+//    Messages are streamed through the four lanes; a lane is refilled as
+//    soon as its message finishes, so mixed lengths keep every lane busy.
+// -----------------------------------------------------------------------------
+void qfHashMany(const uint8_t* const* messages, const size_t* lengths, size_t count,
+    uint8_t* digests, size_t digestLen);
+
+// Same, but every message starts from `init` instead of qfInit's state
+// (e.g. a state that has already absorbed a full key block)
+void qfHashManyFrom(const QFState& init, const uint8_t* const* messages, const size_t* lengths,
+    size_t count, uint8_t* digests, size_t digestLen);
+
 #endif // PERFORMANCE_H
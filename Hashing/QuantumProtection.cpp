@@ -1,13 +1,14 @@
 #include "QuantumProtection.h"
 #include <cstring>     // for std::memcpy, etc.
 #include <iostream>    // optional: for debugging
+#include <utility>     // for std::integer_sequence
 
 // ----------------------------------------------------
 // Some constants/round keys for the permutation
 // Well use 24 rounds, reminiscent of Keccak, 
 // but these are random or arbitrary for demonstration
 // ----------------------------------------------------
-static const uint64_t ROUND_CONSTANTS[24] = {
+const uint64_t QF_ROUND_CONSTANTS[QF_ROUNDS] = {
     0x0000000000000001ULL, 0x0000000000008082ULL,
     0x800000000000808aULL, 0x8000000080008000ULL,
     0x000000000000808bULL, 0x0000000080000001ULL,
@@ -23,25 +24,28 @@ static const uint64_t ROUND_CONSTANTS[24] = {
 };
 
 // ----------------------------------------------------
-// Helper: 64-bit rotation
+// Helper: 64-bit rotation (n = 0 returns x)
 // ----------------------------------------------------
 static inline uint64_t rotl64(uint64_t x, unsigned n) {
-    return (x << n) | (x >> (64 - n));
+    return (x << n) | (x >> ((64 - n) & 63));
 }
 
+// ----------------------------------------------------
+// Initial state: the four leading constants, zeros after
+// ----------------------------------------------------
+static const uint64_t QF_INITIAL_STATE[QFState::STATE_WORDS] = {
+    0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL,
+    0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL
+};
+
 // ----------------------------------------------------
 // 1) qfInit
 //     - Clear or set some arbitrary starting constants
 // ----------------------------------------------------
 void qfInit(QFState& qs) {
-    std::memset(qs.state, 0, sizeof(qs.state));
     // You could set them to random or "nothing-up-our-sleeves" constants
-    // e.g. for demonstration:
-    qs.state[0] = 0x6A09E667F3BCC908ULL;
-    qs.state[1] = 0xBB67AE8584CAA73BULL;
-    qs.state[2] = 0x3C6EF372FE94F82BULL;
-    qs.state[3] = 0xA54FF53A5F1D36F1ULL;
-    // etc. for all 32 words if you want
+    // (all 32 words if you want); see QF_INITIAL_STATE
+    std::memcpy(qs.state, QF_INITIAL_STATE, sizeof(qs.state));
     qs.absorbedBytes = 0;
 }
 
@@ -49,32 +53,55 @@ void qfInit(QFState& qs) {
 // A big, toy "permutation" that tries to mix the full 
 // 2048-bit state with 24 rounds of shifts, xors, etc.
 // (Heavily inspired by SHA-3/Keccak style, but not identical.)
+//
+// Every round is expanded at compile time (templates over the round and
+// word index), so each rotation amount and word index is an immediate
+// instead of three modulo operations per word.  Same steps, same order.
 // ----------------------------------------------------
+
+// 2. Sub-rounds: rotate pairs, cross-couple
+template <int ROUND, int I>
+static inline void qfPairStep(uint64_t* s) {
+    uint64_t a = rotl64(s[I] ^ s[I + 1], (I + ROUND) % 63);
+    uint64_t b = rotl64(s[I + 1] ^ a, ((I * 3) + ROUND) % 59);
+    s[I] = a;
+    s[I + 1] = b;
+}
+
+// 3. More cross-lane mixing (sequential: words 27..31 see new 0..4)
+template <int ROUND, int I>
+static inline void qfCrossStep(uint64_t* s) {
+    s[I] ^= rotl64(s[(I + 5) % 32], ((I + ROUND) % 7) + 1);
+}
+
+template <int ROUND, int... P>
+static inline void qfPairSteps(uint64_t* s, std::integer_sequence<int, P...>) {
+    (qfPairStep<ROUND, 2 * P>(s), ...);
+}
+
+template <int ROUND, int... I>
+static inline void qfCrossSteps(uint64_t* s, std::integer_sequence<int, I...>) {
+    (qfCrossStep<ROUND, I>(s), ...);
+}
+
+template <int ROUND>
+static inline void qfRound(uint64_t* s) {
+    // 1. XOR a round constant into one word
+    s[ROUND % QFState::STATE_WORDS] ^= QF_ROUND_CONSTANTS[ROUND];
+    qfPairSteps<ROUND>(s, std::make_integer_sequence<int, 16>{});
+    qfCrossSteps<ROUND>(s, std::make_integer_sequence<int, 32>{});
+}
+
+template <int... ROUND>
+static inline void qfRounds(uint64_t* s, std::integer_sequence<int, ROUND...>) {
+    (qfRound<ROUND>(s), ...);
+}
+
 void qfPermutation(QFState& qs) {
     // We'll treat qs.state as 32 words. 
     // For a fancier approach, you might arrange them in a 5x5 or 8x4 matrix, etc.
     // We'll do something simpler but still large.
-
-    for (int round = 0; round < 24; round++) {
-        // 1. XOR a round constant into one word
-        qs.state[round % QFState::STATE_WORDS] ^= ROUND_CONSTANTS[round];
-
-        // 2. Sub-rounds: rotate pairs, cross-couple
-        for (int i = 0; i < 32; i += 2) {
-            uint64_t a = qs.state[i];
-            uint64_t b = qs.state[i + 1];
-            // simple mixing
-            a = rotl64(a ^ b, (i + round) % 63);
-            b = rotl64(b ^ a, ((i * 3) + round) % 59);
-            qs.state[i] = a;
-            qs.state[i + 1] = b;
-        }
-
-        // 3. More cross-lane mixing
-        for (int i = 0; i < 32; i++) {
-            qs.state[i] ^= rotl64(qs.state[(i + 5) % 32], ((i + round) % 7) + 1);
-        }
-    }
+    qfRounds(qs.state, std::make_integer_sequence<int, QF_ROUNDS>{});
 }
 
 // ----------------------------------------------------
@@ -111,6 +138,51 @@ void qfAbsorb(QFState& qs, const uint8_t* data, size_t len) {
     }
 }
 
+// ----------------------------------------------------
+// 2b) qfAbsorbZeros
+//     - A partial trailing block XORs zeros and is not
+//       permuted, exactly like qfAbsorb's partial case
+// ----------------------------------------------------
+void qfAbsorbZeros(QFState& qs, uint64_t len) {
+    qs.absorbedBytes += len;
+    for (uint64_t blocks = len / QF_RATE_BYTES; blocks > 0; blocks--) {
+        qfPermutation(qs);
+    }
+}
+
+// ----------------------------------------------------
+// 2c) qfHashShort
+//     - qfInit + qfAbsorb + qfSqueeze for len < 128: the
+//       message is XORed as whole words into a copy of the
+//       constant initial state, then one permutation per
+//       128 output bytes (the one qfSqueeze always runs)
+// ----------------------------------------------------
+void qfHashShort(const uint8_t* data, size_t len, uint8_t* out, size_t outLen) {
+    if (len >= QF_RATE_BYTES) {
+        QFState qs;
+        qfInit(qs);
+        qfAbsorb(qs, data, len);
+        qfSqueeze(qs, out, outLen);
+        return;
+    }
+
+    uint64_t block[QF_RATE_BYTES / 8] = { 0 };
+    if (len > 0) std::memcpy(block, data, len);
+
+    QFState qs;
+    for (int i = 0; i < 16; i++) qs.state[i] = QF_INITIAL_STATE[i] ^ block[i];
+    for (int i = 16; i < QFState::STATE_WORDS; i++) qs.state[i] = 0;
+
+    while (true) {
+        qfPermutation(qs);
+        size_t take = (outLen < QF_RATE_BYTES) ? outLen : QF_RATE_BYTES;
+        std::memcpy(out, qs.state, take);
+        out += take;
+        outLen -= take;
+        if (outLen == 0) return;
+    }
+}
+
 // ----------------------------------------------------
 // 3) qfSqueeze
 //    - If we havent processed a partial block, we do so with padding
@@ -15,6 +15,12 @@ struct QFState {
     // Possibly track other parameters if you want
 };
 
+// Sponge geometry and permutation constants, shared with the
+// multi-buffer (SIMD) implementations in Performance.cpp
+static const size_t QF_RATE_BYTES = 128; // 1024-bit rate
+static const int QF_ROUNDS = 24;
+extern const uint64_t QF_ROUND_CONSTANTS[QF_ROUNDS];
+
 // --------------------------------------------------------------------
 // API
 // --------------------------------------------------------------------
@@ -25,6 +31,16 @@ void qfInit(QFState &qs);
 // Absorb data (in a sponge-like manner)
 void qfAbsorb(QFState &qs, const uint8_t *data, size_t len);
 
+// Same result as qfAbsorb on len zero bytes, without a zero buffer:
+// XORing zeros is a no-op, so only the per-block permutations remain
+// (used for holes in sparse files)
+void qfAbsorbZeros(QFState &qs, uint64_t len);
+
+// One-shot digest of a short message (len < 128, one rate block): same
+// bytes as qfInit + qfAbsorb + qfSqueeze without the struct setup, the
+// byte-wise XOR loop or the state copy.  Longer input takes the generic path.
+void qfHashShort(const uint8_t *data, size_t len, uint8_t *out, size_t outLen);
+
 // Finalize and produce a 512-bit (or bigger) digest
 // For demonstration, well produce 512 bits (64 bytes)
 void qfSqueeze(const QFState &qs, uint8_t *out, size_t outLen);
@@ -0,0 +1,157 @@
+#include "Routing.h"
+#include "Performance.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Items per qfHashManyFrom call in the batched paths
+static const size_t ROUTE_BATCH = 1024;
+
+static uint64_t loadLE64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// Finalizer of MurmurHash3: spreads a (key hash ^ node seed) pair over
+// all 64 bits.  Both inputs already come from the keyed QF, so this only
+// has to decorrelate nodes, not resist chosen keys on its own.
+static uint64_t fmix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// --------------------------------------------------------------------
+// QFKeyedHash
+//   - State after absorbing u64 LE key length || key, zero-padded to a
+//     whole number of rate blocks, so hash64(x) = QF(pad(len || key) || x)
+//     truncated to 8 bytes.  The length keeps keys that differ only in
+//     trailing zero bytes apart; long keys are absorbed as they are.
+// --------------------------------------------------------------------
+QFKeyedHash::QFKeyedHash(const std::string& key) {
+    const size_t used = 8 + key.size();
+    std::vector<uint8_t> blocks((used + QF_RATE_BYTES - 1) / QF_RATE_BYTES * QF_RATE_BYTES, 0);
+    for (int b = 0; b < 8; b++) blocks[b] = static_cast<uint8_t>(static_cast<uint64_t>(key.size()) >> (8 * b));
+    std::memcpy(blocks.data() + 8, key.data(), key.size());
+    qfInit(keyed);
+    qfAbsorb(keyed, blocks.data(), blocks.size());
+}
+
+uint64_t QFKeyedHash::hash64(const uint8_t* data, size_t len) const {
+    QFState qs = keyed;
+    qfAbsorb(qs, data, len);
+    uint8_t digest[8];
+    qfSqueeze(qs, digest, sizeof(digest));
+    return loadLE64(digest);
+}
+
+void QFKeyedHash::hash64Many(const uint8_t* const* items, const size_t* lengths, size_t count,
+    uint64_t* out) const {
+    uint8_t digests[ROUTE_BATCH * 8];
+    for (size_t first = 0; first < count; first += ROUTE_BATCH) {
+        size_t n = std::min(ROUTE_BATCH, count - first);
+        qfHashManyFrom(keyed, items + first, lengths + first, n, digests, 8);
+        for (size_t i = 0; i < n; i++) out[first + i] = loadLE64(digests + 8 * i);
+    }
+}
+
+// --------------------------------------------------------------------
+// Jump consistent hash
+// --------------------------------------------------------------------
+int32_t qfJumpHash(uint64_t keyHash, int32_t buckets) {
+    int64_t b = -1, j = 0;
+    while (j < buckets) {
+        b = j;
+        keyHash = keyHash * 2862933555777941757ULL + 1;
+        j = static_cast<int64_t>((b + 1) * (double(int64_t(1) << 31) / double((keyHash >> 33) + 1)));
+    }
+    return static_cast<int32_t>(b);
+}
+
+QFJumpRouter::QFJumpRouter(int32_t buckets, const std::string& key)
+    : hasher(key), n(std::max<int32_t>(buckets, 1)) {
+}
+
+int32_t QFJumpRouter::route(const uint8_t* data, size_t len) const {
+    return qfJumpHash(hasher.hash64(data, len), n);
+}
+
+void QFJumpRouter::routeMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+    int32_t* buckets) const {
+    std::vector<uint64_t> hashes(std::min(count, ROUTE_BATCH));
+    for (size_t first = 0; first < count; first += ROUTE_BATCH) {
+        size_t m = std::min(ROUTE_BATCH, count - first);
+        hasher.hash64Many(items + first, lengths + first, m, hashes.data());
+        for (size_t i = 0; i < m; i++) buckets[first + i] = qfJumpHash(hashes[i], n);
+    }
+}
+
+// --------------------------------------------------------------------
+// Weighted rendezvous hashing
+//   - Node i scores weight_i / -ln(u_i), u_i uniform in (0, 1) from
+//     fmix64(keyHash ^ seed_i); the top score wins.  Each node then owns
+//     weight_i / sum(weights) of the keys in expectation.
+// --------------------------------------------------------------------
+QFRendezvousRouter::QFRendezvousRouter(const std::vector<QFRouteNode>& nodes, const std::string& key)
+    : hasher(key), nodeInfo(nodes), nodeSeeds(nodes.size()) {
+    for (size_t i = 0; i < nodes.size(); i++) nodeSeeds[i] = hasher.hash64(nodes[i].name);
+}
+
+size_t QFRendezvousRouter::pick(uint64_t keyHash) const {
+    size_t best = SIZE_MAX;
+    double bestScore = 0.0;
+    for (size_t i = 0; i < nodeInfo.size(); i++) {
+        double weight = nodeInfo[i].weight;
+        if (!(weight > 0.0)) continue;
+        uint64_t x = fmix64(keyHash ^ nodeSeeds[i]);
+        double u = (double(x >> 11) + 0.5) * (1.0 / 9007199254740992.0); // (0, 1)
+        double score = weight / -std::log(u);
+        if (best == SIZE_MAX || score > bestScore) {
+            best = i;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+size_t QFRendezvousRouter::route(const uint8_t* data, size_t len) const {
+    return pick(hasher.hash64(data, len));
+}
+
+void QFRendezvousRouter::routeMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+    size_t* nodes) const {
+    std::vector<uint64_t> hashes(std::min(count, ROUTE_BATCH));
+    for (size_t first = 0; first < count; first += ROUTE_BATCH) {
+        size_t m = std::min(ROUTE_BATCH, count - first);
+        hasher.hash64Many(items + first, lengths + first, m, hashes.data());
+        for (size_t i = 0; i < m; i++) nodes[first + i] = pick(hashes[i]);
+    }
+}
+
+// --------------------------------------------------------------------
+// QFSampler
+// --------------------------------------------------------------------
+QFSampler::QFSampler(double rate, const std::string& key)
+    : hasher(key), samplingRate(std::clamp(rate, 0.0, 1.0)), threshold(0), all(false) {
+    double scaled = std::ldexp(samplingRate, 64);
+    if (scaled >= 18446744073709551615.0) all = true; // rounds to 2^64
+    else threshold = static_cast<uint64_t>(scaled);
+}
+
+bool QFSampler::sample(const uint8_t* data, size_t len) const {
+    return below(hasher.hash64(data, len));
+}
+
+void QFSampler::sampleMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+    uint8_t* keep) const {
+    std::vector<uint64_t> hashes(std::min(count, ROUTE_BATCH));
+    for (size_t first = 0; first < count; first += ROUTE_BATCH) {
+        size_t m = std::min(ROUTE_BATCH, count - first);
+        hasher.hash64Many(items + first, lengths + first, m, hashes.data());
+        for (size_t i = 0; i < m; i++) keep[first + i] = below(hashes[i]) ? 1 : 0;
+    }
+}
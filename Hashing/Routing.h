@@ -0,0 +1,113 @@
+#ifndef ROUTING_H
+#define ROUTING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "QuantumProtection.h"
+
+// --------------------------------------------------------------------
+// Hash-based routing and deterministic sampling
+//   - QFKeyedHash: 64-bit keyed QF.  The key is absorbed once, length-
+//     prefixed and zero-padded to whole rate blocks (one block for keys
+//     up to 120 bytes); each item then costs a single permutation, and
+//     the *Many calls run four items per permutation through
+//     qfHashManyFrom.
+//   - QFJumpRouter: jump consistent hash (Lamping & Veach) over N
+//     buckets; growing to N + 1 moves only ~1/(N + 1) of the keys.
+//   - QFRendezvousRouter: weighted highest-random-weight over named
+//     nodes; removing a node only moves the keys it owned.
+//   - QFSampler: keeps a key iff its hash falls below rate * 2^64, so
+//     every service with the same key makes the same decision.
+// --------------------------------------------------------------------
+
+class QFKeyedHash {
+public:
+    explicit QFKeyedHash(const std::string& key = std::string());
+
+    uint64_t hash64(const uint8_t* data, size_t len) const;
+    uint64_t hash64(const std::string& s) const {
+        return hash64(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+    void hash64Many(const uint8_t* const* items, const size_t* lengths, size_t count,
+        uint64_t* out) const;
+
+private:
+    QFState keyed;
+};
+
+// Bucket in [0, buckets) for a 64-bit key hash
+int32_t qfJumpHash(uint64_t keyHash, int32_t buckets);
+
+class QFJumpRouter {
+public:
+    QFJumpRouter(int32_t buckets, const std::string& key = std::string());
+
+    int32_t route(const uint8_t* data, size_t len) const;
+    int32_t route(const std::string& s) const {
+        return route(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+    void routeMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+        int32_t* buckets) const;
+
+    int32_t bucketCount() const { return n; }
+
+private:
+    QFKeyedHash hasher;
+    int32_t n;
+};
+
+struct QFRouteNode {
+    std::string name;
+    double weight = 1.0; // relative share of keys; <= 0 never wins
+};
+
+class QFRendezvousRouter {
+public:
+    explicit QFRendezvousRouter(const std::vector<QFRouteNode>& nodes,
+        const std::string& key = std::string());
+
+    // Index into the node list (SIZE_MAX if there are no usable nodes)
+    size_t route(const uint8_t* data, size_t len) const;
+    size_t route(const std::string& s) const {
+        return route(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+    void routeMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+        size_t* nodes) const;
+
+    const std::vector<QFRouteNode>& nodeList() const { return nodeInfo; }
+
+private:
+    size_t pick(uint64_t keyHash) const;
+
+    QFKeyedHash hasher;
+    std::vector<QFRouteNode> nodeInfo;
+    std::vector<uint64_t> nodeSeeds; // keyed QF of each node name
+};
+
+class QFSampler {
+public:
+    // rate in [0, 1]
+    explicit QFSampler(double rate, const std::string& key = std::string());
+
+    bool sample(const uint8_t* data, size_t len) const;
+    bool sample(const std::string& s) const {
+        return sample(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+    // keep[i] = 1 if items[i] is sampled
+    void sampleMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+        uint8_t* keep) const;
+
+    double rate() const { return samplingRate; }
+
+private:
+    bool below(uint64_t h) const { return all || h < threshold; }
+
+    QFKeyedHash hasher;
+    double samplingRate;
+    uint64_t threshold;
+    bool all;
+};
+
+#endif // ROUTING_H
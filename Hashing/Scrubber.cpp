@@ -0,0 +1,338 @@
+#include "Scrubber.h"
+#include "Encoding.h"
+#include "FileIO.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Uncomment to enable debug prints
+// #define SCRUB_DEBUG
+
+#ifdef SCRUB_DEBUG
+#define SCRUB_LOG(msg) std::cerr << "[Scrubber] " << msg << "\n"
+#else
+#define SCRUB_LOG(msg) /* no-op */
+#endif
+
+static double threadCpuSeconds() {
+#if defined(_WIN32)
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) return 0.0;
+    auto ticks = [](const FILETIME& t) { return (uint64_t(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) * 1e-7;
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0.0;
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Idle CPU and I/O class for the calling thread only
+static void lowerThreadPriority() {
+#if defined(__linux__)
+    pid_t tid = static_cast<pid_t>(::syscall(SYS_gettid));
+    ::setpriority(PRIO_PROCESS, static_cast<id_t>(tid), 19);
+#if defined(SYS_ioprio_set)
+    const int IOPRIO_WHO_PROCESS = 1, IOPRIO_CLASS_IDLE = 3, IOPRIO_CLASS_SHIFT = 13;
+    ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+#elif defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+}
+
+static bool parseDigest(const std::string& hex, QFDigest& out) {
+    return hex.size() == 2 * out.size() && qfHexDecode(hex.data(), hex.size(), out.data());
+}
+
+const char* qfScrubStatusName(QFScrubStatus status) {
+    switch (status) {
+    case QFScrubStatus::Ok:         return "ok";
+    case QFScrubStatus::Corrupt:    return "corrupt";
+    case QFScrubStatus::Missing:    return "missing";
+    case QFScrubStatus::Unreadable: return "unreadable";
+    default:                        return "new";
+    }
+}
+
+// --------------------------------------------------------------------
+// QFTokenBucket
+// --------------------------------------------------------------------
+QFTokenBucket::QFTokenBucket(double rate, double burst)
+    : perSecond(rate), capacity(burst), tokens(burst), last(std::chrono::steady_clock::now()) {
+}
+
+void QFTokenBucket::acquire(double amount) {
+    if (perSecond <= 0.0 || amount <= 0.0) return;
+    double debt;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto now = std::chrono::steady_clock::now();
+        tokens = std::min(capacity, tokens + std::chrono::duration<double>(now - last).count() * perSecond);
+        last = now;
+        tokens -= amount;
+        debt = -tokens;
+    }
+    if (debt > 0.0) std::this_thread::sleep_for(std::chrono::duration<double>(debt / perSecond));
+}
+
+// --------------------------------------------------------------------
+// State file: "# qfscrub 1", then "<hex> <lastVerified> <status>  <path>"
+// --------------------------------------------------------------------
+bool QFScrubber::open(const std::string& path) {
+    statePath = path;
+    entries.clear();
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return true;   // first run
+
+    std::string line;
+    if (!std::getline(in, line) || line.rfind("# qfscrub 1", 0) != 0) {
+        std::cerr << "[Scrubber] Not a scrub state file: " << path << "\n";
+        return false;
+    }
+    uint64_t lineNo = 1;
+    while (std::getline(in, line)) {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        Entry e;
+        size_t a = line.find(' ');
+        size_t b = (a == std::string::npos) ? a : line.find(' ', a + 1);
+        size_t c = (b == std::string::npos) ? b : line.find("  ", b + 1);
+        if (c == std::string::npos || !parseDigest(line.substr(0, a), e.expected)) {
+            std::cerr << "[Scrubber] " << path << ":" << lineNo << ": malformed line\n";
+            return false;
+        }
+        e.lastVerified = std::strtoll(line.c_str() + a + 1, nullptr, 10);
+        std::string status = line.substr(b + 1, c - b - 1);
+        for (QFScrubStatus s : { QFScrubStatus::Ok, QFScrubStatus::Corrupt, QFScrubStatus::Missing,
+            QFScrubStatus::Unreadable }) {
+            if (status == qfScrubStatusName(s)) e.status = s;
+        }
+        e.path = line.substr(c + 2);
+        entries.push_back(std::move(e));
+    }
+    SCRUB_LOG(path << ": " << entries.size() << " entries");
+    return true;
+}
+
+bool QFScrubber::save() {
+    std::vector<Entry> copy;
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        copy = entries;
+    }
+    const std::string tmp = statePath + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "[Scrubber] Failed to create " << tmp << "\n";
+            return false;
+        }
+        out << "# qfscrub 1\n";
+        for (const Entry& e : copy) {
+            out << toHex(e.expected.data(), e.expected.size()) << ' ' << e.lastVerified << ' '
+                << qfScrubStatusName(e.status) << "  " << e.path << '\n';
+        }
+        if (!out.flush()) {
+            std::cerr << "[Scrubber] Failed to write " << tmp << "\n";
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, statePath, ec);
+    if (ec) {
+        std::cerr << "[Scrubber] Failed to replace " << statePath << ": " << ec.message() << "\n";
+        return false;
+    }
+    return true;
+}
+
+long QFScrubber::importManifest(const std::string& manifestPath) {
+    std::ifstream in(manifestPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "[Scrubber] Failed to open manifest: " << manifestPath << "\n";
+        return -1;
+    }
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < entries.size(); i++) index.emplace(entries[i].path, i);
+
+    long changed = 0;
+    uint64_t malformed = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t sep = line.find(' ');
+        QFDigest digest{};
+        if (sep == std::string::npos || sep + 2 >= line.size() || (line[sep + 1] != ' ' && line[sep + 1] != '*')
+            || !parseDigest(line.substr(0, sep), digest)) {
+            if (!line.empty()) malformed++;
+            continue;
+        }
+        std::string path = line.substr(sep + 2);
+        auto known = index.find(path);
+        if (known == index.end()) {
+            index.emplace(path, entries.size());
+            entries.push_back({ path, digest, 0, QFScrubStatus::Unverified });
+            changed++;
+        }
+        else if (entries[known->second].expected != digest) {
+            entries[known->second] = { path, digest, 0, QFScrubStatus::Unverified };
+            changed++;
+        }
+    }
+    if (malformed > 0) std::cerr << "[Scrubber] Skipped " << malformed << " malformed lines in " << manifestPath << "\n";
+    return changed;
+}
+
+uint64_t QFScrubber::secondsUntilDue(uint64_t intervalSeconds) const {
+    if (entries.empty()) return intervalSeconds;
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    int64_t oldest = now;
+    for (const Entry& e : entries) oldest = std::min(oldest, e.lastVerified);
+    int64_t due = oldest + static_cast<int64_t>(intervalSeconds);
+    return (due <= now) ? 0 : static_cast<uint64_t>(due - now);
+}
+
+// --------------------------------------------------------------------
+// run: oldest-verified-first pass over the due entries
+// --------------------------------------------------------------------
+bool QFScrubber::run(const QFScrubOptions& options, QFScrubReport& report, const QFScrubCallback& onResult) {
+    auto start = std::chrono::steady_clock::now();
+    report = QFScrubReport();
+    stopping = false;
+
+    const int64_t now = static_cast<int64_t>(std::time(nullptr));
+    std::vector<size_t> due;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].lastVerified == 0 || now - entries[i].lastVerified >= static_cast<int64_t>(options.intervalSeconds)) {
+            due.push_back(i);
+        }
+    }
+    std::stable_sort(due.begin(), due.end(), [&](size_t a, size_t b) {
+        return entries[a].lastVerified < entries[b].lastVerified;
+    });
+    report.due = due.size();
+
+    unsigned threads = options.threads;
+    if (threads == 0) {
+        threads = qfAvailableCpus();
+        if (options.cpuCores > 0.0) threads = std::min(threads, static_cast<unsigned>(std::ceil(options.cpuCores)));
+    }
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(std::max<size_t>(1, due.size()))));
+    report.threads = threads;
+
+    // Chunks stay a multiple of the rate so per-chunk absorption matches
+    // digestFile()
+    const size_t chunk = std::max<size_t>(QF_RATE_BYTES, options.readChunk / QF_RATE_BYTES * QF_RATE_BYTES);
+    QFTokenBucket io(options.ioBytesPerSecond, 2.0 * chunk);
+    QFTokenBucket cpu(options.cpuCores, 0.05 * std::max(1.0, options.cpuCores));
+
+    std::atomic<size_t> next{ 0 };
+    std::mutex doneLock;
+    std::condition_variable doneWake;
+    unsigned finished = 0;
+
+    auto worker = [&]() {
+        if (options.lowPriority) lowerThreadPriority();
+        std::vector<uint8_t> buffer(chunk);
+        double cpuStart = threadCpuSeconds();
+        uint64_t bytes = 0;
+        for (size_t k = next++; k < due.size() && !stopping; k = next++) {
+            Entry& e = entries[due[k]];
+            QFScrubStatus status;
+            QFDigest actual{};
+            int fd = qfOpenRead(e.path);
+            if (fd < 0) {
+                std::error_code ec;
+                status = std::filesystem::exists(e.path, ec) ? QFScrubStatus::Unreadable : QFScrubStatus::Missing;
+            }
+            else {
+                QFState qs;
+                qfInit(qs);
+                int64_t offset = 0;
+                const int64_t size = qfFileSize(fd);
+                long n;
+                do {
+                    // Charge what this read will return (the EOF probe is free)
+                    int64_t expect = (size < 0) ? static_cast<int64_t>(chunk)
+                        : std::min<int64_t>(static_cast<int64_t>(chunk), std::max<int64_t>(0, size - offset));
+                    io.acquire(static_cast<double>(expect));
+                    double before = threadCpuSeconds();
+                    n = qfReadFull(fd, buffer.data(), chunk, offset);
+                    if (n > 0) {
+                        processRaw(qs, buffer.data(), static_cast<size_t>(n));
+                        qfDropCache(fd, offset, n);
+                        offset += n;
+                    }
+                    cpu.acquire(threadCpuSeconds() - before);
+                } while (n == static_cast<long>(chunk) && !stopping);
+                qfClose(fd);
+                if (stopping && n == static_cast<long>(chunk)) break;   // abandoned mid-file: stays due
+                bytes += static_cast<uint64_t>(offset);
+                if (n < 0) status = QFScrubStatus::Unreadable;
+                else {
+                    qfSqueeze(qs, actual.data(), actual.size());
+                    status = (actual == e.expected) ? QFScrubStatus::Ok : QFScrubStatus::Corrupt;
+                }
+            }
+
+            std::lock_guard<std::mutex> guard(stateLock);
+            e.status = status;
+            e.lastVerified = static_cast<int64_t>(std::time(nullptr));
+            if (status == QFScrubStatus::Ok || status == QFScrubStatus::Corrupt) report.verified++;
+            if (status == QFScrubStatus::Corrupt) report.corrupt++;
+            if (status == QFScrubStatus::Missing) report.missing++;
+            if (status == QFScrubStatus::Unreadable) report.unreadable++;
+            if (onResult) onResult(e.path, status, e.expected, actual);
+        }
+        {
+            std::lock_guard<std::mutex> guard(doneLock);
+            std::lock_guard<std::mutex> state(stateLock);
+            report.bytes += bytes;
+            report.cpuSeconds += threadCpuSeconds() - cpuStart;
+            finished++;
+        }
+        doneWake.notify_all();
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) workers.emplace_back(worker);
+
+    // Checkpoints while the workers run
+    bool saved = true;
+    while (true) {
+        std::unique_lock<std::mutex> guard(doneLock);
+        bool done = doneWake.wait_for(guard, std::chrono::seconds(std::max(1u, options.checkpointSeconds)),
+            [&]() { return finished == threads; });
+        guard.unlock();
+        if (done) break;
+        saved = save() && saved;
+    }
+    for (std::thread& w : workers) w.join();
+    saved = save() && saved;
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    SCRUB_LOG(report.verified << " verified, " << report.bytes << " bytes in " << report.seconds << " s, cpu "
+        << report.cpuSeconds << " s on " << threads << " threads");
+    return saved;
+}
@@ -0,0 +1,111 @@
+#ifndef SCRUBBER_H
+#define SCRUBBER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Background bit-rot scrubber
+//   - A state file records, per file, the expected digest, when it was
+//     last verified and the last outcome.  Entries come from manifests
+//     ("<hex>  <path>", as the bulk modes print) and are never rewritten
+//     from what is read back: a rotten file keeps its recorded digest.
+//   - Each pass re-digests the files that are due (not verified for
+//     intervalSeconds), oldest verification first, and checkpoints the
+//     state every checkpointSeconds (write + rename), so a restart
+//     resumes with whatever was verified longest ago.
+//   - Budgets are shared token buckets: reads take bytes from the I/O
+//     bucket before they are issued, and each chunk's thread CPU time is
+//     charged to the CPU bucket afterwards.  Workers default to the CPU
+//     budget rounded up, capped by qfAvailableCpus() (cgroup quota), run
+//     at idle CPU/I/O priority and drop what they read from the page
+//     cache, so co-located services keep theirs.
+// --------------------------------------------------------------------
+
+// Rate limiter: `rate` units per second, up to `burst` banked.  acquire()
+// may overdraw; the caller then sleeps off the debt, so one large request
+// is not starved by small ones.
+class QFTokenBucket {
+public:
+    QFTokenBucket(double rate, double burst);
+    void acquire(double amount);
+    double rate() const { return perSecond; }
+
+private:
+    std::mutex lock;
+    double perSecond;
+    double capacity;
+    double tokens;
+    std::chrono::steady_clock::time_point last;
+};
+
+enum class QFScrubStatus { Unverified, Ok, Corrupt, Missing, Unreadable };
+
+struct QFScrubOptions {
+    double ioBytesPerSecond = 64.0 * (1 << 20);   // 0 => unlimited
+    double cpuCores = 0.5;                       // 0 => unlimited
+    unsigned threads = 0;                        // 0 => from cpuCores and the cgroup quota
+    uint64_t intervalSeconds = 7 * 24 * 3600;    // re-verify after this long
+    size_t readChunk = 1 << 20;                  // multiple of the sponge rate
+    unsigned checkpointSeconds = 10;
+    bool lowPriority = true;                     // nice 19 + idle I/O class (Linux)
+};
+
+struct QFScrubReport {
+    uint64_t due = 0;
+    uint64_t verified = 0;       // files read to the end
+    uint64_t bytes = 0;
+    uint64_t corrupt = 0;
+    uint64_t missing = 0;
+    uint64_t unreadable = 0;
+    unsigned threads = 0;
+    double seconds = 0.0;
+    double cpuSeconds = 0.0;     // thread CPU time of the workers
+};
+
+typedef std::function<void(const std::string& path, QFScrubStatus status,
+    const QFDigest& expected, const QFDigest& actual)> QFScrubCallback;
+
+class QFScrubber {
+public:
+    // Loads the state file if it exists (a missing one is an empty state)
+    bool open(const std::string& statePath);
+
+    // Adds manifest entries; known paths keep their history unless the
+    // recorded digest differs, which restarts them as unverified.
+    // Returns the number of new or changed entries, or -1 on error.
+    long importManifest(const std::string& manifestPath);
+
+    // One pass over the due files; returns false if the state cannot be
+    // saved.  stop() (any thread) ends the pass early after a checkpoint.
+    bool run(const QFScrubOptions& options, QFScrubReport& report, const QFScrubCallback& onResult = nullptr);
+    void stop() { stopping = true; }
+
+    bool save();
+    size_t size() const { return entries.size(); }
+    // Seconds until the next file becomes due (0 = something is due now)
+    uint64_t secondsUntilDue(uint64_t intervalSeconds) const;
+
+private:
+    struct Entry {
+        std::string path;
+        QFDigest expected{};
+        int64_t lastVerified = 0;   // unix seconds, 0 = never
+        QFScrubStatus status = QFScrubStatus::Unverified;
+    };
+
+    std::string statePath;
+    std::vector<Entry> entries;
+    std::mutex stateLock;           // entries' lastVerified/status during run()
+    std::atomic<bool> stopping{ false };
+};
+
+const char* qfScrubStatusName(QFScrubStatus status);
+
+#endif // SCRUBBER_H
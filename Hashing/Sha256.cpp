@@ -0,0 +1,204 @@
+#include "Sha256.h"
+#include <cstring>
+
+// The SHA-NI block function is built on every x86 target and picked at
+// run time, so it does not depend on -msha: GCC / Clang compile it through
+// a target attribute, MSVC accepts the intrinsics without any flag.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define QF_HAVE_SHA_NI 1
+#if defined(_MSC_VER)
+#include <intrin.h>     // for __cpuid / __cpuidex
+#else
+#include <cpuid.h>      // for __get_cpuid / __get_cpuid_count
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define QF_TARGET_SHA_NI __attribute__((target("sha,sse4.1,ssse3")))
+#else
+#define QF_TARGET_SHA_NI
+#endif
+#endif
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotr32(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+// --------------------------------------------------------------------
+// Portable compression function
+// --------------------------------------------------------------------
+static void compressPortable(uint32_t h[8], const uint8_t* data, size_t blocks) {
+    uint32_t w[64];
+    while (blocks--) {
+        for (int t = 0; t < 16; t++) {
+            w[t] = (uint32_t(data[4 * t]) << 24) | (uint32_t(data[4 * t + 1]) << 16)
+                | (uint32_t(data[4 * t + 2]) << 8) | uint32_t(data[4 * t + 3]);
+        }
+        for (int t = 16; t < 64; t++) {
+            uint32_t s0 = rotr32(w[t - 15], 7) ^ rotr32(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            uint32_t s1 = rotr32(w[t - 2], 17) ^ rotr32(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+        for (int t = 0; t < 64; t++) {
+            uint32_t t1 = k + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + K[t] + w[t];
+            uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            k = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+        h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+        data += 64;
+    }
+}
+
+#if defined(QF_HAVE_SHA_NI)
+// --------------------------------------------------------------------
+// SHA-NI compression: state kept as ABEF/CDGH, four rounds per step,
+// message schedule extended with sha256msg1/msg2 four words at a time
+// --------------------------------------------------------------------
+QF_TARGET_SHA_NI static void compressShaNi(uint32_t h[8], const uint8_t* data, size_t blocks) {
+    const __m128i BSWAP = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&h[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&h[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);             // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);       // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);    // CDGH
+
+    while (blocks--) {
+        __m128i abefSave = state0;
+        __m128i cdghSave = state1;
+        __m128i msgs[4];
+        for (int i = 0; i < 4; i++) {
+            msgs[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), BSWAP);
+        }
+        for (int i = 0; i < 16; i++) {
+            __m128i msg = _mm_add_epi32(msgs[i & 3], _mm_loadu_si128(reinterpret_cast<const __m128i*>(&K[4 * i])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            if (i < 12) {
+                // W[t..t+3] = msg2(msg1(W[t-16], W[t-12]) + W[t-7..t-4], W[t-4])
+                __m128i next = _mm_sha256msg1_epu32(msgs[i & 3], msgs[(i + 1) & 3]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(msgs[(i + 3) & 3], msgs[(i + 2) & 3], 4));
+                msgs[i & 3] = _mm_sha256msg2_epu32(next, msgs[(i + 3) & 3]);
+            }
+        }
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);          // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);       // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);    // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);       // ABEF
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&h[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&h[4]), state1);
+}
+#endif
+
+// SHA (CPUID.7.0:EBX[29]) plus the SSSE3 / SSE4.1 shuffles and blends
+static bool cpuHasShaNi() {
+#if defined(QF_HAVE_SHA_NI) && defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    bool sse = (regs[2] & (1 << 9)) && (regs[2] & (1 << 19));
+    __cpuidex(regs, 7, 0);
+    return sse && (regs[1] & (1 << 29));
+#elif defined(QF_HAVE_SHA_NI)
+    unsigned a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return false;
+    bool sse = (c & (1u << 9)) && (c & (1u << 19));
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return false;
+    return sse && (b & (1u << 29));
+#else
+    return false;
+#endif
+}
+
+// Function-local so hashing from another file's static initialiser is safe
+static bool useShaNi() {
+    static const bool yes = cpuHasShaNi();
+    return yes;
+}
+
+static void compress(uint32_t h[8], const uint8_t* data, size_t blocks) {
+#if defined(QF_HAVE_SHA_NI)
+    if (useShaNi()) {
+        compressShaNi(h, data, blocks);
+        return;
+    }
+#endif
+    compressPortable(h, data, blocks);
+}
+
+const char* QFSha256::implementation() {
+    return useShaNi() ? "sha-ni" : "portable";
+}
+
+// --------------------------------------------------------------------
+// QFSha256
+// --------------------------------------------------------------------
+void QFSha256::reset() {
+    static const uint32_t IV[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    std::memcpy(h, IV, sizeof(h));
+    blockLen = 0;
+    totalBytes = 0;
+}
+
+void QFSha256::update(const uint8_t* data, size_t len) {
+    totalBytes += len;
+    if (blockLen > 0) {
+        size_t take = (len < 64 - blockLen) ? len : 64 - blockLen;
+        std::memcpy(block + blockLen, data, take);
+        blockLen += take;
+        data += take;
+        len -= take;
+        if (blockLen < 64) return;
+        compress(h, block, 1);
+        blockLen = 0;
+    }
+    if (len >= 64) {
+        compress(h, data, len / 64);
+        data += len & ~size_t(63);
+        len &= 63;
+    }
+    if (len > 0) {
+        std::memcpy(block, data, len);
+        blockLen = len;
+    }
+}
+
+void QFSha256::finalize(QFSha256Digest& out) {
+    uint64_t bits = totalBytes * 8;
+    uint8_t pad[72] = { 0x80 };
+    size_t padLen = (blockLen < 56) ? 56 - blockLen : 120 - blockLen;
+    for (int i = 0; i < 8; i++) {
+        pad[padLen + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+    update(pad, padLen + 8);
+    for (int i = 0; i < 8; i++) {
+        out[4 * i] = static_cast<uint8_t>(h[i] >> 24);
+        out[4 * i + 1] = static_cast<uint8_t>(h[i] >> 16);
+        out[4 * i + 2] = static_cast<uint8_t>(h[i] >> 8);
+        out[4 * i + 3] = static_cast<uint8_t>(h[i]);
+    }
+    reset();
+}
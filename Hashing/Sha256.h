@@ -0,0 +1,35 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// --------------------------------------------------------------------
+// SHA-256 (FIPS 180-4), published alongside the QF digest for
+// compliance.  On x86 the SHA extensions (SHA-NI) are detected with
+// CPUID at start-up, with no compiler flag needed (GCC, Clang or MSVC);
+// other CPUs and older x86 parts use the portable block function.
+// --------------------------------------------------------------------
+
+typedef std::array<uint8_t, 32> QFSha256Digest;
+
+class QFSha256 {
+public:
+    QFSha256() { reset(); }
+
+    void reset();
+    void update(const uint8_t* data, size_t len);
+    void finalize(QFSha256Digest& out);
+
+    // Name of the block function in use on this CPU ("sha-ni" or "portable")
+    static const char* implementation();
+
+private:
+    uint32_t h[8];
+    uint8_t block[64];
+    size_t blockLen = 0;
+    uint64_t totalBytes = 0;
+};
+
+#endif // SHA256_H
@@ -0,0 +1,327 @@
+#include "Sketches.h"
+#include "Performance.h"
+#include "QuantumProtection.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Items per qfHashMany call in the batched paths
+static const size_t SKETCH_BATCH = 1024;
+
+static const uint8_t SKETCH_VERSION = 1;
+
+static uint64_t loadLE64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static uint32_t loadLE32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+// --------------------------------------------------------------------
+// QFHyperLogLog
+//   - 64-bit hash: top p bits pick the register, the rank is the
+//     position of the first 1 in the remaining 64 - p bits.
+// --------------------------------------------------------------------
+QFHyperLogLog::QFHyperLogLog(unsigned precision)
+    : p(std::clamp(precision, MIN_PRECISION, MAX_PRECISION)),
+      registers(size_t(1) << p, 0) {
+}
+
+void QFHyperLogLog::addDigest(const uint8_t* digest) {
+    uint64_t h = loadLE64(digest);
+    size_t index = static_cast<size_t>(h >> (64 - p));
+    uint64_t rest = h << p;
+    uint8_t rank = static_cast<uint8_t>(rest == 0 ? (64 - p + 1) : (std::countl_zero(rest) + 1));
+    if (rank > registers[index]) registers[index] = rank;
+}
+
+void QFHyperLogLog::add(const uint8_t* data, size_t len) {
+    uint8_t digest[8];
+    qfHashShort(data, len, digest, sizeof(digest));
+    addDigest(digest);
+}
+
+void QFHyperLogLog::addMany(const uint8_t* const* items, const size_t* lengths, size_t count) {
+    uint8_t digests[SKETCH_BATCH * 8];
+    for (size_t first = 0; first < count; first += SKETCH_BATCH) {
+        size_t n = std::min(SKETCH_BATCH, count - first);
+        qfHashMany(items + first, lengths + first, n, digests, 8);
+        for (size_t i = 0; i < n; i++) addDigest(digests + 8 * i);
+    }
+}
+
+double QFHyperLogLog::estimate() const {
+    const double m = static_cast<double>(registers.size());
+    double alpha;
+    if (registers.size() == 16) alpha = 0.673;
+    else if (registers.size() == 32) alpha = 0.697;
+    else if (registers.size() == 64) alpha = 0.709;
+    else alpha = 0.7213 / (1.0 + 1.079 / m);
+
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t r : registers) {
+        sum += std::ldexp(1.0, -static_cast<int>(r));
+        if (r == 0) zeros++;
+    }
+    double e = alpha * m * m / sum;
+
+    // Small-range correction (linear counting); a 64-bit hash needs no
+    // large-range correction at any realistic cardinality
+    if (e <= 2.5 * m && zeros > 0) {
+        e = m * std::log(m / static_cast<double>(zeros));
+    }
+    return e;
+}
+
+void QFHyperLogLog::clear() {
+    std::fill(registers.begin(), registers.end(), uint8_t(0));
+}
+
+bool QFHyperLogLog::merge(const QFHyperLogLog& other) {
+    if (other.p != p) {
+        std::cerr << "[QFHyperLogLog] Cannot merge precision " << other.p << " into " << p << "\n";
+        return false;
+    }
+    uint8_t* dst = registers.data();
+    const uint8_t* src = other.registers.data();
+    size_t n = registers.size();
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_max_epu8(a, b));
+    }
+#endif
+    for (; i < n; i++) dst[i] = std::max(dst[i], src[i]);
+    return true;
+}
+
+// "QFHL" | version | p | registers packed 6 bits each (ranks are <= 61)
+void QFHyperLogLog::serialize(std::vector<uint8_t>& out) const {
+    out.clear();
+    out.insert(out.end(), { 'Q', 'F', 'H', 'L', SKETCH_VERSION, static_cast<uint8_t>(p) });
+    uint32_t acc = 0;
+    unsigned bits = 0;
+    for (uint8_t r : registers) {
+        acc |= uint32_t(r & 0x3F) << bits;
+        bits += 6;
+        while (bits >= 8) {
+            out.push_back(static_cast<uint8_t>(acc));
+            acc >>= 8;
+            bits -= 8;
+        }
+    }
+    if (bits > 0) out.push_back(static_cast<uint8_t>(acc));
+}
+
+bool QFHyperLogLog::deserialize(const uint8_t* data, size_t len) {
+    if (len < 6 || std::memcmp(data, "QFHL", 4) != 0 || data[4] != SKETCH_VERSION
+        || data[5] < MIN_PRECISION || data[5] > MAX_PRECISION) {
+        std::cerr << "[QFHyperLogLog] Not a serialized HyperLogLog sketch\n";
+        return false;
+    }
+    unsigned precision = data[5];
+    size_t m = size_t(1) << precision;
+    if (len != 6 + (m * 6 + 7) / 8) {
+        std::cerr << "[QFHyperLogLog] Truncated sketch (" << len << " bytes)\n";
+        return false;
+    }
+    p = precision;
+    registers.assign(m, 0);
+    const uint8_t* in = data + 6;
+    uint32_t acc = 0;
+    unsigned bits = 0;
+    for (size_t i = 0; i < m; i++) {
+        while (bits < 6) {
+            acc |= uint32_t(*in++) << bits;
+            bits += 8;
+        }
+        registers[i] = static_cast<uint8_t>(acc & 0x3F);
+        acc >>= 6;
+        bits -= 6;
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// QFCountMin
+//   - Row r's column comes from digest bytes [8 + 4r, 12 + 4r), scaled
+//     into [0, width) with a multiply-shift, so one squeeze covers every
+//     row (and leaves the first 8 bytes to a HyperLogLog).
+// --------------------------------------------------------------------
+QFCountMin::QFCountMin(uint32_t width, unsigned depth)
+    : w(std::max<uint32_t>(width, 1)),
+      d(std::clamp(depth, 1u, MAX_DEPTH)),
+      itemsTotal(0),
+      counters(size_t(w) * d, 0) {
+}
+
+QFCountMin QFCountMin::forError(double epsilon, double delta) {
+    double width = std::ceil(std::exp(1.0) / std::max(epsilon, 1e-9));
+    double depth = std::ceil(std::log(1.0 / std::clamp(delta, 1e-9, 0.5)));
+    return QFCountMin(static_cast<uint32_t>(std::min(width, 4294967295.0)), static_cast<unsigned>(depth));
+}
+
+size_t QFCountMin::column(const uint8_t* digest, unsigned row) const {
+    uint64_t h = loadLE32(digest + 8 + 4 * row);
+    return size_t(row) * w + static_cast<size_t>((h * w) >> 32);
+}
+
+void QFCountMin::addDigest(const uint8_t* digest, uint64_t count) {
+    for (unsigned r = 0; r < d; r++) counters[column(digest, r)] += count;
+    itemsTotal += count;
+}
+
+void QFCountMin::add(const uint8_t* data, size_t len, uint64_t count) {
+    uint8_t digest[8 + MAX_DEPTH * 4];
+    qfHashShort(data, len, digest, digestBytes());
+    addDigest(digest, count);
+}
+
+void QFCountMin::addMany(const uint8_t* const* items, const size_t* lengths, size_t count) {
+    const size_t digestLen = digestBytes();
+    std::vector<uint8_t> digests(SKETCH_BATCH * digestLen);
+    for (size_t first = 0; first < count; first += SKETCH_BATCH) {
+        size_t n = std::min(SKETCH_BATCH, count - first);
+        qfHashMany(items + first, lengths + first, n, digests.data(), digestLen);
+        for (size_t i = 0; i < n; i++) {
+            addDigest(digests.data() + i * digestLen);
+        }
+    }
+}
+
+uint64_t QFCountMin::estimate(const uint8_t* data, size_t len) const {
+    uint8_t digest[8 + MAX_DEPTH * 4];
+    qfHashShort(data, len, digest, digestBytes());
+    uint64_t best = UINT64_MAX;
+    for (unsigned r = 0; r < d; r++) best = std::min(best, counters[column(digest, r)]);
+    return best;
+}
+
+void QFCountMin::estimateMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+    uint64_t* estimates) const {
+    const size_t digestLen = digestBytes();
+    std::vector<uint8_t> digests(SKETCH_BATCH * digestLen);
+    for (size_t first = 0; first < count; first += SKETCH_BATCH) {
+        size_t n = std::min(SKETCH_BATCH, count - first);
+        qfHashMany(items + first, lengths + first, n, digests.data(), digestLen);
+        for (size_t i = 0; i < n; i++) {
+            const uint8_t* digest = digests.data() + i * digestLen;
+            uint64_t best = UINT64_MAX;
+            for (unsigned r = 0; r < d; r++) best = std::min(best, counters[column(digest, r)]);
+            estimates[first + i] = best;
+        }
+    }
+}
+
+void QFCountMin::clear() {
+    std::fill(counters.begin(), counters.end(), uint64_t(0));
+    itemsTotal = 0;
+}
+
+bool QFCountMin::merge(const QFCountMin& other) {
+    if (other.w != w || other.d != d) {
+        std::cerr << "[QFCountMin] Cannot merge " << other.w << "x" << other.d
+            << " into " << w << "x" << d << "\n";
+        return false;
+    }
+    uint64_t* dst = counters.data();
+    const uint64_t* src = other.counters.data();
+    size_t n = counters.size();
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_add_epi64(a, b));
+    }
+#endif
+    for (; i < n; i++) dst[i] += src[i];
+    itemsTotal += other.itemsTotal;
+    return true;
+}
+
+// "QFCM" | version | depth | width (LE32) | total (varint) | counters (varints)
+void QFCountMin::serialize(std::vector<uint8_t>& out) const {
+    out.clear();
+    out.insert(out.end(), { 'Q', 'F', 'C', 'M', SKETCH_VERSION, static_cast<uint8_t>(d) });
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(w >> (8 * i)));
+    putVarint(out, itemsTotal);
+    for (uint64_t c : counters) putVarint(out, c);
+}
+
+bool QFCountMin::deserialize(const uint8_t* data, size_t len) {
+    if (len < 10 || std::memcmp(data, "QFCM", 4) != 0 || data[4] != SKETCH_VERSION
+        || data[5] < 1 || data[5] > MAX_DEPTH) {
+        std::cerr << "[QFCountMin] Not a serialized Count-Min sketch\n";
+        return false;
+    }
+    uint32_t width = loadLE32(data + 6);
+    unsigned depth = data[5];
+    // Every counter takes at least one varint byte
+    if (width == 0 || uint64_t(width) * depth > len - 10) {
+        std::cerr << "[QFCountMin] Sketch dimensions do not match its size\n";
+        return false;
+    }
+    const uint8_t* p = data + 10;
+    const uint8_t* end = data + len;
+    uint64_t total;
+    std::vector<uint64_t> values(size_t(width) * depth);
+    bool ok = getVarint(p, end, total);
+    for (size_t i = 0; ok && i < values.size(); i++) ok = getVarint(p, end, values[i]);
+    if (!ok || p != end) {
+        std::cerr << "[QFCountMin] Truncated or malformed sketch\n";
+        return false;
+    }
+    w = width;
+    d = depth;
+    itemsTotal = total;
+    counters.swap(values);
+    return true;
+}
+
+// --------------------------------------------------------------------
+// qfSketchAddMany
+// --------------------------------------------------------------------
+void qfSketchAddMany(QFHyperLogLog& hll, QFCountMin& cm,
+    const uint8_t* const* items, const size_t* lengths, size_t count) {
+    const size_t digestLen = cm.digestBytes();
+    std::vector<uint8_t> digests(SKETCH_BATCH * digestLen);
+    for (size_t first = 0; first < count; first += SKETCH_BATCH) {
+        size_t n = std::min(SKETCH_BATCH, count - first);
+        qfHashMany(items + first, lengths + first, n, digests.data(), digestLen);
+        for (size_t i = 0; i < n; i++) {
+            hll.addDigest(digests.data() + i * digestLen);
+            cm.addDigest(digests.data() + i * digestLen);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef SKETCHES_H
+#define SKETCHES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------------------
+// Probabilistic sketches keyed by QF
+//   - One QF evaluation per item supplies every index the sketch needs
+//     (register + rank for HyperLogLog, all row columns for Count-Min);
+//     the *Many calls batch items through qfHashMany's four lanes.
+//   - Sketches with the same parameters merge (per-thread sketches ->
+//     one result) with AVX2 max / add when available.
+//   - Digest layout (one evaluation can feed both sketches):
+//     bytes [0, 8) -> HLL, bytes [8 + 4r, 12 + 4r) -> Count-Min row r.
+//     qfSketchAddMany() fills an HLL and a Count-Min from one squeeze.
+//   - serialize()/deserialize() use a small versioned binary format:
+//     HLL registers packed 6 bits each, Count-Min counters as varints.
+// --------------------------------------------------------------------
+
+class QFHyperLogLog {
+public:
+    static const unsigned MIN_PRECISION = 4;
+    static const unsigned MAX_PRECISION = 18;
+
+    // 2^precision registers; standard error ~ 1.04 / sqrt(2^precision)
+    explicit QFHyperLogLog(unsigned precision = 14);
+
+    void add(const uint8_t* data, size_t len);
+    void add(const std::string& s) { add(reinterpret_cast<const uint8_t*>(s.data()), s.size()); }
+    void addMany(const uint8_t* const* items, const size_t* lengths, size_t count);
+    void addDigest(const uint8_t* digest); // first 8 bytes of the layout above
+
+    double estimate() const;
+    void clear();
+
+    // False (after logging) if the precisions differ
+    bool merge(const QFHyperLogLog& other);
+
+    unsigned precision() const { return p; }
+    size_t registerCount() const { return registers.size(); }
+
+    void serialize(std::vector<uint8_t>& out) const;
+    bool deserialize(const uint8_t* data, size_t len);
+
+private:
+
+    unsigned p;
+    std::vector<uint8_t> registers;
+};
+
+class QFCountMin {
+public:
+    static const unsigned MAX_DEPTH = 30; // 8 + 30 x 4 bytes = one 128-byte squeeze
+
+    QFCountMin(uint32_t width, unsigned depth);
+
+    // Width/depth for "overestimate <= epsilon * total with probability 1 - delta"
+    static QFCountMin forError(double epsilon, double delta);
+
+    void add(const uint8_t* data, size_t len, uint64_t count = 1);
+    void add(const std::string& s, uint64_t count = 1) {
+        add(reinterpret_cast<const uint8_t*>(s.data()), s.size(), count);
+    }
+    void addMany(const uint8_t* const* items, const size_t* lengths, size_t count);
+    void addDigest(const uint8_t* digest, uint64_t count = 1);
+    size_t digestBytes() const { return 8 + 4 * size_t(d); }
+
+    uint64_t estimate(const uint8_t* data, size_t len) const;
+    uint64_t estimate(const std::string& s) const {
+        return estimate(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+    void estimateMany(const uint8_t* const* items, const size_t* lengths, size_t count,
+        uint64_t* estimates) const;
+
+    void clear();
+
+    // False (after logging) if width or depth differ
+    bool merge(const QFCountMin& other);
+
+    uint32_t width() const { return w; }
+    unsigned depth() const { return d; }
+    uint64_t total() const { return itemsTotal; }
+
+    void serialize(std::vector<uint8_t>& out) const;
+    bool deserialize(const uint8_t* data, size_t len);
+
+private:
+    size_t column(const uint8_t* digest, unsigned row) const;
+
+    uint32_t w;
+    unsigned d;
+    uint64_t itemsTotal;
+    std::vector<uint64_t> counters; // d rows of w counters
+};
+
+// Hash every item once (8 + 4 * cm.depth() bytes) and add it to both
+void qfSketchAddMany(QFHyperLogLog& hll, QFCountMin& cm,
+    const uint8_t* const* items, const size_t* lengths, size_t count);
+
+#endif // SKETCHES_H
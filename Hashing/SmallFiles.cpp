@@ -0,0 +1,353 @@
+#include "SmallFiles.h"
+#include "BufferArena.h"
+#include "FileIO.h"
+#include "IoUring.h"
+#include "Performance.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#if defined(QF_HAVE_IO_URING)
+#include <fcntl.h>
+#endif
+
+// Uncomment to enable debug prints
+// #define SMALL_DEBUG
+
+#ifdef SMALL_DEBUG
+#define SMALL_LOG(msg) std::cerr << "[SmallFiles] " << msg << "\n"
+#else
+#define SMALL_LOG(msg) /* no-op */
+#endif
+
+namespace {
+
+// Per-file outcome of the read phase (SLOT_SHORT: read so far, no EOF yet)
+enum SlotState : uint8_t { SLOT_DATA, SLOT_LARGE, SLOT_FAILED, SLOT_SHORT };
+
+// Shared by all tasks.  `good` is per-file bytes rather than the caller's
+// vector<bool>, whose packed bits cannot be written from several threads.
+struct Results {
+    std::vector<QFDigest>& digests;
+    std::vector<uint8_t> good;
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<uint64_t> largeFiles{ 0 };
+    std::atomic<uint64_t> failures{ 0 };
+};
+
+// Slot size: room for maxFileSize plus at least one more byte, page-aligned
+size_t slotBytesFor(size_t maxFileSize) {
+    return ((maxFileSize + 4096) / 4096) * 4096;
+}
+
+size_t uringBatchFor(const QFSmallFilesOptions& options) {
+    return std::max<size_t>(std::min<size_t>(options.batchFiles, 4096), 1);
+}
+
+// The caller's arena when its slabs are big enough, else one sized to
+// this call (held by `local`)
+QFBufferArena& slabArena(const QFSmallFilesOptions& options, size_t slabBytes, size_t slabs,
+    std::unique_ptr<QFBufferArena>& local) {
+    if (options.arena && options.arena->bufferSize() >= slabBytes) return *options.arena;
+    local.reset(new QFBufferArena(slabBytes, slabs));
+    return *local;
+}
+
+// --------------------------------------------------------------------
+// Hash files [first, first+count) whose contents sit in consecutive
+// slots of `slab`.  Large files are re-read through digestFile().
+// --------------------------------------------------------------------
+void hashGroup(const std::vector<std::string>& files, size_t first, size_t count,
+    const uint8_t* slab, size_t slotBytes, const size_t* lengths, const SlotState* states,
+    Results& results) {
+    std::vector<const uint8_t*> msgs;
+    std::vector<size_t> lens;
+    std::vector<size_t> owners;
+    msgs.reserve(count);
+    lens.reserve(count);
+    owners.reserve(count);
+
+    for (size_t k = 0; k < count; k++) {
+        size_t idx = first + k;
+        if (states[k] == SLOT_DATA) {
+            msgs.push_back(slab + k * slotBytes);
+            lens.push_back(lengths[k]);
+            owners.push_back(idx);
+        }
+        else if (states[k] == SLOT_LARGE) {
+            results.largeFiles++;
+            results.good[idx] = digestFile(files[idx], results.digests[idx]) ? 1 : 0;
+            if (!results.good[idx]) results.failures++;
+        }
+        else {
+            results.failures++;
+        }
+    }
+    if (msgs.empty()) return;
+
+    std::vector<uint8_t> out(msgs.size() * QF_DIGEST_BYTES);
+    qfHashMany(msgs.data(), lens.data(), msgs.size(), out.data(), QF_DIGEST_BYTES);
+    uint64_t bytes = 0;
+    for (size_t m = 0; m < msgs.size(); m++) {
+        std::memcpy(results.digests[owners[m]].data(), out.data() + m * QF_DIGEST_BYTES, QF_DIGEST_BYTES);
+        results.good[owners[m]] = 1;
+        bytes += lens[m];
+    }
+    results.bytes += bytes;
+}
+
+// Classify one read result
+SlotState classify(long n, size_t slotBytes, size_t maxFileSize) {
+    if (n < 0) return SLOT_FAILED;
+    if (static_cast<size_t>(n) > maxFileSize || static_cast<size_t>(n) == slotBytes) return SLOT_LARGE;
+    return SLOT_DATA;
+}
+
+// --------------------------------------------------------------------
+// Thread-pool backend: one task = open/read/close + hash for a group
+// --------------------------------------------------------------------
+void runThreadPool(const std::vector<std::string>& files, const QFSmallFilesOptions& options,
+    Results& results) {
+    QFScheduler& scheduler = qfScheduler();
+    const size_t slotBytes = slotBytesFor(options.maxFileSize);
+    const size_t group = std::min<size_t>(std::max<size_t>(options.groupFiles, 1), files.size());
+    if (group == 0) return;
+    size_t groups = (files.size() + group - 1) / group;
+    std::unique_ptr<QFBufferArena> local;
+    QFBufferArena& arena = slabArena(options, slotBytes * group,
+        std::min<size_t>(scheduler.workerCount() + 1, groups), local);
+
+    scheduler.parallelFor(groups, [&](size_t g) {
+        size_t first = g * group;
+        size_t count = std::min(group, files.size() - first);
+        QFArenaLease slab(arena);
+        std::vector<size_t> lengths(count, 0);
+        std::vector<SlotState> states(count, SLOT_FAILED);
+
+        for (size_t k = 0; k < count; k++) {
+            int fd = qfOpenRead(files[first + k]);
+            if (fd < 0) {
+                std::cerr << "[hashSmallFiles] Failed to open file: " << files[first + k] << "\n";
+                continue;
+            }
+            // A short read is not EOF: keep reading until 0 or a full slot
+            long n = qfReadFull(fd, slab.data() + k * slotBytes, slotBytes, 0);
+            qfClose(fd);
+            states[k] = classify(n, slotBytes, options.maxFileSize);
+            if (states[k] == SLOT_FAILED) {
+                std::cerr << "[hashSmallFiles] Read error on " << files[first + k] << ": "
+                    << std::strerror(static_cast<int>(-n)) << "\n";
+            }
+            lengths[k] = (n > 0) ? static_cast<size_t>(n) : 0;
+        }
+        hashGroup(files, first, count, slab.data(), slotBytes, lengths.data(), states.data(), results);
+    });
+}
+
+#if defined(QF_HAVE_IO_URING)
+// --------------------------------------------------------------------
+// io_uring backend
+//   Per batch: [close previous batch + openat this batch] in one submit,
+//   then [read every opened file] in a second.  Two io_uring_enter calls
+//   per batch instead of 3 syscalls per file.  Hashing of batch k runs on
+//   the scheduler while batch k+1 is being read into the other slab.
+//
+//   The operations are not IOSQE_IO_LINK-ed: a linked read would need the
+//   descriptor produced by its openat, which requires direct (fixed)
+//   descriptors; two submits per batch get nearly the same syscall count.
+// --------------------------------------------------------------------
+enum : uint64_t { OP_OPEN = 1, OP_READ = 2, OP_CLOSE = 3 };
+
+uint64_t tag(uint64_t op, size_t index) {
+    return (op << 32) | static_cast<uint64_t>(index);
+}
+
+bool runUring(const std::vector<std::string>& files, const QFSmallFilesOptions& options,
+    Results& results) {
+    const size_t batch = std::min(uringBatchFor(options), files.size());
+    if (batch == 0) return true;
+    QFUring ring;
+    // Room for a batch of closes plus a batch of opens in one submit
+    if (!ring.init(static_cast<unsigned>(2 * batch))) return false;
+
+    QFScheduler& scheduler = qfScheduler();
+    const size_t slotBytes = slotBytesFor(options.maxFileSize);
+    const size_t group = std::max<size_t>(options.groupFiles, 1);
+    std::unique_ptr<QFBufferArena> local;
+    QFBufferArena& arena = slabArena(options, slotBytes * batch, 2, local);
+    QFArenaLease slab0(arena), slab1(arena);
+    uint8_t* slabs[2] = { slab0.data(), slab1.data() };
+
+    std::vector<int> fds[2] = { std::vector<int>(batch, -1), std::vector<int>(batch, -1) };
+    std::vector<size_t> lengths[2] = { std::vector<size_t>(batch, 0), std::vector<size_t>(batch, 0) };
+    std::vector<SlotState> states[2] = { std::vector<SlotState>(batch, SLOT_FAILED),
+        std::vector<SlotState>(batch, SLOT_FAILED) };
+    std::unique_ptr<QFTaskGroup> hashing;
+    size_t toClose = 0;       // fds of the previous batch still open
+    int closeSide = 0;
+
+    // Submit everything queued and wait until `expected` completions for
+    // batch `side` (whose first file is `first`) have been handled; false
+    // if the ring failed first
+    auto complete = [&](size_t expected, int side, size_t first) {
+        auto onCompletion = [&](uint64_t id, int res) {
+            uint64_t op = id >> 32;
+            size_t k = static_cast<size_t>(id & 0xFFFFFFFFu);
+            if (op == OP_OPEN) {
+                fds[side][k] = res;
+            }
+            else if (op == OP_READ) {
+                if (res < 0) {
+                    states[side][k] = SLOT_FAILED;
+                    std::cerr << "[hashSmallFiles] Read error on " << files[first + k] << ": "
+                        << std::strerror(-res) << "\n";
+                    return;
+                }
+                lengths[side][k] += static_cast<size_t>(res);
+                states[side][k] = (res == 0 || lengths[side][k] == slotBytes)
+                    ? classify(static_cast<long>(lengths[side][k]), slotBytes, options.maxFileSize)
+                    : SLOT_SHORT;
+            }
+        };
+        size_t handled = 0;
+        while (handled < expected) {
+            if (ring.submit(1) < 0) break;
+            handled += ring.drain(onCompletion);
+        }
+        return handled >= expected;
+    };
+
+    for (size_t first = 0, b = 0; first < files.size(); first += batch, b++) {
+        const int side = static_cast<int>(b & 1);
+        const size_t count = std::min(batch, files.size() - first);
+        uint8_t* slab = slabs[side];
+
+        // Phase 1: close the previous batch and open this one
+        size_t queued = 0;
+        for (size_t k = 0; k < toClose; k++) {
+            if (fds[closeSide][k] >= 0) {
+                ring.prepClose(fds[closeSide][k], tag(OP_CLOSE, k));
+                queued++;
+            }
+        }
+        for (size_t k = 0; k < count; k++) {
+            fds[side][k] = -1;
+            ring.prepOpenAt(AT_FDCWD, files[first + k].c_str(), O_RDONLY | O_CLOEXEC, tag(OP_OPEN, k));
+            queued++;
+        }
+        complete(queued, side, first);
+
+        // Phase 2: read every file into its slot.  A read may stop short
+        // of EOF, so files keep reading (one more round for the batch,
+        // usually just confirming EOF) until a read returns 0 or fills
+        // the slot.
+        std::vector<size_t> reading;
+        reading.reserve(count);
+        for (size_t k = 0; k < count; k++) {
+            states[side][k] = SLOT_FAILED;
+            lengths[side][k] = 0;
+            if (fds[side][k] < 0) {
+                // openat unsupported (pre-5.6) or a real error: retry the
+                // plain way so only genuine failures are reported
+                fds[side][k] = qfOpenRead(files[first + k]);
+                if (fds[side][k] < 0) {
+                    std::cerr << "[hashSmallFiles] Failed to open file: " << files[first + k] << "\n";
+                    continue;
+                }
+            }
+            reading.push_back(k);
+        }
+        while (!reading.empty()) {
+            for (size_t k : reading) {
+                size_t got = lengths[side][k];
+                ring.prepRead(fds[side][k], slab + k * slotBytes + got, slotBytes - got,
+                    static_cast<int64_t>(got), tag(OP_READ, k));
+            }
+            if (!complete(reading.size(), side, first)) {
+                for (size_t k : reading) {
+                    if (states[side][k] == SLOT_SHORT) states[side][k] = SLOT_FAILED;
+                }
+                break;
+            }
+            reading.erase(std::remove_if(reading.begin(), reading.end(),
+                [&](size_t k) { return states[side][k] != SLOT_SHORT; }), reading.end());
+        }
+        toClose = count;
+        closeSide = side;
+
+        // Batch b-1 must finish hashing before its slab is reused by b+1
+        if (hashing) hashing->wait();
+        hashing.reset(new QFTaskGroup(scheduler));
+        for (size_t g = 0; g < count; g += group) {
+            size_t n = std::min(group, count - g);
+            hashing->run([&, side, first, g, n, slab]() {
+                hashGroup(files, first + g, n, slab + g * slotBytes, slotBytes,
+                    lengths[side].data() + g, states[side].data() + g, results);
+            });
+        }
+        SMALL_LOG("batch " << b << ": " << count << " files");
+    }
+
+    size_t queued = 0;
+    for (size_t k = 0; k < toClose; k++) {
+        if (fds[closeSide][k] >= 0) {
+            ring.prepClose(fds[closeSide][k], tag(OP_CLOSE, k));
+            queued++;
+        }
+    }
+    complete(queued, closeSide, 0);
+    if (hashing) hashing->wait();
+    return true;
+}
+#endif // QF_HAVE_IO_URING
+
+} // namespace
+
+// --------------------------------------------------------------------
+// hashSmallFiles
+// --------------------------------------------------------------------
+void hashSmallFiles(const std::vector<std::string>& files, std::vector<QFDigest>& digests,
+    std::vector<bool>& ok, QFSmallFilesReport& report, const QFSmallFilesOptions& options) {
+    report = QFSmallFilesReport();
+    digests.assign(files.size(), QFDigest());
+    Results results{ digests, std::vector<uint8_t>(files.size(), 0) };
+
+    auto start = std::chrono::steady_clock::now();
+    bool done = false;
+#if defined(QF_HAVE_IO_URING)
+    if (options.backend != QFSmallFilesBackend::ThreadPool) {
+        done = runUring(files, options, results);
+        if (done) report.backend = "io_uring";
+    }
+#endif
+    if (!done) {
+        runThreadPool(files, options, results);
+        report.backend = "thread pool";
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.files = files.size();
+    report.bytes = results.bytes.load();
+    report.largeFiles = results.largeFiles.load();
+    report.failures = results.failures.load();
+    ok.assign(results.good.begin(), results.good.end());
+}
+
+std::unique_ptr<QFBufferArena> newSmallFilesArena(const QFSmallFilesOptions& options) {
+    const size_t slots = std::max<size_t>(uringBatchFor(options), options.groupFiles);
+    // Not prefaulted: a small flush only touches the first slots of a slab
+    return std::unique_ptr<QFBufferArena>(new QFBufferArena(slotBytesFor(options.maxFileSize) * slots,
+        qfScheduler().workerCount() + 1, false));
+}
+
+void printSmallFilesReport(const QFSmallFilesReport& report, std::ostream& os) {
+    os << "[SmallFiles] backend = " << report.backend << ", files = " << report.files
+        << ", bytes = " << report.bytes << ", large = " << report.largeFiles
+        << ", failed = " << report.failures << "\n";
+    os << "[SmallFiles] " << report.seconds << " s, "
+        << static_cast<uint64_t>(report.filesPerSecond()) << " files/s\n";
+}
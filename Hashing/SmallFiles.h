@@ -0,0 +1,62 @@
+#ifndef SMALL_FILES_H
+#define SMALL_FILES_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include "UniversalData.h"
+
+class QFBufferArena;
+
+// --------------------------------------------------------------------
+// Many-small-files mode
+//   - For trees of millions of 1-16 KiB files, where per-file syscalls
+//     cost more than hashing.  Each file is read into a slot of a pooled
+//     slab until a read returns 0 (slot > maxFileSize, so a full slot
+//     means "too big" without a separate stat call).
+//   - io_uring backend: openat / read / close are queued for a whole
+//     batch and submitted together; the next batch's I/O overlaps the
+//     current batch's hashing.
+//   - Thread-pool backend: scheduler tasks open/read/close a group of
+//     files each (non-Linux, or when io_uring is unavailable).
+//   - Either way the slot contents go to qfHashMany(), four messages per
+//     permutation.  Digests equal digestFile().
+// --------------------------------------------------------------------
+
+enum class QFSmallFilesBackend { Auto, Uring, ThreadPool };
+
+struct QFSmallFilesOptions {
+    QFSmallFilesBackend backend = QFSmallFilesBackend::Auto;
+    size_t maxFileSize = 64 << 10;  // larger files fall back to digestFile()
+    size_t batchFiles = 256;        // files per io_uring submission batch
+    size_t groupFiles = 32;         // files per hashing / thread-pool task
+    QFBufferArena* arena = nullptr; // slab pool reused across calls (see
+                                    // newSmallFilesArena); nullptr = one
+                                    // sized to each call's batch
+};
+
+struct QFSmallFilesReport {
+    const char* backend = "";
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    uint64_t largeFiles = 0;        // went through digestFile()
+    uint64_t failures = 0;
+    double seconds = 0.0;
+
+    double filesPerSecond() const { return seconds > 0.0 ? files / seconds : 0.0; }
+};
+
+void printSmallFilesReport(const QFSmallFilesReport& report, std::ostream& os);
+
+// Slab pool for callers that hash repeatedly (e.g. a watcher flushing a
+// few files at a time); set it as options.arena for those calls
+std::unique_ptr<QFBufferArena> newSmallFilesArena(const QFSmallFilesOptions& options = QFSmallFilesOptions());
+
+// digests/ok are resized to files.size()
+void hashSmallFiles(const std::vector<std::string>& files, std::vector<QFDigest>& digests,
+    std::vector<bool>& ok, QFSmallFilesReport& report,
+    const QFSmallFilesOptions& options = QFSmallFilesOptions());
+
+#endif // SMALL_FILES_H
@@ -0,0 +1,370 @@
+#include "TaskScheduler.h"
+#include "Numa.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#endif
+
+// Uncomment to enable debug prints
+// #define SCHED_DEBUG
+
+#ifdef SCHED_DEBUG
+#define SCHED_LOG(msg) std::cerr << "[TaskScheduler] " << msg << "\n"
+#else
+#define SCHED_LOG(msg) /* no-op */
+#endif
+
+// --------------------------------------------------------------------
+// Per-worker state: one deque per priority, guarded by a short lock
+// --------------------------------------------------------------------
+struct QFScheduler::Worker {
+    std::mutex lock;
+    std::deque<std::function<void()>> queues[2];
+    std::thread thread;
+};
+
+struct QFScheduler::Sleep {
+    std::mutex lock;
+    std::condition_variable wake;
+};
+
+// Which scheduler/worker the current thread belongs to
+static thread_local const QFScheduler* tlsScheduler = nullptr;
+static thread_local int tlsWorker = -1;
+
+// --------------------------------------------------------------------
+// Pin the calling thread to one CPU (best effort)
+// --------------------------------------------------------------------
+static void pinCurrentThread(unsigned cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % CPU_SETSIZE, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        SCHED_LOG("pinning to CPU " << cpu << " failed");
+    }
+#elif defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << (cpu % (sizeof(DWORD_PTR) * 8)));
+#else
+    (void)cpu;
+#endif
+}
+
+// --------------------------------------------------------------------
+// QFScheduler
+// --------------------------------------------------------------------
+QFScheduler::QFScheduler(unsigned threads, bool pinWorkers) : sleep(new Sleep()) {
+    if (threads == 0) threads = qfDefaultThreadCount();
+    threads = std::min(threads, QF_MAX_THREADS);
+
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back(new Worker());
+    }
+
+    // Placement: with pinning on a multi-node host, deal workers out node
+    // by node (w0 -> node0, w1 -> node1, ...) so every node gets a share
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> workerCpus(threads);
+    workerNodes.assign(threads, 0);
+    const QFNumaTopology& topo = qfNumaTopology();
+    std::vector<unsigned> populated;
+    for (unsigned n = 0; n < topo.nodeCount(); n++) {
+        if (!topo.nodeCpus[n].empty()) populated.push_back(n);
+    }
+    bool perNode = pinWorkers && topo.multiNode();
+    for (unsigned i = 0; i < threads; i++) {
+        if (perNode) {
+            unsigned node = populated[i % populated.size()];
+            const std::vector<unsigned>& nodeCpus = topo.nodeCpus[node];
+            workerNodes[i] = static_cast<int>(node);
+            workerCpus[i] = nodeCpus[(i / populated.size()) % nodeCpus.size()];
+        }
+        else {
+            workerCpus[i] = i % cpus;
+        }
+    }
+
+    for (unsigned i = 0; i < threads; i++) {
+        unsigned cpu = workerCpus[i];
+        workers[i]->thread = std::thread([this, i, pinWorkers, cpu]() {
+            if (pinWorkers) pinCurrentThread(cpu);
+            workerLoop(i);
+        });
+    }
+    SCHED_LOG("started " << threads << " worker(s)");
+}
+
+QFScheduler::~QFScheduler() {
+    {
+        std::lock_guard<std::mutex> guard(sleep->lock);
+        stopping.store(true);
+    }
+    sleep->wake.notify_all();
+    for (auto& w : workers) {
+        if (w->thread.joinable()) w->thread.join();
+    }
+}
+
+int QFScheduler::currentWorker() const {
+    return (tlsScheduler == this) ? tlsWorker : -1;
+}
+
+void QFScheduler::submit(std::function<void()> fn, QFTaskPriority priority, int affinityHint) {
+    unsigned n = workerCount();
+    unsigned target;
+    if (affinityHint >= 0) {
+        target = static_cast<unsigned>(affinityHint) % n;
+    }
+    else if (currentWorker() >= 0) {
+        target = static_cast<unsigned>(currentWorker());
+    }
+    else {
+        target = nextWorker.fetch_add(1, std::memory_order_relaxed) % n;
+    }
+
+    Worker& w = *workers[target];
+    {
+        std::lock_guard<std::mutex> guard(w.lock);
+        w.queues[static_cast<int>(priority)].push_back(std::move(fn));
+    }
+    queued.fetch_add(1, std::memory_order_release);
+
+    // Take the sleep lock so a worker between "nothing queued" and wait()
+    // cannot miss this notification
+    {
+        std::lock_guard<std::mutex> guard(sleep->lock);
+    }
+    sleep->wake.notify_one();
+}
+
+// --------------------------------------------------------------------
+// findTask
+//   - Interactive before bulk; own deque (newest first) before stealing
+//     (oldest first), starting from the neighbour to spread contention.
+//   - Workers steal from their own NUMA node first.
+// --------------------------------------------------------------------
+bool QFScheduler::findTask(int self, std::function<void()>& out) {
+    if (queued.load(std::memory_order_acquire) == 0) return false;
+
+    unsigned n = workerCount();
+    unsigned start = (self >= 0) ? static_cast<unsigned>(self)
+                                 : nextWorker.load(std::memory_order_relaxed) % n;
+    for (int prio = 0; prio < 2; prio++) {
+        if (self >= 0) {
+            Worker& own = *workers[self];
+            std::lock_guard<std::mutex> guard(own.lock);
+            std::deque<std::function<void()>>& q = own.queues[prio];
+            if (!q.empty()) {
+                out = std::move(q.back());
+                q.pop_back();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        // pass 0: same node only, pass 1: everyone else
+        for (int pass = 0; pass < 2; pass++) {
+            for (unsigned k = (self >= 0) ? 1 : 0; k < n; k++) {
+                unsigned v = (start + k) % n;
+                bool sameNode = (self < 0) || workerNodes[v] == workerNodes[self];
+                if (sameNode != (pass == 0)) continue;
+
+                Worker& victim = *workers[v];
+                std::unique_lock<std::mutex> guard(victim.lock, std::try_to_lock);
+                if (!guard.owns_lock()) continue;
+                std::deque<std::function<void()>>& q = victim.queues[prio];
+                if (!q.empty()) {
+                    out = std::move(q.front());
+                    q.pop_front();
+                    queued.fetch_sub(1, std::memory_order_relaxed);
+                    stolen.fetch_add(1, std::memory_order_relaxed);
+                    if (!sameNode) crossNodeStolen.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void QFScheduler::workerLoop(unsigned index) {
+    tlsScheduler = this;
+    tlsWorker = static_cast<int>(index);
+
+    std::function<void()> task;
+    while (true) {
+        if (findTask(static_cast<int>(index), task)) {
+            task();
+            task = nullptr;
+            executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(sleep->lock);
+        if (stopping.load()) break;
+        if (queued.load(std::memory_order_acquire) > 0) {
+            // A task exists but its deque was busy (try_lock); retry
+            guard.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        sleep->wake.wait(guard);
+    }
+}
+
+bool QFScheduler::runPending() {
+    std::function<void()> task;
+    if (!findTask(currentWorker(), task)) return false;
+    task();
+    executed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void QFScheduler::parallelFor(size_t count, const std::function<void(size_t)>& body,
+    QFTaskPriority priority, size_t grain) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    QFTaskGroup group(*this, priority);
+    for (size_t begin = 0; begin < count; begin += grain) {
+        size_t end = std::min(count, begin + grain);
+        group.run([&body, begin, end]() {
+            for (size_t i = begin; i < end; i++) body(i);
+        });
+    }
+    group.wait();
+}
+
+QFSchedulerStats QFScheduler::stats() const {
+    QFSchedulerStats s;
+    s.workers = workerCount();
+    s.executed = executed.load();
+    s.stolen = stolen.load();
+    s.crossNodeStolen = crossNodeStolen.load();
+    return s;
+}
+
+// --------------------------------------------------------------------
+// QFTaskGroup
+// --------------------------------------------------------------------
+QFTaskGroup::QFTaskGroup(QFScheduler& s, QFTaskPriority p) : scheduler(s), priority(p) {}
+
+QFTaskGroup::~QFTaskGroup() {
+    waitAll();
+}
+
+void QFTaskGroup::run(std::function<void()> fn, int affinityHint) {
+    pendingTasks.fetch_add(1, std::memory_order_relaxed);
+    scheduler.submit([this, fn = std::move(fn)]() {
+        std::exception_ptr error;
+        try {
+            fn();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        // Decrement under the lock: wait() takes it before returning, so the
+        // group cannot be destroyed while we still touch it
+        std::lock_guard<std::mutex> guard(doneLock);
+        if (error && !firstError) firstError = error;
+        if (pendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            doneWake.notify_all();
+        }
+    }, priority, affinityHint);
+}
+
+void QFTaskGroup::wait() {
+    waitAll();
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> guard(doneLock);
+        std::swap(error, firstError);
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+void QFTaskGroup::waitAll() {
+    while (pendingTasks.load(std::memory_order_acquire) > 0) {
+        // Help instead of blocking; sleep briefly if every task is already running
+        if (!scheduler.runPending()) {
+            std::unique_lock<std::mutex> guard(doneLock);
+            doneWake.wait_for(guard, std::chrono::milliseconds(1), [this]() {
+                return pendingTasks.load(std::memory_order_acquire) == 0;
+            });
+        }
+    }
+    std::lock_guard<std::mutex> guard(doneLock);
+}
+
+// --------------------------------------------------------------------
+// Process-wide scheduler
+// --------------------------------------------------------------------
+static unsigned configuredThreads = 0;
+static bool configuredPinning = false;
+
+#if defined(__linux__)
+// cgroup CPU quota in cores (v2 cpu.max, else v1 CFS); 0 = unlimited
+static double cgroupCpuQuota() {
+    std::string group;
+    std::ifstream self("/proc/self/cgroup");
+    for (std::string line; std::getline(self, line);) {
+        if (line.rfind("0::", 0) == 0) group = line.substr(3);
+    }
+    for (const std::string& dir : { "/sys/fs/cgroup" + group, std::string("/sys/fs/cgroup") }) {
+        std::ifstream max(dir + "/cpu.max");
+        std::string quota;
+        double period = 0.0;
+        if (max >> quota >> period) return (quota == "max" || period <= 0.0) ? 0.0 : std::stod(quota) / period;
+    }
+    std::ifstream quotaFile("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+    std::ifstream periodFile("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+    double quota = 0.0, period = 0.0;
+    if (quotaFile >> quota && periodFile >> period && quota > 0.0 && period > 0.0) return quota / period;
+    return 0.0;
+}
+#endif
+
+unsigned qfAvailableCpus() {
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) cpus = std::max(1, CPU_COUNT(&set));
+    double quota = cgroupCpuQuota();
+    if (quota > 0.0) cpus = std::min(cpus, std::max(1u, static_cast<unsigned>(quota + 0.999)));
+    SCHED_LOG("available CPUs: " << cpus << " (cgroup quota " << quota << ")");
+#endif
+    return cpus;
+}
+
+unsigned qfDefaultThreadCount() {
+    const char* env = std::getenv("QF_THREADS");
+    if (env != nullptr) {
+        long v = std::strtol(env, nullptr, 10);
+        if (v > 0) return std::min(static_cast<unsigned>(v), QF_MAX_THREADS);
+    }
+    return std::min(qfAvailableCpus(), QF_MAX_THREADS);
+}
+
+void qfSetSchedulerThreads(unsigned threads, bool pinWorkers) {
+    configuredThreads = threads;
+    configuredPinning = pinWorkers;
+}
+
+QFScheduler& qfScheduler() {
+    static QFScheduler instance(configuredThreads, configuredPinning);
+    return instance;
+}
@@ -0,0 +1,139 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "AsyncHashing.h"
+
+// --------------------------------------------------------------------
+// A single work-stealing scheduler shared by every parallel hashing
+// path (files, directories, trees, batches), so the process never runs
+// more hashing threads than one bounded pool.
+//
+//   - Each worker owns two deques (interactive + bulk).  The owner pops
+//     the newest task (LIFO, cache-warm); idle workers steal the oldest
+//     (FIFO) from others.
+//   - Interactive tasks are always taken before any bulk task, including
+//     across workers, so a small request is never stuck behind a scan.
+//   - An affinity hint queues the task on a specific worker; with
+//     pinning enabled that also means a specific CPU.  On multi-node
+//     hosts pinned workers are spread node by node and steal from their
+//     own node before crossing to another (see Numa.h).
+// --------------------------------------------------------------------
+
+enum class QFTaskPriority {
+    Interactive = 0,
+    Bulk = 1
+};
+
+struct QFSchedulerStats {
+    unsigned workers;
+    uint64_t executed;   // tasks run by workers or helping waiters
+    uint64_t stolen;     // tasks taken from another worker's deque
+    uint64_t crossNodeStolen; // ... of which from a worker on another NUMA node
+};
+
+class QFScheduler : public QFExecutor {
+public:
+    // threads = 0 => qfDefaultThreadCount()
+    explicit QFScheduler(unsigned threads = 0, bool pinWorkers = false);
+    ~QFScheduler() override;
+
+    QFScheduler(const QFScheduler&) = delete;
+    QFScheduler& operator=(const QFScheduler&) = delete;
+
+    // affinityHint < 0 => current worker if called from one, else round-robin
+    void submit(std::function<void()> fn,
+        QFTaskPriority priority = QFTaskPriority::Bulk, int affinityHint = -1);
+
+    // QFExecutor: coroutine resumptions are latency-sensitive
+    void post(std::function<void()> fn) override {
+        submit(std::move(fn), QFTaskPriority::Interactive);
+    }
+
+    // Run one queued task on the calling thread; false if none was found.
+    // Used by waiters so nested parallelism cannot deadlock the pool.
+    bool runPending();
+
+    // body(i) for i in [0, count), split into chunks of `grain` indexes
+    void parallelFor(size_t count, const std::function<void(size_t)>& body,
+        QFTaskPriority priority = QFTaskPriority::Bulk, size_t grain = 1);
+
+    unsigned workerCount() const { return static_cast<unsigned>(workers.size()); }
+    // Index of the calling worker in this scheduler, or -1
+    int currentWorker() const;
+    // NUMA node a worker is pinned to (0 when not pinned per node)
+    int workerNode(unsigned worker) const { return workerNodes[worker]; }
+
+    QFSchedulerStats stats() const;
+
+    struct Worker;
+private:
+    bool findTask(int self, std::function<void()>& out);
+    void workerLoop(unsigned index);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<int> workerNodes;
+    std::atomic<size_t> queued{ 0 };
+    std::atomic<unsigned> nextWorker{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::atomic<uint64_t> executed{ 0 };
+    std::atomic<uint64_t> stolen{ 0 };
+    std::atomic<uint64_t> crossNodeStolen{ 0 };
+
+    struct Sleep;
+    std::unique_ptr<Sleep> sleep;
+};
+
+// --------------------------------------------------------------------
+// QFTaskGroup
+//   - Fork/join on a scheduler.  wait() helps run queued tasks instead
+//     of blocking, so groups can be nested inside scheduler tasks.
+//   - A task that throws still counts as finished; the first exception
+//     is rethrown from wait() once every task is done.  The destructor
+//     waits but drops a pending exception.
+// --------------------------------------------------------------------
+class QFTaskGroup {
+public:
+    explicit QFTaskGroup(QFScheduler& scheduler,
+        QFTaskPriority priority = QFTaskPriority::Bulk);
+    ~QFTaskGroup();
+
+    void run(std::function<void()> fn, int affinityHint = -1);
+    void wait();
+
+private:
+    void waitAll();
+
+    QFScheduler& scheduler;
+    QFTaskPriority priority;
+    std::atomic<size_t> pendingTasks{ 0 };
+    std::mutex doneLock;
+    std::condition_variable doneWake;
+    std::exception_ptr firstError;   // guarded by doneLock
+};
+
+// --------------------------------------------------------------------
+// Process-wide scheduler
+//   - Thread count: QF_THREADS environment variable if set, otherwise
+//     qfAvailableCpus(), capped at QF_MAX_THREADS.
+//   - qfSetSchedulerThreads() must run before the first qfScheduler().
+// --------------------------------------------------------------------
+static const unsigned QF_MAX_THREADS = 256;
+
+// CPUs this process can really use: the affinity mask, capped by a
+// cgroup CPU quota (rounded up).  Containers see every host CPU in
+// hardware_concurrency() even when their quota is two.
+unsigned qfAvailableCpus();
+unsigned qfDefaultThreadCount();
+void qfSetSchedulerThreads(unsigned threads, bool pinWorkers = false);
+QFScheduler& qfScheduler();
+
+#endif // TASK_SCHEDULER_H
@@ -0,0 +1,337 @@
+#include "TreeDigest.h"
+#include "Encoding.h"
+#include "SmallFiles.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+// Uncomment to enable debug prints
+// #define TREE_DEBUG
+
+#ifdef TREE_DEBUG
+#define TREE_LOG(msg) std::cerr << "[TreeDigest] " << msg << "\n"
+#else
+#define TREE_LOG(msg) /* no-op */
+#endif
+
+namespace fs = std::filesystem;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void putLE32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+// --------------------------------------------------------------------
+// Directory digests, deepest level first.  Breadth-first order makes
+// every level one contiguous index range.
+// --------------------------------------------------------------------
+void QFTree::digestDirectories() {
+    if (items.empty()) return;
+    size_t end = items.size();
+    while (end > 0) {
+        uint32_t depth = items[end - 1].depth;
+        size_t begin = end;
+        while (begin > 0 && items[begin - 1].depth == depth) begin--;
+
+        std::vector<uint32_t> dirs;
+        for (size_t i = begin; i < end; i++) {
+            if (items[i].type == 'd') dirs.push_back(static_cast<uint32_t>(i));
+        }
+        qfScheduler().parallelFor(dirs.size(), [&](size_t k) {
+            QFTreeNode& dir = items[dirs[k]];
+            std::vector<uint8_t> record;
+            for (uint32_t c = dir.firstChild; c < dir.firstChild + dir.childCount; c++) {
+                const QFTreeNode& child = items[c];
+                record.push_back(static_cast<uint8_t>(child.type));
+                putLE32(record, child.mode);
+                putLE32(record, static_cast<uint32_t>(child.name.size()));
+                record.insert(record.end(), child.name.begin(), child.name.end());
+                record.insert(record.end(), child.digest.begin(), child.digest.end());
+            }
+            QFState qs;
+            qfInit(qs);
+            processRaw(qs, record.data(), record.size());
+            qfSqueeze(qs, dir.digest.data(), dir.digest.size());
+        }, QFTaskPriority::Bulk, 16);
+        end = begin;
+    }
+}
+
+bool QFTree::build(const std::string& root, QFTreeReport& report) {
+    report = QFTreeReport();
+    items.clear();
+    std::error_code ec;
+    fs::file_status rootStatus = fs::status(root, ec);
+    if (ec || !fs::is_directory(rootStatus)) {
+        std::cerr << "[TreeDigest] Not a directory: " << root << "\n";
+        return false;
+    }
+
+    // Breadth-first listing; each directory's children land contiguously
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> fullPaths{ root };
+    QFTreeNode top;
+    top.type = 'd';
+    top.mode = static_cast<uint32_t>(rootStatus.permissions()) & 07777;
+    items.push_back(top);
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i].type != 'd') continue;
+        struct Child {
+            std::string name;
+            char type;
+            uint32_t mode;
+        };
+        std::vector<Child> children;
+        for (auto it = fs::directory_iterator(fullPaths[i], ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            fs::file_status st = it->symlink_status(ec);
+            if (ec) continue;
+            char type = fs::is_symlink(st) ? 'l' : fs::is_directory(st) ? 'd' : fs::is_regular_file(st) ? 'f' : 0;
+            if (type == 0) continue;   // sockets, fifos, devices
+            children.push_back({ it->path().filename().string(), type, static_cast<uint32_t>(st.permissions()) & 07777 });
+        }
+        if (ec) {
+            std::cerr << "[TreeDigest] Failed to list " << fullPaths[i] << ": " << ec.message() << "\n";
+            report.failures++;
+            ec.clear();
+        }
+        std::sort(children.begin(), children.end(), [](const Child& a, const Child& b) { return a.name < b.name; });
+        items[i].firstChild = static_cast<uint32_t>(items.size());
+        items[i].childCount = static_cast<uint32_t>(children.size());
+        for (Child& c : children) {
+            QFTreeNode node;
+            node.name = std::move(c.name);
+            node.type = c.type;
+            node.mode = c.mode;
+            node.parent = static_cast<uint32_t>(i);
+            node.depth = items[i].depth + 1;
+            fullPaths.push_back(fullPaths[i] + "/" + node.name);
+            items.push_back(std::move(node));
+        }
+    }
+    report.scanSeconds = secondsSince(start);
+
+    // Leaves: files in one batch, symlinks by target
+    start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> fileIndex;
+    std::vector<std::string> files;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i].type == 'f') {
+            fileIndex.push_back(static_cast<uint32_t>(i));
+            files.push_back(fullPaths[i]);
+        }
+        else if (items[i].type == 'l') {
+            std::string target = fs::read_symlink(fullPaths[i], ec).string();
+            ec.clear();
+            qfHashShort(reinterpret_cast<const uint8_t*>(target.data()), target.size(),
+                items[i].digest.data(), items[i].digest.size());
+        }
+        else report.directories++;
+    }
+    std::vector<QFDigest> digests;
+    std::vector<bool> ok;
+    QFSmallFilesReport filesReport;
+    hashSmallFiles(files, digests, ok, filesReport);
+    for (size_t k = 0; k < fileIndex.size(); k++) {
+        if (ok[k]) items[fileIndex[k]].digest = digests[k];
+    }
+    report.files = files.size();
+    report.bytes = filesReport.bytes;
+    report.failures += filesReport.failures;
+    report.hashSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    digestDirectories();
+    report.treeSeconds = secondsSince(start);
+    TREE_LOG(root << ": " << items.size() << " nodes, scan " << report.scanSeconds << " s, files "
+        << report.hashSeconds << " s, dirs " << report.treeSeconds << " s");
+    return true;
+}
+
+std::string QFTree::pathOf(uint32_t index) const {
+    if (index == 0) return ".";
+    std::vector<uint32_t> chain;
+    for (uint32_t i = index; i != 0; i = items[i].parent) chain.push_back(i);
+    std::string path;
+    for (size_t k = chain.size(); k-- > 0;) {
+        path += items[chain[k]].name;
+        if (k > 0) path += '/';
+    }
+    return path;
+}
+
+// --------------------------------------------------------------------
+// .tree files
+// --------------------------------------------------------------------
+bool QFTree::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "[TreeDigest] Failed to create " << path << "\n";
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    out << "# qftree 1\n";
+    char mode[16];
+    for (uint32_t i = 0; i < items.size(); i++) {
+        std::snprintf(mode, sizeof(mode), "%o", items[i].mode);
+        out << toHex(items[i].digest.data(), items[i].digest.size()) << ' ' << items[i].type << ' '
+            << mode << "  " << pathOf(i) << '\n';
+    }
+    if (!out.flush()) {
+        std::cerr << "[TreeDigest] Failed to write " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool QFTree::load(const std::string& path) {
+    items.clear();
+    std::ifstream in(path, std::ios::binary);
+    std::string line;
+    if (!in || !std::getline(in, line) || line.rfind("# qftree 1", 0) != 0) {
+        std::cerr << "[TreeDigest] Not a tree file: " << path << "\n";
+        return false;
+    }
+
+    std::unordered_map<std::string, uint32_t> dirIndex;
+    uint64_t lineNo = 1;
+    auto fail = [&](const char* why) {
+        std::cerr << "[TreeDigest] " << path << ":" << lineNo << ": " << why << "\n";
+        items.clear();
+        return false;
+    };
+    while (std::getline(in, line)) {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        QFTreeNode node;
+        const size_t hexLen = 2 * node.digest.size();
+        if (line.size() < hexLen + 7 || line[hexLen] != ' ' || line[hexLen + 2] != ' ') return fail("malformed line");
+        if (!qfHexDecode(line.data(), hexLen, node.digest.data())) return fail("bad digest");
+        node.type = line[hexLen + 1];
+        if (node.type != 'f' && node.type != 'd' && node.type != 'l') return fail("bad type");
+        size_t sep = line.find("  ", hexLen + 3);
+        if (sep == std::string::npos) return fail("malformed line");
+        node.mode = static_cast<uint32_t>(std::strtoul(line.c_str() + hexLen + 3, nullptr, 8));
+        std::string rel = line.substr(sep + 2);
+
+        if (items.empty()) {
+            if (rel != "." || node.type != 'd') return fail("first node must be the root directory");
+            dirIndex.emplace(".", 0);
+            items.push_back(std::move(node));
+            continue;
+        }
+        size_t slash = rel.rfind('/');
+        std::string parentPath = (slash == std::string::npos) ? "." : rel.substr(0, slash);
+        node.name = (slash == std::string::npos) ? rel : rel.substr(slash + 1);
+        auto parent = dirIndex.find(parentPath);
+        if (parent == dirIndex.end()) return fail("parent directory not listed before its children");
+
+        // Tree order: children contiguous, name-sorted, parents in order
+        const uint32_t index = static_cast<uint32_t>(items.size());
+        QFTreeNode& p = items[parent->second];
+        if (parent->second < items.back().parent) return fail("nodes out of tree order");
+        if (p.childCount == 0) p.firstChild = index;
+        else if (p.firstChild + p.childCount != index || !(items.back().name < node.name)) {
+            return fail("nodes out of tree order");
+        }
+        p.childCount++;
+        node.parent = parent->second;
+        node.depth = p.depth + 1;
+        if (node.type == 'd') dirIndex.emplace(rel, index);
+        items.push_back(std::move(node));
+    }
+    if (items.empty()) return fail("no root");
+
+    // Re-derive the directory digests from the leaves
+    std::vector<QFDigest> stored;
+    for (const QFTreeNode& n : items) {
+        if (n.type == 'd') stored.push_back(n.digest);
+    }
+    digestDirectories();
+    size_t k = 0;
+    for (const QFTreeNode& n : items) {
+        if (n.type == 'd' && n.digest != stored[k++]) {
+            std::cerr << "[TreeDigest] " << path << ": directory digest mismatch (file edited or corrupt)\n";
+            items.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// diffTrees: merge-join children by name, descend only where digests
+// differ
+// --------------------------------------------------------------------
+namespace {
+
+struct TreeDiffer {
+    const QFTree& oldTree;
+    const QFTree& newTree;
+    const QFTreeDiffCallback& onDiff;
+    QFTreeDiffReport& report;
+
+    void emit(QFDiffKind kind, const QFTree& tree, uint32_t index, const QFTreeNode* a, const QFTreeNode* b) {
+        std::string path = tree.pathOf(index);
+        if (tree.nodes()[index].type == 'd') path += '/';
+        if (kind == QFDiffKind::Added) report.added++;
+        else if (kind == QFDiffKind::Removed) report.removed++;
+        else report.changed++;
+        if (onDiff) onDiff(kind, path, a, b);
+    }
+
+    void compare(uint32_t ia, uint32_t ib) {
+        const QFTreeNode& a = oldTree.nodes()[ia];
+        const QFTreeNode& b = newTree.nodes()[ib];
+        report.visited++;
+        if (a.type == b.type && a.mode == b.mode && a.digest == b.digest) return;
+        if (a.type != 'd' || b.type != 'd') {
+            emit(QFDiffKind::Changed, newTree, ib, &a, &b);
+            return;
+        }
+        // A directory's own mode is not in its digest (its parent's is)
+        if (a.mode != b.mode) emit(QFDiffKind::Changed, newTree, ib, &a, &b);
+        if (a.digest == b.digest) return;
+        uint32_t i = a.firstChild, iEnd = a.firstChild + a.childCount;
+        uint32_t j = b.firstChild, jEnd = b.firstChild + b.childCount;
+        while (i < iEnd || j < jEnd) {
+            int c = (i == iEnd) ? 1 : (j == jEnd) ? -1
+                : oldTree.nodes()[i].name.compare(newTree.nodes()[j].name);
+            if (c < 0) {
+                emit(QFDiffKind::Removed, oldTree, i, &oldTree.nodes()[i], nullptr);
+                i++;
+            }
+            else if (c > 0) {
+                emit(QFDiffKind::Added, newTree, j, nullptr, &newTree.nodes()[j]);
+                j++;
+            }
+            else compare(i++, j++);
+        }
+    }
+};
+
+} // namespace
+
+void diffTrees(const QFTree& oldTree, const QFTree& newTree, const QFTreeDiffCallback& onDiff,
+    QFTreeDiffReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    report = QFTreeDiffReport();
+    report.oldNodes = oldTree.nodes().size();
+    report.newNodes = newTree.nodes().size();
+    if (!oldTree.nodes().empty() && !newTree.nodes().empty()) {
+        TreeDiffer differ{ oldTree, newTree, onDiff, report };
+        differ.compare(0, 0);
+    }
+    report.seconds = secondsSince(start);
+}
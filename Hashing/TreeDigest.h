@@ -0,0 +1,85 @@
+#ifndef TREE_DIGEST_H
+#define TREE_DIGEST_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ManifestDiff.h"
+#include "UniversalData.h"
+
+// --------------------------------------------------------------------
+// Hierarchical directory digests
+//   - Every directory gets the QF digest of its children sorted by name,
+//     each as type | mode | name length | name | digest.  Files carry
+//     digestFile(), symlinks the digest of their target string.
+//   - Nodes are stored breadth-first with each directory's children in
+//     one contiguous, name-sorted range, so one depth level is one index
+//     range: files are hashed with hashSmallFiles(), then directories
+//     level by level (deepest first) in parallel on the scheduler.
+//   - Two trees (scanned now or loaded from a saved .tree file) are
+//     compared from the root down, entering only directories whose
+//     digests differ: the work is proportional to what changed.
+// --------------------------------------------------------------------
+
+struct QFTreeNode {
+    std::string name;          // one path component ("" for the root)
+    char type = 'f';           // 'f' file, 'd' directory, 'l' symlink
+    uint32_t mode = 0;         // permission bits
+    uint32_t parent = 0;
+    uint32_t depth = 0;
+    uint32_t firstChild = 0;   // children: [firstChild, firstChild + childCount)
+    uint32_t childCount = 0;
+    QFDigest digest{};
+};
+
+struct QFTreeReport {
+    uint64_t files = 0;
+    uint64_t directories = 0;
+    uint64_t bytes = 0;
+    uint64_t failures = 0;     // unreadable files (digest left zero)
+    double scanSeconds = 0.0;
+    double hashSeconds = 0.0;  // file digests
+    double treeSeconds = 0.0;  // directory digests
+};
+
+class QFTree {
+public:
+    // Walks and digests root; false if root is not a directory
+    bool build(const std::string& root, QFTreeReport& report);
+
+    // Text file: "# qftree 1", then "<hex> <type> <mode octal>  <path>"
+    // per node in tree order (root path "."); load re-derives every
+    // directory digest and fails on any mismatch
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    const std::vector<QFTreeNode>& nodes() const { return items; }
+    const QFDigest& rootDigest() const { return items.front().digest; }
+    std::string pathOf(uint32_t index) const;   // relative to the root
+
+private:
+    void digestDirectories();
+    std::vector<QFTreeNode> items;
+};
+
+struct QFTreeDiffReport {
+    uint64_t added = 0;
+    uint64_t removed = 0;
+    uint64_t changed = 0;
+    uint64_t visited = 0;      // node pairs compared
+    uint64_t oldNodes = 0;
+    uint64_t newNodes = 0;
+    double seconds = 0.0;
+};
+
+// Added/Removed directories are reported once (path ends in '/'), not
+// per descendant.  A node that changed type or mode is Changed; a
+// directory whose mode changed is reported before its changed children.
+typedef std::function<void(QFDiffKind kind, const std::string& path,
+    const QFTreeNode* oldNode, const QFTreeNode* newNode)> QFTreeDiffCallback;
+
+void diffTrees(const QFTree& oldTree, const QFTree& newTree, const QFTreeDiffCallback& onDiff,
+    QFTreeDiffReport& report);
+
+#endif // TREE_DIGEST_H
@@ -1,9 +1,12 @@
 #include "UniversalData.h"
 #include "QuantumProtection.h"
+#include "BufferArena.h"
+#include "FileIO.h"
+#include "Encoding.h"
 #include <cstring>      // for std::memcpy
 #include <iostream>     // for I/O, logging
-#include <fstream>
 #include <algorithm>    // for std::min
+#include <cstdint>      // for INT64_MAX
 
 // Uncomment the following line to enable debug prints
 // #define UNIVERSALDATA_DEBUG
@@ -112,10 +115,16 @@ void processBytes(QFState& qs, const std::vector<uint8_t>& data) {
 //   - Returns false if file can't be opened, true otherwise
 // --------------------------------------------------------------------
 bool processFile(QFState& qs, const std::string& filename, size_t chunkSize) {
+    std::vector<uint8_t> buffer(chunkSize);
+    return processFile(qs, filename, buffer.data(), buffer.size());
+}
+
+bool processFile(QFState& qs, const std::string& filename, uint8_t* buffer, size_t chunkSize,
+    QFReadStats* stats) {
     UDATA_LOG("processFile: reading " << filename << " in chunks of " << chunkSize << " bytes.");
 
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
+    int fd = qfOpenRead(filename);
+    if (fd < 0) {
         std::cerr << "[processFile] Failed to open file: " << filename << "\n";
         return false;
     }
@@ -125,33 +134,127 @@ bool processFile(QFState& qs, const std::string& filename, size_t chunkSize) {
     // For example:
     // processString(qs, filename);
 
-    // read in chunked manner
-    std::vector<uint8_t> buffer(chunkSize);
+    long err = processFdChunks(fd, chunkSize, [buffer]() { return buffer; },
+        [&qs](const uint8_t* data, size_t len) {
+            if (data) processRaw(qs, data, len);
+            else qfAbsorbZeros(qs, len);
+        }, stats);
+    if (err < 0) {
+        // Logged, not fatal: the state covers what was read before it
+        std::cerr << "[processFile] Reading error before EOF.\n";
+    }
+    qfClose(fd);
+    return true;
+}
+
+long processFdChunks(int fd, size_t chunkSize, const std::function<uint8_t*()>& nextBuffer,
+    const std::function<void(const uint8_t* data, size_t len)>& onChunk, QFReadStats* stats) {
+    QFReadStats local;
+    QFReadStats& st = stats ? *stats : local;
+    st = QFReadStats();
+
+    // Extent map for sparse files.  Chunk boundaries stay exactly those of
+    // a dense read, because the sponge absorbs a partial chunk differently
+    // from a full one; only where the bytes come from changes.
+    int64_t size = qfFileSize(fd);
+    int64_t dataStart = 0, dataEnd = INT64_MAX;
+    int found = (size > 0) ? qfNextDataExtent(fd, 0, dataStart, dataEnd) : -1;
+    bool sparse = (found >= 0);
+    if (found == 0) dataStart = dataEnd = INT64_MAX; // all hole
+
+    int64_t offset = 0;
+    while (sparse && offset < size) {
+        size_t n = static_cast<size_t>(std::min<int64_t>(static_cast<int64_t>(chunkSize), size - offset));
+        int64_t chunkEnd = offset + static_cast<int64_t>(n);
+
+        if (chunkEnd <= dataStart && (n % QF_RATE_BYTES) == 0) {
+            // Whole chunk is a hole: no read, no zero buffer
+            onChunk(nullptr, n);
+            st.holeBytes += n;
+        }
+        else {
+            // Mixed chunk: read the data parts, zero-fill the rest
+            uint8_t* buffer = nextBuffer();
+            int64_t pos = offset;
+            while (pos < chunkEnd) {
+                if (pos >= dataEnd) {
+                    if (qfNextDataExtent(fd, pos, dataStart, dataEnd) != 1) dataStart = dataEnd = INT64_MAX;
+                    continue;
+                }
+                int64_t segEnd = std::min(chunkEnd, (pos < dataStart) ? dataStart : dataEnd);
+                size_t segLen = static_cast<size_t>(segEnd - pos);
+                uint8_t* dst = buffer + (pos - offset);
+                if (pos < dataStart) {
+                    std::memset(dst, 0, segLen);
+                    st.holeBytes += segLen;
+                }
+                else {
+                    long got = qfReadFull(fd, dst, segLen, pos);
+                    if (got < 0) return got;
+                    st.bytesRead += segLen;
+                    if (static_cast<size_t>(got) < segLen) {
+                        // Truncated while we read: treat as EOF, like a dense read
+                        n = static_cast<size_t>(pos - offset) + static_cast<size_t>(got);
+                        size = offset + static_cast<int64_t>(n);
+                        break;
+                    }
+                }
+                pos = segEnd;
+            }
+            onChunk(buffer, n);
+        }
+        st.logicalBytes += n;
+        offset += static_cast<int64_t>(n);
+    }
+
+    // Dense path (no extent information, pipes), and anything appended
+    // after the size was sampled.  The offset is explicit so reads resume
+    // where the sparse loop stopped.
     while (true) {
-        file.read(reinterpret_cast<char*>(buffer.data()), chunkSize);
-        std::streamsize bytesRead = file.gcount();
-        if (bytesRead <= 0) {
-            break; // done or error
+        uint8_t* buffer = nextBuffer();
+        long bytesRead = qfReadFull(fd, buffer, chunkSize, sparse ? offset : -1);
+        if (bytesRead < 0) return bytesRead;
+        if (bytesRead == 0) {
+            break; // done
         }
 
         // Optionally do endianness transform here, if desired
         // For large files, we might skip it for performance. 
-        // We'll just call processRaw:
-        processRaw(qs, buffer.data(), static_cast<size_t>(bytesRead));
-
-        if (!file) {
-            // might be EOF or some error
-            if (file.eof()) break;
-            if (file.fail() && !file.eof()) {
-                std::cerr << "[processFile] Reading error before EOF.\n";
-                break;
-            }
-        }
+        // We'll just hand the raw chunk on:
+        onChunk(buffer, static_cast<size_t>(bytesRead));
+        st.bytesRead += static_cast<uint64_t>(bytesRead);
+        st.logicalBytes += static_cast<uint64_t>(bytesRead);
+        offset += bytesRead;
+
+        if (static_cast<size_t>(bytesRead) < chunkSize) break; // EOF
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// digestFile
+//   - Fresh state, whole file, 64-byte squeeze
+// --------------------------------------------------------------------
+bool digestFile(const std::string& filename, QFDigest& out) {
+    QFArenaLease buffer(qfIoArena());
+    QFState qs;
+    qfInit(qs);
+    if (!processFile(qs, filename, buffer.data(), buffer.size())) {
+        return false;
     }
-    file.close();
+    qfSqueeze(qs, out.data(), out.size());
     return true;
 }
 
+// --------------------------------------------------------------------
+// toHex
+// --------------------------------------------------------------------
+std::string toHex(const uint8_t* data, size_t len) {
+    std::string hex(qfHexLength(len), '0');
+    qfHexEncode(data, len, &hex[0]);
+    return hex;
+}
+
 // --------------------------------------------------------------------
 // The templated functions (processContainer, processArray, processStruct)
 // remain in the header, but if you want to provide explicit instantiations,
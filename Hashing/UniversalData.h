@@ -1,6 +1,8 @@
 #ifndef UNIVERSAL_DATA_H
 #define UNIVERSAL_DATA_H
 
+#include <array>
+#include <functional>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -75,6 +77,48 @@ void processStruct(QFState& qs, const T& obj)
 // ------------------------------------------------------------------
 bool processFile(QFState& qs, const std::string& filename, size_t chunkSize = 4096);
 
+// Same, but reads through a caller-owned buffer (bufferSize bytes), e.g.
+// a NUMA-local or huge-page buffer that is reused across files.
+//   - Sparse files: chunks that lie in a hole (SEEK_DATA/SEEK_HOLE) are
+//     absorbed as zeros without reading them; hole parts of mixed chunks
+//     are zero-filled in memory.  The digest equals a dense read.
+//   - stats (optional) reports how much was actually read.
+struct QFReadStats {
+    uint64_t logicalBytes = 0; // bytes absorbed
+    uint64_t bytesRead = 0;    // bytes requested from the file system
+    uint64_t holeBytes = 0;    // bytes synthesized as zeros
+};
+
+bool processFile(QFState& qs, const std::string& filename, uint8_t* buffer, size_t bufferSize,
+    QFReadStats* stats = nullptr);
+
+// The chunk reader behind processFile, for callers that need the bytes
+// too (e.g. hashFileMulti feeding SHA-256 / CRC32C alongside QF).
+//   - Same chunk boundaries and hole handling as processFile: absorbing
+//     the chunks in order gives the same QF state.
+//   - nextBuffer() supplies a chunkSize-byte buffer for every chunk that
+//     is read; onChunk(data, len) then receives that chunk.  A chunk that
+//     lies entirely in a hole is delivered as data == nullptr: len zero
+//     bytes, no buffer (absorb it with qfAbsorbZeros).
+//   - Returns 0, or -errno of the first failed read (the chunks before
+//     it have been delivered).
+long processFdChunks(int fd, size_t chunkSize, const std::function<uint8_t*()>& nextBuffer,
+    const std::function<void(const uint8_t* data, size_t len)>& onChunk, QFReadStats* stats = nullptr);
+
+// ------------------------------------------------------------------
+// 6b) File digests
+//     - qfInit + processFile + qfSqueeze, i.e. the plain sponge digest
+//       used by every bulk mode (manifests, dupes, copy, ...).
+//     - Reads through a recycled buffer from qfIoArena().
+// ------------------------------------------------------------------
+static const size_t QF_DIGEST_BYTES = 64; // 512 bits
+typedef std::array<uint8_t, QF_DIGEST_BYTES> QFDigest;
+
+bool digestFile(const std::string& filename, QFDigest& out);
+
+// Lower-case hex of a byte string
+std::string toHex(const uint8_t* data, size_t len);
+
 // ------------------------------------------------------------------
 // 7) (Optional) Overloads / specializations for specific data types
 //    e.g. processInts, processDoubles, etc.  if you want 
@@ -0,0 +1,449 @@
+#include "Watch.h"
+#include "BufferArena.h"
+#include "SmallFiles.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Uncomment to enable debug prints
+// #define WATCH_DEBUG
+
+#ifdef WATCH_DEBUG
+#define WATCH_LOG(msg) std::cerr << "[Watch] " << msg << "\n"
+#else
+#define WATCH_LOG(msg) /* no-op */
+#endif
+
+namespace fs = std::filesystem;
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Size + mtime of a regular file; false if it is gone or not a file
+static bool statFile(const std::string& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    fs::file_status st = fs::status(path, ec);
+    if (ec || !fs::is_regular_file(st)) return false;
+    size = fs::file_size(path, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+static bool hasPrefixDir(const std::string& path, const std::string& dir) {
+    return path.size() > dir.size() && path.compare(0, dir.size(), dir) == 0 && path[dir.size()] == '/';
+}
+
+QFDirectoryWatcher::QFDirectoryWatcher(const std::string& rootPath, const QFWatchOptions& opts)
+    : root(rootPath), options(opts) {
+    while (root.size() > 1 && (root.back() == '/' || root.back() == '\\')) root.pop_back();
+}
+
+QFDirectoryWatcher::~QFDirectoryWatcher() {
+    stop();
+}
+
+// --------------------------------------------------------------------
+// Dirty tracking
+//   The manifest (and its temporary) may live inside the watched tree;
+//   rewriting it must not count as a change or every flush would
+//   trigger the next one.
+// --------------------------------------------------------------------
+void QFDirectoryWatcher::markDirty(const std::string& path) {
+    if (!options.manifestPath.empty()) {
+        fs::path name = fs::path(path).filename();
+        fs::path manifestName = fs::path(options.manifestPath).filename();
+        if (name == manifestName || name.string() == manifestName.string() + ".tmp") {
+            std::error_code ec;
+            fs::path candidate = fs::absolute(path, ec).lexically_normal();
+            fs::path manifest = fs::absolute(options.manifestPath, ec).lexically_normal();
+            if (candidate == manifest || candidate.string() == manifest.string() + ".tmp") return;
+        }
+    }
+    if (dirty.empty()) firstDirtyMs = nowMs();
+    dirty.insert(path);
+}
+
+// Every file under dir; with includeKnown also every manifest entry
+// under it, so files deleted meanwhile are noticed
+void QFDirectoryWatcher::markTree(const std::string& dir, bool includeKnown) {
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(dir, ec);
+        !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_regular_file(ec)) markDirty(it->path().string());
+    }
+    if (!includeKnown) return;
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto it = entries.lower_bound(dir + "/"); it != entries.end() && hasPrefixDir(it->first, dir); ++it) {
+        markDirty(it->first);
+    }
+}
+
+// --------------------------------------------------------------------
+// start / stop
+// --------------------------------------------------------------------
+bool QFDirectoryWatcher::start(QFWatchCallback onChange) {
+    if (worker.joinable()) return true;
+    std::error_code ec;
+    if (!fs::is_directory(root, ec)) {
+        std::cerr << "[Watch] Not a directory: " << root << "\n";
+        return false;
+    }
+    callback = std::move(onChange);
+    stopping = false;
+    if (!slabs) slabs = newSmallFilesArena();
+    auto start = std::chrono::steady_clock::now();
+
+#if defined(__linux__)
+    // Watches go in before the initial scan, so nothing written during
+    // the scan can slip through
+    if (!options.forcePolling) {
+        notifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (notifyFd < 0) {
+            std::cerr << "[Watch] inotify unavailable (" << std::strerror(errno) << "); polling every "
+                << options.pollSeconds << " s\n";
+        }
+        else if (::pipe(wakeFds) != 0) {
+            ::close(notifyFd);
+            notifyFd = -1;
+        }
+    }
+    if (notifyFd >= 0) {
+        const uint32_t mask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+            | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+        std::vector<std::string> dirs{ root };
+        for (auto it = fs::recursive_directory_iterator(root, ec);
+            !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_directory(ec) && !it->is_symlink(ec)) dirs.push_back(it->path().string());
+        }
+        for (const std::string& dir : dirs) {
+            int wd = ::inotify_add_watch(notifyFd, dir.c_str(), mask);
+            if (wd < 0) {
+                std::cerr << "[Watch] inotify_add_watch failed on " << dir << " (" << std::strerror(errno)
+                    << "); polling every " << options.pollSeconds << " s\n";
+                ::close(notifyFd);
+                notifyFd = -1;
+                watchDirs.clear();
+                break;
+            }
+            watchDirs[wd] = dir;
+        }
+    }
+#endif
+
+    // Initial full scan
+    markTree(root, false);
+    flush();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        counters.backend = (notifyFd >= 0) ? "inotify" : "polling";
+        counters.rehashed = 0;
+        counters.flushes = 0;
+        counters.initialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (!options.manifestPath.empty() && !writeManifest()) return false;
+
+    worker = std::thread([this]() { run(); });
+    return true;
+}
+
+void QFDirectoryWatcher::stop() {
+    if (worker.joinable()) {
+        stopping = true;
+#if defined(__linux__)
+        if (wakeFds[1] >= 0) {
+            char byte = 1;
+            ssize_t written = ::write(wakeFds[1], &byte, 1);
+            (void)written;
+        }
+#endif
+        wake.notify_all();
+        worker.join();
+    }
+#if defined(__linux__)
+    if (notifyFd >= 0) ::close(notifyFd);
+    for (int& fd : wakeFds) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+#endif
+    notifyFd = -1;
+    watchDirs.clear();
+}
+
+void QFDirectoryWatcher::run() {
+    if (notifyFd >= 0) runInotify();
+    if (!stopping) runPolling();
+}
+
+// --------------------------------------------------------------------
+// inotify backend
+//   poll() sleeps until an event, the wake pipe, or the debounce
+//   deadline of the pending burst.  New directories get a watch and a
+//   walk (files may have landed before the watch existed); a directory
+//   moved or deleted away dirties every entry below it.
+// --------------------------------------------------------------------
+void QFDirectoryWatcher::runInotify() {
+#if defined(__linux__)
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+        | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+    alignas(struct inotify_event) char buffer[64 << 10];
+
+    while (!stopping) {
+        int timeout = -1;
+        int64_t deadline = 0;
+        if (!dirty.empty()) {
+            deadline = std::min<int64_t>(lastEventMs + options.debounceMs, firstDirtyMs + options.maxDelayMs);
+            timeout = static_cast<int>(std::max<int64_t>(0, deadline - nowMs()));
+        }
+        struct pollfd fds[2] = { { notifyFd, POLLIN, 0 }, { wakeFds[0], POLLIN, 0 } };
+        int ready = ::poll(fds, 2, timeout);
+        if (stopping) break;
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "[Watch] poll failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+
+        bool lostWatch = false;
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            while (true) {
+                ssize_t n = ::read(notifyFd, buffer, sizeof(buffer));
+                if (n <= 0) break;
+                for (char* p = buffer; p < buffer + n;) {
+                    const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+                    p += sizeof(struct inotify_event) + ev->len;
+                    lastEventMs = nowMs();
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        counters.events++;
+                    }
+                    if (ev->mask & IN_Q_OVERFLOW) {
+                        WATCH_LOG("event queue overflow, rescanning " << root);
+                        markTree(root, true);
+                        std::lock_guard<std::mutex> guard(lock);
+                        counters.rescans++;
+                        continue;
+                    }
+                    auto dir = watchDirs.find(ev->wd);
+                    if (dir == watchDirs.end()) continue;
+                    if (ev->mask & IN_IGNORED) {
+                        if (dir->second == root) lostWatch = true;
+                        watchDirs.erase(dir);
+                        continue;
+                    }
+                    if (ev->len == 0) continue;   // IN_DELETE_SELF: the parent reports the entry
+                    std::string path = dir->second + "/" + ev->name;
+
+                    if (!(ev->mask & IN_ISDIR)) {
+                        markDirty(path);
+                    }
+                    else if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        std::vector<std::string> dirs{ path };
+                        std::error_code ec;
+                        for (auto it = fs::recursive_directory_iterator(path, ec);
+                            !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+                            if (it->is_directory(ec) && !it->is_symlink(ec)) dirs.push_back(it->path().string());
+                        }
+                        for (const std::string& d : dirs) {
+                            int wd = ::inotify_add_watch(notifyFd, d.c_str(), mask);
+                            if (wd >= 0) watchDirs[wd] = d;
+                            else lostWatch = true;
+                        }
+                        markTree(path, false);
+                    }
+                    else if (ev->mask & (IN_MOVED_FROM | IN_DELETE)) {
+                        // Watches below a moved directory would report stale paths
+                        for (auto it = watchDirs.begin(); it != watchDirs.end();) {
+                            if (it->second == path || hasPrefixDir(it->second, path)) {
+                                ::inotify_rm_watch(notifyFd, it->first);
+                                it = watchDirs.erase(it);
+                            }
+                            else ++it;
+                        }
+                        markTree(path, true);
+                    }
+                }
+            }
+        }
+
+        if (!dirty.empty() && nowMs() >= std::min<int64_t>(lastEventMs + options.debounceMs,
+            firstDirtyMs + options.maxDelayMs)) {
+            flush();
+        }
+        if (lostWatch) {
+            std::cerr << "[Watch] Lost an inotify watch under " << root << "; polling every "
+                << options.pollSeconds << " s\n";
+            std::lock_guard<std::mutex> guard(lock);
+            counters.backend = "polling";
+            return;
+        }
+    }
+#endif
+}
+
+// --------------------------------------------------------------------
+// Polling backend: stat the tree, dirty anything whose size or mtime
+// moved and anything that disappeared
+// --------------------------------------------------------------------
+void QFDirectoryWatcher::runPolling() {
+    while (!stopping) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait_for(guard, std::chrono::seconds(options.pollSeconds), [this]() { return stopping.load(); });
+        }
+        if (stopping) break;
+
+        std::unordered_set<std::string> seen;
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(root, ec);
+            !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_regular_file(ec)) continue;
+            std::string path = it->path().string();
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            if (!statFile(path, size, mtime)) continue;
+            seen.insert(path);
+            std::lock_guard<std::mutex> guard(lock);
+            auto known = entries.find(path);
+            if (known == entries.end() || known->second.size != size || known->second.mtime != mtime) {
+                markDirty(path);
+                counters.events++;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (const auto& entry : entries) {
+                if (!seen.count(entry.first)) {
+                    markDirty(entry.first);
+                    counters.events++;
+                }
+            }
+            counters.rescans++;
+        }
+        if (!dirty.empty()) flush();
+    }
+}
+
+// --------------------------------------------------------------------
+// flush: re-digest the dirty files that still exist, drop the rest,
+// report what changed
+// --------------------------------------------------------------------
+void QFDirectoryWatcher::flush() {
+    std::vector<std::string> present, gone;
+    std::vector<Entry> meta;
+    for (const std::string& path : dirty) {
+        Entry e;
+        if (statFile(path, e.size, e.mtime)) {
+            present.push_back(path);
+            meta.push_back(e);
+        }
+        else gone.push_back(path);
+    }
+    dirty.clear();
+
+    std::vector<QFDigest> digests;
+    std::vector<bool> ok;
+    QFSmallFilesReport report;
+    QFSmallFilesOptions smallOptions;
+    smallOptions.arena = slabs.get();
+    if (!present.empty()) hashSmallFiles(present, digests, ok, report, smallOptions);
+
+    struct Change {
+        QFWatchChange kind;
+        std::string path;
+        QFDigest oldDigest, newDigest;
+    };
+    std::vector<Change> changes;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (size_t i = 0; i < present.size(); i++) {
+            // Unreadable right now: keep the old digest, the next event retries
+            if (!ok[i]) continue;
+            meta[i].digest = digests[i];
+            auto it = entries.find(present[i]);
+            if (it == entries.end()) {
+                changes.push_back({ QFWatchChange::Added, present[i], QFDigest{}, digests[i] });
+                entries.emplace(present[i], meta[i]);
+            }
+            else {
+                if (it->second.digest != digests[i]) {
+                    changes.push_back({ QFWatchChange::Changed, present[i], it->second.digest, digests[i] });
+                }
+                it->second = meta[i];
+            }
+        }
+        for (const std::string& path : gone) {
+            auto it = entries.find(path);
+            if (it == entries.end()) continue;
+            changes.push_back({ QFWatchChange::Removed, path, it->second.digest, QFDigest{} });
+            entries.erase(it);
+        }
+        counters.flushes++;
+        counters.rehashed += present.size();
+        counters.files = entries.size();
+    }
+    WATCH_LOG("flush: " << present.size() << " rehashed, " << gone.size() << " gone, "
+        << changes.size() << " changes");
+
+    if (changes.empty() || !worker.joinable()) return;   // initial scan: no callbacks, start() writes
+    std::sort(changes.begin(), changes.end(), [](const Change& a, const Change& b) { return a.path < b.path; });
+    if (callback) {
+        for (const Change& c : changes) {
+            callback(c.kind, c.path, c.kind == QFWatchChange::Added ? nullptr : &c.oldDigest,
+                c.kind == QFWatchChange::Removed ? nullptr : &c.newDigest);
+        }
+    }
+    if (!options.manifestPath.empty()) writeManifest();
+}
+
+bool QFDirectoryWatcher::writeManifest() {
+    const std::string tmp = options.manifestPath + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "[Watch] Failed to create manifest: " << tmp << "\n";
+            return false;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        for (const auto& entry : entries) {
+            out << toHex(entry.second.digest.data(), entry.second.digest.size()) << "  " << entry.first << '\n';
+        }
+        if (!out.flush()) {
+            std::cerr << "[Watch] Failed to write manifest: " << tmp << "\n";
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, options.manifestPath, ec);
+    if (ec) {
+        std::cerr << "[Watch] Failed to replace manifest " << options.manifestPath << ": " << ec.message() << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::pair<std::string, QFDigest>> QFDirectoryWatcher::snapshot() const {
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<std::pair<std::string, QFDigest>> out;
+    out.reserve(entries.size());
+    for (const auto& entry : entries) out.emplace_back(entry.first, entry.second.digest);
+    return out;
+}
+
+QFWatchStats QFDirectoryWatcher::stats() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return counters;
+}
@@ -0,0 +1,116 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "UniversalData.h"
+
+class QFBufferArena;
+
+// --------------------------------------------------------------------
+// Watch mode: a manifest of a live directory kept current
+//   - start() digests the whole tree once, then a background thread
+//     follows changes.  On Linux that is inotify (one watch per
+//     directory, new subdirectories are picked up as they appear); a
+//     queue overflow or a missing inotify falls back to rescanning.
+//     Elsewhere, or with forcePolling, the tree is re-stat'ed every
+//     pollSeconds and files whose size or mtime moved are dirty.
+//   - Events only mark paths dirty.  A burst is flushed once it has been
+//     quiet for debounceMs (or after maxDelayMs of continuous activity):
+//     the dirty files that still exist are re-digested with
+//     hashSmallFiles() on the scheduler, the rest are dropped.  Every
+//     flush reads through one slab arena kept for the watcher's lifetime.
+//   - The callback sees every digest that appeared, changed or went
+//     away; the on-disk manifest ("<hex>  <path>", sorted, replaced via
+//     rename) is rewritten after each flush that changed something.
+// --------------------------------------------------------------------
+
+enum class QFWatchChange { Added, Removed, Changed };
+
+// oldDigest is null for Added, newDigest is null for Removed.  Called on
+// the watcher thread; keep it short.
+typedef std::function<void(QFWatchChange change, const std::string& path,
+    const QFDigest* oldDigest, const QFDigest* newDigest)> QFWatchCallback;
+
+struct QFWatchOptions {
+    unsigned debounceMs = 250;     // quiet period that ends a burst
+    unsigned maxDelayMs = 5000;    // flush a burst that never goes quiet
+    unsigned pollSeconds = 5;      // scan interval of the polling backend
+    bool forcePolling = false;
+    std::string manifestPath;      // empty => in-memory only
+};
+
+struct QFWatchStats {
+    const char* backend = "";
+    uint64_t files = 0;            // entries in the manifest now
+    uint64_t events = 0;           // raw inotify events / polling hits
+    uint64_t flushes = 0;
+    uint64_t rehashed = 0;         // files re-digested after the initial scan
+    uint64_t rescans = 0;          // full scans after overflow (or polling)
+    double initialSeconds = 0.0;
+};
+
+class QFDirectoryWatcher {
+public:
+    explicit QFDirectoryWatcher(const std::string& root, const QFWatchOptions& options = QFWatchOptions());
+    ~QFDirectoryWatcher();
+
+    QFDirectoryWatcher(const QFDirectoryWatcher&) = delete;
+    QFDirectoryWatcher& operator=(const QFDirectoryWatcher&) = delete;
+
+    // Initial scan (+ manifest write) and watcher thread; false if the
+    // root is not a directory or the manifest cannot be written
+    bool start(QFWatchCallback onChange = nullptr);
+    void stop();
+
+    // Copy of the current manifest, path order
+    std::vector<std::pair<std::string, QFDigest>> snapshot() const;
+    QFWatchStats stats() const;
+
+private:
+    struct Entry {
+        QFDigest digest{};
+        uint64_t size = 0;
+        int64_t mtime = 0;
+    };
+
+    void run();
+    void runInotify();
+    void runPolling();
+    void markDirty(const std::string& path);
+    void markTree(const std::string& dir, bool includeKnown);
+    void flush();
+    bool writeManifest();
+
+    std::string root;
+    QFWatchOptions options;
+    QFWatchCallback callback;
+
+    mutable std::mutex lock;                 // entries + stats
+    std::map<std::string, Entry> entries;
+    QFWatchStats counters;
+
+    // Watcher thread only
+    std::unordered_set<std::string> dirty;
+    int64_t firstDirtyMs = 0;
+    int64_t lastEventMs = 0;
+    std::unique_ptr<QFBufferArena> slabs;    // hashSmallFiles() slabs, reused by every flush
+
+    std::thread worker;
+    std::atomic<bool> stopping{ false };
+    std::condition_variable wake;            // interrupts the polling sleep
+    int wakeFds[2] = { -1, -1 };             // self-pipe that interrupts poll()
+    int notifyFd = -1;
+    std::map<int, std::string> watchDirs;    // inotify wd -> directory path
+};
+
+#endif // WATCH_H
@@ -0,0 +1,17 @@
+#ifndef WIPE_H
+#define WIPE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// --------------------------------------------------------------------
+// Zero key material (sponge states, derived keys, key file text) before
+// the memory is freed or reused.  Writes go through a volatile pointer
+// so the compiler cannot drop them as dead stores.
+// --------------------------------------------------------------------
+inline void qfWipe(void* p, size_t n) {
+    volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+    while (n-- > 0) *v++ = 0;
+}
+
+#endif // WIPE_H
@@ -2,13 +2,61 @@
 #include <vector>
 #include <string>
 #include <cstdlib>
+#include <algorithm>
 #include <fstream>      // for std::ifstream
 #include <limits>       // for std::numeric_limits
+#include <filesystem>   // for directory walks in the bulk modes
+#include <chrono>
+#include <thread>       // for the watch mode's sleep loop
 
 #include "QuantumProtection.h"
 #include "SelfHeal.h"
 #include "UniversalData.h"
 #include "Performance.h"
+#include "Benchmark.h"
+#include "FileCopy.h"
+#include "BufferArena.h"
+#include "Numa.h"
+#include "SmallFiles.h"
+#include "MultiHash.h"
+#include "Dupes.h"
+#include "ManifestDiff.h"
+#include "Delta.h"
+#include "MultisetHash.h"
+#include "Archive.h"
+#include "Watch.h"
+#include "TreeDigest.h"
+#include "Scrubber.h"
+#include "Kdf.h"
+#include "Aead.h"
+#include "Keystream.h"
+#include "FileIO.h"
+#include "Encoding.h"
+#include "TaskScheduler.h"
+
+// --------------------------------------------------------------------
+// Expand command-line paths: files as-is, directories recursively
+// (regular files only, sorted so output order is stable).
+// --------------------------------------------------------------------
+static std::vector<std::string> expandPaths(int first, int argc, char* argv[]) {
+    std::vector<std::string> files;
+    for (int i = first; i < argc; i++) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(argv[i], ec)) {
+            std::vector<std::string> found;
+            for (auto it = std::filesystem::recursive_directory_iterator(argv[i], ec);
+                !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+                if (it->is_regular_file(ec)) found.push_back(it->path().string());
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        }
+        else {
+            files.push_back(argv[i]);
+        }
+    }
+    return files;
+}
 
 int main(int argc, char* argv[]) {
     // --------------------------------------------------------------------
@@ -26,10 +74,32 @@ int main(int argc, char* argv[]) {
     // --------------------------------------------------------------------
     if (argc < 2) {
         std::cerr << "Usage:\n"
-            << "  " << argv[0] << " <file|string> [data]\n\n"
+            << "  " << argv[0] << " <file|string> [data]\n"
+            << "  " << argv[0] << " copy <src> <dst> [--sync] [--verify]\n"
+            << "  " << argv[0] << " numa <file|dir>...\n"
+            << "  " << argv[0] << " smallfiles [--pool] <file|dir>...\n"
+            << "  " << argv[0] << " multi [--algs qf,sha256,crc32c] <file|dir>...\n"
+            << "  " << argv[0] << " dupes [--min-size bytes] <file|dir>...\n"
+            << "  " << argv[0] << " diff <old.manifest> <new.manifest> [--memory MiB] [--tmp dir]\n"
+            << "  " << argv[0] << " multiset <lines.txt>...\n"
+            << "  " << argv[0] << " signature <old> <sig> [--block bytes]\n"
+            << "  " << argv[0] << " delta <sig> <new> <delta>\n"
+            << "  " << argv[0] << " patch <old> <delta> <out>\n"
+            << "  " << argv[0] << " archive <file.tar|file.zip|->\n"
+            << "  " << argv[0] << " tree <dir> [--save file.tree]\n"
+            << "  " << argv[0] << " treediff <old dir|.tree> <new dir|.tree>\n"
+            << "  " << argv[0] << " scrub <state> [--import manifest]... [--io MiB/s] [--cpu cores] [--threads n] [--interval s] [--loop]\n"
+            << "  " << argv[0] << " kdf <salt> [--memory MiB] [--passes n] [--lanes n] [--len bytes] < passphrase\n"
+            << "  " << argv[0] << " seal <in> <out> --key keyfile [--chunk KiB]\n"
+            << "  " << argv[0] << " unseal <in> <out> --key keyfile\n"
+            << "  " << argv[0] << " encrypt <in> <out> --key keyfile\n"
+            << "  " << argv[0] << " decrypt <in> <out> --key keyfile [--offset bytes] [--length bytes]\n"
+            << "  " << argv[0] << " watch <dir> [--manifest file] [--debounce ms] [--poll seconds] [--seconds N]\n"
+            << "  " << argv[0] << " bench [name] [args...]\n\n"
             << "Examples:\n"
             << "  " << argv[0] << " file myBinary.dat\n"
-            << "  " << argv[0] << " string \"Hello, Universe!\"\n";
+            << "  " << argv[0] << " string \"Hello, Universe!\"\n"
+            << "  " << argv[0] << " bench scheduler 64\n";
         return EXIT_FAILURE;
     }
 
@@ -64,8 +134,10 @@ int main(int argc, char* argv[]) {
             std::cout << "[Main] Processed user string: \"" << fallbackInput << "\"\n";
         }
         else {
-            // The file is accessible; proceed with processFile
-            bool ok = processFile(fortress, filename);
+            // The file is accessible; proceed with processFile, reading
+            // through a recycled (huge-page backed when possible) buffer
+            QFArenaLease buffer(qfIoArena());
+            bool ok = processFile(fortress, filename, buffer.data(), buffer.size());
             if (!ok) {
                 std::cerr << "[Error] Failed to process file: " << filename << "\n";
                 return EXIT_FAILURE;
@@ -90,6 +162,568 @@ int main(int argc, char* argv[]) {
         std::cout << "[Main] Processed string: \"" << inputData << "\"\n";
 
     }
+    else if (mode == "copy") {
+        // main.exe copy src dst [--sync] [--verify]  (single-pass copy + digest)
+        if (argc < 4) {
+            std::cerr << "[Error] copy needs a source and a destination.\n";
+            return EXIT_FAILURE;
+        }
+        QFCopyOptions options;
+        for (int i = 4; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--sync") options.sync = true;
+            else if (flag == "--verify") options.verify = true;
+            else {
+                std::cerr << "[Error] Unknown copy option: " << flag << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        QFCopyResult result;
+        if (!copyAndHashFile(argv[2], argv[3], options, result)) {
+            return EXIT_FAILURE;
+        }
+        std::cout << toHex(result.digest.data(), result.digest.size()) << "  " << argv[3] << "\n";
+        std::cerr << "[Main] Copied " << result.bytes << " bytes in " << result.seconds << " s"
+            << (options.sync ? ", synced" : "")
+            << (options.verify ? ", verified against processFile" : "") << "\n";
+        return EXIT_SUCCESS;
+    }
+    else if (mode == "numa") {
+        // main.exe numa <file|dir>...  (NUMA-sharded bulk digests)
+        if (argc < 3) {
+            std::cerr << "[Error] No files provided.\n";
+            return EXIT_FAILURE;
+        }
+        std::vector<std::string> files = expandPaths(2, argc, argv);
+        qfSetSchedulerThreads(0, qfNumaTopology().multiNode());
+
+        std::vector<QFDigest> digests;
+        std::vector<bool> ok;
+        QFNumaReport report;
+        hashFilesNuma(files, digests, ok, report);
+
+        int failures = 0;
+        QFManifestWriter manifest;
+        for (size_t i = 0; i < files.size(); i++) {
+            if (!ok[i]) {
+                failures++;
+                continue;
+            }
+            manifest.add(digests[i].data(), digests[i].size(), files[i]);
+        }
+        if (!manifest.flush()) failures++;
+        printNumaReport(report, std::cerr);
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (mode == "smallfiles") {
+        // main.exe smallfiles [--pool] <file|dir>...  (batched small-file digests)
+        QFSmallFilesOptions options;
+        int first = 2;
+        if (first < argc && std::string(argv[first]) == "--pool") {
+            options.backend = QFSmallFilesBackend::ThreadPool;
+            first++;
+        }
+        if (first >= argc) {
+            std::cerr << "[Error] No files provided.\n";
+            return EXIT_FAILURE;
+        }
+        std::vector<std::string> files = expandPaths(first, argc, argv);
+
+        std::vector<QFDigest> digests;
+        std::vector<bool> ok;
+        QFSmallFilesReport report;
+        hashSmallFiles(files, digests, ok, report, options);
+
+        QFManifestWriter manifest;
+        for (size_t i = 0; i < files.size(); i++) {
+            if (!ok[i]) continue;
+            manifest.add(digests[i].data(), digests[i].size(), files[i]);
+        }
+        bool written = manifest.flush();
+        printSmallFilesReport(report, std::cerr);
+        return (report.failures == 0 && written) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (mode == "multi") {
+        // main.exe multi [--algs list] <file|dir>...  (one read, several digests)
+        unsigned algorithms = QF_ALG_ALL;
+        int first = 2;
+        if (first + 1 < argc && std::string(argv[first]) == "--algs") {
+            if (!parseHashAlgorithms(argv[first + 1], algorithms)) {
+                std::cerr << "[Error] Unknown algorithm list: " << argv[first + 1]
+                    << " (use qf, sha256, crc32c or all)\n";
+                return EXIT_FAILURE;
+            }
+            first += 2;
+        }
+        if (first >= argc) {
+            std::cerr << "[Error] No files provided.\n";
+            return EXIT_FAILURE;
+        }
+        std::vector<std::string> files = expandPaths(first, argc, argv);
+
+        // BSD-style tagged lines, one per algorithm
+        int failures = 0;
+        for (const std::string& file : files) {
+            QFMultiDigest digest;
+            if (!hashFileMulti(file, algorithms, digest)) {
+                failures++;
+                continue;
+            }
+            if (algorithms & QF_ALG_QF512) {
+                std::cout << "QF512 (" << file << ") = " << toHex(digest.qf.data(), digest.qf.size()) << "\n";
+            }
+            if (algorithms & QF_ALG_SHA256) {
+                std::cout << "SHA256 (" << file << ") = " << toHex(digest.sha256.data(), digest.sha256.size()) << "\n";
+            }
+            if (algorithms & QF_ALG_CRC32C) {
+                uint8_t be[4] = { static_cast<uint8_t>(digest.crc32c >> 24), static_cast<uint8_t>(digest.crc32c >> 16),
+                    static_cast<uint8_t>(digest.crc32c >> 8), static_cast<uint8_t>(digest.crc32c) };
+                std::cout << "CRC32C (" << file << ") = " << toHex(be, 4) << "\n";
+            }
+        }
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (mode == "dupes") {
+        // main.exe dupes [--min-size N] <file|dir>...  (JSON duplicate groups)
+        QFDupesOptions options;
+        int first = 2;
+        if (first + 1 < argc && std::string(argv[first]) == "--min-size") {
+            options.minSize = std::strtoull(argv[first + 1], nullptr, 10);
+            first += 2;
+        }
+        if (first >= argc) {
+            std::cerr << "[Error] No files provided.\n";
+            return EXIT_FAILURE;
+        }
+        std::vector<std::string> files = expandPaths(first, argc, argv);
+
+        std::vector<QFDupeGroup> groups;
+        QFDupesReport report;
+        findDuplicates(files, groups, report, options);
+        writeDupesJson(groups, report, std::cout);
+        std::cerr << "[Main] " << groups.size() << " duplicate groups, "
+            << report.bytesRead << " of " << report.totalBytes << " bytes read ("
+            << report.bytesAvoided() << " avoided)\n";
+        return report.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (mode == "diff") {
+        // main.exe diff old new [--memory MiB] [--tmp dir]  (external-sort manifest diff)
+        if (argc < 4) {
+            std::cerr << "[Error] diff needs two manifests.\n";
+            return EXIT_FAILURE;
+        }
+        QFManifestDiffOptions options;
+        for (int i = 4; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--memory" && i + 1 < argc) options.memoryBudget = std::strtoull(argv[++i], nullptr, 10) << 20;
+            else if (flag == "--tmp" && i + 1 < argc) options.tempDir = argv[++i];
+            else {
+                std::cerr << "[Error] Unknown diff option: " << flag << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        // "+ new  path", "- old  path", "~ new  path"
+        QFManifestDiffReport report;
+        QFManifestWriter out;
+        bool ok = diffManifests(argv[2], argv[3],
+            [&out](QFDiffKind kind, std::string_view path, std::string_view oldDigest, std::string_view newDigest) {
+                out.addText((kind == QFDiffKind::Added) ? "+ " : (kind == QFDiffKind::Removed) ? "- " : "~ ");
+                out.addText(kind == QFDiffKind::Removed ? oldDigest : newDigest);
+                out.addText("  ");
+                out.addText(path);
+                out.addText("\n");
+            }, report, options);
+        if (!out.flush() || !ok) return EXIT_FAILURE;
+        std::cerr << "[Main] " << report.added << " added, " << report.removed << " removed, "
+            << report.changed << " changed, " << report.unchanged << " unchanged ("
+            << report.oldRuns << " + " << report.newRuns << " runs, "
+            << report.malformedLines << " malformed lines, " << report.seconds << " s)\n";
+        return EXIT_SUCCESS;
+    }
+    else if (mode == "multiset") {
+        // main.exe multiset <lines.txt>...  (order-independent digest of all lines)
+        if (argc < 3) {
+            std::cerr << "[Error] multiset needs at least one file of lines.\n";
+            return EXIT_FAILURE;
+        }
+        QFMultisetHash set;
+        for (int i = 2; i < argc; i++) {
+            std::ifstream in(argv[i], std::ios::binary);
+            if (!in) {
+                std::cerr << "[Error] Could not open file: " << argv[i] << "\n";
+                return EXIT_FAILURE;
+            }
+            std::vector<std::string> lines;
+            std::string line;
+            while (std::getline(in, line)) lines.push_back(line);
+            set.addMany(lines);
+        }
+        QFDigest digest;
+        set.digest(digest);
+        std::cout << toHex(digest.data(), digest.size()) << "  (" << set.count() << " elements)\n";
+        return EXIT_SUCCESS;
+    }
+    else if (mode == "signature") {
+        // main.exe signature old sig [--block bytes]  (rsync-style block signature)
+        if (argc < 4) {
+            std::cerr << "[Error] signature needs <old> <sig>.\n";
+            return EXIT_FAILURE;
+        }
+        QFSignatureOptions options;
+        for (int i = 4; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--block" && i + 1 < argc) options.blockSize = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            else {
+                std::cerr << "[Error] Unknown signature option: " << flag << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        return writeSignature(argv[2], argv[3], options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (mode == "delta") {
+        // main.exe delta sig new delta  (copy/literal instructions against sig)
+        if (argc < 5) {
+            std::cerr << "[Error] delta needs <sig> <new> <delta>.\n";
+            return EXIT_FAILURE;
+        }
+        QFDeltaReport report;
+        if (!writeDelta(argv[2], argv[3], argv[4], report)) return EXIT_FAILURE;
+        std::cerr << "[Main] " << report.copiedBytes << " bytes copied (" << report.copyOps << " runs), "
+            << report.literalBytes << " literal (" << report.literalOps << " ops), delta "
+            << report.deltaBytes << " bytes, " << report.seconds << " s\n";
+        return EXIT_SUCCESS;
+    }
+    else if (mode == "patch") {
+        // main.exe patch old delta out  (rebuild + verify the digest)
+        if (argc < 5) {
+            std::cerr << "[Error] patch needs <old> <delta> <out>.\n";
+            return EXIT_FAILURE;
+        }
+        return applyDelta(argv[2], argv[3], argv[4]) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (mode == "archive") {
+        // main.exe archive <file.tar|file.zip|->  (per-member digests, no extraction)
+        if (argc < 3) {
+            std::cerr << "[Error] archive needs <file.tar|file.zip|->.\n";
+            return EXIT_FAILURE;
+        }
+        std::vector<QFArchiveMember> members;
+        QFArchiveReport report;
+        if (!hashArchive(argv[2], members, report)) return EXIT_FAILURE;
+        QFManifestWriter manifest;
+        for (const auto& m : members) {
+            if (m.ok) manifest.add(m.digest.data(), m.digest.size(), m.name);
+            else std::cerr << "[Main] FAILED  " << m.name << "\n";
+        }
+        manifest.add(report.archiveDigest.data(), report.archiveDigest.size(), argv[2]);
+        if (!manifest.flush()) return EXIT_FAILURE;
+        std::cerr << "[Main] " << report.format << ": " << report.members << " members, "
+            << report.payloadBytes << " payload bytes, " << report.failures << " failed, "
+            << report.seconds << " s\n";
+        return report.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (mode == "tree") {
+        // main.exe tree dir [--save file.tree]  (bottom-up directory digests)
+        if (argc < 3) {
+            std::cerr << "[Error] tree needs <dir>.\n";
+            return EXIT_FAILURE;
+        }
+        std::string savePath;
+        for (int i = 3; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--save" && i + 1 < argc) savePath = argv[++i];
+            else {
+                std::cerr << "[Error] Unknown tree option: " << flag << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        QFTree tree;
+        QFTreeReport report;
+        if (!tree.build(argv[2], report)) return EXIT_FAILURE;
+        if (!savePath.empty() && !tree.save(savePath)) return EXIT_FAILURE;
+        std::cout << toHex(tree.rootDigest().data(), tree.rootDigest().size()) << "  " << argv[2] << "\n";
+        std::cerr << "[Main] " << report.files << " files, " << report.directories << " directories, "
+            << report.bytes << " bytes, " << report.failures << " failures (scan " << report.scanSeconds
+            << " s, files " << report.hashSeconds << " s, directories " << report.treeSeconds << " s)\n";
+        return report.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (mode == "treediff") {
+        // main.exe treediff old new  (each a directory or a saved .tree; descends only into changes)
+        if (argc < 4) {
+            std::cerr << "[Error] treediff needs <old> <new>.\n";
+            return EXIT_FAILURE;
+        }
+        QFTree trees[2];
+        for (int k = 0; k < 2; k++) {
+            QFTreeReport report;
+            std::error_code ec;
+            bool ok = std::filesystem::is_directory(argv[2 + k], ec) ? trees[k].build(argv[2 + k], report)
+                : trees[k].load(argv[2 + k]);
+            if (!ok) return EXIT_FAILURE;
+        }
+        // "+ new  path", "- old  path", "~ new  path" as in diff
+        QFTreeDiffReport report;
+        QFManifestWriter out;
+        diffTrees(trees[0], trees[1],
+            [&out](QFDiffKind kind, const std::string& path, const QFTreeNode* oldNode, const QFTreeNode* newNode) {
+                out.addText((kind == QFDiffKind::Added) ? "+ " : (kind == QFDiffKind::Removed) ? "- " : "~ ");
+                const QFDigest& d = (kind == QFDiffKind::Removed) ? oldNode->digest : newNode->digest;
+                out.add(d.data(), d.size(), path);
+            }, report);
+        if (!out.flush()) return EXIT_FAILURE;
+        std::cerr << "[Main] " << report.added << " added, " << report.removed << " removed, "
+            << report.changed << " changed; visited " << report.visited << " of " << report.newNodes
+            << " nodes in " << report.seconds << " s\n";
+        return EXIT_SUCCESS;
+    }
+    else if (mode == "scrub") {
+        // main.exe scrub state [--import manifest]... [--io MiB/s] [--cpu cores] [--threads n]
+        //                [--interval s] [--loop]  (throttled bit-rot verification)
+        if (argc < 3) {
+            std::cerr << "[Error] scrub needs <state>.\n";
+            return EXIT_FAILURE;
+        }
+        QFScrubOptions options;
+        std::vector<std::string> imports;
+        bool loop = false;
+        for (int i = 3; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--import" && i + 1 < argc) imports.push_back(argv[++i]);
+            else if (flag == "--io" && i + 1 < argc) options.ioBytesPerSecond = std::strtod(argv[++i], nullptr) * (1 << 20);
+            else if (flag == "--cpu" && i + 1 < argc) options.cpuCores = std::strtod(argv[++i], nullptr);
+            else if (flag == "--threads" && i + 1 < argc) options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (flag == "--interval" && i + 1 < argc) options.intervalSeconds = std::strtoull(argv[++i], nullptr, 10);
+            else if (flag == "--loop") loop = true;
+            else {
+                std::cerr << "[Error] Unknown scrub option: " << flag << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        QFScrubber scrubber;
+        if (!scrubber.open(argv[2])) return EXIT_FAILURE;
+        for (const std::string& manifest : imports) {
+            long added = scrubber.importManifest(manifest);
+            if (added < 0) return EXIT_FAILURE;
+            std::cerr << "[Main] " << manifest << ": " << added << " new or changed entries\n";
+        }
+        if (!imports.empty() && !scrubber.save()) return EXIT_FAILURE;
+
+        // Problems only: "<status>  <path>"
+        uint64_t problems = 0;
+        do {
+            QFScrubReport report;
+            bool ok = scrubber.run(options, report,
+                [](const std::string& path, QFScrubStatus status, const QFDigest&, const QFDigest&) {
+                    if (status != QFScrubStatus::Ok) std::cout << qfScrubStatusName(status) << "  " << path << std::endl;
+                });
+            if (!ok) return EXIT_FAILURE;
+            problems += report.corrupt + report.missing + report.unreadable;
+            std::cerr << "[Main] " << report.verified << " of " << report.due << " due files verified ("
+                << scrubber.size() << " tracked), " << report.corrupt << " corrupt, " << report.missing
+                << " missing, " << report.unreadable << " unreadable; " << report.bytes / double(1 << 20)
+                << " MiB in " << report.seconds << " s, " << report.cpuSeconds << " CPU s on "
+                << report.threads << " threads\n";
+            if (loop) std::this_thread::sleep_for(std::chrono::seconds(std::max<uint64_t>(1, scrubber.secondsUntilDue(options.intervalSeconds))));
+        } while (loop);
+        return problems == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (mode == "kdf") {
+        // main.exe kdf salt [--memory MiB] [--passes n] [--lanes n] [--len bytes] < passphrase
+        //   (memory-hard key from the first stdin line)
+        if (argc < 3) {
+            std::cerr << "[Error] kdf needs <salt>.\n";
+            return EXIT_FAILURE;
+        }
+        QFKdfParams params;
+        size_t outLen = 32;
+        for (int i = 3; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--memory" && i + 1 < argc) {
+                // memoryKiB is 32-bit, so at most 4194303 MiB; larger values would wrap
+                unsigned long long mib = std::strtoull(argv[++i], nullptr, 10);
+                if (mib == 0 || mib > (0xFFFFFFFFull >> 10)) {
+                    std::cerr << "[Error] --memory must be 1.." << (0xFFFFFFFFull >> 10) << " MiB: " << argv[i] << "\n";
+                    return EXIT_FAILURE;
+                }
+                params.memoryKiB = static_cast<uint32_t>(mib << 10);
+            }
+            else if (flag == "--passes" && i + 1 < argc) params.passes = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            else if (flag == "--lanes" && i + 1 < argc) params.lanes = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            else if (flag == "--len" && i + 1 < argc) outLen = std::strtoul(argv[++i], nullptr, 10);
+            else {
+                std::cerr << "[Error] Unknown kdf option: " << flag << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        std::string passphrase;
+        std::getline(std::cin, passphrase);
+        if (!passphrase.empty() && passphrase.back() == '\r') passphrase.pop_back();
+        std::string salt = argv[2];
+        std::vector<uint8_t> key(outLen);
+        if (!qfKdf(reinterpret_cast<const uint8_t*>(passphrase.data()), passphrase.size(),
+            reinterpret_cast<const uint8_t*>(salt.data()), salt.size(), params, key.data(), key.size())) {
+            return EXIT_FAILURE;
+        }
+        std::cout << toHex(key.data(), key.size()) << "\n";
+        return EXIT_SUCCESS;
+    }
+    else if (mode == "seal" || mode == "unseal") {
+        // main.exe seal in out --key keyfile [--chunk KiB]   (chunked duplex AEAD)
+        // main.exe unseal in out --key keyfile
+        //   (keyfile: 64 hex digits, e.g. from the kdf mode, or 32 raw bytes)
+        if (argc < 4) {
+            std::cerr << "[Error] " << mode << " needs <in> <out>.\n";
+            return EXIT_FAILURE;
+        }
+        std::string keyPath;
+        QFSealOptions options;
+        for (int i = 4; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--key" && i + 1 < argc) keyPath = argv[++i];
+            else if (flag == "--chunk" && i + 1 < argc && mode == "seal") options.chunkSize = std::strtoul(argv[++i], nullptr, 10) << 10;
+            else {
+                std::cerr << "[Error] Unknown " << mode << " option: " << flag << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        if (keyPath.empty()) {
+            std::cerr << "[Error] " << mode << " needs --key keyfile.\n";
+            return EXIT_FAILURE;
+        }
+        uint8_t key[QF_AEAD_KEY_BYTES];
+        if (!qfLoadKeyFile(keyPath, key)) {
+            return EXIT_FAILURE;
+        }
+        QFSealReport report;
+        bool ok = mode == "seal" ? qfSealFile(argv[2], argv[3], key, options, report)
+                                 : qfOpenSealedFile(argv[2], argv[3], key, report);
+        std::fill(key, key + sizeof(key), 0);
+        if (!ok) {
+            return EXIT_FAILURE;
+        }
+        std::cerr << "[Main] " << (mode == "seal" ? "Sealed " : "Opened ") << report.bytes << " bytes in "
+                  << report.chunks << " chunks, " << report.seconds << " s\n";
+        return EXIT_SUCCESS;
+    }
+    else if (mode == "encrypt" || mode == "decrypt") {
+        // main.exe encrypt in out --key keyfile   (random-access CTR keystream, no integrity)
+        // main.exe decrypt in out --key keyfile [--offset bytes] [--length bytes]
+        //   (a range decrypts only the blocks it covers)
+        if (argc < 4) {
+            std::cerr << "[Error] " << mode << " needs <in> <out>.\n";
+            return EXIT_FAILURE;
+        }
+        std::string keyPath;
+        uint64_t offset = 0, length = 0;
+        bool ranged = false;
+        for (int i = 4; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--key" && i + 1 < argc) keyPath = argv[++i];
+            else if (flag == "--offset" && i + 1 < argc && mode == "decrypt") {
+                offset = std::strtoull(argv[++i], nullptr, 10);
+                ranged = true;
+            }
+            else if (flag == "--length" && i + 1 < argc && mode == "decrypt") {
+                length = std::strtoull(argv[++i], nullptr, 10);
+                ranged = true;
+            }
+            else {
+                std::cerr << "[Error] Unknown " << mode << " option: " << flag << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        if (keyPath.empty()) {
+            std::cerr << "[Error] " << mode << " needs --key keyfile.\n";
+            return EXIT_FAILURE;
+        }
+        uint8_t key[QF_AEAD_KEY_BYTES];
+        if (!qfLoadKeyFile(keyPath, key)) {
+            return EXIT_FAILURE;
+        }
+        QFCtrReport report;
+        bool ok;
+        if (!ranged) {
+            ok = mode == "encrypt" ? qfCtrEncryptFile(argv[2], argv[3], key, report)
+                                   : qfCtrDecryptFile(argv[2], argv[3], key, report);
+        }
+        else {
+            auto start = std::chrono::steady_clock::now();
+            QFCtrReader reader;
+            ok = reader.open(argv[2], key);
+            int fd = ok ? qfOpenWrite(argv[3]) : -1;
+            ok = ok && fd >= 0;
+            uint64_t end = length == 0 ? reader.size() : std::min(reader.size(), offset + length);
+            std::vector<uint8_t> buffer(4 << 20);
+            for (uint64_t at = offset; ok && at < end; at += buffer.size()) {
+                size_t want = static_cast<size_t>(std::min<uint64_t>(buffer.size(), end - at));
+                long got = reader.readAt(buffer.data(), want, at);
+                ok = got == static_cast<long>(want) && qfWriteAll(fd, buffer.data(), want) == got;
+                if (ok) report.bytes += want;
+            }
+            if (fd >= 0) qfClose(fd);
+            report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!ok) std::cerr << "[Error] Could not decrypt the range into " << argv[3] << "\n";
+        }
+        std::fill(key, key + sizeof(key), 0);
+        if (!ok) {
+            return EXIT_FAILURE;
+        }
+        std::cerr << "[Main] " << (mode == "encrypt" ? "Encrypted " : "Decrypted ") << report.bytes << " bytes, "
+                  << report.seconds << " s\n";
+        return EXIT_SUCCESS;
+    }
+    else if (mode == "watch") {
+        // main.exe watch dir [--manifest file] [--debounce ms] [--poll s] [--seconds N]  (live manifest)
+        if (argc < 3) {
+            std::cerr << "[Error] watch needs <dir>.\n";
+            return EXIT_FAILURE;
+        }
+        QFWatchOptions options;
+        unsigned long seconds = 0;   // 0 => until killed
+        for (int i = 3; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--manifest" && i + 1 < argc) options.manifestPath = argv[++i];
+            else if (flag == "--debounce" && i + 1 < argc) options.debounceMs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (flag == "--poll" && i + 1 < argc) {
+                options.forcePolling = true;
+                options.pollSeconds = static_cast<unsigned>(std::max(1ul, std::strtoul(argv[++i], nullptr, 10)));
+            }
+            else if (flag == "--seconds" && i + 1 < argc) seconds = std::strtoul(argv[++i], nullptr, 10);
+            else {
+                std::cerr << "[Error] Unknown watch option: " << flag << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        QFDirectoryWatcher watcher(argv[2], options);
+        bool started = watcher.start([](QFWatchChange change, const std::string& path,
+            const QFDigest* oldDigest, const QFDigest* newDigest) {
+            const char* kind = (change == QFWatchChange::Added) ? "added  "
+                : (change == QFWatchChange::Removed) ? "removed" : "changed";
+            const QFDigest* shown = newDigest ? newDigest : oldDigest;
+            std::cout << kind << " " << toHex(shown->data(), shown->size()) << "  " << path << std::endl;
+        });
+        if (!started) return EXIT_FAILURE;
+        QFWatchStats stats = watcher.stats();
+        std::cerr << "[Main] watching " << stats.files << " files (" << stats.backend << ", initial scan "
+            << stats.initialSeconds << " s)\n";
+        for (unsigned long t = 0; seconds == 0 || t < seconds; t++) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+        watcher.stop();
+        stats = watcher.stats();
+        std::cerr << "[Main] " << stats.events << " events, " << stats.flushes << " flushes, "
+            << stats.rehashed << " files rehashed, " << stats.files << " files\n";
+        return EXIT_SUCCESS;
+    }
+    else if (mode == "bench") {
+        // main.exe bench <name> [args...]  (no name => list)
+        if (argc < 3) {
+            listBenchmarks(std::cout);
+            return EXIT_SUCCESS;
+        }
+        std::vector<std::string> benchArgs(argv + 3, argv + argc);
+        return runBenchmark(argv[2], benchArgs);
+    }
     else {
         std::cerr << "[Error] Unknown mode: " << mode << "\n";
         return EXIT_FAILURE;
@@ -133,21 +767,23 @@ int main(int argc, char* argv[]) {
     std::vector<uint8_t> digest(DIGEST_SIZE);
     qfSqueeze(fortress, digest.data(), DIGEST_SIZE);
 
-    std::cout << "\n[Main] Final 512-bit digest (" << DIGEST_SIZE << " bytes):\n";
-    for (size_t i = 0; i < DIGEST_SIZE; i++) {
-        std::printf("%02x", digest[i]);
-    }
-    std::cout << std::endl;
+    std::cout << "\n[Main] Final 512-bit digest (" << DIGEST_SIZE << " bytes):\n"
+        << toHex(digest.data(), DIGEST_SIZE) << std::endl;
 
     // --------------------------------------------------------------------
     // 6) Print final QFState for demonstration
     // --------------------------------------------------------------------
-    std::cout << "\n[Main] Final QFState:\n";
+    // One buffer for all 32 words instead of a stream round trip per word
+    std::string dump = "\n[Main] Final QFState:\n";
     for (int i = 0; i < QFState::STATE_WORDS; i++) {
-        std::cout << "  fortress.state[" << i << "] = 0x"
-            << std::hex << fortress.state[i] << std::dec << "\n";
+        uint8_t be[8];
+        for (int b = 0; b < 8; b++) be[b] = static_cast<uint8_t>(fortress.state[i] >> (56 - 8 * b));
+        // Unpadded, as std::hex printed it
+        std::string hex = toHex(be, sizeof(be));
+        size_t lead = std::min(hex.find_first_not_of('0'), hex.size() - 1);
+        dump += "  fortress.state[" + std::to_string(i) + "] = 0x" + hex.substr(lead) + "\n";
     }
-    std::cout << "\nabsorbedBytes = " << fortress.absorbedBytes << "\n";
+    std::cout << dump << "\nabsorbedBytes = " << fortress.absorbedBytes << "\n";
 
     std::cout << "[Main] End of demonstration.\n";
     return 0;